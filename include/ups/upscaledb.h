@@ -140,6 +140,8 @@ extern "C" {
  *   2.1.5:  new freelist; version is 3
  *   2.1.9:  changes in btree node format; version is 4
  *   2.1.13: changes in btree node format; version is 5
+ *   2.2.1:  persisted key filters in the header page; version is 6 while
+ *           the persisted filters are valid, otherwise 5
  */
 #define UPS_VERSION_MAJ     2
 #define UPS_VERSION_MIN     2
@@ -571,6 +573,15 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  *      By default, upscaledb checks if it can use mmap,
  *      since mmap is faster than read/write. For performance
  *      reasons, this flag should not be used.
+ *     <li>@ref UPS_ENABLE_IO_URING</li> Uses io_uring (Linux only) to
+ *      submit page writes in batches and to read pages ahead while
+ *      scanning. Falls back to read/write if io_uring is not available.
+ *     <li>@ref UPS_DIRECT_IO</li> Bypasses the file system cache of the
+ *      operating system (O_DIRECT; not supported on Win32). All pages are
+ *      read and written directly, and the upscaledb cache is the only
+ *      cache. Implies @ref UPS_DISABLE_MMAP. The page size should be a
+ *      multiple of 4 kb. Not allowed in combination with
+ *      @ref UPS_IN_MEMORY.
  *     <li>@ref UPS_CACHE_UNLIMITED</li> Do not limit the cache. Nearly as
  *      fast as an In-Memory Database. Not allowed in combination
  *      with a limited cache size.
@@ -580,6 +591,9 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  *      Environment.
  *     <li>@ref UPS_ENABLE_CRC32</li> Stores (and verifies) CRC32
  *      checksums. Not allowed in combination with @ref UPS_IN_MEMORY.
+ *     <li>@ref UPS_ENABLE_CONCURRENT_READS</li> Allows concurrent
+ *      lookups with @ref ups_db_find from several threads. See the
+ *      documentation of @ref UPS_ENABLE_CONCURRENT_READS.
  *    </ul>
  *
  * @param mode File access rights for the new file. This is the @a mode
@@ -595,6 +609,61 @@ ups_get_version(uint32_t *major, uint32_t *minor,
  *      posix_fadvise(). Only on supported platforms. Allowed values are
  *      @ref UPS_POSIX_FADVICE_NORMAL (which is the default) or
  *      @ref UPS_POSIX_FADVICE_RANDOM.
+ *    <li>@ref UPS_PARAM_CACHE_POLICY</li> Sets the replacement policy
+ *      of the cache. Allowed values are @ref UPS_CACHE_POLICY_LRU (which is
+ *      the default), @ref UPS_CACHE_POLICY_2Q or @ref UPS_CACHE_POLICY_CLOCK.
+ *      2Q protects frequently used pages from being evicted by long scans
+ *      (i.e. by full table scans). CLOCK has the cheapest cache hits.
+ *    <li>@ref UPS_PARAM_CACHE_SHARDS</li> The number of cache shards
+ *      (1 - 64). Each shard has its own lock; multiple shards reduce
+ *      the contention if many threads access the cache. Default is 1.
+ *    <li>@ref UPS_PARAM_WORKER_THREADS</li> The number of background
+ *      threads which flush modified pages to disk and purge the cache
+ *      (1 - 64). Pages of different file regions are written in parallel
+ *      if more than one thread is used. The threads also redo the
+ *      journaled pages during recovery, and replay the logged inserts
+ *      and erases of different Databases in parallel. Default is 1.
+ *    <li>@ref UPS_PARAM_GROUP_COMMIT_USEC</li> Enables group commit
+ *      for Transactions. A committed Transaction waits up to this many
+ *      microseconds for concurrent commits; then the journal of the whole
+ *      group is written (and synced, if @ref UPS_ENABLE_FSYNC is set) at
+ *      once. Default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_GROUP_COMMIT_SIZE</li> The max. number of commits
+ *      of a group; the group is written as soon as this many commits are
+ *      waiting. Default is 32.
+ *    <li>@ref UPS_PARAM_JOURNAL_PAGE_DELTAS</li> If set to 1 then the
+ *      journal logs only the modified bytes of a page, not the whole page,
+ *      if the page was logged before. Reduces the size of the journal,
+ *      but keeps a copy of each logged page in memory. Default is 0.
+ *    <li>@ref UPS_PARAM_JOURNAL_FILES</li> The number of journal files
+ *      (2 to 64). The files are used as a ring; a file is reused when
+ *      all its transactions were flushed. Default is 2.
+ *    <li>@ref UPS_PARAM_JOURNAL_FILE_SIZE</li> If set then each journal
+ *      file is preallocated with this size (in bytes), and a file is
+ *      switched as soon as it is full. Default is 0 (the files grow on
+ *      demand).
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> If set then a
+ *      checkpoint is written to the journal whenever this many bytes were
+ *      logged. The checkpoint records which pages were not yet written to
+ *      the database file; the recovery skips all other pages. Default is 0
+ *      (disabled).
+ *    <li>@ref UPS_PARAM_JOURNAL_SYNC_MSEC</li> If set then
+ *      @ref ups_txn_commit returns as soon as the commit is in the journal
+ *      buffer; a background thread writes and syncs the journal every
+ *      this many milliseconds. At most the commits of this time window are
+ *      lost after a crash. Use @ref ups_env_wait_for_commit to wait till
+ *      a commit is durable. Default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_TXN_MERGE_LIMIT</li> If set then committed
+ *      Transactions are merged into the Database by a background thread.
+ *      If more than this many committed Transactions are waiting, then
+ *      @ref ups_txn_commit merges them itself. Default is 0 (committed
+ *      Transactions are merged by @ref ups_txn_commit).
+ *    <li>@ref UPS_PARAM_TXN_CONFLICT_WAIT_MSEC</li> If set then
+ *      lookups, inserts and erases which conflict with an active
+ *      Transaction wait till that Transaction is committed or aborted,
+ *      then retry. @ref UPS_TXN_CONFLICT is returned if the conflict
+ *      persists after this many milliseconds. Default is 0 (conflicts
+ *      are returned immediately).
  *    <li>@ref UPS_PARAM_PAGE_SIZE</li> The size of a file page, in
  *      bytes. It is recommended not to change the default size. The
  *      default size depends on hardware and operating system.
@@ -688,6 +757,15 @@ ups_env_create(ups_env_t **env, const char *filename,
  *      By default, upscaledb checks if it can use mmap,
  *      since mmap is faster than read/write. For performance
  *      reasons, this flag should not be used.
+ *     <li>@ref UPS_ENABLE_IO_URING </li> Uses io_uring (Linux only) to
+ *      submit page writes in batches and to read pages ahead while
+ *      scanning. Falls back to read/write if io_uring is not available.
+ *     <li>@ref UPS_DIRECT_IO </li> Bypasses the file system cache of the
+ *      operating system (O_DIRECT; not supported on Win32). All pages are
+ *      read and written directly, and the upscaledb cache is the only
+ *      cache. Implies @ref UPS_DISABLE_MMAP. The page size should be a
+ *      multiple of 4 kb. Not allowed in combination with
+ *      @ref UPS_IN_MEMORY.
  *     <li>@ref UPS_CACHE_UNLIMITED </li> Do not limit the cache. Nearly as
  *      fast as an In-Memory Database. Not allowed in combination
  *      with a limited cache size.
@@ -699,6 +777,9 @@ ups_env_create(ups_env_t **env, const char *filename,
  *      if necessary.
  *     <li>@ref UPS_ENABLE_CRC32</li> Stores (and verifies) CRC32
  *      checksums.
+ *     <li>@ref UPS_ENABLE_CONCURRENT_READS</li> Allows concurrent
+ *      lookups with @ref ups_db_find from several threads. See the
+ *      documentation of @ref UPS_ENABLE_CONCURRENT_READS.
  *    </ul>
  * @param param An array of ups_parameter_t structures. The following
  *      parameters are available:
@@ -710,6 +791,61 @@ ups_env_create(ups_env_t **env, const char *filename,
  *      posix_fadvise(). Only on supported platforms. Allowed values are
  *      @ref UPS_POSIX_FADVICE_NORMAL (which is the default) or
  *      @ref UPS_POSIX_FADVICE_RANDOM.
+ *    <li>@ref UPS_PARAM_CACHE_POLICY</li> Sets the replacement policy
+ *      of the cache. Allowed values are @ref UPS_CACHE_POLICY_LRU (which is
+ *      the default), @ref UPS_CACHE_POLICY_2Q or @ref UPS_CACHE_POLICY_CLOCK.
+ *      2Q protects frequently used pages from being evicted by long scans
+ *      (i.e. by full table scans). CLOCK has the cheapest cache hits.
+ *    <li>@ref UPS_PARAM_CACHE_SHARDS</li> The number of cache shards
+ *      (1 - 64). Each shard has its own lock; multiple shards reduce
+ *      the contention if many threads access the cache. Default is 1.
+ *    <li>@ref UPS_PARAM_WORKER_THREADS</li> The number of background
+ *      threads which flush modified pages to disk and purge the cache
+ *      (1 - 64). Pages of different file regions are written in parallel
+ *      if more than one thread is used. The threads also redo the
+ *      journaled pages during recovery, and replay the logged inserts
+ *      and erases of different Databases in parallel. Default is 1.
+ *    <li>@ref UPS_PARAM_GROUP_COMMIT_USEC</li> Enables group commit
+ *      for Transactions. A committed Transaction waits up to this many
+ *      microseconds for concurrent commits; then the journal of the whole
+ *      group is written (and synced, if @ref UPS_ENABLE_FSYNC is set) at
+ *      once. Default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_GROUP_COMMIT_SIZE</li> The max. number of commits
+ *      of a group; the group is written as soon as this many commits are
+ *      waiting. Default is 32.
+ *    <li>@ref UPS_PARAM_JOURNAL_PAGE_DELTAS</li> If set to 1 then the
+ *      journal logs only the modified bytes of a page, not the whole page,
+ *      if the page was logged before. Reduces the size of the journal,
+ *      but keeps a copy of each logged page in memory. Default is 0.
+ *    <li>@ref UPS_PARAM_JOURNAL_FILES</li> The number of journal files
+ *      (2 to 64). The files are used as a ring; a file is reused when
+ *      all its transactions were flushed. Default is 2.
+ *    <li>@ref UPS_PARAM_JOURNAL_FILE_SIZE</li> If set then each journal
+ *      file is preallocated with this size (in bytes), and a file is
+ *      switched as soon as it is full. Default is 0 (the files grow on
+ *      demand).
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> If set then a
+ *      checkpoint is written to the journal whenever this many bytes were
+ *      logged. The checkpoint records which pages were not yet written to
+ *      the database file; the recovery skips all other pages. Default is 0
+ *      (disabled).
+ *    <li>@ref UPS_PARAM_JOURNAL_SYNC_MSEC</li> If set then
+ *      @ref ups_txn_commit returns as soon as the commit is in the journal
+ *      buffer; a background thread writes and syncs the journal every
+ *      this many milliseconds. At most the commits of this time window are
+ *      lost after a crash. Use @ref ups_env_wait_for_commit to wait till
+ *      a commit is durable. Default is 0 (disabled).
+ *    <li>@ref UPS_PARAM_TXN_MERGE_LIMIT</li> If set then committed
+ *      Transactions are merged into the Database by a background thread.
+ *      If more than this many committed Transactions are waiting, then
+ *      @ref ups_txn_commit merges them itself. Default is 0 (committed
+ *      Transactions are merged by @ref ups_txn_commit).
+ *    <li>@ref UPS_PARAM_TXN_CONFLICT_WAIT_MSEC</li> If set then
+ *      lookups, inserts and erases which conflict with an active
+ *      Transaction wait till that Transaction is committed or aborted,
+ *      then retry. @ref UPS_TXN_CONFLICT is returned if the conflict
+ *      persists after this many milliseconds. Default is 0 (conflicts
+ *      are returned immediately).
  *    <li>@ref UPS_PARAM_FILE_SIZE_LIMIT</li> Sets a file size limit (in bytes).
  *      Disabled by default. If the limit is exceeded, API functions
  *      return @ref UPS_LIMITS_REACHED.
@@ -766,6 +902,34 @@ ups_env_open(ups_env_t **env, const char *filename,
  *    <li>@ref UPS_PARAM_JOURNAL_COMPRESSION</li> Returns the
  *        selected algorithm for journal compression, or 0 if compression
  *        is disabled
+ *    <li>@ref UPS_PARAM_CACHE_POLICY</li> Returns the replacement
+ *        policy of the cache
+ *    <li>@ref UPS_PARAM_CACHE_SHARDS</li> Returns the number of
+ *        cache shards
+ *    <li>@ref UPS_PARAM_WORKER_THREADS</li> Returns the number of
+ *        background threads
+ *    <li>@ref UPS_PARAM_GROUP_COMMIT_USEC</li> Returns the group commit
+ *        window, in microseconds
+ *    <li>@ref UPS_PARAM_GROUP_COMMIT_SIZE</li> Returns the max. number
+ *        of commits per group
+ *    <li>@ref UPS_PARAM_JOURNAL_PAGE_DELTAS</li> Returns 1 if the journal
+ *        logs page deltas, otherwise 0
+ *    <li>@ref UPS_PARAM_JOURNAL_FILES</li> Returns the number of
+ *        journal files
+ *    <li>@ref UPS_PARAM_JOURNAL_FILE_SIZE</li> Returns the size of
+ *        the preallocated journal files, or 0
+ *    <li>@ref UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL</li> Returns the
+ *        number of journal bytes between two checkpoints, or 0
+ *    <li>@ref UPS_PARAM_JOURNAL_SYNC_MSEC</li> Returns the interval
+ *        of the background sync, or 0
+ *    <li>@ref UPS_PARAM_TXN_MERGE_LIMIT</li> Returns the max. number of
+ *        committed Transactions which wait for the background merge, or 0
+ *    <li>@ref UPS_PARAM_TXN_CONFLICT_WAIT_MSEC</li> Returns the max.
+ *        time an operation waits for a conflicting Transaction, or 0
+ *    <li>@ref UPS_PARAM_JOURNAL_COMMIT_LSN</li> Returns the lsn of the
+ *        most recent commit
+ *    <li>@ref UPS_PARAM_JOURNAL_DURABLE_LSN</li> Returns the lsn up to
+ *        which all commits are durable
  *    </ul>
  *
  * @param env A valid Environment handle
@@ -872,6 +1036,10 @@ ups_env_get_parameters(ups_env_t *env, ups_parameter_t *param);
  * @ref UPS_PARAM_KEY_COMPRESSION. See the upscaledb documentation
  * for more details.
  *
+ * Variable length keys of type @ref UPS_TYPE_BINARY which share long
+ * prefixes (i.e. URLs or file paths) can use @ref UPS_COMPRESSOR_PREFIX.
+ * Each node then stores the common prefix of its keys only once.
+ *
  * In addition, several integer compression algorithms are available
  * for Databases created with the type @ref UPS_TYPE_UINT32. Note that
  * integer compression only works with the default page size of 16kb.
@@ -916,6 +1084,12 @@ ups_env_get_parameters(ups_env_t *env, ups_parameter_t *param);
  *      (and key->flags is @ref UPS_KEY_USER_ALLOC), the value of the current
  *      key is returned in @a key. If key-data is NULL and key->size is 0,
  *      key->data is temporarily allocated by upscaledb.
+ *     <li>@ref UPS_ENABLE_NORMALIZED_KEYS </li> Stores the first 4 bytes
+ *      of each key as an integer next to the key's index entry. Most
+ *      key comparisons are then resolved with an integer comparison, and
+ *      the full key is only compared if the first 4 bytes are equal.
+ *      Costs 4 bytes per key. Only allowed for variable length keys of
+ *      type @ref UPS_TYPE_BINARY.
  *    </ul>
  *
  * @param params An array of ups_parameter_t structures. The following
@@ -940,6 +1114,16 @@ ups_env_get_parameters(ups_env_t *env, ups_parameter_t *param);
  *    <li>@ref UPS_PARAM_CUSTOM_COMPARE_NAME</li> Specifies the name of the
  *      custom compare function (only if @a UPS_PARAM_KEY_TYPE is @a
  *      UPS_TYPE_CUSTOM).
+ *    <li>@ref UPS_PARAM_KEY_FILTER_BITS</li> Maintains a Bloom filter
+ *      with the specified number of bits per key (1 - 32; 10 bits
+ *      result in about 1% false positives). @ref ups_db_find and
+ *      Transactional inserts and erases then skip the B+Tree lookup if
+ *      the key does not exist. The filter is stored in the file when
+ *      the Database is closed. It is rebuilt when the Database is opened
+ *      after a crash, or after many keys were erased. It is not used if
+ *      the Database is opened with @ref UPS_ENABLE_CONCURRENT_READS.
+ *      Not allowed for keys of type
+ *      @ref UPS_TYPE_CUSTOM. The default is 0 (disabled).
  *    </ul>
  *
  * @return @ref UPS_SUCCESS upon success
@@ -1078,6 +1262,26 @@ ups_env_erase_db(ups_env_t *env, uint16_t name, uint32_t flags);
 UPS_EXPORT ups_status_t UPS_CALLCONV
 ups_env_flush(ups_env_t *env, uint32_t flags);
 
+/**
+ * Waits till a commit is durable
+ *
+ * If @ref UPS_PARAM_JOURNAL_SYNC_MSEC is set then @ref ups_txn_commit
+ * returns before the commit was written to disk. This function writes
+ * and syncs the journal, unless the commit with the specified lsn
+ * (see @ref UPS_PARAM_JOURNAL_COMMIT_LSN) is already durable.
+ *
+ * Without @ref UPS_PARAM_JOURNAL_SYNC_MSEC, commits are flushed before
+ * @ref ups_txn_commit returns, and this function returns immediately.
+ *
+ * @param env A valid Environment handle
+ * @param lsn The lsn of a commit, or 0 for the most recent commit
+ *
+ * @return @ref UPS_SUCCESS upon success
+ * @return @ref UPS_INV_PARAMETER if @a env is NULL
+ */
+UPS_EXPORT ups_status_t UPS_CALLCONV
+ups_env_wait_for_commit(ups_env_t *env, uint64_t lsn);
+
 /* internal use only - don't lock mutex */
 #define UPS_DONT_LOCK        0xf0000000
 
@@ -1188,7 +1392,12 @@ typedef struct ups_txn_t ups_txn_t;
  *    bitwise OR. Possible flags are:
  *    <ul>
  *     <li>@ref UPS_TXN_READ_ONLY </li> This Txn is read-only and
- *      will not modify the Database.
+ *      will not modify the Database. It reads from a snapshot: it only
+ *      sees the Txns which were committed before it began, and never
+ *      returns @ref UPS_TXN_CONFLICT. Inserts and erases fail with
+ *      @ref UPS_WRITE_PROTECTED. Txns which are committed while the
+ *      snapshot is active are not flushed to the Database file till the
+ *      read-only Txn is committed or aborted.
  *    </ul>
  *
  * @return @ref UPS_SUCCESS upon success
@@ -1212,6 +1421,34 @@ ups_txn_begin(ups_txn_t **txn, ups_env_t *env, const char *name,
 UPS_EXPORT const char *
 ups_txn_get_name(ups_txn_t *txn);
 
+/**
+ * Retrieves the Txn ID
+ *
+ * The IDs are unique within an Environment and increase with every new
+ * Txn.
+ *
+ * @returns 0 if @a txn is invalid
+ */
+UPS_EXPORT uint64_t
+ups_txn_get_id(ups_txn_t *txn);
+
+/**
+ * Retrieves the ID of the Txn which caused a conflict
+ *
+ * If an operation of @a txn failed with @ref UPS_TXN_CONFLICT then this
+ * function returns the ID (see @ref ups_txn_get_id) of the active Txn
+ * which modified the same key. An ID is returned instead of a handle,
+ * because the other Txn can be committed or aborted (and its handle
+ * released) at any time.
+ *
+ * See also @ref UPS_PARAM_TXN_CONFLICT_WAIT_MSEC.
+ *
+ * @returns The ID of the Txn which caused the most recent conflict of
+ *    @a txn, or 0 if there was no conflict or if @a txn is invalid
+ */
+UPS_EXPORT uint64_t
+ups_txn_get_conflicting_txn_id(ups_txn_t *txn);
+
 /**
  * Commits a Txn
  *
@@ -1221,6 +1458,10 @@ ups_txn_get_name(ups_txn_t *txn);
  * a Cursor was attached to this Txn (with @ref ups_cursor_create
  * or @ref ups_cursor_clone), and the Cursor was not closed.
  *
+ * If group commit is enabled (see @ref UPS_PARAM_GROUP_COMMIT_USEC) then
+ * the function returns when the journal of the whole commit group was
+ * written.
+ *
  * @param txn Pointer to a Txn structure
  * @param flags Optional flags for committing the Txn, combined with
  *    bitwise OR. Unused, set to 0.
@@ -1275,13 +1516,19 @@ ups_txn_abort(ups_txn_t *txn, uint32_t flags);
  * This flag is non persistent. */
 #define UPS_READ_ONLY                               0x00000004
 
-/* unused                                           0x00000008 */
+/** Flag for @ref ups_env_open, @ref ups_env_create.
+ * This flag is non persistent. */
+#define UPS_ENABLE_IO_URING                         0x00000008
 
-/* unused                                           0x00000010 */
+/** Flag for @ref ups_env_open, @ref ups_env_create.
+ * This flag is non persistent. */
+#define UPS_DIRECT_IO                               0x00000010
 
 /* reserved                                         0x00000020 */
 
-/* unused                                           0x00000040 */
+/** Flag for @ref ups_env_create_db.
+ * This flag is persisted in the Database. */
+#define UPS_ENABLE_NORMALIZED_KEYS                  0x00000040
 
 /** Flag for @ref ups_env_create.
  * This flag is non persistent. */
@@ -1349,6 +1596,36 @@ ups_txn_abort(ups_txn_t *txn, uint32_t flags);
  * This flag is non persistent. */
 #define UPS_FLUSH_TRANSACTIONS_IMMEDIATELY          0x08000000
 
+/** Flag for @ref ups_env_open, @ref ups_env_create.
+ * This flag is non persistent.
+ *
+ * By default, all API calls of an Environment are serialized by a
+ * single lock. With this flag, @ref ups_db_find only acquires a shared
+ * lock and can run in parallel to other lookups, while all other
+ * operations (including Cursor operations and UQI queries) still acquire
+ * the lock exclusively. Lookups only run in parallel if the Database does
+ * not use Transactions, duplicate keys, key compression or record
+ * compression; otherwise they are serialized as well.
+ *
+ * If the Database furthermore has fixed-length keys and records which
+ * are stored in the Btree leafs (see @ref UPS_FORCE_RECORDS_INLINE) then
+ * @ref ups_db_insert and @ref ups_db_erase can also run in parallel to
+ * the lookups, but not in parallel to each other. Concurrent lookups
+ * then validate the version of each Btree node instead of locking it,
+ * and are restarted if a node was modified in the meantime.
+ *
+ * With Transactions, @ref ups_db_insert and @ref ups_db_erase of
+ * Transactions can run in parallel to each other, as long as the Database
+ * does not use duplicate keys, record numbers or key compression, and
+ * no Cursor of the Database is open. Committing or aborting a Transaction
+ * still acquires the lock exclusively.
+ *
+ * If this flag is set then key and record data returned by the
+ * Database is stored in per-thread buffers instead of a single
+ * per-Database buffer. Usage metrics are not synchronized and may be
+ * slightly inaccurate. */
+#define UPS_ENABLE_CONCURRENT_READS                 0x10000000
+
 /**
  * Typedef for a key comparison function
  *
@@ -1669,6 +1946,8 @@ ups_db_count(ups_db_t *db, ups_txn_t *txn, uint32_t flags, uint64_t *count);
  *    <li>@ref UPS_PARAM_KEY_COMPRESSION</li> Returns the
  *        selected algorithm for key compression, or 0 if compression
  *        is disabled
+ *    <li>@ref UPS_PARAM_KEY_FILTER_BITS</li> Returns the number of
+ *        bits per key of the key filter, or 0 if the filter is disabled
  *    </ul>
  *
  * @param db A valid Database handle
@@ -1744,6 +2023,69 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
 /** Value for @ref UPS_PARAM_POSIX_FADVISE */
 #define UPS_POSIX_FADVICE_RANDOM                 1
 
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * replacement policy of the page cache */
+#define UPS_PARAM_CACHE_POLICY          0x00000113
+
+/** Value for @ref UPS_PARAM_CACHE_POLICY: least recently used (default) */
+#define UPS_CACHE_POLICY_LRU                     0
+
+/** Value for @ref UPS_PARAM_CACHE_POLICY: scan-resistant "2Q" policy */
+#define UPS_CACHE_POLICY_2Q                      1
+
+/** Value for @ref UPS_PARAM_CACHE_POLICY: "CLOCK" policy; cache hits only
+ * set a reference bit and do not reorganize the cache */
+#define UPS_CACHE_POLICY_CLOCK                   2
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of independently locked cache shards */
+#define UPS_PARAM_CACHE_SHARDS          0x00000114
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of background threads for flushing pages */
+#define UPS_PARAM_WORKER_THREADS        0x00000115
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * time window (in microseconds) for group commits */
+#define UPS_PARAM_GROUP_COMMIT_USEC     0x00000116
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * max. number of commits per group */
+#define UPS_PARAM_GROUP_COMMIT_SIZE     0x00000117
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; enables
+ * logging of page deltas in the journal */
+#define UPS_PARAM_JOURNAL_PAGE_DELTAS   0x00000118
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of journal files */
+#define UPS_PARAM_JOURNAL_FILES         0x00000119
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * size of the preallocated journal files */
+#define UPS_PARAM_JOURNAL_FILE_SIZE     0x0000011a
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; sets the
+ * number of journal bytes between two checkpoints */
+#define UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL   0x0000011b
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; commits
+ * return before they are durable, and the journal is synced in the
+ * background every n milliseconds */
+#define UPS_PARAM_JOURNAL_SYNC_MSEC     0x0000011c
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; committed
+ * Transactions are merged into the Database in the background */
+#define UPS_PARAM_TXN_MERGE_LIMIT       0x0000011d
+
+/** Parameter name for @ref ups_env_create, @ref ups_env_open; operations
+ * wait up to n milliseconds for a conflicting Transaction */
+#define UPS_PARAM_TXN_CONFLICT_WAIT_MSEC        0x0000011e
+
+/** Parameter name for @ref ups_env_create_db; maintains a Bloom filter
+ * with n bits per key, which rules out lookups of keys that do not exist */
+#define UPS_PARAM_KEY_FILTER_BITS       0x0000011f
+
 /** Value for unlimited record sizes */
 #define UPS_RECORD_SIZE_UNLIMITED       ((uint32_t)-1)
 
@@ -1780,6 +2122,18 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
  */
 #define UPS_PARAM_MAX_KEYS_PER_PAGE     0x00000204
 
+/**
+ * Retrieves the lsn of the most recent commit; the value can be used
+ * with @ref ups_env_wait_for_commit.
+ */
+#define UPS_PARAM_JOURNAL_COMMIT_LSN    0x00000205
+
+/**
+ * Retrieves the lsn up to which all commits are durable (see
+ * @ref UPS_PARAM_JOURNAL_SYNC_MSEC).
+ */
+#define UPS_PARAM_JOURNAL_DURABLE_LSN   0x00000206
+
 /**
  * Parameter name for @ref ups_env_create, @ref ups_env_open;
  * enables compression for the journal.
@@ -1840,6 +2194,12 @@ ups_db_get_parameters(ups_db_t *db, ups_parameter_t *param);
 /** uint32 key compression (SIMDFOR - Frame Of Reference w/ SIMD) */
 #define UPS_COMPRESSOR_UINT32_SIMDFOR      11
 
+/**
+ * prefix compression for variable length binary keys; the common
+ * prefix of the keys in a Btree node is only stored once
+ */
+#define UPS_COMPRESSOR_PREFIX              12
+
 /**
  * Retrieves the Environment handle of a Database
  *
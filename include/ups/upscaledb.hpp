@@ -254,6 +254,16 @@ class txn {
       return p ? p : "";
     }
 
+    /** Returns the Txn ID */
+    uint64_t get_id() {
+      return ups_txn_get_id(_txn);
+    }
+
+    /** Returns the ID of the Txn which caused the most recent conflict */
+    uint64_t get_conflicting_txn_id() {
+      return ups_txn_get_conflicting_txn_id(_txn);
+    }
+
     /** Returns a pointer to the internal ups_txn_t structure. */
     ups_txn_t *get_handle() {
       return _txn;
@@ -209,7 +209,7 @@ typedef struct btree_metrics_t {
  * Metrics marked "global" are stored globally and shared between multiple
  * Environments.
  */
-#define UPS_METRICS_VERSION         9
+#define UPS_METRICS_VERSION         14
 
 typedef struct ups_env_metrics_t {
   /* the version indicator - must be UPS_METRICS_VERSION */
@@ -238,6 +238,15 @@ typedef struct ups_env_metrics_t {
   /* amount of pages written to disk */
   uint64_t page_count_flushed;
 
+  /* amount of pages written in batches (when purging the cache or
+   * flushing a changeset) */
+  uint64_t page_count_flushed_batched;
+
+  /* number of write operations for these batches; adjacent pages are
+   * combined in a single write. page_count_flushed_batched divided by
+   * page_count_flush_writes is the coalescing ratio */
+  uint64_t page_count_flush_writes;
+
   /* number of index pages in this Environment */
   uint64_t page_count_type_index;
 
@@ -286,6 +295,46 @@ typedef struct ups_env_metrics_t {
   /* log/journal bytes after compression */
   uint64_t journal_bytes_after_compression;
 
+  /* number of Transaction commits written to the log/journal */
+  uint64_t journal_commit_count;
+
+  /* number of journal flushes for these commits; with group commit,
+   * journal_commit_count divided by journal_commit_groups is the
+   * average group size */
+  uint64_t journal_commit_groups;
+
+  /* accumulated time (in microseconds) till the commits were flushed */
+  uint64_t journal_commit_latency_usec;
+
+  /* max. time (in microseconds) till a commit was flushed */
+  uint64_t journal_commit_max_latency_usec;
+
+  /* number of changeset pages which were logged as deltas */
+  uint64_t journal_page_deltas;
+
+  /* bytes which were saved by logging page deltas instead of full pages */
+  uint64_t journal_page_bytes_saved;
+
+  /* number of checkpoints which were written to the journal */
+  uint64_t journal_checkpoints;
+
+  /* number of journaled pages which were not redone during recovery,
+   * because a checkpoint showed that they were already written */
+  uint64_t journal_recovery_skipped_pages;
+
+  /* number of pages which were redone during recovery */
+  uint64_t journal_recovery_pages;
+
+  /* number of inserts and erases which were replayed during recovery */
+  uint64_t journal_recovery_operations;
+
+  /* number of replayed inserts and erases which were staged in parallel
+   * by the worker threads */
+  uint64_t journal_recovery_parallel_operations;
+
+  /* duration of the recovery, in microseconds */
+  uint64_t journal_recovery_usec;
+
   /* record bytes before compression */
   uint64_t record_bytes_before_compression;
 
@@ -298,6 +347,12 @@ typedef struct ups_env_metrics_t {
   /* key bytes after compression */
   uint64_t key_bytes_after_compression;
 
+  /* (global) number of lookups which were ruled out by a key filter */
+  uint64_t key_filter_negatives;
+
+  /* (global) number of times a key filter was (re-)built */
+  uint64_t key_filter_rebuilds;
+
   /* btree metrics for leaf nodes */
   btree_metrics_t btree_leaf_metrics;
 
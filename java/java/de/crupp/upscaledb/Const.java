@@ -163,6 +163,9 @@ public class Const {
   /** Flag for Database.create() */
   public final static int UPS_ENABLE_DUPLICATE_KEYS =  0x4000;
 
+  /** Flag for Database.create() */
+  public final static int UPS_ENABLE_NORMALIZED_KEYS =  0x0040;
+
   /** Flag for Database.open() */
   public final static int UPS_AUTO_RECOVERY         =  0x10000;
 
@@ -235,6 +238,10 @@ public class Const {
   /** Parameter name for Database.getParameters() */
   public final static int UPS_PARAM_MAX_KEYS_PER_PAGE     =  0x204;
 
+  /** Parameter name for Environment.createDatabase(),
+   * Database.getParameters() */
+  public final static int UPS_PARAM_KEY_FILTER_BITS       =  0x11f;
+
   /** upscaledb pro: Parameter name for Environment.create(),
    * Environment.open() */
   public final static int UPS_PARAM_JOURNAL_COMPRESSION     = 0x01000;
@@ -260,6 +267,9 @@ public class Const {
   /** upscaledb pro: lzop compression */
   public final static int UPS_COMPRESSOR_LZOP         =    4;
 
+  /** Prefix compression for variable length binary keys */
+  public final static int UPS_COMPRESSOR_PREFIX       =   12;
+
   /** Flag for Database.insert(), Cursor.insert() */
   public final static int UPS_OVERWRITE             =    1;
 
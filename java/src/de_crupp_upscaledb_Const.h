@@ -105,6 +105,8 @@ extern "C" {
 #define de_crupp_upscaledb_Const_UPS_RECORD_NUMBER 8192L
 #undef de_crupp_upscaledb_Const_UPS_ENABLE_DUPLICATE_KEYS
 #define de_crupp_upscaledb_Const_UPS_ENABLE_DUPLICATE_KEYS 16384L
+#undef de_crupp_upscaledb_Const_UPS_ENABLE_NORMALIZED_KEYS
+#define de_crupp_upscaledb_Const_UPS_ENABLE_NORMALIZED_KEYS 64L
 #undef de_crupp_upscaledb_Const_UPS_AUTO_RECOVERY
 #define de_crupp_upscaledb_Const_UPS_AUTO_RECOVERY 65536L
 #undef de_crupp_upscaledb_Const_UPS_ENABLE_TRANSACTIONS
@@ -157,6 +159,8 @@ extern "C" {
 #define de_crupp_upscaledb_Const_UPS_PARAM_DATABASE_NAME 515L
 #undef de_crupp_upscaledb_Const_UPS_PARAM_MAX_KEYS_PER_PAGE
 #define de_crupp_upscaledb_Const_UPS_PARAM_MAX_KEYS_PER_PAGE 516L
+#undef de_crupp_upscaledb_Const_UPS_PARAM_KEY_FILTER_BITS
+#define de_crupp_upscaledb_Const_UPS_PARAM_KEY_FILTER_BITS 287L
 #undef de_crupp_upscaledb_Const_UPS_PARAM_JOURNAL_COMPRESSION
 #define de_crupp_upscaledb_Const_UPS_PARAM_JOURNAL_COMPRESSION 4096L
 #undef de_crupp_upscaledb_Const_UPS_PARAM_RECORD_COMPRESSION
@@ -173,6 +177,8 @@ extern "C" {
 #define de_crupp_upscaledb_Const_UPS_COMPRESSOR_LZF 3L
 #undef de_crupp_upscaledb_Const_UPS_COMPRESSOR_LZOP
 #define de_crupp_upscaledb_Const_UPS_COMPRESSOR_LZOP 4L
+#undef de_crupp_upscaledb_Const_UPS_COMPRESSOR_PREFIX
+#define de_crupp_upscaledb_Const_UPS_COMPRESSOR_PREFIX 12L
 #undef de_crupp_upscaledb_Const_UPS_OVERWRITE
 #define de_crupp_upscaledb_Const_UPS_OVERWRITE 1L
 #undef de_crupp_upscaledb_Const_UPS_DUPLICATE
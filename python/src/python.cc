@@ -1651,6 +1651,7 @@ initupscaledb()
   add_const(d, "UPS_RECORD_NUMBER32", UPS_RECORD_NUMBER32);
   add_const(d, "UPS_RECORD_NUMBER64", UPS_RECORD_NUMBER64);
   add_const(d, "UPS_ENABLE_DUPLICATE_KEYS", UPS_ENABLE_DUPLICATE_KEYS);
+  add_const(d, "UPS_ENABLE_NORMALIZED_KEYS", UPS_ENABLE_NORMALIZED_KEYS);
   add_const(d, "UPS_AUTO_RECOVERY", UPS_AUTO_RECOVERY);
   add_const(d, "UPS_ENABLE_TRANSACTIONS", UPS_ENABLE_TRANSACTIONS);
   add_const(d, "UPS_CACHE_UNLIMITED", UPS_CACHE_UNLIMITED);
@@ -1693,10 +1694,12 @@ initupscaledb()
   add_const(d, "UPS_PARAM_RECORD_COMPRESSION", UPS_PARAM_RECORD_COMPRESSION);
   add_const(d, "UPS_PARAM_KEY_COMPRESSION", UPS_PARAM_KEY_COMPRESSION);
   add_const(d, "UPS_PARAM_CUSTOM_COMPARE_NAME", UPS_PARAM_CUSTOM_COMPARE_NAME);
+  add_const(d, "UPS_PARAM_KEY_FILTER_BITS", UPS_PARAM_KEY_FILTER_BITS);
   add_const(d, "UPS_COMPRESSOR_NONE", UPS_COMPRESSOR_NONE);
   add_const(d, "UPS_COMPRESSOR_ZLIB", UPS_COMPRESSOR_ZLIB);
   add_const(d, "UPS_COMPRESSOR_SNAPPY", UPS_COMPRESSOR_SNAPPY);
   add_const(d, "UPS_COMPRESSOR_LZF", UPS_COMPRESSOR_LZF);
+  add_const(d, "UPS_COMPRESSOR_PREFIX", UPS_COMPRESSOR_PREFIX);
   add_const(d, "UPS_TXN_AUTO_ABORT", UPS_TXN_AUTO_ABORT);
   add_const(d, "UPS_TXN_AUTO_COMMIT", UPS_TXN_AUTO_COMMIT);
   add_const(d, "UPS_CURSOR_FIRST", UPS_CURSOR_FIRST);
@@ -112,10 +112,9 @@ struct IntrusiveList {
       tail_ = t;
     }
     else {
+      t->list_node.previous[I] = tail_;
       tail_->list_node.next[I] = t;
       tail_ = t;
-      if (!head_)
-        head_ = t;
     }
     size_++;
   }
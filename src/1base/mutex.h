@@ -29,6 +29,8 @@
 #include <boost/version.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/tss.hpp>
 #include <boost/thread/condition.hpp>
@@ -57,6 +59,94 @@ struct Mutex : public boost::mutex
   }
 };
 
+// A reader/writer lock. Unless shared locking is enabled, readers and
+// writers are serialized by a plain mutex (which is cheaper than the
+// shared_mutex if there's no concurrency).
+struct ReadWriteMutex
+{
+  ReadWriteMutex()
+    : is_shared_enabled(false) {
+  }
+
+  // Enables shared locking; must be called before the mutex is used
+  void enable_shared() {
+    is_shared_enabled = true;
+  }
+
+  void lock() {
+    if (is_shared_enabled)
+      rwlock.lock();
+    else
+      mutex.lock();
+  }
+
+  bool try_lock() {
+    if (is_shared_enabled)
+      return rwlock.try_lock();
+    return mutex.try_lock();
+  }
+
+  // Blocks until the exclusive lock is acquired or |timeout| expires;
+  // returns false on timeout
+  bool timed_lock(const boost::posix_time::time_duration &timeout) {
+    if (is_shared_enabled)
+      return rwlock.timed_lock(timeout);
+    return mutex.timed_lock(timeout);
+  }
+
+  void unlock() {
+    if (is_shared_enabled)
+      rwlock.unlock();
+    else
+      mutex.unlock();
+  }
+
+  void lock_shared() {
+    if (is_shared_enabled)
+      rwlock.lock_shared();
+    else
+      mutex.lock();
+  }
+
+  void unlock_shared() {
+    if (is_shared_enabled)
+      rwlock.unlock_shared();
+    else
+      mutex.unlock();
+  }
+
+  // The upgrade lock is shared with readers, but exclusive to other
+  // writers
+  void lock_upgrade() {
+    if (is_shared_enabled)
+      rwlock.lock_upgrade();
+    else
+      mutex.lock();
+  }
+
+  void unlock_upgrade() {
+    if (is_shared_enabled)
+      rwlock.unlock_upgrade();
+    else
+      mutex.unlock();
+  }
+
+  // Atomically turns the upgrade lock into an exclusive lock. Without
+  // shared locking, the plain mutex is already held exclusively
+  void unlock_upgrade_and_lock() {
+    if (is_shared_enabled)
+      rwlock.unlock_upgrade_and_lock();
+  }
+
+  bool is_shared_enabled;
+  boost::timed_mutex mutex;
+  boost::shared_mutex rwlock;
+};
+
+typedef boost::unique_lock<ReadWriteMutex> ScopedWriteLock;
+typedef boost::shared_lock<ReadWriteMutex> ScopedReadLock;
+typedef boost::upgrade_lock<ReadWriteMutex> ScopedUpgradeLock;
+
 template<typename T>
 struct ScopedTryLock
 {
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A version-based latch for optimistic lock coupling.
+ *
+ * Writers lock the latch before they modify the protected data, and
+ * increment the version when they unlock it. Readers never write to the
+ * latch: they remember the version before reading the data and validate
+ * it afterwards. If the version changed (or the latch was locked in
+ * the meantime) then the reader has seen inconsistent data and has to
+ * restart.
+ *
+ * The lowest bit of the version is the "locked" bit.
+ */
+
+#ifndef UPS_OPTIMISTIC_LATCH_H
+#define UPS_OPTIMISTIC_LATCH_H
+
+#include "0root/root.h"
+
+#include <boost/atomic.hpp>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct OptimisticLatch
+{
+  enum {
+    kLocked = 1
+  };
+
+  OptimisticLatch()
+    : version(0) {
+  }
+
+  // Waits till the latch is unlocked, then returns the current version
+  uint64_t read_lock() const {
+    uint64_t v = version.load(boost::memory_order_acquire);
+    while (unlikely(v & kLocked)) {
+      boost::this_thread::yield();
+      v = version.load(boost::memory_order_acquire);
+    }
+    return v;
+  }
+
+  // Returns true if the latch was not modified since |v| was retrieved
+  // with read_lock()
+  bool validate(uint64_t v) const {
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    return version.load(boost::memory_order_relaxed) == v;
+  }
+
+  // Returns true if the latch is locked by a writer
+  bool is_locked() const {
+    return (version.load(boost::memory_order_relaxed) & kLocked) != 0;
+  }
+
+  // Locks the latch; concurrent readers will fail to validate
+  void lock() {
+    uint64_t v = read_lock();
+    while (!version.compare_exchange_weak(v, v | kLocked,
+                            boost::memory_order_acquire)) {
+      v = read_lock();
+    }
+    boost::atomic_thread_fence(boost::memory_order_release);
+  }
+
+  // Unlocks the latch and increments the version
+  void unlock() {
+    assert(is_locked());
+    version.fetch_add(1, boost::memory_order_release);
+  }
+
+  // The version; the lowest bit is set if the latch is locked
+  boost::atomic<uint64_t> version;
+};
+
+} // namespace upscaledb
+
+#endif // UPS_OPTIMISTIC_LATCH_H
@@ -64,6 +64,10 @@ uint64_t Globals::ms_btree_smo_merge;
 
 uint64_t Globals::ms_btree_smo_shift;
 
+uint64_t Globals::ms_key_filter_negatives;
+
+uint64_t Globals::ms_key_filter_rebuilds;
+
 int Globals::ms_flush_threshold = 10;
 
 } // namespace upscaledb
@@ -91,6 +91,12 @@ struct Globals {
   // usage metrics - number of page shifts
   static uint64_t ms_btree_smo_shift;
 
+  // usage metrics - number of lookups which were ruled out by a key filter
+  static uint64_t ms_key_filter_negatives;
+
+  // usage metrics - number of key filter (re-)builds
+  static uint64_t ms_key_filter_rebuilds;
+
   // flush threshold for committed transactions
   static int ms_flush_threshold;
 };
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A bump allocator ("arena") for objects which share the same lifetime.
+ *
+ * Memory is carved from fixed-size chunks and released all at once with
+ * clear(). Large allocations get a chunk of their own. The chunks can be
+ * recycled through an ArenaPool, which is shared by many arenas.
+ *
+ * @exception_safe: strong
+ * @thread_safe: no (the ArenaPool is thread-safe)
+ */
+
+#ifndef UPS_ARENA_H
+#define UPS_ARENA_H
+
+#include "0root/root.h"
+
+#include <vector>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+#include "1mem/mem.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+//
+// A pool of unused chunks
+//
+struct ArenaPool {
+  enum {
+    // the size of a chunk
+    kChunkSize = 32 * 1024,
+
+    // the max. number of chunks which are kept in the pool
+    kMaxChunks = 64
+  };
+
+  // Destructor; releases all pooled chunks
+  ~ArenaPool() {
+    for (size_t i = 0; i < chunks.size(); i++)
+      Memory::release(chunks[i]);
+  }
+
+  // Returns a chunk of kChunkSize bytes
+  uint8_t *acquire() {
+    {
+      ScopedLock lock(mutex);
+      if (!chunks.empty()) {
+        uint8_t *chunk = chunks.back();
+        chunks.pop_back();
+        return chunk;
+      }
+    }
+    return Memory::allocate<uint8_t>(kChunkSize);
+  }
+
+  // Returns a chunk to the pool, or releases it if the pool is full
+  void release(uint8_t *chunk) {
+    {
+      ScopedLock lock(mutex);
+      if (chunks.size() < kMaxChunks) {
+        chunks.push_back(chunk);
+        return;
+      }
+    }
+    Memory::release(chunk);
+  }
+
+  // Protects |chunks|
+  Mutex mutex;
+
+  // The unused chunks
+  std::vector<uint8_t *> chunks;
+};
+
+//
+// The bump allocator
+//
+struct ArenaAllocator {
+  // Each chunk starts with this header
+  struct Chunk {
+    // the previously allocated chunk
+    Chunk *next;
+
+    // padding; keeps the payload aligned
+    uint64_t _reserved;
+  };
+
+  enum {
+    // allocations are aligned to 8 bytes
+    kAlignment = 8,
+
+    // allocations which exceed this size get their own chunk
+    kMaxBumpSize = ArenaPool::kChunkSize / 4
+  };
+
+  // Constructor; |pool| can be null
+  ArenaAllocator(ArenaPool *pool_ = 0)
+    : pool(pool_), chunks(0), large_chunks(0),
+      used(ArenaPool::kChunkSize), allocated_bytes(0) {
+  }
+
+  // Destructor; releases all memory
+  ~ArenaAllocator() {
+    clear();
+  }
+
+  // Returns |size| bytes; the memory is released with clear()
+  void *allocate(size_t size) {
+    size = (size + kAlignment - 1) & ~(size_t)(kAlignment - 1);
+
+    if (unlikely(size > kMaxBumpSize)) {
+      Chunk *c = Memory::allocate<Chunk>(sizeof(Chunk) + size);
+      c->next = large_chunks;
+      large_chunks = c;
+      allocated_bytes += size;
+      return c + 1;
+    }
+
+    if (unlikely(used + size > ArenaPool::kChunkSize)) {
+      Chunk *c = (Chunk *)(pool ? pool->acquire()
+                                : Memory::allocate<uint8_t>(
+                                        ArenaPool::kChunkSize));
+      c->next = chunks;
+      chunks = c;
+      used = sizeof(Chunk);
+    }
+
+    void *p = (uint8_t *)chunks + used;
+    used += size;
+    allocated_bytes += size;
+    return p;
+  }
+
+  // Releases all memory at once; the chunks are returned to the pool
+  void clear() {
+    while (chunks) {
+      Chunk *next = chunks->next;
+      if (pool)
+        pool->release((uint8_t *)chunks);
+      else
+        Memory::release(chunks);
+      chunks = next;
+    }
+    while (large_chunks) {
+      Chunk *next = large_chunks->next;
+      Memory::release(large_chunks);
+      large_chunks = next;
+    }
+    used = ArenaPool::kChunkSize;
+    allocated_bytes = 0;
+  }
+
+  // The pool which recycles the chunks; can be null
+  ArenaPool *pool;
+
+  // The linked list of chunks; the head is the current chunk
+  Chunk *chunks;
+
+  // The linked list of chunks for large allocations
+  Chunk *large_chunks;
+
+  // Number of bytes used in the current chunk
+  size_t used;
+
+  // Number of bytes allocated since the last clear()
+  uint64_t allocated_bytes;
+};
+
+} // namespace upscaledb
+
+#endif // UPS_ARENA_H
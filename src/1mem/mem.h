@@ -75,6 +75,29 @@ struct Memory {
     return t;
   }
 
+  // allocates |size| bytes at an address which is a multiple of
+  // |alignment| (a power of two); required for direct I/O. The memory is
+  // released with release().
+  // On Win32 the memory is not aligned, because it could not be released
+  // with free().
+  template<typename T>
+  static T *allocate_aligned(size_t size, size_t alignment) {
+#ifdef WIN32
+    return allocate<T>(size);
+#else
+    ms_total_allocations++;
+    ms_current_allocations++;
+    void *t = 0;
+#  ifdef UPS_USE_TCMALLOC
+    if (unlikely(::tc_posix_memalign(&t, alignment, size) != 0))
+#  else
+    if (unlikely(::posix_memalign(&t, alignment, size) != 0))
+#  endif
+      throw Exception(UPS_OUT_OF_MEMORY);
+    return (T *)t;
+#endif
+  }
+
   // allocates |size| bytes; returns null if out of memory. initializes
   // the allocated memory with zeroes.
   // usage:
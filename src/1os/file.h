@@ -49,24 +49,38 @@ class File
       kSeekSet = SEEK_SET,
       kSeekEnd = SEEK_END,
       kSeekCur = SEEK_CUR,
-      kMaxPath = PATH_MAX
+      kMaxPath = PATH_MAX,
 #else
       kSeekSet = FILE_BEGIN,
       kSeekEnd = FILE_END,
       kSeekCur = FILE_CURRENT,
-      kMaxPath = MAX_PATH
+      kMaxPath = MAX_PATH,
 #endif
+
+      // alignment of file offsets, sizes and buffers for direct I/O
+      kDirectIoAlignment = 4096
+    };
+
+    // A buffer for pwritev()
+    struct IoVector {
+      // the data
+      const void *data;
+
+      // the size of the data
+      size_t size;
     };
 
     // Constructor: creates an empty File handle
     File()
-      : m_fd(UPS_INVALID_FD), m_mmaph(UPS_INVALID_FD), m_posix_advice(0) {
+      : m_fd(UPS_INVALID_FD), m_mmaph(UPS_INVALID_FD), m_posix_advice(0),
+        m_direct_io(false) {
     }
 
     // Copy constructor: moves ownership of the file handle
     File(File &&other)
       : m_fd(other.m_fd), m_mmaph(other.m_mmaph),
-        m_posix_advice(other.m_posix_advice) {
+        m_posix_advice(other.m_posix_advice),
+        m_direct_io(other.m_direct_io) {
       other.m_fd = UPS_INVALID_FD;
 	  other.m_mmaph = UPS_INVALID_FD;
     }
@@ -79,21 +93,43 @@ class File
     // Assignment operator: moves ownership of the file handle
     File &operator=(File &&other) {
       m_fd = other.m_fd;
+      m_direct_io = other.m_direct_io;
       other.m_fd = UPS_INVALID_FD;
       return *this;
     }
 
-    // Creates a new file
-    void create(const char *filename, uint32_t mode);
+    // Creates a new file. If |direct_io| is true then the file system
+    // cache is bypassed (if supported by the file system).
+    void create(const char *filename, uint32_t mode, bool direct_io = false);
 
-    // Opens an existing file
-    void open(const char *filename, bool read_only);
+    // Opens an existing file. If |direct_io| is true then the file system
+    // cache is bypassed (if supported by the file system).
+    void open(const char *filename, bool read_only, bool direct_io = false);
 
     // Returns true if the file is open
     bool is_open() const {
       return m_fd != UPS_INVALID_FD;
     }
 
+    // Returns the file handle; required for asynchronous I/O
+    ups_fd_t fd() const {
+      return m_fd;
+    }
+
+    // Returns true if the file was opened with O_DIRECT. Unaligned reads
+    // and writes are then copied through an aligned buffer.
+    bool is_direct_io() const {
+      return m_direct_io;
+    }
+
+    // Returns true if a request can be sent to a file opened with
+    // O_DIRECT without copying it
+    static bool is_aligned_for_direct_io(uint64_t addr, const void *buffer,
+                    size_t len) {
+      return ((addr | len | (uintptr_t)buffer)
+                      & (kDirectIoAlignment - 1)) == 0;
+    }
+
     // Flushes a file
     void flush();
 
@@ -117,6 +153,10 @@ class File
     // Positional write to a file
     void pwrite(uint64_t addr, const void *buffer, size_t len);
 
+    // Positional write of multiple buffers to adjacent file ranges; the
+    // buffers are written with a single system call (if available)
+    void pwritev(uint64_t addr, const IoVector *vectors, size_t count);
+
     // Write data to a file; uses the current file position
     void write(const void *buffer, size_t len);
 
@@ -135,6 +175,10 @@ class File
     // Truncate/resize the file
     void truncate(uint64_t newsize);
 
+    // Allocates disk space for the first |size| bytes of the file, without
+    // modifying existing data; grows the file if it is smaller
+    void allocate(uint64_t size);
+
     // Closes the file descriptor
     void close();
 
@@ -148,6 +192,9 @@ class File
     // Parameter for posix_fadvise()
     int m_posix_advice;
 
+    // True if the file was opened with O_DIRECT
+    bool m_direct_io;
+
 #ifdef WIN32
 	// A mutex; required for Win32
 	Mutex m_mutex;
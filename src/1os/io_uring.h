@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A minimal wrapper for the Linux io_uring interface. Positional reads and
+ * writes are queued, then submitted with a single system call. The wrapper
+ * uses the raw system calls and does not depend on liburing.
+ *
+ * The ring is not thread-safe; the caller has to synchronize access.
+ */
+
+#ifndef UPS_OS_IO_URING_H
+#define UPS_OS_IO_URING_H
+
+#include "0root/root.h"
+
+#include <sys/uio.h>
+
+#include "ups/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1os/os.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct IoUringState;
+
+struct IoUring
+{
+  // Constructor: creates an uninitialized ring
+  IoUring()
+    : state_(0) {
+  }
+
+  // Destructor: closes the ring
+  ~IoUring() {
+    close();
+  }
+
+  // Returns true if the kernel supports io_uring (and the library was
+  // built with support for io_uring)
+  static bool is_supported();
+
+  // Sets up a ring with (at least) |entries| submission slots. Returns
+  // false if io_uring is not available
+  bool initialize(uint32_t entries);
+
+  // Returns true if the ring was set up
+  bool is_initialized() const {
+    return state_ != 0;
+  }
+
+  // Returns the number of submission slots
+  uint32_t capacity() const;
+
+  // Queues a positional read; |user_data| is returned by wait_completion()
+  void prepare_read(ups_fd_t fd, uint64_t offset, void *buffer, size_t len,
+                  uint64_t user_data);
+
+  // Queues a positional write; |user_data| is returned by wait_completion()
+  void prepare_write(ups_fd_t fd, uint64_t offset, const void *buffer,
+                  size_t len, uint64_t user_data);
+
+  // Queues a positional write of |count| buffers to adjacent file ranges;
+  // |iov| must remain valid till the request is completed
+  void prepare_writev(ups_fd_t fd, uint64_t offset, const struct iovec *iov,
+                  size_t count, uint64_t user_data);
+
+  // Submits all queued requests to the kernel
+  void submit();
+
+  // Retrieves a completed request without blocking. Returns false if no
+  // request is completed. |result| is the number of bytes transferred, or
+  // a negative errno value.
+  bool peek_completion(uint64_t *user_data, int *result);
+
+  // Waits till a request is completed
+  void wait_completion(uint64_t *user_data, int *result);
+
+  // Closes the ring
+  void close();
+
+  private:
+    IoUringState *state_;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_OS_IO_URING_H */
@@ -31,6 +31,12 @@ namespace upscaledb {
 //  Windows
 #  include <intrin.h>
 #  define cpuid    __cpuid
+#  define cpuid_count __cpuidex
+
+static uint64_t
+xgetbv0() {
+  return _xgetbv(0);
+}
 #else
 #  include <cpuid.h>
 static void
@@ -47,8 +53,51 @@ cpuid(int info[4], int level) {
       "a" (infotype)
   );*/
 }
+
+static void
+cpuid_count(int info[4], int level, int sublevel) {
+  __cpuid_count(level, sublevel, info[0], info[1], info[2], info[3]);
+}
+
+static uint64_t
+xgetbv0() {
+  uint32_t eax, edx;
+  __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+  return ((uint64_t)edx << 32) | eax;
+}
 #endif
 
+// The wide registers can only be used if the operating system saves
+// them on a context switch; this is reported by XGETBV
+static void
+detect_wide_vectors(bool *avx2, bool *avx512)
+{
+  *avx2 = false;
+  *avx512 = false;
+
+  int info[4];
+  cpuid(info, 0);
+  int num_ids = info[0];
+  if (num_ids < 7)
+    return;
+
+  // OSXSAVE is required for XGETBV
+  cpuid(info, 0x00000001);
+  if ((info[2] & ((int)1 << 27)) == 0)
+    return;
+
+  uint64_t xcr0 = xgetbv0();
+  bool has_ymm = (xcr0 & 0x06) == 0x06;  // SSE and AVX state
+  bool has_zmm = (xcr0 & 0xe6) == 0xe6;  // ... and the AVX-512 state
+
+  cpuid_count(info, 7, 0);
+  uint32_t leaf7_ebx = (uint32_t)info[1];
+  *avx2 = has_ymm && (leaf7_ebx & (1u << 5)) != 0;
+  *avx512 = has_zmm && *avx2
+                && (leaf7_ebx & (1u << 16)) != 0    // AVX512F
+                && (leaf7_ebx & (1u << 30)) != 0;   // AVX512BW
+}
+
 bool
 os_has_avx()
 {
@@ -73,6 +122,32 @@ os_has_avx()
   return available;
 }
 
+bool
+os_has_avx2()
+{
+  static bool available = false;
+  static bool initialized = false;
+  if (!initialized) {
+    bool avx512;
+    detect_wide_vectors(&available, &avx512);
+    initialized = true;
+  }
+  return available;
+}
+
+bool
+os_has_avx512()
+{
+  static bool available = false;
+  static bool initialized = false;
+  if (!initialized) {
+    bool avx2;
+    detect_wide_vectors(&avx2, &available);
+    initialized = true;
+  }
+  return available;
+}
+
 #else // !HAVE_SSE2
 
 bool
@@ -81,6 +156,18 @@ os_has_avx()
   return false;
 }
 
+bool
+os_has_avx2()
+{
+  return false;
+}
+
+bool
+os_has_avx512()
+{
+  return false;
+}
+
 #endif // HAVE_SSE2
 
 } // namespace upscaledb
@@ -66,6 +66,15 @@ typedef SOCKET             ups_socket_t;
 extern bool
 os_has_avx();
 
+// Returns true if the CPU and the operating system support AVX2
+extern bool
+os_has_avx2();
+
+// Returns true if the CPU and the operating system support AVX-512
+// (the foundation and the byte/word instructions)
+extern bool
+os_has_avx512();
+
 } // namespace upscaledb
 
 #endif /* UPS_OS_H */
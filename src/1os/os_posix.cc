@@ -21,15 +21,17 @@
 
 #include "0root/root.h"
 
+#include <algorithm>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
 #if HAVE_MMAP
 #  include <sys/mman.h>
 #endif
-#if HAVE_WRITEV
+#if HAVE_WRITEV || HAVE_PWRITEV
 #  include <sys/uio.h>
 #endif
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/file.h>
@@ -38,12 +40,19 @@
 #include <netdb.h>
 #include <fcntl.h>
 #include <unistd.h>
+#ifdef HAVE_LINUX_IO_URING_H
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <linux/io_uring.h>
+#endif
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
 #include "1errorinducer/errorinducer.h"
+#include "1mem/mem.h"
 #include "1os/file.h"
 #include "1os/socket.h"
+#include "1os/io_uring.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -95,6 +104,145 @@ enable_largefile(int fd)
 #endif
 }
 
+// Opens a file. If |direct_io| is true then the file system cache is
+// bypassed, if the file system supports this. |is_direct_io| is set to true
+// if the file was opened with O_DIRECT.
+static ups_fd_t
+open_file(const char *filename, int osflags, uint32_t mode, bool direct_io,
+                bool *is_direct_io)
+{
+  *is_direct_io = false;
+
+#ifdef O_DIRECT
+  if (direct_io) {
+    ups_fd_t fd = ::open(filename, osflags | O_DIRECT, mode);
+    if (fd >= 0) {
+      *is_direct_io = true;
+      return fd;
+    }
+    if (errno != EINVAL)
+      return fd;
+    ups_log(("file system does not support O_DIRECT, falling back to "
+            "buffered I/O"));
+  }
+#endif
+
+  ups_fd_t fd = ::open(filename, osflags, mode);
+#ifdef F_NOCACHE
+  // MacOS does not have O_DIRECT, but can disable caching per file
+  if (fd >= 0 && direct_io)
+    ::fcntl(fd, F_NOCACHE, 1);
+#endif
+  return fd;
+}
+
+// Reads up to |len| bytes; returns the number of bytes read, which is
+// less than |len| if the end of the file is reached
+static size_t
+pread_until_eof(ups_fd_t fd, uint64_t addr, uint8_t *buffer, size_t len)
+{
+  size_t total = 0;
+
+  while (total < len) {
+    ssize_t r = ::pread(fd, buffer + total, len - total, addr + total);
+    if (r < 0) {
+      ups_log(("File::pread failed with status %u (%s)", errno,
+                              strerror(errno)));
+      throw Exception(UPS_IO_ERROR);
+    }
+    if (r == 0)
+      break;
+    total += r;
+  }
+  return total;
+}
+
+// Writes |len| bytes
+static void
+pwrite_all(ups_fd_t fd, uint64_t addr, const uint8_t *buffer, size_t len)
+{
+  size_t total = 0;
+
+  while (total < len) {
+    ssize_t s = ::pwrite(fd, buffer + total, len - total, addr + total);
+    if (s < 0) {
+      ups_log(("pwrite() failed with status %u (%s)", errno, strerror(errno)));
+      throw Exception(UPS_IO_ERROR);
+    }
+    if (s == 0)
+      break;
+    total += s;
+  }
+
+  if (total != len) {
+    ups_log(("pwrite() failed with short write (%s)", strerror(errno)));
+    throw Exception(UPS_IO_ERROR);
+  }
+}
+
+// An aligned buffer which covers an unaligned range of a file opened
+// with O_DIRECT, i.e. the 512 byte header which is read when a file is
+// opened, or pages with a page size of less than 4 kb
+struct DirectIoBuffer {
+  DirectIoBuffer(uint64_t addr, size_t len) {
+    const uint64_t mask = File::kDirectIoAlignment - 1;
+    start = addr & ~mask;
+    size = (size_t)(((addr + len + mask) & ~mask) - start);
+    data = Memory::allocate_aligned<uint8_t>(size, File::kDirectIoAlignment);
+  }
+
+  ~DirectIoBuffer() {
+    Memory::release(data);
+  }
+
+  // the aligned file offset
+  uint64_t start;
+
+  // the aligned size
+  size_t size;
+
+  // the aligned buffer
+  uint8_t *data;
+};
+
+static void
+pread_unaligned(ups_fd_t fd, uint64_t addr, void *buffer, size_t len)
+{
+  DirectIoBuffer aligned(addr, len);
+  size_t total = pread_until_eof(fd, aligned.start, aligned.data,
+                  aligned.size);
+  if (total < addr - aligned.start + len) {
+    ups_log(("File::pread() failed with short read (%s)", strerror(errno)));
+    throw Exception(UPS_IO_ERROR);
+  }
+  ::memcpy(buffer, aligned.data + (addr - aligned.start), len);
+}
+
+static void
+pwrite_unaligned(ups_fd_t fd, uint64_t addr, const void *buffer, size_t len)
+{
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ups_log(("fstat failed with status %u (%s)", errno, strerror(errno)));
+    throw Exception(UPS_IO_ERROR);
+  }
+
+  // read-modify-write the aligned range
+  DirectIoBuffer aligned(addr, len);
+  size_t total = pread_until_eof(fd, aligned.start, aligned.data,
+                  aligned.size);
+  ::memset(aligned.data + total, 0, aligned.size - total);
+  ::memcpy(aligned.data + (addr - aligned.start), buffer, len);
+  pwrite_all(fd, aligned.start, aligned.data, aligned.size);
+
+  // the file must not grow beyond the written data
+  uint64_t end = std::max((uint64_t)st.st_size, addr + len);
+  if (aligned.start + aligned.size > end && ::ftruncate(fd, end) != 0) {
+    ups_log(("ftruncate failed with status %u (%s)", errno, strerror(errno)));
+    throw Exception(UPS_IO_ERROR);
+  }
+}
+
 static void
 os_read(ups_fd_t fd, uint8_t *buffer, size_t len)
 {
@@ -224,22 +372,12 @@ File::pread(uint64_t addr, void *buffer, size_t len)
   os_log(("File::pread: fd=%d, address=%lld, size=%lld", m_fd, addr, len));
 
 #if HAVE_PREAD
-  int r;
-  size_t total = 0;
-
-  while (total < len) {
-    r = ::pread(m_fd, (uint8_t *)buffer + total, len - total,
-                    addr + total);
-    if (r < 0) {
-      ups_log(("File::pread failed with status %u (%s)", errno,
-                              strerror(errno)));
-      throw Exception(UPS_IO_ERROR);
-    }
-    if (r == 0)
-      break;
-    total += r;
+  if (unlikely(m_direct_io && !is_aligned_for_direct_io(addr, buffer, len))) {
+    pread_unaligned(m_fd, addr, buffer, len);
+    return;
   }
 
+  size_t total = pread_until_eof(m_fd, addr, (uint8_t *)buffer, len);
   if (total != len) {
     ups_log(("File::pread() failed with short read (%s)", strerror(errno)));
     throw Exception(UPS_IO_ERROR);
@@ -256,28 +394,99 @@ File::pwrite(uint64_t addr, const void *buffer, size_t len)
   os_log(("File::pwrite: fd=%d, address=%lld, size=%lld", m_fd, addr, len));
 
 #if HAVE_PWRITE
-  ssize_t s;
-  size_t total = 0;
+  if (unlikely(m_direct_io && !is_aligned_for_direct_io(addr, buffer, len))) {
+    pwrite_unaligned(m_fd, addr, buffer, len);
+    return;
+  }
 
-  while (total < len) {
-    s = ::pwrite(m_fd, buffer, len, addr + total);
-    if (s < 0) {
-      ups_log(("pwrite() failed with status %u (%s)", errno, strerror(errno)));
-      throw Exception(UPS_IO_ERROR);
-    }
-    if (s == 0)
-      break;
-    total += s;
+  pwrite_all(m_fd, addr, (const uint8_t *)buffer, len);
+#else
+  seek(addr, kSeekSet);
+  write(buffer, len);
+#endif
+}
+
+#if HAVE_PWRITEV
+// Writes up to |kMaxIoVectors| buffers with a single pwritev() call
+static void
+pwritev_chunk(File *file, ups_fd_t fd, uint64_t addr,
+                const File::IoVector *vectors, size_t count)
+{
+  enum { kMaxIoVectors = 64 };
+  struct iovec iov[kMaxIoVectors];
+  size_t len = 0;
+  assert(count <= kMaxIoVectors);
+  for (size_t i = 0; i < count; i++) {
+    iov[i].iov_base = (void *)vectors[i].data;
+    iov[i].iov_len = vectors[i].size;
+    len += vectors[i].size;
   }
 
-  if (total != len) {
-    ups_log(("pwrite() failed with short read (%s)", strerror(errno)));
+  ssize_t s = ::pwritev(fd, iov, (int)count, addr);
+  if (s < 0) {
+    ups_log(("pwritev() failed with status %u (%s)", errno, strerror(errno)));
     throw Exception(UPS_IO_ERROR);
   }
+  if ((size_t)s == len)
+    return;
+
+  // short write: write the remaining data with pwrite()
+  size_t written = (size_t)s;
+  for (size_t i = 0; i < count; i++) {
+    if (written < vectors[i].size) {
+      file->pwrite(addr + written, (const uint8_t *)vectors[i].data + written,
+                      vectors[i].size - written);
+      written = 0;
+    }
+    else
+      written -= vectors[i].size;
+    addr += vectors[i].size;
+  }
+}
+#endif
+
+void
+File::pwritev(uint64_t addr, const IoVector *vectors, size_t count)
+{
+  os_log(("File::pwritev: fd=%d, address=%lld, count=%lld", m_fd, addr,
+                          count));
+
+#if HAVE_PWRITEV
+  bool is_aligned = true;
+  if (m_direct_io) {
+    uint64_t offset = addr;
+    for (size_t i = 0; i < count && is_aligned; i++) {
+      is_aligned = is_aligned_for_direct_io(offset, vectors[i].data,
+                      vectors[i].size);
+      offset += vectors[i].size;
+    }
+  }
+
+  // unaligned buffers are written one by one, because File::pwrite()
+  // copies them through an aligned buffer
+  if (is_aligned) {
+    // POSIX guarantees that IOV_MAX is at least 16
+#ifdef IOV_MAX
+    const size_t max_vectors = std::min(64, IOV_MAX);
 #else
-  seek(addr, kSeekSet);
-  write(buffer, len);
+    const size_t max_vectors = 16;
 #endif
+    while (count > 0) {
+      size_t n = std::min(count, max_vectors);
+      pwritev_chunk(this, m_fd, addr, vectors, n);
+      for (size_t i = 0; i < n; i++)
+        addr += vectors[i].size;
+      vectors += n;
+      count -= n;
+    }
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < count; i++) {
+    pwrite(addr, vectors[i].data, vectors[i].size);
+    addr += vectors[i].size;
+  }
 }
 
 void
@@ -323,14 +532,34 @@ File::truncate(uint64_t newsize)
 }
 
 void
-File::create(const char *filename, uint32_t mode)
+File::allocate(uint64_t size)
+{
+  os_log(("File::allocate: fd=%d, size=%lld", m_fd, size));
+#if HAVE_POSIX_FALLOCATE
+  int r = ::posix_fallocate(m_fd, 0, size);
+  if (r == 0)
+    return;
+  // not supported by the file system? then fall back to ftruncate()
+  if (r != EINVAL && r != EOPNOTSUPP) {
+    ups_log(("posix_fallocate failed with status %d (%s)", r, strerror(r)));
+    throw Exception(UPS_IO_ERROR);
+  }
+#endif
+  if (file_size() < size)
+    truncate(size);
+}
+
+void
+File::create(const char *filename, uint32_t mode, bool direct_io)
 {
   int osflags = O_CREAT | O_RDWR | O_TRUNC;
 #if HAVE_O_NOATIME
   osflags |= O_NOATIME;
 #endif
 
-  ups_fd_t fd = ::open(filename, osflags, mode ? mode : 0644);
+  bool is_direct_io;
+  ups_fd_t fd = open_file(filename, osflags, mode ? mode : 0644, direct_io,
+                  &is_direct_io);
   if (fd < 0) {
     ups_log(("creating file %s failed with status %u (%s)", filename,
         errno, strerror(errno)));
@@ -344,6 +573,7 @@ File::create(const char *filename, uint32_t mode)
   enable_largefile(fd);
 
   m_fd = fd;
+  m_direct_io = is_direct_io;
 }
 
 void
@@ -364,7 +594,7 @@ File::flush()
 }
 
 void
-File::open(const char *filename, bool read_only)
+File::open(const char *filename, bool read_only, bool direct_io)
 {
   int osflags = 0;
 
@@ -376,7 +606,8 @@ File::open(const char *filename, bool read_only)
   osflags |= O_NOATIME;
 #endif
 
-  ups_fd_t fd = ::open(filename, osflags);
+  bool is_direct_io;
+  ups_fd_t fd = open_file(filename, osflags, 0, direct_io, &is_direct_io);
   if (fd < 0) {
     ups_log(("opening file %s failed with status %u (%s)", filename,
         errno, strerror(errno)));
@@ -390,6 +621,7 @@ File::open(const char *filename, bool read_only)
   enable_largefile(fd);
 
   m_fd = fd;
+  m_direct_io = is_direct_io;
 }
 
 void
@@ -475,4 +707,311 @@ Socket::close()
   }
 }
 
+#ifdef HAVE_LINUX_IO_URING_H
+
+struct IoUringState
+{
+  int ring_fd;
+
+  // the submission queue
+  uint32_t *sq_head;
+  uint32_t *sq_tail;
+  uint32_t *sq_mask;
+  uint32_t *sq_array;
+  uint32_t sq_entries;
+  struct io_uring_sqe *sqes;
+
+  // the completion queue
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t *cq_mask;
+  struct io_uring_cqe *cqes;
+
+  // the mapped memory of the rings
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  size_t sqes_size;
+
+  // number of queued requests which were not yet submitted
+  uint32_t to_submit;
+};
+
+static int
+io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete,
+                uint32_t flags)
+{
+  return (int)::syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                  flags, 0, 0);
+}
+
+bool
+IoUring::is_supported()
+{
+  static int supported = -1;
+  if (supported == -1) {
+    IoUring ring;
+    supported = ring.initialize(1) ? 1 : 0;
+  }
+  return supported == 1;
+}
+
+bool
+IoUring::initialize(uint32_t entries)
+{
+  close();
+
+  struct io_uring_params p;
+  ::memset(&p, 0, sizeof(p));
+  int fd = (int)::syscall(__NR_io_uring_setup, entries, &p);
+  if (fd < 0) {
+    ups_log(("io_uring_setup failed with status %d (%s)", errno,
+                            strerror(errno)));
+    return false;
+  }
+
+  IoUringState *s = new IoUringState;
+  ::memset(s, 0, sizeof(*s));
+  s->ring_fd = fd;
+  s->sq_entries = p.sq_entries;
+  s->sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  s->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  s->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  bool single_mmap = ISSET(p.features, IORING_FEAT_SINGLE_MMAP);
+  if (single_mmap) {
+    if (s->cq_size > s->sq_size)
+      s->sq_size = s->cq_size;
+    s->cq_size = s->sq_size;
+  }
+
+  s->sq_ptr = ::mmap(0, s->sq_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (s->sq_ptr == MAP_FAILED)
+    goto fail_sq;
+  if (single_mmap)
+    s->cq_ptr = s->sq_ptr;
+  else {
+    s->cq_ptr = ::mmap(0, s->cq_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (s->cq_ptr == MAP_FAILED)
+      goto fail_cq;
+  }
+  s->sqes = (struct io_uring_sqe *)::mmap(0, s->sqes_size,
+                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                  IORING_OFF_SQES);
+  if (s->sqes == MAP_FAILED)
+    goto fail_sqes;
+
+  s->sq_head = (uint32_t *)((uint8_t *)s->sq_ptr + p.sq_off.head);
+  s->sq_tail = (uint32_t *)((uint8_t *)s->sq_ptr + p.sq_off.tail);
+  s->sq_mask = (uint32_t *)((uint8_t *)s->sq_ptr + p.sq_off.ring_mask);
+  s->sq_array = (uint32_t *)((uint8_t *)s->sq_ptr + p.sq_off.array);
+  s->cq_head = (uint32_t *)((uint8_t *)s->cq_ptr + p.cq_off.head);
+  s->cq_tail = (uint32_t *)((uint8_t *)s->cq_ptr + p.cq_off.tail);
+  s->cq_mask = (uint32_t *)((uint8_t *)s->cq_ptr + p.cq_off.ring_mask);
+  s->cqes = (struct io_uring_cqe *)((uint8_t *)s->cq_ptr + p.cq_off.cqes);
+
+  state_ = s;
+  return true;
+
+fail_sqes:
+  if (!single_mmap)
+    ::munmap(s->cq_ptr, s->cq_size);
+fail_cq:
+  ::munmap(s->sq_ptr, s->sq_size);
+fail_sq:
+  ups_log(("io_uring mmap failed with status %d (%s)", errno,
+                          strerror(errno)));
+  ::close(fd);
+  delete s;
+  return false;
+}
+
+uint32_t
+IoUring::capacity() const
+{
+  return state_ ? state_->sq_entries : 0;
+}
+
+static void
+io_uring_prepare(IoUringState *s, uint8_t opcode, ups_fd_t fd,
+                uint64_t offset, const void *buffer, size_t len,
+                uint64_t user_data)
+{
+  uint32_t tail = *s->sq_tail;
+  uint32_t head = __atomic_load_n(s->sq_head, __ATOMIC_ACQUIRE);
+  if (tail - head == s->sq_entries) {
+    ups_log(("io_uring submission queue is full"));
+    throw Exception(UPS_IO_ERROR);
+  }
+
+  uint32_t index = tail & *s->sq_mask;
+  struct io_uring_sqe *sqe = &s->sqes[index];
+  ::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = (uint64_t)(uintptr_t)buffer;
+  sqe->len = (uint32_t)len;
+  sqe->user_data = user_data;
+  s->sq_array[index] = index;
+
+  __atomic_store_n(s->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  s->to_submit++;
+}
+
+void
+IoUring::prepare_read(ups_fd_t fd, uint64_t offset, void *buffer, size_t len,
+                uint64_t user_data)
+{
+  assert(state_ != 0);
+  io_uring_prepare(state_, IORING_OP_READ, fd, offset, buffer, len,
+                  user_data);
+}
+
+void
+IoUring::prepare_write(ups_fd_t fd, uint64_t offset, const void *buffer,
+                size_t len, uint64_t user_data)
+{
+  assert(state_ != 0);
+  io_uring_prepare(state_, IORING_OP_WRITE, fd, offset, buffer, len,
+                  user_data);
+}
+
+void
+IoUring::prepare_writev(ups_fd_t fd, uint64_t offset, const struct iovec *iov,
+                size_t count, uint64_t user_data)
+{
+  assert(state_ != 0);
+  io_uring_prepare(state_, IORING_OP_WRITEV, fd, offset, iov, count,
+                  user_data);
+}
+
+void
+IoUring::submit()
+{
+  assert(state_ != 0);
+  while (state_->to_submit > 0) {
+    int r = io_uring_enter(state_->ring_fd, state_->to_submit, 0, 0);
+    if (r < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      ups_log(("io_uring_enter failed with status %d (%s)", errno,
+                              strerror(errno)));
+      throw Exception(UPS_IO_ERROR);
+    }
+    state_->to_submit -= r;
+  }
+}
+
+bool
+IoUring::peek_completion(uint64_t *user_data, int *result)
+{
+  assert(state_ != 0);
+  uint32_t head = *state_->cq_head;
+  uint32_t tail = __atomic_load_n(state_->cq_tail, __ATOMIC_ACQUIRE);
+  if (head == tail)
+    return false;
+
+  struct io_uring_cqe *cqe = &state_->cqes[head & *state_->cq_mask];
+  *user_data = cqe->user_data;
+  *result = cqe->res;
+  __atomic_store_n(state_->cq_head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+void
+IoUring::wait_completion(uint64_t *user_data, int *result)
+{
+  submit();
+  while (!peek_completion(user_data, result)) {
+    int r = io_uring_enter(state_->ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+    if (r < 0 && errno != EINTR && errno != EAGAIN) {
+      ups_log(("io_uring_enter failed with status %d (%s)", errno,
+                              strerror(errno)));
+      throw Exception(UPS_IO_ERROR);
+    }
+  }
+}
+
+void
+IoUring::close()
+{
+  if (!state_)
+    return;
+  ::munmap(state_->sqes, state_->sqes_size);
+  if (state_->cq_ptr != state_->sq_ptr)
+    ::munmap(state_->cq_ptr, state_->cq_size);
+  ::munmap(state_->sq_ptr, state_->sq_size);
+  ::close(state_->ring_fd);
+  delete state_;
+  state_ = 0;
+}
+
+#else // !HAVE_LINUX_IO_URING_H
+
+bool
+IoUring::is_supported()
+{
+  return false;
+}
+
+bool
+IoUring::initialize(uint32_t)
+{
+  return false;
+}
+
+uint32_t
+IoUring::capacity() const
+{
+  return 0;
+}
+
+void
+IoUring::prepare_read(ups_fd_t, uint64_t, void *, size_t, uint64_t)
+{
+  throw Exception(UPS_NOT_IMPLEMENTED);
+}
+
+void
+IoUring::prepare_write(ups_fd_t, uint64_t, const void *, size_t, uint64_t)
+{
+  throw Exception(UPS_NOT_IMPLEMENTED);
+}
+
+void
+IoUring::prepare_writev(ups_fd_t, uint64_t, const struct iovec *, size_t,
+                uint64_t)
+{
+  throw Exception(UPS_NOT_IMPLEMENTED);
+}
+
+void
+IoUring::submit()
+{
+  throw Exception(UPS_NOT_IMPLEMENTED);
+}
+
+bool
+IoUring::peek_completion(uint64_t *, int *)
+{
+  throw Exception(UPS_NOT_IMPLEMENTED);
+}
+
+void
+IoUring::wait_completion(uint64_t *, int *)
+{
+  throw Exception(UPS_NOT_IMPLEMENTED);
+}
+
+void
+IoUring::close()
+{
+}
+
+#endif // HAVE_LINUX_IO_URING_H
+
 } // namespace upscaledb
@@ -231,6 +231,15 @@ File::pwrite(uint64_t addr, const void *buffer, size_t len)
     throw Exception(UPS_IO_ERROR);
 }
 
+void
+File::pwritev(uint64_t addr, const IoVector *vectors, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    pwrite(addr, vectors[i].data, vectors[i].size);
+    addr += vectors[i].size;
+  }
+}
+
 void
 File::write(const void *buffer, size_t len)
 {
@@ -330,8 +339,24 @@ File::truncate(uint64_t newsize)
 }
 
 void
-File::create(const char *filename, uint32_t mode)
+File::allocate(uint64_t size)
+{
+  if (file_size() >= size)
+    return;
+
+  // truncate() moves the file pointer
+  uint64_t position = tell();
+  truncate(size);
+  seek(position, kSeekSet);
+}
+
+void
+File::create(const char *filename, uint32_t mode, bool direct_io)
 {
+  // direct I/O is not supported on Win32, because FILE_FLAG_NO_BUFFERING
+  // requires sector-aligned reads and writes; |direct_io| is ignored
+  (void)direct_io;
+
   ups_status_t st;
   DWORD share = 0; /* 1.1.0: default behaviour is exclusive locking */
   DWORD access = GENERIC_READ | GENERIC_WRITE;
@@ -384,8 +409,12 @@ File::flush()
 }
 
 void
-File::open(const char *filename, bool read_only)
+File::open(const char *filename, bool read_only, bool direct_io)
 {
+  // direct I/O is not supported on Win32, because FILE_FLAG_NO_BUFFERING
+  // requires sector-aligned reads and writes; |direct_io| is ignored
+  (void)direct_io;
+
   ups_status_t st;
   DWORD share = 0; /* 1.1.0: default behaviour is exclusive locking */
   DWORD access = read_only
@@ -44,7 +44,7 @@ struct DbConfig
     : db_name(db_name_), flags(0), key_type(UPS_TYPE_BINARY),
       key_size(UPS_KEY_SIZE_UNLIMITED), record_type(UPS_TYPE_BINARY),
       record_size(UPS_RECORD_SIZE_UNLIMITED), key_compressor(0),
-      record_compressor(0) {
+      record_compressor(0), key_filter_bits(0) {
   }
 
   // the database name
@@ -71,6 +71,9 @@ struct DbConfig
   // the algorithm for record compression
   int record_compressor;
 
+  // bits per key of the key filter; 0 if the filter is disabled
+  int key_filter_bits;
+
   // the name of the custom compare callback function
   std::string compare_name;
 };
@@ -53,7 +53,12 @@ struct EnvConfig
       file_size_limit_bytes(std::numeric_limits<size_t>::max()), 
       remote_timeout_sec(0), journal_compressor(0),
       is_encryption_enabled(false), journal_switch_threshold(0),
-      posix_advice(UPS_POSIX_FADVICE_NORMAL) {
+      posix_advice(UPS_POSIX_FADVICE_NORMAL),
+      cache_policy(UPS_CACHE_POLICY_LRU), cache_shards(1),
+      worker_threads(1), group_commit_usec(0), group_commit_size(32),
+      journal_page_deltas(false), journal_files(2), journal_file_size(0),
+      journal_checkpoint_interval(0), journal_sync_msec(0),
+      txn_merge_limit(0), txn_conflict_wait_msec(0) {
   }
 
   // the environment's flags
@@ -97,6 +102,45 @@ struct EnvConfig
 
   // parameter for posix_fadvise()
   int posix_advice;
+
+  // the replacement policy of the cache (UPS_CACHE_POLICY_*)
+  int cache_policy;
+
+  // the number of cache shards
+  int cache_shards;
+
+  // the number of worker threads
+  int worker_threads;
+
+  // the time window for group commits (in microseconds); 0 if disabled
+  uint32_t group_commit_usec;
+
+  // the max. number of commits per group
+  uint32_t group_commit_size;
+
+  // log only the modified bytes of journaled pages
+  bool journal_page_deltas;
+
+  // the number of journal files
+  int journal_files;
+
+  // the size of the preallocated journal files; 0 if they grow on demand
+  uint64_t journal_file_size;
+
+  // the number of journal bytes between two checkpoints; 0 if disabled
+  uint64_t journal_checkpoint_interval;
+
+  // the interval of the background journal sync (in milliseconds); 0 if
+  // disabled
+  uint32_t journal_sync_msec;
+
+  // the max. number of committed Txns which wait for the background
+  // merge; 0 if the merge is not performed in the background
+  uint32_t txn_merge_limit;
+
+  // the max. time an operation waits for a conflicting Txn (in
+  // milliseconds); 0 if conflicts are returned immediately
+  uint32_t txn_conflict_wait_msec;
 };
 
 } // namespace upscaledb
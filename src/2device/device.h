@@ -42,10 +42,22 @@ namespace upscaledb {
 
 class Page;
 
+// A single request for Device::write_multiple()
+struct DeviceWriteRequest {
+  // the file offset
+  uint64_t offset;
+
+  // the data which is written
+  void *buffer;
+
+  // the size of the data
+  size_t size;
+};
+
 struct Device {
   // Constructor
   Device(const EnvConfig &config)
-  : config(config) {
+  : config(config), batched_pages(0), batched_writes(0) {
   }
 
   // virtual destructor
@@ -90,6 +102,30 @@ struct Device {
   // Writes to the device; this function does not use mmap
   virtual void write(uint64_t offset, void *buffer, size_t len) = 0;
 
+  // Writes multiple buffers to the device. The requests are sorted by
+  // their offset. The default implementation calls write() for each
+  // request; disk-based devices combine adjacent requests into a single
+  // write.
+  virtual void write_multiple(DeviceWriteRequest *requests, size_t count) {
+    for (size_t i = 0; i < count; i++)
+      write(requests[i].offset, requests[i].buffer, requests[i].size);
+    batched_pages += count;
+    batched_writes += count;
+  }
+
+  // Returns the number of requests, starting at |requests|, which write
+  // adjacent file ranges and can be combined into a single write. Returns
+  // at most |max_count|.
+  static size_t count_adjacent(const DeviceWriteRequest *requests,
+                  size_t count, size_t max_count) {
+    size_t n = 1;
+    while (n < count && n < max_count
+            && requests[n - 1].offset + requests[n - 1].size
+                    == requests[n].offset)
+      n++;
+    return n;
+  }
+
   // Allocate storage from this device; this function
   // will *NOT* use mmap. returns the offset of the allocated storage.
   virtual uint64_t alloc(size_t len) = 0;
@@ -97,6 +133,12 @@ struct Device {
   // Reads a page from the device; this function CAN use mmap
   virtual void read_page(Page *page, uint64_t address) = 0;
 
+  // Starts reading the page at |address| in the background, if the device
+  // supports asynchronous I/O. A subsequent read_page() then picks up the
+  // data.
+  virtual void read_ahead(uint64_t address) {
+  }
+
   // Allocate storage for a page from this device; this function
   // can use mmap if available
   virtual void alloc_page(Page *page) = 0;
@@ -114,6 +156,12 @@ struct Device {
 
   // the Environment configuration settings
   const EnvConfig &config;
+
+  // number of pages written with write_multiple()
+  uint64_t batched_pages;
+
+  // number of write operations required for these pages
+  uint64_t batched_writes;
 };
 
 } // namespace upscaledb
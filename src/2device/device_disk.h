@@ -53,6 +53,13 @@ namespace upscaledb {
  * a File-based device
  */
 class DiskDevice : public Device {
+  protected:
+    enum {
+      // max. number of adjacent pages which are combined in a single write
+      kMaxCoalescedPages = 64
+    };
+
+  private:
     struct State {
       State() = default;
       State(const State&) = delete;
@@ -98,7 +105,8 @@ class DiskDevice : public Device {
       ScopedSpinlock lock(m_mutex);
 
       File file;
-      file.create(config.filename.c_str(), config.file_mode);
+      file.create(config.filename.c_str(), config.file_mode,
+                      ISSET(config.flags, UPS_DIRECT_IO));
       file.set_posix_advice(config.posix_advice);
       m_state.file = std::move(file);
     }
@@ -112,7 +120,8 @@ class DiskDevice : public Device {
       ScopedSpinlock lock(m_mutex);
 
       State state = std::move(m_state);
-      state.file.open(config.filename.c_str(), read_only);
+      state.file.open(config.filename.c_str(), read_only,
+                      ISSET(config.flags, UPS_DIRECT_IO));
       state.file.set_posix_advice(config.posix_advice);
 
       // the file size which backs the mapped ptr
@@ -223,6 +232,39 @@ class DiskDevice : public Device {
       m_state.file.pwrite(offset, buffer, len);
     }
 
+    // Writes multiple pages; adjacent pages are combined into a single
+    // vectored write
+    virtual void write_multiple(DeviceWriteRequest *requests, size_t count) {
+#ifdef UPS_ENABLE_ENCRYPTION
+      if (config.is_encryption_enabled) {
+        Device::write_multiple(requests, count);
+        return;
+      }
+#endif
+
+      // with direct I/O, unaligned requests are written with a
+      // read-modify-write cycle; these must not run in parallel
+      if (m_state.file.is_direct_io()) {
+        for (size_t i = 0; i < count; i++) {
+          if (!File::is_aligned_for_direct_io(requests[i].offset,
+                                  requests[i].buffer, requests[i].size)) {
+            ScopedSpinlock lock(m_mutex);
+            batched_writes += write_runs(requests, count);
+            batched_pages += count;
+            return;
+          }
+        }
+      }
+
+      // otherwise the file is not locked while writing; the worker threads
+      // write different pages concurrently
+      size_t writes = write_runs(requests, count);
+
+      ScopedSpinlock lock(m_mutex);
+      batched_writes += writes;
+      batched_pages += count;
+    }
+
     // allocate storage from this device; this function
     // will *NOT* return mmapped memory
     virtual uint64_t alloc(size_t requested_length) {
@@ -284,7 +326,7 @@ class DiskDevice : public Device {
         // note that |p| will not leak if file.pread() throws; |p| is stored
         // in the |page| object and will be cleaned up by the caller in
         // case of an exception.
-        uint8_t *p = Memory::allocate<uint8_t>(config.page_size_bytes);
+        uint8_t *p = allocate_page_buffer();
         page->assign_allocated_buffer(p, address);
       }
 
@@ -305,7 +347,7 @@ class DiskDevice : public Device {
       page->set_address(address);
 
       // allocate a memory buffer
-      uint8_t *p = Memory::allocate<uint8_t>(config.page_size_bytes);
+      uint8_t *p = allocate_page_buffer();
       page->assign_allocated_buffer(p, address);
     }
 
@@ -335,7 +377,35 @@ class DiskDevice : public Device {
       return &m_state.mmapptr[address];
     }
 
-  private:
+  protected:
+    // Writes the requests; adjacent pages are combined into a single
+    // vectored write. Returns the number of writes.
+    size_t write_runs(DeviceWriteRequest *requests, size_t count) {
+      File::IoVector vectors[kMaxCoalescedPages];
+      size_t writes = 0;
+      for (size_t i = 0; i < count; ) {
+        size_t n = count_adjacent(&requests[i], count - i,
+                        kMaxCoalescedPages);
+        for (size_t j = 0; j < n; j++) {
+          vectors[j].data = requests[i + j].buffer;
+          vectors[j].size = requests[i + j].size;
+        }
+        m_state.file.pwritev(requests[i].offset, vectors, n);
+        writes++;
+        i += n;
+      }
+      return writes;
+    }
+
+    // Allocates a buffer for a page; the buffer is aligned if the file
+    // was opened for direct I/O
+    uint8_t *allocate_page_buffer() const {
+      if (m_state.file.is_direct_io())
+        return Memory::allocate_aligned<uint8_t>(config.page_size_bytes,
+                        File::kDirectIoAlignment);
+      return Memory::allocate<uint8_t>(config.page_size_bytes);
+    }
+
     // truncate/resize the device, sans locking
     void truncate_nolock(uint64_t new_file_size) {
       if (new_file_size > config.file_size_limit_bytes)
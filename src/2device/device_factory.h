@@ -32,6 +32,9 @@
 #include "2config/env_config.h"
 #include "2device/device_disk.h"
 #include "2device/device_inmem.h"
+#ifdef HAVE_LINUX_IO_URING_H
+#  include "2device/device_io_uring.h"
+#endif
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -44,8 +47,11 @@ struct DeviceFactory {
   static Device *create(const EnvConfig &config) {
     if (ISSET(config.flags, UPS_IN_MEMORY))
       return new InMemoryDevice(config);
-    else
-      return new DiskDevice(config);
+#ifdef HAVE_LINUX_IO_URING_H
+    if (ISSET(config.flags, UPS_ENABLE_IO_URING) && IoUring::is_supported())
+      return new IoUringDevice(config);
+#endif
+    return new DiskDevice(config);
   }
 };
 
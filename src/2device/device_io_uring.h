@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A disk-based device which uses io_uring (Linux) for batched writes and
+ * asynchronous read-ahead (see UPS_ENABLE_IO_URING).
+ *
+ * Multiple page writes are submitted with a single system call. Pages
+ * which are read ahead are stored in private buffers till they are
+ * picked up by read_page(); a write to the same address discards the
+ * buffer. All other operations are inherited from the DiskDevice.
+ *
+ * If the ring cannot be set up then the device behaves exactly like the
+ * DiskDevice.
+ *
+ * @exception_safe: basic
+ * @thread_safe: yes
+ */
+
+#ifndef UPS_DEVICE_IO_URING_H
+#define UPS_DEVICE_IO_URING_H
+
+#include "0root/root.h"
+
+#include <map>
+#include <vector>
+#include <sys/uio.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+#include "1os/io_uring.h"
+#include "2device/device_disk.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+class IoUringDevice : public DiskDevice {
+    enum {
+      // number of submission slots of the ring
+      kRingEntries = 64,
+
+      // max. number of pages which are read ahead
+      kMaxReadAhead = 16,
+
+      // the lowest bit of the user_data tags a read-ahead; page addresses
+      // are always aligned
+      kReadAheadTag = 1
+    };
+
+    // A page which is read ahead
+    struct ReadAhead {
+      // the buffer which receives the page data
+      uint8_t *buffer;
+
+      // true if the read was completed
+      bool is_completed;
+
+      // number of bytes read, or a negative errno value
+      int result;
+    };
+
+    typedef std::map<uint64_t, ReadAhead> ReadAheadMap;
+
+  public:
+    IoUringDevice(const EnvConfig &config)
+      : DiskDevice(config) {
+    }
+
+    ~IoUringDevice() {
+      ScopedLock lock(m_ring_mutex);
+      drain_read_ahead();
+    }
+
+    // Create a new device
+    virtual void create() {
+      DiskDevice::create();
+      initialize_ring();
+    }
+
+    // opens an existing device
+    virtual void open() {
+      DiskDevice::open();
+      initialize_ring();
+    }
+
+    // closes the device
+    virtual void close() {
+      {
+        ScopedLock lock(m_ring_mutex);
+        drain_read_ahead();
+        m_ring.close();
+      }
+      DiskDevice::close();
+    }
+
+    // truncate/resize the device
+    virtual void truncate(uint64_t new_file_size) {
+      {
+        ScopedLock lock(m_ring_mutex);
+        drain_read_ahead();
+      }
+      DiskDevice::truncate(new_file_size);
+    }
+
+    // writes to the device
+    virtual void write(uint64_t offset, void *buffer, size_t len) {
+      {
+        ScopedLock lock(m_ring_mutex);
+        discard_read_ahead(offset, len);
+      }
+      DiskDevice::write(offset, buffer, len);
+    }
+
+    // Submits all writes with a single system call, then waits till they
+    // are completed
+    virtual void write_multiple(DeviceWriteRequest *requests, size_t count) {
+      if (!is_ring_enabled()) {
+        DiskDevice::write_multiple(requests, count);
+        return;
+      }
+
+      // with direct I/O, unaligned requests are copied through an aligned
+      // buffer by the File
+      if (m_state.file.is_direct_io()) {
+        for (size_t i = 0; i < count; i++) {
+          if (!File::is_aligned_for_direct_io(requests[i].offset,
+                                  requests[i].buffer, requests[i].size)) {
+            DiskDevice::write_multiple(requests, count);
+            return;
+          }
+        }
+      }
+
+      // adjacent pages are combined in a single vectored write
+      std::vector<struct iovec> iov(count);
+      std::vector<std::pair<size_t, size_t> > runs; // first request, length
+      for (size_t i = 0; i < count; ) {
+        size_t n = count_adjacent(&requests[i], count - i,
+                        kMaxCoalescedPages);
+        for (size_t j = i; j < i + n; j++) {
+          iov[j].iov_base = requests[j].buffer;
+          iov[j].iov_len = requests[j].size;
+        }
+        runs.push_back(std::make_pair(i, n));
+        i += n;
+      }
+
+      ScopedLock lock(m_ring_mutex);
+      ups_status_t st = 0;
+
+      // the ring is shared with the read-ahead requests; submit the writes
+      // in chunks which always fit into the ring
+      size_t chunk = kRingEntries - kMaxReadAhead;
+      for (size_t done = 0; done < runs.size(); done += chunk) {
+        size_t n = std::min(chunk, runs.size() - done);
+        for (size_t i = done; i < done + n; i++) {
+          DeviceWriteRequest *first = &requests[runs[i].first];
+          DeviceWriteRequest *last = first + runs[i].second - 1;
+          discard_read_ahead(first->offset,
+                          last->offset + last->size - first->offset);
+          m_ring.prepare_writev(m_state.file.fd(), first->offset,
+                          &iov[runs[i].first], runs[i].second, i << 1);
+        }
+        m_ring.submit();
+
+        while (n > 0) {
+          uint64_t user_data;
+          int result;
+          m_ring.wait_completion(&user_data, &result);
+          if (user_data & kReadAheadTag) {
+            complete_read_ahead(user_data, result);
+            continue;
+          }
+
+          n--;
+          batched_writes++;
+          const std::pair<size_t, size_t> &run = runs[user_data >> 1];
+          if (unlikely(result < 0)) {
+            ups_log(("io_uring write failed with status %d (%s)", -result,
+                                    strerror(-result)));
+            st = UPS_IO_ERROR;
+            continue;
+          }
+
+          // short write: write the remaining data synchronously
+          size_t written = (size_t)result;
+          for (size_t i = run.first; i < run.first + run.second; i++) {
+            DeviceWriteRequest *r = &requests[i];
+            if (likely(written >= r->size)) {
+              written -= r->size;
+              continue;
+            }
+            m_state.file.pwrite(r->offset + written,
+                            (uint8_t *)r->buffer + written, r->size - written);
+            written = 0;
+          }
+        }
+      }
+
+      batched_pages += count;
+      if (st)
+        throw Exception(st);
+    }
+
+    // reads a page from the device; picks up the data if the page was
+    // read ahead
+    virtual void read_page(Page *page, uint64_t address) {
+      {
+        ScopedLock lock(m_ring_mutex);
+        ReadAheadMap::iterator it = m_read_ahead.find(address);
+        if (it != m_read_ahead.end()) {
+          while (!it->second.is_completed)
+            wait_for_read_ahead();
+
+          ReadAhead ra = it->second;
+          m_read_ahead.erase(it);
+
+          if (ra.result == (int)config.page_size_bytes) {
+            if (page->data() == 0)
+              page->assign_allocated_buffer(ra.buffer, address);
+            else {
+              ::memcpy(page->data(), ra.buffer, config.page_size_bytes);
+              Memory::release(ra.buffer);
+            }
+            return;
+          }
+
+          // the read failed; fall back to a synchronous read
+          Memory::release(ra.buffer);
+        }
+      }
+
+      DiskDevice::read_page(page, address);
+    }
+
+    // Starts reading a page in the background
+    virtual void read_ahead(uint64_t address) {
+      if (!is_ring_enabled() || address == 0
+              || address < m_state.mapped_size)
+        return;
+
+      if (m_state.file.is_direct_io()
+          && !File::is_aligned_for_direct_io(address, 0,
+                                  config.page_size_bytes))
+        return;
+
+      ScopedLock lock(m_ring_mutex);
+      if (m_read_ahead.find(address) != m_read_ahead.end())
+        return;
+
+      // collect completed reads; if the limit is reached then discard the
+      // pages which were read ahead, but never picked up
+      uint64_t user_data;
+      int result;
+      while (m_ring.peek_completion(&user_data, &result))
+        complete_read_ahead(user_data, result);
+
+      if (m_read_ahead.size() >= kMaxReadAhead) {
+        for (ReadAheadMap::iterator it = m_read_ahead.begin();
+                it != m_read_ahead.end(); ) {
+          if (it->second.is_completed) {
+            Memory::release(it->second.buffer);
+            m_read_ahead.erase(it++);
+          }
+          else
+            it++;
+        }
+        if (m_read_ahead.size() >= kMaxReadAhead)
+          return;
+      }
+
+      ReadAhead ra;
+      ra.buffer = allocate_page_buffer();
+      ra.is_completed = false;
+      ra.result = 0;
+      m_read_ahead[address] = ra;
+      try {
+        m_ring.prepare_read(m_state.file.fd(), address, ra.buffer,
+                        config.page_size_bytes, address | kReadAheadTag);
+        m_ring.submit();
+      }
+      catch (Exception &) {
+        // not critical; the page will be read synchronously
+        m_read_ahead.erase(address);
+        Memory::release(ra.buffer);
+      }
+    }
+
+    // Removes unused space at the end of the file
+    virtual void reclaim_space() {
+      {
+        ScopedLock lock(m_ring_mutex);
+        drain_read_ahead();
+      }
+      DiskDevice::reclaim_space();
+    }
+
+  private:
+    // Sets up the ring; if this fails then the device falls back to
+    // synchronous I/O
+    void initialize_ring() {
+      ScopedLock lock(m_ring_mutex);
+      if (!m_ring.initialize(kRingEntries))
+        ups_log(("io_uring is not available, falling back to read/write"));
+    }
+
+    // Returns true if the ring is used. Encrypted pages are written and
+    // read synchronously, because the DiskDevice encrypts them on the fly.
+    bool is_ring_enabled() const {
+#ifdef UPS_ENABLE_ENCRYPTION
+      if (config.is_encryption_enabled)
+        return false;
+#endif
+      return m_ring.is_initialized();
+    }
+
+    // Stores the result of a completed read-ahead
+    void complete_read_ahead(uint64_t user_data, int result) {
+      ReadAheadMap::iterator it = m_read_ahead.find(user_data
+                                                & ~(uint64_t)kReadAheadTag);
+      assert(it != m_read_ahead.end());
+      it->second.is_completed = true;
+      it->second.result = result;
+    }
+
+    // Waits till the next read-ahead is completed. All other requests
+    // are completed while the ring mutex is held.
+    void wait_for_read_ahead() {
+      uint64_t user_data;
+      int result;
+      m_ring.wait_completion(&user_data, &result);
+      assert(user_data & kReadAheadTag);
+      complete_read_ahead(user_data, result);
+    }
+
+    // Discards the pages which were read ahead and which overlap with the
+    // range that is overwritten
+    void discard_read_ahead(uint64_t offset, size_t len) {
+      if (m_read_ahead.empty())
+        return;
+
+      uint64_t start = offset >= config.page_size_bytes
+                          ? offset - config.page_size_bytes + 1
+                          : 0;
+      ReadAheadMap::iterator it = m_read_ahead.lower_bound(start);
+      while (it != m_read_ahead.end() && it->first < offset + len) {
+        while (!it->second.is_completed)
+          wait_for_read_ahead();
+        Memory::release(it->second.buffer);
+        m_read_ahead.erase(it++);
+      }
+    }
+
+    // Waits for all pending reads, then discards all pages which were
+    // read ahead
+    void drain_read_ahead() {
+      for (ReadAheadMap::iterator it = m_read_ahead.begin();
+              it != m_read_ahead.end(); it++) {
+        while (!it->second.is_completed)
+          wait_for_read_ahead();
+        Memory::release(it->second.buffer);
+      }
+      m_read_ahead.clear();
+    }
+
+    // Serializes access to the ring and the read-ahead buffers
+    Mutex m_ring_mutex;
+
+    // The io_uring instance
+    IoUring m_ring;
+
+    // The pages which are read ahead, indexed by their address
+    ReadAheadMap m_read_ahead;
+};
+
+} // namespace upscaledb
+
+#endif /* UPS_DEVICE_IO_URING_H */
@@ -20,7 +20,7 @@
  * Manager for the log sequence number (lsn)
  *
  * @exception_safe: nothrow
- * @thread_safe: no
+ * @thread_safe: yes
  */
  
 #ifndef UPS_LSN_MANAGER_H
@@ -28,6 +28,8 @@
 
 #include "0root/root.h"
 
+#include <boost/atomic.hpp>
+
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
 #endif
@@ -41,13 +43,13 @@ struct LsnManager
     : current(1) {
   }
 
-  // Returns the next lsn
+  // Returns the next lsn; Txns can stage operations concurrently
   uint64_t next() {
-    return current++;
+    return current.fetch_add(1, boost::memory_order_relaxed);
   }
 
   // the current lsn
-  uint64_t current;
+  boost::atomic<uint64_t> current;
 };
 
 } // namespace upscaledb
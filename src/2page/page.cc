@@ -19,6 +19,8 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <algorithm>
+#include <vector>
 #include "3rdparty/murmurhash3/MurmurHash3.h"
 
 #include "1base/error.h"
@@ -32,7 +34,7 @@ namespace upscaledb {
 uint64_t Page::ms_page_count_flushed = 0;
 
 Page::Page(Device *device, LocalDb *db)
-  : device_(device), db_(db), node_proxy_(0)
+  : cache_referenced(false), device_(device), db_(db), node_proxy_(0)
 {
   persisted_data.raw_data = 0;
   persisted_data.is_dirty = false;
@@ -75,18 +77,24 @@ Page::fetch(uint64_t address)
   set_address(address);
 }
 
+// Updates the crc32 of a page before it is written
+static inline void
+update_crc32(Device *device, Page::PersistedData *data)
+{
+  if (ISSET(device->config.flags, UPS_ENABLE_CRC32)
+      && likely(!data->is_without_header)) {
+    MurmurHash3_x86_32(data->raw_data->header.payload,
+                       data->size - (sizeof(PPageHeader) - 1),
+                       (uint32_t)data->address,
+                       &data->raw_data->header.crc32);
+  }
+}
+
 void
 Page::flush()
 {
   if (persisted_data.is_dirty) {
-    // update crc32
-    if (ISSET(device_->config.flags, UPS_ENABLE_CRC32)
-        && likely(!persisted_data.is_without_header)) {
-      MurmurHash3_x86_32(persisted_data.raw_data->header.payload,
-                         persisted_data.size - (sizeof(PPageHeader) - 1),
-                         (uint32_t)persisted_data.address,
-                         &persisted_data.raw_data->header.crc32);
-    }
+    update_crc32(device_, &persisted_data);
     device_->write(persisted_data.address, persisted_data.raw_data,
                     persisted_data.size);
     persisted_data.is_dirty = false;
@@ -94,11 +102,49 @@ Page::flush()
   }
 }
 
+static bool
+compare_offsets(const DeviceWriteRequest &lhs, const DeviceWriteRequest &rhs)
+{
+  return lhs.offset < rhs.offset;
+}
+
+void
+Page::flush_multiple(Page **pages, size_t count)
+{
+  std::vector<DeviceWriteRequest> requests;
+  requests.reserve(count);
+  Device *device = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    PersistedData *data = &pages[i]->persisted_data;
+    if (!data->is_dirty)
+      continue;
+    device = pages[i]->device_;
+    update_crc32(device, data);
+    DeviceWriteRequest request = {data->address, data->raw_data, data->size};
+    requests.push_back(request);
+  }
+
+  if (requests.empty())
+    return;
+
+  // the device combines adjacent pages in a single write
+  std::sort(requests.begin(), requests.end(), compare_offsets);
+  device->write_multiple(&requests[0], requests.size());
+
+  for (size_t i = 0; i < count; i++) {
+    if (pages[i]->persisted_data.is_dirty) {
+      pages[i]->persisted_data.is_dirty = false;
+      ms_page_count_flushed++;
+    }
+  }
+}
+
 void
 Page::free_buffer()
 {
   if (node_proxy_) {
-    delete node_proxy_;
+    delete node_proxy_.load();
     node_proxy_ = 0;
   }
 }
@@ -24,6 +24,7 @@
 
 #include "1base/error.h"
 #include "1base/spinlock.h"
+#include "1base/optimistic_latch.h"
 #include "1mem/mem.h"
 #include "1base/intrusive_list.h"
 #include "3btree/btree_cursor.h"
@@ -125,6 +126,31 @@ class Page {
       PPageData *raw_data;
     };
 
+    // The page data as it was last written to the journal. The journal
+    // logs only the modified bytes of the page as long as this image is
+    // still stored in journal file |file| (see UPS_PARAM_JOURNAL_PAGE_DELTAS)
+    struct JournalImage {
+      JournalImage()
+        : data(0), address(0), file(0), generation(0) {
+      }
+
+      ~JournalImage() {
+        Memory::release(data);
+      }
+
+      // a copy of the logged page data; null if the page was not logged
+      uint8_t *data;
+
+      // the address of the page when it was logged
+      uint64_t address;
+
+      // the journal file which stores the image
+      uint32_t file;
+
+      // the generation of the journal file when the image was logged
+      uint64_t generation;
+    };
+
     // Misc. enums
     enum {
       // sizeof the persistent page header
@@ -145,8 +171,11 @@ class Page {
       // a bucket in the hash table of the cache
       kListBucket             = 2,
 
+      // list of cached pages which were accessed only once (2Q policy)
+      kListCacheA1            = 3,
+
       // array limit
-      kListMax                = 3
+      kListMax                = 4
     };
 
     // non-persistent page flags
@@ -330,6 +359,11 @@ class Page {
     // Flushes the page to disk, clears the "dirty" flag
     void flush();
 
+    // Flushes multiple pages with a single request to the device; pages
+    // which are not dirty are skipped. The pages are sorted by address,
+    // and the device combines adjacent pages in a single write.
+    static void flush_multiple(Page **pages, size_t count);
+
     // Returns the cached BtreeNodeProxy
     BtreeNodeProxy *node_proxy() {
       return node_proxy_;
@@ -362,6 +396,17 @@ class Page {
     // Intrusive linked btree cursors
     IntrusiveList<BtreeCursor> cursor_list;
 
+    // The reference bit of the cache (UPS_CACHE_POLICY_CLOCK); set whenever
+    // the page is retrieved from the cache
+    boost::atomic<bool> cache_referenced;
+
+    // Version latch of the btree node; locked by writers while they modify
+    // the node, validated by concurrent (optimistic) readers
+    OptimisticLatch latch;
+
+    // The last image of this page in the journal
+    JournalImage journal_image;
+
   private:
     // the Device for allocating storage
     Device *device_;
@@ -369,8 +414,9 @@ class Page {
     // the Database handle (can be NULL)
     LocalDb *db_;
 
-    // the cached BtreeNodeProxy object
-    BtreeNodeProxy *node_proxy_;
+    // the cached BtreeNodeProxy object; atomic because concurrent readers
+    // create it on demand
+    boost::atomic<BtreeNodeProxy *> node_proxy_;
 };
 
 } // namespace upscaledb
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * Selects the SIMD search kernels at startup.
+ */
+
+#include "0root/root.h"
+
+#ifdef HAVE_SSE2
+
+// Always verify that a file of level N does not include headers > N!
+#include "1os/os.h"
+#include "2simd/simd.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// Returns the widest lower-bound kernel which is supported by the CPU,
+// or null
+template<typename T>
+static typename SimdKernels<T>::LowerBound
+select_lower_bound()
+{
+  if (os_has_avx512())
+    return &lower_bound_avx512;
+  if (os_has_avx2())
+    return &lower_bound_avx2;
+  return 0;
+}
+
+template<> SimdKernels<uint8_t>::LowerBound
+SimdKernels<uint8_t>::lower_bound = select_lower_bound<uint8_t>();
+template<> SimdKernels<uint16_t>::LowerBound
+SimdKernels<uint16_t>::lower_bound = select_lower_bound<uint16_t>();
+template<> SimdKernels<uint32_t>::LowerBound
+SimdKernels<uint32_t>::lower_bound = select_lower_bound<uint32_t>();
+template<> SimdKernels<uint64_t>::LowerBound
+SimdKernels<uint64_t>::lower_bound = select_lower_bound<uint64_t>();
+template<> SimdKernels<float>::LowerBound
+SimdKernels<float>::lower_bound = select_lower_bound<float>();
+template<> SimdKernels<double>::LowerBound
+SimdKernels<double>::lower_bound = select_lower_bound<double>();
+
+} // namespace upscaledb
+
+#endif // HAVE_SSE2
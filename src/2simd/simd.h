@@ -31,6 +31,8 @@
 
 #ifdef __SSE__
 
+#include <algorithm>
+
 #ifdef WIN32
 //#  include <xmmintrin.h>
 //#  include <smmintrin.h>
@@ -333,6 +335,114 @@ linear_search_sse<uint64_t>(uint64_t *data, int start, int count, uint64_t key)
 }
 #endif
 
+// Runs a binary search till the remaining range fits into a few vector
+// registers, then compares a full register of keys at once. |probe|
+// returns the index of the first key in the register which is not
+// < |key|, or Probe::kLanes. Returns the index of the first key which is
+// >= |key|, or |count| if all keys are smaller.
+template<typename T, typename Probe>
+inline int
+vector_lower_bound(const T *data, int count, T key, const Probe &probe)
+{
+  int l = 0, r = count;
+
+  // all keys in [0, l) are < key, and all keys in [r, count) are >= key
+  while (r - l > Probe::kWindow) {
+    int m = l + (r - l) / 2;
+    if (data[m] < key)
+      l = m + 1;
+    else
+      r = m;
+  }
+
+  for (; l + Probe::kLanes <= r; l += Probe::kLanes) {
+    int lane = probe(&data[l]);
+    if (lane < Probe::kLanes)
+      return l + lane;
+  }
+
+  while (l < r && data[l] < key)
+    l++;
+  return l;
+}
+
+#ifdef HAVE_SSE2
+
+//
+// Lower-bound search kernels for sorted arrays of POD keys. They are
+// compiled in separate translation units with the respective compiler
+// flags (simd_avx2.cc and simd_avx512.cc). The widest kernel which is
+// supported by the CPU is selected at startup (simd.cc); the pointer is
+// null if neither AVX2 nor AVX-512 is available.
+//
+template<typename T>
+struct SimdKernels {
+  typedef int (*LowerBound)(const T *data, int count, T key);
+
+  // the selected lower-bound kernel; can be null
+  static LowerBound lower_bound;
+};
+
+template<> SimdKernels<uint8_t>::LowerBound SimdKernels<uint8_t>::lower_bound;
+template<> SimdKernels<uint16_t>::LowerBound SimdKernels<uint16_t>::lower_bound;
+template<> SimdKernels<uint32_t>::LowerBound SimdKernels<uint32_t>::lower_bound;
+template<> SimdKernels<uint64_t>::LowerBound SimdKernels<uint64_t>::lower_bound;
+template<> SimdKernels<float>::LowerBound SimdKernels<float>::lower_bound;
+template<> SimdKernels<double>::LowerBound SimdKernels<double>::lower_bound;
+
+// The AVX2 kernels; only call them if os_has_avx2() returns true
+extern int lower_bound_avx2(const uint8_t *data, int count, uint8_t key);
+extern int lower_bound_avx2(const uint16_t *data, int count, uint16_t key);
+extern int lower_bound_avx2(const uint32_t *data, int count, uint32_t key);
+extern int lower_bound_avx2(const uint64_t *data, int count, uint64_t key);
+extern int lower_bound_avx2(const float *data, int count, float key);
+extern int lower_bound_avx2(const double *data, int count, double key);
+
+// The AVX-512 kernels; only call them if os_has_avx512() returns true
+extern int lower_bound_avx512(const uint8_t *data, int count, uint8_t key);
+extern int lower_bound_avx512(const uint16_t *data, int count, uint16_t key);
+extern int lower_bound_avx512(const uint32_t *data, int count, uint32_t key);
+extern int lower_bound_avx512(const uint64_t *data, int count, uint64_t key);
+extern int lower_bound_avx512(const float *data, int count, float key);
+extern int lower_bound_avx512(const double *data, int count, double key);
+
+#endif // HAVE_SSE2
+
+// Returns the index of the first key which is >= |key|, or |count| if
+// all keys are smaller
+template<typename T>
+inline int
+find_lower_bound_simd(const T *data, int count, T key)
+{
+#ifdef HAVE_SSE2
+  typename SimdKernels<T>::LowerBound kernel = SimdKernels<T>::lower_bound;
+  if (likely(kernel != 0))
+    return kernel(data, count, key);
+#endif
+  return (int)(std::lower_bound(data, data + count, key) - data);
+}
+
+// Returns the index of the key, or -1 if the key does not exist. Uses
+// the lower-bound kernel if the CPU supports AVX2, otherwise the SSE
+// search.
+template<typename T>
+inline int
+find_simd(size_t node_count, T *data, const ups_key_t *hkey)
+{
+#ifdef HAVE_SSE2
+  typename SimdKernels<T>::LowerBound kernel = SimdKernels<T>::lower_bound;
+  if (likely(kernel != 0)) {
+    assert(hkey->size == sizeof(T));
+    T key = *(T *)hkey->data;
+    int slot = kernel(data, (int)node_count, key);
+    if (slot < (int)node_count && data[slot] == key)
+      return slot;
+    return -1;
+  }
+#endif
+  return find_simd_sse<T>(node_count, data, hkey);
+}
+
 } // namespace upscaledb
 
 #endif // __SSE__
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * AVX2 lower-bound search kernels (see SimdKernels in simd.h). This file
+ * is compiled with -mavx2.
+ *
+ * AVX2 only compares signed integers; unsigned keys are compared after
+ * flipping their sign bit.
+ */
+
+#include "0root/root.h"
+
+#ifdef HAVE_SSE2
+
+#include <immintrin.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "2simd/simd.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// Returns the index of the first lane which is not set in |mask|; the
+// mask has |bits| bits per lane
+static inline int
+first_clear_lane(uint32_t mask, int bits)
+{
+  return (int)ctz(~mask) / bits;
+}
+
+struct ProbeUint8Avx2 {
+  enum { kLanes = 32, kWindow = 4 * kLanes };
+
+  ProbeUint8Avx2(uint8_t key)
+    : bias(_mm256_set1_epi8((char)0x80)),
+      key32(_mm256_xor_si256(_mm256_set1_epi8((char)key), bias)) {
+  }
+
+  int operator()(const uint8_t *p) const {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias);
+    uint32_t less = (uint32_t)_mm256_movemask_epi8(
+                            _mm256_cmpgt_epi8(key32, v));
+    return less == 0xffffffffu ? kLanes : first_clear_lane(less, 1);
+  }
+
+  __m256i bias;
+  __m256i key32;
+};
+
+struct ProbeUint16Avx2 {
+  enum { kLanes = 16, kWindow = 4 * kLanes };
+
+  ProbeUint16Avx2(uint16_t key)
+    : bias(_mm256_set1_epi16((short)0x8000)),
+      key16(_mm256_xor_si256(_mm256_set1_epi16((short)key), bias)) {
+  }
+
+  int operator()(const uint16_t *p) const {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias);
+    uint32_t less = (uint32_t)_mm256_movemask_epi8(
+                            _mm256_cmpgt_epi16(key16, v));
+    return less == 0xffffffffu ? kLanes : first_clear_lane(less, 2);
+  }
+
+  __m256i bias;
+  __m256i key16;
+};
+
+struct ProbeUint32Avx2 {
+  enum { kLanes = 8, kWindow = 4 * kLanes };
+
+  ProbeUint32Avx2(uint32_t key)
+    : bias(_mm256_set1_epi32((int)0x80000000)),
+      key8(_mm256_xor_si256(_mm256_set1_epi32((int)key), bias)) {
+  }
+
+  int operator()(const uint32_t *p) const {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias);
+    uint32_t less = (uint32_t)_mm256_movemask_ps(
+                            _mm256_castsi256_ps(_mm256_cmpgt_epi32(key8, v)));
+    return less == 0xffu ? kLanes : first_clear_lane(less, 1);
+  }
+
+  __m256i bias;
+  __m256i key8;
+};
+
+struct ProbeUint64Avx2 {
+  enum { kLanes = 4, kWindow = 4 * kLanes };
+
+  ProbeUint64Avx2(uint64_t key)
+    : bias(_mm256_set1_epi64x((long long)0x8000000000000000ull)),
+      key4(_mm256_xor_si256(_mm256_set1_epi64x((long long)key), bias)) {
+  }
+
+  int operator()(const uint64_t *p) const {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias);
+    uint32_t less = (uint32_t)_mm256_movemask_pd(
+                            _mm256_castsi256_pd(_mm256_cmpgt_epi64(key4, v)));
+    return less == 0xfu ? kLanes : first_clear_lane(less, 1);
+  }
+
+  __m256i bias;
+  __m256i key4;
+};
+
+struct ProbeFloatAvx2 {
+  enum { kLanes = 8, kWindow = 4 * kLanes };
+
+  ProbeFloatAvx2(float key)
+    : key8(_mm256_set1_ps(key)) {
+  }
+
+  int operator()(const float *p) const {
+    uint32_t less = (uint32_t)_mm256_movemask_ps(
+                    _mm256_cmp_ps(_mm256_loadu_ps(p), key8, _CMP_LT_OQ));
+    return less == 0xffu ? kLanes : first_clear_lane(less, 1);
+  }
+
+  __m256 key8;
+};
+
+struct ProbeDoubleAvx2 {
+  enum { kLanes = 4, kWindow = 4 * kLanes };
+
+  ProbeDoubleAvx2(double key)
+    : key4(_mm256_set1_pd(key)) {
+  }
+
+  int operator()(const double *p) const {
+    uint32_t less = (uint32_t)_mm256_movemask_pd(
+                    _mm256_cmp_pd(_mm256_loadu_pd(p), key4, _CMP_LT_OQ));
+    return less == 0xfu ? kLanes : first_clear_lane(less, 1);
+  }
+
+  __m256d key4;
+};
+
+int
+lower_bound_avx2(const uint8_t *data, int count, uint8_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint8Avx2(key));
+}
+
+int
+lower_bound_avx2(const uint16_t *data, int count, uint16_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint16Avx2(key));
+}
+
+int
+lower_bound_avx2(const uint32_t *data, int count, uint32_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint32Avx2(key));
+}
+
+int
+lower_bound_avx2(const uint64_t *data, int count, uint64_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint64Avx2(key));
+}
+
+int
+lower_bound_avx2(const float *data, int count, float key)
+{
+  return vector_lower_bound(data, count, key, ProbeFloatAvx2(key));
+}
+
+int
+lower_bound_avx2(const double *data, int count, double key)
+{
+  return vector_lower_bound(data, count, key, ProbeDoubleAvx2(key));
+}
+
+} // namespace upscaledb
+
+#endif // HAVE_SSE2
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * AVX-512 lower-bound search kernels (see SimdKernels in simd.h). This
+ * file is compiled with -mavx512f -mavx512bw.
+ */
+
+#include "0root/root.h"
+
+#ifdef HAVE_SSE2
+
+#include <immintrin.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "2simd/simd.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+// Returns the index of the first lane which is not set in |mask|
+static inline int
+first_clear_lane(uint64_t mask)
+{
+#ifdef WIN32
+  unsigned long index;
+  _BitScanForward64(&index, ~mask);
+  return (int)index;
+#else
+  return __builtin_ctzll(~mask);
+#endif
+}
+
+struct ProbeUint8Avx512 {
+  enum { kLanes = 64, kWindow = 4 * kLanes };
+
+  ProbeUint8Avx512(uint8_t key)
+    : key64(_mm512_set1_epi8((char)key)) {
+  }
+
+  int operator()(const uint8_t *p) const {
+    uint64_t less = _mm512_cmplt_epu8_mask(_mm512_loadu_si512(p), key64);
+    return less == ~(uint64_t)0 ? kLanes : first_clear_lane(less);
+  }
+
+  __m512i key64;
+};
+
+struct ProbeUint16Avx512 {
+  enum { kLanes = 32, kWindow = 4 * kLanes };
+
+  ProbeUint16Avx512(uint16_t key)
+    : key32(_mm512_set1_epi16((short)key)) {
+  }
+
+  int operator()(const uint16_t *p) const {
+    uint64_t less = _mm512_cmplt_epu16_mask(_mm512_loadu_si512(p), key32);
+    return less == 0xffffffffull ? kLanes : first_clear_lane(less);
+  }
+
+  __m512i key32;
+};
+
+struct ProbeUint32Avx512 {
+  enum { kLanes = 16, kWindow = 4 * kLanes };
+
+  ProbeUint32Avx512(uint32_t key)
+    : key16(_mm512_set1_epi32((int)key)) {
+  }
+
+  int operator()(const uint32_t *p) const {
+    uint64_t less = _mm512_cmplt_epu32_mask(_mm512_loadu_si512(p), key16);
+    return less == 0xffffull ? kLanes : first_clear_lane(less);
+  }
+
+  __m512i key16;
+};
+
+struct ProbeUint64Avx512 {
+  enum { kLanes = 8, kWindow = 4 * kLanes };
+
+  ProbeUint64Avx512(uint64_t key)
+    : key8(_mm512_set1_epi64((long long)key)) {
+  }
+
+  int operator()(const uint64_t *p) const {
+    uint64_t less = _mm512_cmplt_epu64_mask(_mm512_loadu_si512(p), key8);
+    return less == 0xffull ? kLanes : first_clear_lane(less);
+  }
+
+  __m512i key8;
+};
+
+struct ProbeFloatAvx512 {
+  enum { kLanes = 16, kWindow = 4 * kLanes };
+
+  ProbeFloatAvx512(float key)
+    : key16(_mm512_set1_ps(key)) {
+  }
+
+  int operator()(const float *p) const {
+    uint64_t less = _mm512_cmp_ps_mask(_mm512_loadu_ps(p), key16,
+                            _CMP_LT_OQ);
+    return less == 0xffffull ? kLanes : first_clear_lane(less);
+  }
+
+  __m512 key16;
+};
+
+struct ProbeDoubleAvx512 {
+  enum { kLanes = 8, kWindow = 4 * kLanes };
+
+  ProbeDoubleAvx512(double key)
+    : key8(_mm512_set1_pd(key)) {
+  }
+
+  int operator()(const double *p) const {
+    uint64_t less = _mm512_cmp_pd_mask(_mm512_loadu_pd(p), key8,
+                            _CMP_LT_OQ);
+    return less == 0xffull ? kLanes : first_clear_lane(less);
+  }
+
+  __m512d key8;
+};
+
+int
+lower_bound_avx512(const uint8_t *data, int count, uint8_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint8Avx512(key));
+}
+
+int
+lower_bound_avx512(const uint16_t *data, int count, uint16_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint16Avx512(key));
+}
+
+int
+lower_bound_avx512(const uint32_t *data, int count, uint32_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint32Avx512(key));
+}
+
+int
+lower_bound_avx512(const uint64_t *data, int count, uint64_t key)
+{
+  return vector_lower_bound(data, count, key, ProbeUint64Avx512(key));
+}
+
+int
+lower_bound_avx512(const float *data, int count, float key)
+{
+  return vector_lower_bound(data, count, key, ProbeFloatAvx512(key));
+}
+
+int
+lower_bound_avx512(const double *data, int count, double key)
+{
+  return vector_lower_bound(data, count, key, ProbeDoubleAvx512(key));
+}
+
+} // namespace upscaledb
+
+#endif // HAVE_SSE2
@@ -17,7 +17,7 @@
  */
 
 /*
- * The worker thread
+ * The pool of worker threads
  */
 
 #ifndef UPS_WORKER_H
@@ -25,10 +25,13 @@
 
 #include "0root/root.h"
 
+#include <algorithm>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/thread/thread.hpp>
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
 #include "2worker/workitem.h"
 
 #ifndef UPS_ROOT_H
@@ -51,28 +54,102 @@ struct WorkerThread {
 };
  
 // the actual thread pool
+//
+// Each thread has its own strand. Work items which are posted to the same
+// strand are executed in order; work items of different strands run
+// in parallel.
 struct WorkerPool {
+#if BOOST_VERSION < 106600
+  typedef boost::asio::strand Strand;
+#else
+  typedef boost::asio::io_context::strand Strand;
+#endif
+
+  enum {
+    // the max. number of threads
+    kMaxThreads = 64
+  };
+
+  // Wraps a work item; keeps track of the pending items
+  template<typename F>
+  struct Task {
+    Task(WorkerPool *pool_, const F &f_)
+      : pool(pool_), f(f_) {
+    }
+
+    void operator()() {
+      try {
+        f();
+      }
+      catch (...) {
+        pool->complete();
+        throw;
+      }
+      pool->complete();
+    }
+
+    WorkerPool *pool;
+    F f;
+  };
+
   // the constructor just launches some amount of workers
   WorkerPool(size_t num_threads)
-    : working(service), strand(service) {
+    : working(service), pending(0) {
+    num_threads = std::max<size_t>(num_threads, 1);
+    for (size_t i = 0; i < num_threads; ++i)
+      strands.push_back(new Strand(service));
     for (size_t i = 0; i < num_threads; ++i)
       workers.push_back(new boost::thread(WorkerThread(*this)));
   }
 
-  // Add a new work item to the pool
+  // Add a new work item to the pool; all items which are added with this
+  // method are executed in order
   template<typename F>
   void enqueue(F &f) {
-    strand.post(f);
+    enqueue(f, 0);
   }
 
-  // the destructor joins all threads
+  // Add a new work item to the pool; |key| selects the strand. Items with
+  // the same key are executed in order.
+  template<typename F>
+  void enqueue(F &f, size_t key) {
+    {
+      ScopedLock lock(mutex);
+      pending++;
+    }
+    strands[key % strands.size()]->post(Task<F>(this, f));
+  }
+
+  // Returns the number of threads (and strands)
+  size_t size() const {
+    return strands.size();
+  }
+
+  // Waits till all work items are completed
+  void wait() {
+    ScopedLock lock(mutex);
+    while (pending > 0)
+      idle.wait(lock);
+  }
+
+  // Called by a Task when its work item was processed
+  void complete() {
+    ScopedLock lock(mutex);
+    if (--pending == 0)
+      idle.notify_all();
+  }
+
+  // the destructor completes all pending work items, then joins all threads
   ~WorkerPool() {
+    wait();
     service.stop();
 
     for (size_t i = 0; i < workers.size(); ++i) {
       workers[i]->join();
       delete workers[i];
     }
+    for (size_t i = 0; i < strands.size(); ++i)
+      delete strands[i];
   }
 
   // keep track of the threads so we can join them
@@ -81,11 +158,18 @@ struct WorkerPool {
   // the io_service we are wrapping
   boost::asio::io_service service;
   boost::asio::io_service::work working;
-#if BOOST_VERSION < 106600
-  boost::asio::strand strand;
-#else
-  boost::asio::io_context::strand strand;
-#endif
+
+  // one strand per thread
+  std::vector<Strand *> strands;
+
+  // protects |pending|
+  Mutex mutex;
+
+  // signalled when the last pending work item was completed
+  Condition idle;
+
+  // number of work items which were not yet completed
+  size_t pending;
 };
 
 inline void
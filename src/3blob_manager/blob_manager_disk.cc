@@ -315,8 +315,11 @@ DiskBlobManager::allocate(Context *context, ups_record_t *record,
   uint32_t record_size = record->size;
   uint32_t original_size = record->size;
 
-  // compression enabled? then try to compress the data
-  Compressor *compressor = context->db->record_compressor.get();
+  // compression enabled? then try to compress the data. Blobs of the
+  // Environment (i.e. the directory of the key filters) have no Database
+  Compressor *compressor = context->db
+                              ? context->db->record_compressor.get()
+                              : 0;
   if (compressor && !(flags & kDisableCompression)) {
     metric_before_compression += record_size;
     uint32_t len = compressor->compress((uint8_t *)record->data,
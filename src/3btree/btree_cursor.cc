@@ -215,6 +215,11 @@ move_next(BtreeCursor *cursor, Context *context, uint32_t flags)
     node = st_.btree->get_node_from_page(page);
   }
 
+  // start loading the next page; the cursor will most likely continue
+  // with the scan
+  if (node->right_sibling())
+    env->page_manager->read_ahead(node->right_sibling());
+
   // couple this cursor to the smallest key in this page
   cursor->couple_to(page, 0, 0);
 
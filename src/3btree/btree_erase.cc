@@ -113,6 +113,8 @@ fall_through:
     assert(slot >= 0);
     assert(slot < (int)node->length());
 
+    latch(page);
+
     // delete the record, but only on leaf nodes! internal nodes don't have
     // records; they point to pages instead, and we do not want to delete
     // those.
@@ -53,13 +53,23 @@ struct BtreeFindAction
   }
 
   ups_status_t run() {
+    // concurrent lookups do not lock the nodes
+    if (context->is_shared_read && !cursor)
+      return run_optimistic();
+
     LocalEnv *env = (LocalEnv *)btree->db()->env;
     Page *page = 0;
     int slot = -1;
     BtreeNodeProxy *node = 0;
 
-    BtreeStatistics *stats = btree->statistics();
-    BtreeStatistics::FindHints hints = stats->find_hints(flags);
+    // concurrent readers neither use nor update the statistics, because
+    // they are not synchronized
+    BtreeStatistics *stats = context->is_shared_read
+                                ? 0
+                                : btree->statistics();
+    BtreeStatistics::FindHints hints = {flags, flags, 0, false};
+    if (stats)
+      hints = stats->find_hints(flags);
 
     if (hints.try_fast_track) {
       /*
@@ -105,7 +115,8 @@ struct BtreeFindAction
         page = btree->find_lower_bound(context, page, key,
                               PageManager::kReadOnly, 0);
         if (unlikely(!page)) {
-          stats->find_failed();
+          if (stats)
+            stats->find_failed();
           return UPS_KEY_NOT_FOUND;
         }
 
@@ -116,7 +127,8 @@ struct BtreeFindAction
       if (flags == 0 || flags == LocalCursor::kSyncDontLoadKey) {
         slot = node->find(context, key);
         if (unlikely(slot == -1)) {
-          stats->find_failed();
+          if (stats)
+            stats->find_failed();
           return UPS_KEY_NOT_FOUND;
         }
 
@@ -152,7 +164,8 @@ struct BtreeFindAction
     }
 
     if (unlikely(slot < 0)) {
-      stats->find_failed();
+      if (stats)
+        stats->find_failed();
       return UPS_KEY_NOT_FOUND;
     }
 
@@ -178,6 +191,120 @@ return_result:
     return 0;
   }
 
+  // Performs a lookup with optimistic lock coupling. Nodes are not locked;
+  // instead the version of each node's latch is retrieved before the node
+  // is read, and validated afterwards. A child is only fetched after the
+  // parent was validated. If an insert or erase modified a node in the
+  // meantime then the lookup is restarted at the root.
+  ups_status_t run_optimistic() {
+    // approx. matching overwrites |key|; the search therefore uses a copy
+    ups_key_t original = *key;
+    ups_key_t search_key = *key;
+    ByteArray search_arena;
+    if (ISSETANY(flags, UPS_FIND_LT_MATCH | UPS_FIND_GT_MATCH)
+            && key->size > 0) {
+      search_arena.copy((uint8_t *)key->data, key->size);
+      search_key.data = search_arena.data();
+    }
+
+    ups_status_t st = 0;
+    while (!try_optimistic(&search_key, &st))
+      *key = original;
+    return st;
+  }
+
+  // Helper for run_optimistic(). Returns false if a concurrent update was
+  // detected and the lookup has to be restarted.
+  bool try_optimistic(ups_key_t *search_key, ups_status_t *pst) {
+    LocalEnv *env = (LocalEnv *)btree->db()->env;
+
+    // the root page can be replaced by a concurrent split
+    Page *page = btree->root_page(context);
+    uint64_t version = page->latch.read_lock();
+    if (unlikely(page != btree->root_page(context)))
+      return false;
+
+    // traverse the tree till a leaf is reached
+    BtreeNodeProxy *node = btree->get_node_from_page(page);
+    while (!node->is_leaf()) {
+      uint64_t child_id;
+      node->find_lower_bound(context, search_key, &child_id);
+      if (unlikely(!page->latch.validate(version)))
+        return false;
+
+      Page *child = env->page_manager->fetch(context, child_id,
+                        PageManager::kReadOnly);
+      uint64_t child_version = child->latch.read_lock();
+      if (unlikely(!page->latch.validate(version)))
+        return false;
+
+      page = child;
+      version = child_version;
+      node = btree->get_node_from_page(page);
+    }
+
+    // search the leaf
+    uint32_t is_approx_match = 0;
+    bool exact = (flags == 0 || flags == LocalCursor::kSyncDontLoadKey);
+    int slot = exact
+                ? node->find(context, search_key)
+                : find(context, page, search_key, flags, &is_approx_match);
+
+    // approx. matching: continue with the left or right sibling
+    if (!exact && (slot == -1 || slot >= (int)node->length())) {
+      uint64_t sibling_id = slot == -1
+                                ? node->left_sibling()
+                                : node->right_sibling();
+      if (unlikely(!page->latch.validate(version)))
+        return false;
+
+      if (sibling_id == 0)
+        slot = -1;
+      else {
+        Page *sibling = env->page_manager->fetch(context, sibling_id,
+                        PageManager::kReadOnly);
+        uint64_t sibling_version = sibling->latch.read_lock();
+        if (unlikely(!page->latch.validate(version)))
+          return false;
+
+        page = sibling;
+        version = sibling_version;
+        node = btree->get_node_from_page(page);
+        if (slot == -1) {
+          slot = node->length() - 1;
+          is_approx_match = BtreeKey::kLower;
+        }
+        else {
+          slot = 0;
+          is_approx_match = BtreeKey::kGreater;
+        }
+      }
+    }
+
+    if (unlikely(slot < 0 || slot >= (int)node->length())) {
+      if (unlikely(!page->latch.validate(version)))
+        return false;
+      *pst = UPS_KEY_NOT_FOUND;
+      return true;
+    }
+
+    // copy the key and the record, then verify that the leaf was not
+    // modified in the meantime
+    if (is_approx_match) {
+      ups_key_set_intflags(key, is_approx_match);
+      if (NOTSET(flags, LocalCursor::kSyncDontLoadKey))
+        node->key(context, slot, key_arena, key);
+    }
+
+    if (likely(record != 0))
+      node->record(context, slot, record_arena, record, flags);
+
+    if (unlikely(!page->latch.validate(version)))
+      return false;
+    *pst = 0;
+    return true;
+  }
+
   // Searches a leaf node for a key.
   //
   // !!!
@@ -42,7 +42,10 @@ struct BtreeKey {
     kExtendedKey          = 0x01,
 
     // key is compressed; the original size is stored in the payload
-    kCompressed           = 0x08
+    kCompressed           = 0x08,
+
+    // the common prefix of the node was stripped from the key
+    kPrefixed             = 0x10
   };
 
   // flags used with the ups_key_t::_flags (note the underscore - this
@@ -100,6 +100,46 @@ struct PaxNodeImpl : public BaseNodeImpl<KeyList, RecordList> {
     return P::node->length() >= P::estimated_capacity;
   }
 
+  // The following methods update the search index of the KeyList after
+  // the keys were modified. The node's length is updated by the caller.
+
+  // Inserts a new key
+  template<typename Cmp>
+  PBtreeNode::InsertResult insert(Context *context, ups_key_t *key,
+                  uint32_t flags, Cmp &comparator) {
+    PBtreeNode::InsertResult result = P::insert(context, key, flags,
+                    comparator);
+    if (result.status == 0)
+      P::keys.update_index(P::node->length() + 1);
+    return result;
+  }
+
+  // Erases a key
+  void erase(Context *context, int slot) {
+    P::erase(context, slot);
+    P::keys.update_index(P::node->length() - 1);
+  }
+
+  // Splits a node and moves parts of the current node into |other|,
+  // starting at the |pivot| slot
+  void split(Context *context, PaxNodeImpl *other, int pivot) {
+    size_t node_length = P::node->length();
+    P::split(context, other, pivot);
+
+    // in internal nodes the pivot element is not copied
+    P::keys.update_index(pivot);
+    other->keys.update_index(P::node->is_leaf()
+                    ? node_length - pivot
+                    : node_length - pivot - 1);
+  }
+
+  // Merges this node with the |other| node
+  void merge_from(Context *context, PaxNodeImpl *other) {
+    P::merge_from(context, other);
+    P::keys.update_index(P::node->length() + other->node->length());
+    other->keys.update_index(0);
+  }
+
   void initialize() {
     uint32_t usable_nodesize = P::page->usable_page_size()
                   - PBtreeNode::entry_offset();
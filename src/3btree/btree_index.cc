@@ -41,12 +41,15 @@ namespace upscaledb {
 Page *
 BtreeIndex::root_page(Context *context)
 {
-  if (unlikely(state.root_page == 0))
-    state.root_page = state.page_manager->fetch(context,
+  Page *page = state.root_page.load();
+  if (unlikely(page == 0)) {
+    page = state.page_manager->fetch(context,
                             state.btree_header->root_address);
-  else
-    context->changeset.put(state.root_page);
-  return state.root_page;
+    state.root_page = page;
+  }
+  else if (!context->is_shared_read)
+    context->changeset.put(page);
+  return page;
 }
 
 void
@@ -86,6 +89,7 @@ BtreeIndex::open(PBtreeHeader *btree_header, DbConfig *dbconfig)
   dbconfig->record_type = btree_header->record_type;
   dbconfig->record_size = btree_header->record_size;
   dbconfig->record_compressor = btree_header->record_compression();
+  dbconfig->key_filter_bits = btree_header->key_filter_bits;
 
   assert(dbconfig->key_size > 0);
 
@@ -109,6 +113,7 @@ BtreeIndex::persist_configuration(Context *context, const DbConfig *dbconfig)
           = CallbackManager::hash(dbconfig->compare_name);
   state.btree_header->set_record_compression(dbconfig->record_compressor);
   state.btree_header->set_key_compression(dbconfig->key_compressor);
+  state.btree_header->key_filter_bits = (uint8_t)dbconfig->key_filter_bits;
 }
 
 Page *
@@ -23,6 +23,8 @@
 
 #include <algorithm>
 
+#include <boost/atomic.hpp>
+
 // Always verify that a file of level N does not include headers > N!
 #include "1base/abi.h"
 #include "1base/dynamic_array.h"
@@ -94,8 +96,8 @@ UPS_PACK_0 struct UPS_PACK_1 PBtreeHeader {
   // for storing key and record compression algorithm */
   uint8_t compression;
 
-  // reserved
-  uint8_t _reserved1;
+  // bits per key of the key filter (see UPS_PARAM_KEY_FILTER_BITS)
+  uint8_t key_filter_bits;
 
   // the record size
   uint32_t record_size;
@@ -155,11 +157,16 @@ struct BtreeIndexState {
   // the index of the PBtreeHeader in the Environment's header page
   PBtreeHeader *btree_header;
 
-  // the root page of the Btree
-  Page *root_page;
+  // the root page of the Btree; atomic because concurrent readers
+  // can observe a root split
+  boost::atomic<Page *> root_page;
 
   // the btree statistics
   BtreeStatistics statistics;
+
+  // serializes the creation of BtreeNodeProxy objects; required if
+  // lookups run concurrently (see UPS_ENABLE_CONCURRENT_READS)
+  Spinlock node_proxy_mutex;
 };
 
 //
@@ -269,10 +276,14 @@ struct BtreeIndex {
 
   // Returns a BtreeNodeProxy for a Page
   BtreeNodeProxy *get_node_from_page(Page *page) {
-    if (likely(page->node_proxy() != 0))
+    BtreeNodeProxy *proxy = page->node_proxy();
+    if (likely(proxy != 0))
+      return proxy;
+
+    ScopedSpinlock lock(state.node_proxy_mutex);
+    if (page->node_proxy() != 0)
       return page->node_proxy();
 
-    BtreeNodeProxy *proxy;
     PBtreeNode *node = PBtreeNode::from_page(page);
     if (node->is_leaf())
       proxy = leaf_node_from_page_impl(page);
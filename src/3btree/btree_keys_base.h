@@ -63,6 +63,11 @@ struct BaseKeyList : BaseList {
   void erase_extended_key(Context *context, int slot) const {
   }
 
+  // Updates the in-memory search index after the keys were modified;
+  // nothing to do here
+  void update_index(size_t node_count) {
+  }
+
   template<typename Cmp>
   int find_lower_bound(Context *context, size_t node_count,
                   const ups_key_t *hkey, Cmp &comparator, int *pcmp) {
@@ -24,6 +24,10 @@
  * C array of type uint32_t[]. Each key has zero overhead.
  *
  * This KeyList cannot be resized.
+ *
+ * Internal nodes with many keys are additionally indexed by a small
+ * in-memory search tree (the PodBlockIndex), which reduces the number of
+ * cache lines touched by a lookup.
  */
 
 #ifndef UPS_BTREE_KEYS_POD_H
@@ -33,6 +37,7 @@
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1globals/globals.h"
@@ -47,6 +52,163 @@
 
 namespace upscaledb {
 
+//
+// A search tree for the sorted keys of a node ("B+-tree in a page"). The
+// keys are grouped in blocks of one cache line; each level of the tree
+// stores the largest key of every block of the level below. A lookup
+// descends from the top level and scans a single cache line per level,
+// whereas a binary search on a large node touches a new cache line with
+// almost every probe.
+//
+// The index is not persisted, therefore the file format does not change.
+// It is built when the node is opened and rebuilt whenever the keys are
+// modified. It is only valid for the number of keys it was built for.
+//
+// The index is not used if updates run in parallel to lookups (see
+// LocalDb::may_write_concurrently): a concurrent lookup could read
+// the buffer while it is reallocated by a split.
+//
+template<typename T>
+struct PodBlockIndex {
+  enum {
+    // the size of a cache line
+    kCacheLineSize = 64,
+
+    // number of keys per block
+    kBlockSize = kCacheLineSize / sizeof(T),
+
+    // nodes with fewer keys are not indexed
+    kMinKeys = 4 * kBlockSize,
+
+    // max. number of levels
+    kMaxLevels = 16
+  };
+
+  // Constructor
+  PodBlockIndex()
+    : _data(0), _capacity(0), count(0), num_levels(0) {
+  }
+
+  // Destructor
+  ~PodBlockIndex() {
+    Memory::release(_data);
+  }
+
+  // The index owns |_data| and cannot be copied
+  PodBlockIndex(const PodBlockIndex &) = delete;
+  PodBlockIndex &operator=(const PodBlockIndex &) = delete;
+
+  // Returns true if the index can be used for |node_count| keys
+  bool is_valid(size_t node_count) const {
+    return num_levels > 0 && count == node_count;
+  }
+
+  // Discards the index
+  void clear() {
+    count = 0;
+    num_levels = 0;
+  }
+
+  // Builds the index for the |node_count| sorted |keys|
+  void build(const T *keys, size_t node_count) {
+    clear();
+    if (node_count < kMinKeys)
+      return;
+
+    // calculate the size of each level; the top level fits into a
+    // single block. Each level is padded to a full block, and the whole
+    // index is aligned to a cache line.
+    size_t total = 0;
+    int levels = 0;
+    size_t tmp_sizes[kMaxLevels];
+    for (size_t n = node_count; n > kBlockSize; ) {
+      n = (n + kBlockSize - 1) / kBlockSize;
+      assert(levels < kMaxLevels);
+      tmp_sizes[levels++] = n;
+      total += (n + kBlockSize - 1) / kBlockSize * kBlockSize;
+    }
+
+    // the index is optional; if memory is exhausted then the node is
+    // searched without it
+    if (total > _capacity) {
+      Memory::release(_data);
+      _data = 0;
+      _capacity = 0;
+      try {
+        _data = Memory::allocate_aligned<T>(total * sizeof(T),
+                        kCacheLineSize);
+      }
+      catch (Exception &) {
+        return;
+      }
+      _capacity = total;
+    }
+
+    // the levels are stored top-down
+    size_t offset = 0;
+    for (int l = 0; l < levels; l++) {
+      sizes[l] = tmp_sizes[levels - l - 1];
+      offsets[l] = offset;
+      offset += (sizes[l] + kBlockSize - 1) / kBlockSize * kBlockSize;
+    }
+
+    // then fill them bottom-up
+    const T *below = keys;
+    size_t below_size = node_count;
+    for (int l = levels - 1; l >= 0; l--) {
+      T *level = &_data[offsets[l]];
+      for (size_t i = 0; i < sizes[l]; i++)
+        level[i] = below[std::min((i + 1) * kBlockSize, below_size) - 1];
+      below = level;
+      below_size = sizes[l];
+    }
+
+    count = node_count;
+    num_levels = levels;
+  }
+
+  // Returns the index of the first key which is >= |key|, or the number
+  // of keys if all keys are smaller
+  int lower_bound(const T *keys, T key) const {
+    assert(num_levels > 0);
+    size_t slot = 0;
+
+    for (int l = 0; l < num_levels; l++) {
+      const T *level = &_data[offsets[l]];
+      size_t end = std::min(slot + kBlockSize, sizes[l]);
+      while (slot < end && level[slot] < key)
+        slot++;
+      // the largest key of the node is smaller than |key|
+      if (unlikely(slot == end))
+        return (int)count;
+      slot *= kBlockSize;
+    }
+
+    size_t end = std::min(slot + kBlockSize, count);
+    while (slot < end && keys[slot] < key)
+      slot++;
+    return (int)slot;
+  }
+
+  // The levels of the tree, stored top-down
+  T *_data;
+
+  // The capacity of |_data|, in number of keys
+  size_t _capacity;
+
+  // The number of keys which are indexed
+  size_t count;
+
+  // The number of levels
+  int num_levels;
+
+  // The number of entries of each level
+  size_t sizes[kMaxLevels];
+
+  // The offset of each level in |_data|
+  size_t offsets[kMaxLevels];
+};
+
 //
 // The PodKeyList provides simplified access to a list of keys where each
 // key is of type T (i.e. uint32_t).
@@ -80,9 +242,19 @@ struct PodKeyList : BaseKeyList {
   }
 
   // Opens an existing PodKeyList starting at |ptr|
-  void open(uint8_t *ptr, size_t range_size_, size_t) {
+  void open(uint8_t *ptr, size_t range_size_, size_t node_count) {
     _data = (T *)ptr;
     range_size = range_size_;
+    update_index(node_count);
+  }
+
+  // Rebuilds the PodBlockIndex after the keys were modified; only
+  // internal nodes are indexed, and only if lookups cannot run in
+  // parallel to updates
+  void update_index(size_t node_count) {
+    if (node->is_leaf() || db->may_write_concurrently())
+      return;
+    index.build(_data, node_count);
   }
 
   // Returns the required size for the current set of keys
@@ -100,11 +272,12 @@ struct PodKeyList : BaseKeyList {
   // Searches the node for the key and returns the slot of this key
   // - only for exact matches!
   //
-  // This is the SIMD implementation. If SIMD is disabled then the
-  // BaseKeyList::find method is used.
+  // This is the SIMD implementation; it uses the AVX2/AVX-512 kernels
+  // if the CPU supports them. If SIMD is disabled then std::lower_bound
+  // is used.
   template<typename Cmp>
   int find(Context *, size_t node_count, const ups_key_t *key, Cmp &) {
-    return find_simd_sse<T>(node_count, &_data[0], key);
+    return find_simd<T>(node_count, &_data[0], key);
   }
 #else
   template<typename Cmp>
@@ -122,7 +295,16 @@ struct PodKeyList : BaseKeyList {
   int find_lower_bound(Context *, size_t node_count, const ups_key_t *hkey,
                   Cmp &, int *pcmp) {
     T key = *(T *)hkey->data;
-    T *result = std::lower_bound(&_data[0], &_data[node_count], key);
+    T *result;
+    if (index.is_valid(node_count))
+      result = &_data[0] + index.lower_bound(&_data[0], key);
+    else
+#ifdef __SSE__
+      result = &_data[0] + find_lower_bound_simd<T>(&_data[0],
+                                    (int)node_count, key);
+#else
+      result = std::lower_bound(&_data[0], &_data[node_count], key);
+#endif
     if (unlikely(result == &_data[node_count])) {
       if (key > _data[node_count - 1]) {
         *pcmp = +1;
@@ -236,6 +418,9 @@ struct PodKeyList : BaseKeyList {
 
   // The actual array of T's
   T *_data;
+
+  // The search tree for internal nodes
+  PodBlockIndex<T> index;
 };
 
 } // namespace upscaledb
@@ -34,6 +34,14 @@
  * To avoid expensive memcpy-operations, erasing a key only affects this
  * upfront index: the relevant slot is moved to a "freelist". This freelist
  * contains the same meta information as the index table.
+ *
+ * With prefix compression (UPS_COMPRESSOR_PREFIX) the range starts with
+ * the common prefix of the node's keys, followed by the upfront index:
+ *   |PrefixLength|Prefix...|UpfrontIndex...|
+ * Keys which start with this prefix are stored without it and have the
+ * flag BtreeKey::kPrefixed. The prefix is only extended when the node is
+ * rearranged (see vacuumize()); keys which do not share the prefix are
+ * stored in full. Extended keys are always stored in full.
  */
 
 #ifndef UPS_BTREE_KEYS_VARLEN_H
@@ -76,6 +84,12 @@ namespace upscaledb {
 // The key size (as specified by the user when inserting the key) therefore
 // is UpfrontIndex::get_chunk_size() - 1.
 //
+// With UPS_ENABLE_NORMALIZED_KEYS, each slot of the UpfrontIndex also
+// stores the first 4 bytes of the (full) key as a big-endian integer
+// (see normalize()). Comparing these integers gives the same order as
+// comparing the keys; only if they are equal then the full keys have to
+// be compared.
+//
 struct VariableLengthKeyList : BaseKeyList {
   // for caching external keys
   typedef std::map<uint64_t, ByteArray> ExtKeyCache;
@@ -83,18 +97,31 @@ struct VariableLengthKeyList : BaseKeyList {
   enum {
     // This KeyList can reduce its capacity in order to release storage
     kCanReduceCapacity = 1,
+
+    // This KeyList has a custom find() implementation
+    kCustomFind = 1,
+
+    // This KeyList has a custom find_lower_bound() implementation
+    kCustomFindLowerBound = 1,
   };
 
   // Constructor
   VariableLengthKeyList(LocalDb *db, PBtreeNode *node)
-    : BaseKeyList(db, node), _index(db), _data(0) {
+    : BaseKeyList(db, node),
+      _index(db, ISSET(db->config.flags, UPS_ENABLE_NORMALIZED_KEYS)),
+      _data(0) {
     LocalEnv *env = (LocalEnv *)db->env;
     _blob_manager = env->blob_manager.get();
 
     size_t page_size = env->config.page_size_bytes;
     int algo = db->config.key_compressor;
-    if (algo)
-      _compressor.reset(CompressorFactory::create(algo));
+    if (algo == UPS_COMPRESSOR_PREFIX)
+      _prefix_range_size = std::min(page_size / 128, (size_t)256);
+    else {
+      _prefix_range_size = 0;
+      if (algo)
+        _compressor.reset(CompressorFactory::create(algo));
+    }
     if (unlikely(Globals::ms_extended_threshold))
       _extkey_threshold = Globals::ms_extended_threshold;
     else {
@@ -115,19 +142,23 @@ struct VariableLengthKeyList : BaseKeyList {
   void create(uint8_t *ptr, size_t range_size_) {
     _data = ptr;
     range_size = range_size_;
-    _index.create(_data, range_size, range_size / full_key_size());
+    if (_prefix_range_size)
+      _data[0] = 0;
+    size_t index_range_size = range_size - _prefix_range_size;
+    _index.create(_data + _prefix_range_size, index_range_size,
+                    index_range_size / full_key_size());
   }
 
   // Opens an existing KeyList
   void open(uint8_t *ptr, size_t range_size_, size_t node_count) {
     _data = ptr;
     range_size = range_size_;
-    _index.open(_data, range_size);
+    _index.open(_data + _prefix_range_size, range_size - _prefix_range_size);
   }
 
   // Calculates the required size for a range
   size_t required_range_size(size_t node_count) const {
-    return _index.required_range_size(node_count);
+    return _prefix_range_size + _index.required_range_size(node_count);
   }
 
   // Returns the actual key size including overhead. This is an estimate
@@ -160,6 +191,22 @@ struct VariableLengthKeyList : BaseKeyList {
         uncompress(&tmp, &tmp);
     }
 
+    // prepend the node's prefix; the key is assembled in |arena|, unless
+    // the caller provided the memory
+    if (ISSET(*p, BtreeKey::kPrefixed)) {
+      size_t size = prefix_size() + tmp.size;
+      uint8_t *ptr;
+      if (deep_copy && ISSET(dest->flags, UPS_KEY_USER_ALLOC))
+        ptr = (uint8_t *)dest->data;
+      else
+        ptr = (uint8_t *)arena->resize(size);
+      ::memcpy(ptr, prefix_data(), prefix_size());
+      ::memcpy(ptr + prefix_size(), tmp.data, tmp.size);
+      dest->size = (uint16_t)size;
+      dest->data = ptr;
+      return;
+    }
+
     dest->size = tmp.size;
 
     if (likely(deep_copy == false)) {
@@ -175,6 +222,61 @@ struct VariableLengthKeyList : BaseKeyList {
     ::memcpy(dest->data, tmp.data, tmp.size);
   }
 
+  // Returns the normalized prefix of a key: the first 4 bytes as a
+  // big-endian integer, padded with zeroes. If normalize(a) < normalize(b)
+  // then a < b (if the keys are compared with memcmp, and shorter keys
+  // are sorted first).
+  static uint32_t normalize(const ups_key_t *key) {
+    const uint8_t *p = (const uint8_t *)key->data;
+    uint32_t n = 0;
+    for (size_t i = 0; i < sizeof(uint32_t); i++)
+      n = (n << 8) | (i < key->size ? p[i] : 0);
+    return n;
+  }
+
+  // Performs a lower-bound search for a key. Returns the last slot which
+  // is <= |key|, or -1 if |key| is smaller than all keys. |*pcmp| is
+  // the result of the comparison with that slot.
+  template<typename Cmp>
+  int find_lower_bound(Context *context, size_t node_count,
+                  const ups_key_t *key, Cmp &comparator, int *pcmp) {
+    uint32_t tag = _index.has_tags() ? normalize(key) : 0;
+    ByteArray arena;
+    int left = 0;
+    int right = (int)node_count;
+
+    // the result is in [left - 1, right - 1]
+    while (left < right) {
+      int middle = (left + right) / 2;
+      int cmp = compare(context, key, tag, middle, comparator, &arena);
+      if (cmp == 0) {
+        *pcmp = 0;
+        return middle;
+      }
+      if (cmp < 0)
+        right = middle;
+      else
+        left = middle + 1;
+    }
+
+    if (left == 0) {
+      *pcmp = -1;
+      return -1;
+    }
+    *pcmp = +1;
+    return left - 1;
+  }
+
+  // Searches the node for the key and returns the slot of this key
+  // - only for exact matches!
+  template<typename Cmp>
+  int find(Context *context, size_t node_count, const ups_key_t *key,
+                  Cmp &comparator) {
+    int cmp;
+    int slot = find_lower_bound(context, node_count, key, comparator, &cmp);
+    return cmp == 0 ? slot : -1;
+  }
+
   // Iterates all keys, calls the |visitor| on each. Not supported by
   // this KeyList implementation. For variable length keys, the caller
   // must iterate over all keys. The |scan()| interface is only implemented
@@ -217,6 +319,22 @@ struct VariableLengthKeyList : BaseKeyList {
     node_count++;
 
     uint32_t key_flags = 0;
+    const ups_key_t *full_key = key;
+
+    // strip the node's prefix, but only if the full key is also small
+    // enough to be stored inline (see copy_to())
+    ups_key_t suffix = {0};
+    size_t prefix_length = prefix_size();
+    if (prefix_length > 0
+          && key->size >= prefix_length
+          && key->size <= _extkey_threshold
+          && ::memcmp(key->data, prefix_data(), prefix_length) == 0) {
+      suffix.data = (uint8_t *)key->data + prefix_length;
+      suffix.size = (uint16_t)(key->size - prefix_length);
+      key_flags = BtreeKey::kPrefixed;
+      key = &suffix;
+    }
+
     // try to compress the key
     ups_key_t helper = {0};
     if (_compressor && compress(key, &helper)) {
@@ -234,12 +352,20 @@ struct VariableLengthKeyList : BaseKeyList {
       ::memcpy(p + 1, key->data, key->size);
     }
     else {
+      // extended keys are stored in full
+      if (ISSET(key_flags, BtreeKey::kPrefixed)) {
+        key_flags &= ~BtreeKey::kPrefixed;
+        key = full_key;
+      }
       uint64_t blob_id = add_extended_key(context, key);
       _index.allocate_space(node_count, slot, 8 + 1);
       set_extended_blob_id(slot, blob_id);
       set_key_flags(slot, key_flags | BtreeKey::kExtendedKey);
     }
 
+    if (_index.has_tags())
+      _index.set_chunk_tag(slot, normalize(full_key));
+
     return PBtreeNode::InsertResult(0, slot);
   }
 
@@ -273,6 +399,18 @@ struct VariableLengthKeyList : BaseKeyList {
     // UpfrontIndex
     dest._index.change_range_size(other_node_count, 0, 0, _index.capacity());
 
+    // an empty node inherits the prefix, and the keys are copied as they
+    // are. Otherwise the keys are re-encoded with the prefix of |dest|
+    // (if the prefixes differ).
+    if (_prefix_range_size && other_node_count == 0)
+      ::memcpy(dest._data, _data, prefix_size() + 1);
+    bool reencode = _prefix_range_size
+            && (dest.prefix_size() != prefix_size()
+                || ::memcmp(dest.prefix_data(), prefix_data(),
+                            prefix_size()) != 0);
+
+    ByteArray arena;
+
     for (size_t i = 0; i < to_copy; i++) {
       size_t size = key_size(sstart + i);
 
@@ -281,6 +419,26 @@ struct VariableLengthKeyList : BaseKeyList {
       uint8_t flags = *p;
       uint8_t *data = p + 1;
 
+      if (reencode && NOTSET(flags, BtreeKey::kExtendedKey)) {
+        // restore the full key...
+        if (ISSET(flags, BtreeKey::kPrefixed)) {
+          arena.resize(prefix_size() + size);
+          ::memcpy(arena.data(), prefix_data(), prefix_size());
+          ::memcpy(arena.data() + prefix_size(), data, size);
+          data = arena.data();
+          size += prefix_size();
+          flags &= ~BtreeKey::kPrefixed;
+        }
+        // ... and strip the prefix of |dest|
+        if (dest.prefix_size() > 0
+              && size >= dest.prefix_size()
+              && ::memcmp(data, dest.prefix_data(), dest.prefix_size()) == 0) {
+          data += dest.prefix_size();
+          size -= dest.prefix_size();
+          flags |= BtreeKey::kPrefixed;
+        }
+      }
+
       dest._index.insert(other_node_count + i, dstart + i);
       // Add 1 byte for key flags
       uint32_t offset = dest._index.allocate_space(other_node_count + i + 1,
@@ -288,11 +446,17 @@ struct VariableLengthKeyList : BaseKeyList {
       p = dest._index.get_chunk_data_by_offset(offset);
       *p = flags; // sets flags
       ::memcpy(p + 1, data, size); // and data
+      if (_index.has_tags())
+        dest._index.set_chunk_tag(dstart + i, _index.get_chunk_tag(sstart + i));
     }
 
     // A lot of keys will be invalidated after copying, therefore make
     // sure that the next_offset is recalculated when it's required
     _index.invalidate_next_offset();
+
+    // the copied keys might share a longer prefix
+    if (_prefix_range_size && other_node_count == 0)
+      dest.extend_prefix(to_copy);
   }
 
   // Checks the integrity of this node. Throws an exception if there is a
@@ -303,8 +467,20 @@ struct VariableLengthKeyList : BaseKeyList {
     // verify that the offsets and sizes are not overlapping
     _index.check_integrity(node_count);
 
+    if (prefix_size() >= _prefix_range_size && _prefix_range_size > 0) {
+      ups_log(("prefix size %d exceeds the prefix range",
+                              (int)prefix_size()));
+      throw Exception(UPS_INTEGRITY_VIOLATED);
+    }
+
     // make sure that extkeys are handled correctly
     for (size_t i = 0; i < node_count; i++) {
+      if (ISSET(get_key_flags(i), BtreeKey::kPrefixed)
+            && ISSET(get_key_flags(i), BtreeKey::kExtendedKey)) {
+        ups_log(("extended key %d must not be prefixed", (int)i));
+        throw Exception(UPS_INTEGRITY_VIOLATED);
+      }
+
       if (key_size(i) > _extkey_threshold
             && NOTSET(get_key_flags(i), BtreeKey::kExtendedKey)) {
         ups_log(("key size %d, but key is not extended", key_size(i)));
@@ -338,13 +514,35 @@ struct VariableLengthKeyList : BaseKeyList {
           }
         }
       }
+
+      // verify the normalized prefix of inline keys which are not
+      // compressed
+      if (_index.has_tags()
+            && NOTSET(get_key_flags(i), BtreeKey::kExtendedKey)
+            && NOTSET(get_key_flags(i), BtreeKey::kCompressed)) {
+        size_t skip = ISSET(get_key_flags(i), BtreeKey::kPrefixed)
+                          ? prefix_size()
+                          : 0;
+        arena.resize(skip + key_size(i));
+        ::memcpy(arena.data(), prefix_data(), skip);
+        ::memcpy(arena.data() + skip, key_data(i), key_size(i));
+        ups_key_t key = ups_make_key(arena.data(),
+                        (uint16_t)(skip + key_size(i)));
+        if (normalize(&key) != _index.get_chunk_tag(i)) {
+          ups_log(("normalized prefix of key %d is invalid", (int)i));
+          throw Exception(UPS_INTEGRITY_VIOLATED);
+        }
+      }
     }
   }
 
-  // Rearranges the list
+  // Rearranges the list; also tries to extend the common prefix
   void vacuumize(size_t node_count, bool force) {
-    if (force)
+    if (force) {
+      if (_prefix_range_size)
+        extend_prefix(node_count);
       _index.increase_vacuumize_counter(100);
+    }
     _index.maybe_vacuumize(node_count);
   }
 
@@ -352,9 +550,11 @@ struct VariableLengthKeyList : BaseKeyList {
   // copied as necessary
   void change_range_size(size_t node_count, uint8_t *new_data_ptr,
                   size_t new_range_size, size_t capacity_hint) {
+    size_t index_range_size = new_range_size - _prefix_range_size;
+
     // no capacity given? then try to find a good default one
     if (capacity_hint == 0) {
-      capacity_hint = (new_range_size - _index.next_offset(node_count)
+      capacity_hint = (index_range_size - _index.next_offset(node_count)
               - full_key_size()) / _index.full_index_size();
       if (capacity_hint <= node_count)
         capacity_hint = node_count + 1;
@@ -365,13 +565,21 @@ struct VariableLengthKeyList : BaseKeyList {
     if (_index.next_offset(node_count) + full_key_size(0)
                     + capacity_hint * _index.full_index_size()
                     + UpfrontIndex::kPayloadOffset
-              > new_range_size)
+              > index_range_size)
       capacity_hint = node_count + 1;
 
-    _index.change_range_size(node_count, new_data_ptr, new_range_size,
-                      capacity_hint);
+    // the prefix is saved while the index is moved
+    uint8_t prefix[256];
+    if (_prefix_range_size)
+      ::memcpy(prefix, _data, prefix_size() + 1);
+
+    _index.change_range_size(node_count, new_data_ptr + _prefix_range_size,
+                    index_range_size, capacity_hint);
     _data = new_data_ptr;
     range_size = new_range_size;
+
+    if (_prefix_range_size)
+      ::memcpy(_data, prefix, prefix[0] + 1);
   }
 
   // Fills the btree_metrics structure
@@ -386,15 +594,128 @@ struct VariableLengthKeyList : BaseKeyList {
 
   // Prints a slot to |out| (for debugging)
   void print(Context *context, int slot, std::stringstream &out) {
+    ByteArray arena;
     ups_key_t tmp = {0};
-    if (ISSET(get_key_flags(slot), BtreeKey::kExtendedKey)) {
-      get_extended_key(context, get_extended_blob_id(slot), &tmp);
+    key(context, slot, &arena, &tmp, false);
+    out << std::string((const char *)tmp.data, tmp.size);
+  }
+
+  // Returns the size of the node's common prefix
+  size_t prefix_size() const {
+    return _prefix_range_size ? _data[0] : 0;
+  }
+
+  // Returns a pointer to the node's common prefix
+  uint8_t *prefix_data() const {
+    return _data + 1;
+  }
+
+  // Extends the node's common prefix as far as possible. If there are
+  // prefixed keys then the new prefix starts with the old one, otherwise
+  // it's calculated from all inline keys. The keys are shortened in
+  // place; they never grow.
+  void extend_prefix(size_t node_count) {
+    size_t max_size = _prefix_range_size - 1;
+    size_t old_size = prefix_size();
+
+    if (node_count == 0) {
+      _data[0] = 0;
+      return;
     }
-    else {
-      tmp.size = key_size(slot);
-      tmp.data = key_data(slot);
+
+    bool has_prefixed = false;
+    for (size_t i = 0; i < node_count && !has_prefixed; i++)
+      has_prefixed = ISSET(get_key_flags(i), BtreeKey::kPrefixed);
+
+    // calculate the common prefix of the candidates; |first| is the
+    // (full) first candidate
+    uint8_t first[256];
+    size_t size = 0;
+    bool initialized = false;
+    for (size_t i = 0; i < node_count; i++) {
+      uint8_t flags = get_key_flags(i);
+      if (ISSET(flags, BtreeKey::kExtendedKey)
+            || (has_prefixed && NOTSET(flags, BtreeKey::kPrefixed)))
+        continue;
+
+      const uint8_t *data = key_data(i);
+      size_t length = key_size(i);
+      size_t skip = ISSET(flags, BtreeKey::kPrefixed) ? old_size : 0;
+
+      if (!initialized) {
+        // the new prefix starts with the old prefix
+        size = std::min(max_size, skip + length);
+        if (skip)
+          ::memcpy(first, prefix_data(), skip);
+        ::memcpy(first + skip, data, size - skip);
+        initialized = true;
+        continue;
+      }
+
+      // the old prefix is shared by all prefixed keys
+      size_t j = skip;
+      size_t end = std::min(size, skip + length);
+      while (j < end && first[j] == data[j - skip])
+        j++;
+      size = j;
+      if (size == old_size && has_prefixed)
+        return;
     }
-    out << (const char *)tmp.data;
+
+    if (!initialized || (has_prefixed && size <= old_size))
+      return;
+    if (!has_prefixed && size == 0) {
+      _data[0] = 0;
+      return;
+    }
+
+    // now strip the prefix from the keys; they are shifted to the start
+    // of their chunk, and the chunk is shrinked
+    for (size_t i = 0; i < node_count; i++) {
+      uint8_t flags = get_key_flags(i);
+      if (ISSET(flags, BtreeKey::kExtendedKey))
+        continue;
+
+      size_t strip;
+      if (ISSET(flags, BtreeKey::kPrefixed))
+        strip = size - old_size;
+      else if (key_size(i) >= size
+              && ::memcmp(key_data(i), first, size) == 0)
+        strip = size;
+      else
+        continue;
+
+      uint8_t *data = key_data(i);
+      size_t length = key_size(i) - strip;
+      ::memmove(data, data + strip, length);
+      set_key_size(i, length);
+      set_key_flags(i, flags | BtreeKey::kPrefixed);
+    }
+
+    _data[0] = (uint8_t)size;
+    ::memcpy(prefix_data(), first, size);
+
+    // the chunks were shrinked; the gaps are removed when the index is
+    // vacuumized
+    _index.invalidate_next_offset();
+    _index.increase_vacuumize_counter(100);
+  }
+
+  // Compares |key| with the key at |slot|. If normalized keys are enabled
+  // then |tag| is the normalized prefix of |key|; the full keys are only
+  // compared if the normalized prefixes are equal.
+  template<typename Cmp>
+  int compare(Context *context, const ups_key_t *key, uint32_t tag,
+                  int slot, Cmp &comparator, ByteArray *arena) {
+    if (_index.has_tags()) {
+      uint32_t other = _index.get_chunk_tag(slot);
+      if (tag != other)
+        return tag < other ? -1 : +1;
+    }
+
+    ups_key_t tmp = {0};
+    this->key(context, slot, arena, &tmp, false);
+    return comparator(key->data, key->size, tmp.data, tmp.size);
   }
 
   // Returns the pointer to a key's inline data (const flavour)
@@ -455,15 +776,21 @@ struct VariableLengthKeyList : BaseKeyList {
 
   // Retrieves the extended key at |blobid| and stores it in |key|; will
   // use the cache.
+  //
+  // The cache is locked because concurrent readers can modify it (see
+  // UPS_ENABLE_CONCURRENT_READS). Cached keys are only erased by writers.
   void get_extended_key(Context *context, uint64_t blob_id, ups_key_t *key) {
-    if (unlikely(!_extkey_cache))
-      _extkey_cache.reset(new ExtKeyCache());
-    else {
-      ExtKeyCache::iterator it = _extkey_cache->find(blob_id);
-      if (it != _extkey_cache->end()) {
-        key->size = it->second.size();
-        key->data = it->second.data();
-        return;
+    {
+      ScopedSpinlock lock(_extkey_mutex);
+      if (unlikely(!_extkey_cache))
+        _extkey_cache.reset(new ExtKeyCache());
+      else {
+        ExtKeyCache::iterator it = _extkey_cache->find(blob_id);
+        if (it != _extkey_cache->end()) {
+          key->size = it->second.size();
+          key->data = it->second.data();
+          return;
+        }
       }
     }
 
@@ -471,10 +798,17 @@ struct VariableLengthKeyList : BaseKeyList {
     ups_record_t record = {0};
     _blob_manager->read(context, blob_id, &record, UPS_FORCE_DEEP_COPY,
                     &arena);
-    (*_extkey_cache)[blob_id] = arena;
-    arena.disown();
-    key->data = record.data;
-    key->size = record.size;
+
+    ScopedSpinlock lock(_extkey_mutex);
+    std::pair<ExtKeyCache::iterator, bool> p
+            = _extkey_cache->insert(std::make_pair(blob_id, ByteArray()));
+    // another thread was faster? then use the cached copy
+    if (p.second) {
+      p.first->second = arena;
+      arena.disown();
+    }
+    key->data = p.first->second.data();
+    key->size = p.first->second.size();
   }
 
   // Allocates an extended key and stores it in the cache
@@ -558,10 +892,17 @@ struct VariableLengthKeyList : BaseKeyList {
   // Cache for extended keys
   ScopedPtr<ExtKeyCache> _extkey_cache;
 
+  // Protects |_extkey_cache| against concurrent readers
+  Spinlock _extkey_mutex;
+
   // Threshold for extended keys; if key size is > threshold then the
   // key is moved to a blob
   size_t _extkey_threshold;
 
+  // Size of the range which stores the common prefix; 0 if prefix
+  // compression is disabled
+  size_t _prefix_range_size;
+
   // Compressor for the keys
   ScopedPtr<Compressor> _compressor;
 };
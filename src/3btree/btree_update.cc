@@ -19,6 +19,7 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <algorithm>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
@@ -92,6 +93,8 @@ allocate_new_root(BtreeUpdateAction &state, Page *old_root)
   BtreeNodeProxy *new_node = state.btree->get_node_from_page(new_root);
   new_node->set_left_child(old_root->address());
 
+  // concurrent readers must not see the new root before it's complete
+  state.latch(new_root);
   state.btree->set_root_page(new_root);
   Page *header = env->page_manager->fetch(state.context, 0);
   header->set_dirty(true);
@@ -101,6 +104,22 @@ allocate_new_root(BtreeUpdateAction &state, Page *old_root)
   return new_root;
 }
 
+// Shortens the |pivot| key (the smallest key of the right page) to the
+// shortest prefix which is still greater than |left| (the largest key of
+// the left page). Only valid for keys which are compared with memcmp.
+static inline void
+truncate_separator(const ups_key_t *left, ups_key_t *pivot)
+{
+  const uint8_t *l = (const uint8_t *)left->data;
+  const uint8_t *p = (const uint8_t *)pivot->data;
+  uint32_t size = std::min(left->size, pivot->size);
+  uint32_t i = 0;
+  while (i < size && l[i] == p[i])
+    i++;
+  if (i + 1 < pivot->size)
+    pivot->size = (uint16_t)(i + 1);
+}
+
 /* Merges the |sibling| into |page|, returns the merged page and moves
  * the sibling to the freelist */ 
 static inline Page *
@@ -164,8 +183,10 @@ BtreeUpdateAction::traverse_tree(Context *context, const ups_key_t *key,
 
   *parent = 0;
 
-  // if the root page is empty with children then collapse it
-  if (unlikely(node->length() == 0 && !node->is_leaf())) {
+  // if the root page is empty with children then collapse it (but not if
+  // lookups run concurrently, because they might still access the old root)
+  if (unlikely(node->length() == 0 && !node->is_leaf()
+                && !context->is_shared_write)) {
     page = collapse_root(*this, page);
     node = btree->get_node_from_page(page);
   }
@@ -185,6 +206,16 @@ BtreeUpdateAction::traverse_tree(Context *context, const ups_key_t *key,
     Page *child_page = btree->find_lower_bound(context, page, key, 0, &slot);
     BtreeNodeProxy *child_node = btree->get_node_from_page(child_page);
 
+    // Nodes are not merged while lookups run concurrently, because the
+    // merged sibling is deleted. The merge is deferred till the next
+    // update which holds the exclusive lock.
+    if (unlikely(context->is_shared_write)) {
+      *parent = page;
+      page = child_page;
+      node = child_node;
+      continue;
+    }
+
     // We can merge this child with the RIGHT sibling iff...
     // 1. it's not the right-most slot (and therefore the right sibling has
     //      the same parent as the child)
@@ -250,8 +281,11 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
   LocalEnv *env = (LocalEnv *)btree->db()->env;
   BtreeNodeProxy *old_node = btree->get_node_from_page(old_page);
 
+  latch(old_page);
+
   /* allocate a new page and initialize it */
   Page *new_page = env->page_manager->alloc(context, Page::kTypeBindex);
+  latch(new_page);
   {
     PBtreeNode *node = PBtreeNode::from_page(new_page);
     node->set_flags(old_node->is_leaf() ? PBtreeNode::kLeafNode : 0);
@@ -296,13 +330,28 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
 
     /* now move some of the key/rid-tuples to the new page */
     old_node->split(context, new_node, pivot);
+  }
+
+  /* leaf page with variable length binary keys: the separator in the
+   * parent only has to distinguish the two pages, therefore it can be
+   * shortened ("suffix truncation") */
+  if (old_node->is_leaf()
+        && btree->db()->config.key_type == UPS_TYPE_BINARY
+        && btree->db()->config.key_size == UPS_KEY_SIZE_UNLIMITED
+        && old_node->length() > 0) {
+    ByteArray left_key_arena;
+    ups_key_t left_key = {0};
+    old_node->key(context, old_node->length() - 1, &left_key_arena,
+                    &left_key);
+    truncate_separator(&left_key, &pivot_key);
+  }
 
-    // if the new key is >= the pivot key then continue with the right page,
-    // otherwise continue with the left page
+  // if the new key is >= the pivot key then continue with the right page,
+  // otherwise continue with the left page
+  if (to_return == 0)
     to_return = btree->compare_keys((ups_key_t *)key, &pivot_key) >= 0
                       ? new_page
                       : old_page;
-  }
 
   /* update the parent page */
   BtreeNodeProxy *parent_node = btree->get_node_from_page(parent);
@@ -321,6 +370,7 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
     Page *sib_page = env->page_manager->fetch(context,
                     old_node->right_sibling());
     BtreeNodeProxy *sib_node = btree->get_node_from_page(sib_page);
+    latch(sib_page);
     sib_node->set_left_sibling(new_page->address());
     sib_page->set_dirty(true);
   }
@@ -353,6 +403,8 @@ BtreeUpdateAction::insert_in_page(Page *page, ups_key_t *key,
   if (force_append)
     flags |= PBtreeNode::kInsertAppend;
 
+  latch(page);
+
   PBtreeNode::InsertResult result = node->insert(context, key, flags);
   switch (result.status) {
     case UPS_DUPLICATE_KEY:
@@ -426,4 +478,26 @@ BtreeUpdateAction::insert_in_page(Page *page, ups_key_t *key,
   return 0;
 }
 
+void
+BtreeUpdateAction::latch(Page *page)
+{
+  if (likely(!context->is_shared_write))
+    return;
+  if (std::find(latched_pages.begin(), latched_pages.end(), page)
+          != latched_pages.end())
+    return;
+  page->latch.lock();
+  latched_pages.push_back(page);
+}
+
+void
+BtreeUpdateAction::unlatch_all()
+{
+  for (std::vector<Page *>::iterator it = latched_pages.begin();
+                  it != latched_pages.end();
+                  it++)
+    (*it)->latch.unlock();
+  latched_pages.clear();
+}
+
 } // namespace upscaledb
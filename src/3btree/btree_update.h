@@ -22,6 +22,7 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <vector>
 
 // Always verify that a file of level N does not include headers > N!
 
@@ -31,6 +32,7 @@
 
 namespace upscaledb {
 
+struct Page;
 struct Context;
 struct BtreeIndex;
 struct BtreeCursor;
@@ -46,6 +48,19 @@ struct BtreeUpdateAction {
       duplicate_index(duplicate_index_) {
   }
 
+  // Destructor; releases all latched pages
+  ~BtreeUpdateAction() {
+    unlatch_all();
+  }
+
+  // Locks the latch of a |page| before it is modified, but only if lookups
+  // run concurrently (see Context::is_shared_write). The latch is held
+  // till the update is completed.
+  void latch(Page *page);
+
+  // Unlocks all latched pages
+  void unlatch_all();
+
   // Traverses the tree, looking for the leaf with the specified |key|. Will
   // split or merge nodes while descending.
   // Returns the leaf page and the |parent| of the leaf (can be null if
@@ -78,6 +93,9 @@ struct BtreeUpdateAction {
   // the duplicate index (in case the update is for a duplicate key)
   // 1-based (if 0 then this update is not for a duplicate)
   uint32_t duplicate_index;
+
+  // the pages which were latched by this update
+  std::vector<Page *> latched_pages;
 };
 
 } // namespace upscaledb
@@ -87,6 +87,10 @@ struct BtreeVisitAction
       BtreeNodeProxy *node = btree->get_node_from_page(page);
       uint64_t right = node->right_sibling();
 
+      // start loading the next leaf while this one is visited
+      if (likely(right))
+        env->page_manager->read_ahead(right);
+
       visitor(context, node);
 
       /* follow the pointer to the right sibling */
@@ -28,6 +28,10 @@
  * the size of the chunk data. The offset is stored as 16- or 32-bit, depending
  * on the page size. The size is always a 16bit integer.
  *
+ * Optionally, each slot also stores a 32bit "tag" which is managed by the
+ * caller (i.e. the normalized prefix of a key). Tags are moved together
+ * with their slots.
+ *
  * The number of used slots is not stored in the UpfrontIndex, since it is
  * already managed in the caller (this is equal to |PBtreeNode::get_count()|).
  * Therefore you will see a lot of methods receiving a |node_count| parameter.
@@ -93,9 +97,10 @@ struct UpfrontIndex {
   };
 
   // Constructor; creates an empty index which needs to be initialized
-  // with |create()| or |open()|.
-  UpfrontIndex(LocalDb *db)
-    : vacuumize_counter(0) {
+  // with |create()| or |open()|. If |has_tags| is true then each slot
+  // also stores a 32bit tag.
+  UpfrontIndex(LocalDb *db, bool has_tags = false)
+    : vacuumize_counter(0), sizeof_tag(has_tags ? sizeof(uint32_t) : 0) {
     size_t page_size = db->env->config.page_size_bytes;
     if (likely(page_size <= 64 * 1024))
       sizeof_offset = 2;
@@ -180,7 +185,7 @@ struct UpfrontIndex {
 
   // Returns the size of a single index entry
   size_t full_index_size() const {
-    return sizeof_offset + 1; // 1 byte for the size
+    return sizeof_offset + 1 + sizeof_tag; // 1 byte for the size
   }
 
   // Transforms a relative offset of the payload data to an absolute offset
@@ -218,6 +223,25 @@ struct UpfrontIndex {
             = (uint8_t)size;
   }
 
+  // Returns true if the slots store tags
+  bool has_tags() const {
+    return sizeof_tag != 0;
+  }
+
+  // Returns the tag of a slot
+  uint32_t get_chunk_tag(int slot) const {
+    assert(has_tags());
+    return *(uint32_t *)&range_data[kPayloadOffset + full_index_size() * slot
+                              + sizeof_offset + 1];
+  }
+
+  // Sets the tag of a slot
+  void set_chunk_tag(int slot, uint32_t tag) {
+    assert(has_tags());
+    *(uint32_t *)&range_data[kPayloadOffset + full_index_size() * slot
+                              + sizeof_offset + 1] = tag;
+  }
+
   // Increases the "vacuumize-counter", which is an indicator whether
   // rearranging the node makes sense
   void increase_vacuumize_counter(size_t gap_size) {
@@ -446,6 +470,8 @@ struct UpfrontIndex {
       ::memcpy(other->get_chunk_data_by_offset(offset),
                   get_chunk_data_by_offset(get_chunk_offset(i)),
                   size);
+      if (has_tags())
+        other->set_chunk_tag(i - pivot, get_chunk_tag(i));
     }
 
     // this node has lost lots of its data - make sure that it will be
@@ -467,6 +493,8 @@ struct UpfrontIndex {
       ::memcpy(get_chunk_data_by_offset(offset),
                   other->get_chunk_data_by_offset(other->get_chunk_offset(i)),
                   size);
+      if (has_tags())
+        set_chunk_tag(i + node_count, other->get_chunk_tag(i));
     }
 
     other->clear();
@@ -644,6 +672,9 @@ struct UpfrontIndex {
 
   // A counter to indicate when rearranging the data makes sense
   int vacuumize_counter;
+
+  // The size of the tag; either 0 (no tags) or 32 bits
+  size_t sizeof_tag;
 };
 
 } // namespace upscaledb
@@ -26,6 +26,22 @@
  * at the head. The tail therefore points to the page which was not used
  * in a long time, and is the primary candidate for purging.
  *
+ * Optionally (UPS_CACHE_POLICY_2Q) pages are managed with the scan-resistant
+ * "2Q" algorithm: new pages are stored in a separate FIFO queue and only
+ * move to the LRU list if they are accessed again after they were evicted
+ * (their addresses are remembered in a "ghost" list). Pages which are
+ * touched only once (i.e. by a full table scan) therefore can not push
+ * the frequently used pages (i.e. the btree index pages) out of the cache.
+ *
+ * With UPS_CACHE_POLICY_CLOCK a cache hit does not modify any list; it only
+ * sets the page's reference bit. When the cache is purged, referenced
+ * pages get a "second chance": their bit is cleared and they are moved to
+ * the head of the list instead of being evicted.
+ *
+ * The hash buckets and the lists are partitioned into shards. Each shard
+ * has its own lock, therefore threads accessing pages of different shards
+ * do not block each other.
+ *
  * @exception_safe: nothrow
  * @thread_safe: yes
  */
@@ -36,6 +52,7 @@
 #include "0root/root.h"
 
 #include <vector>
+#include <algorithm>
 
 #include "ups/upscaledb_int.h"
 
@@ -64,18 +81,19 @@ struct Cache
 {
   template<typename Purger>
   struct PurgeIfSelector {
-    PurgeIfSelector(Cache *cache, Purger &purger)
-      : cache_(cache), purger_(purger) {
+    PurgeIfSelector(Cache *cache, CacheShard *shard, Purger &purger)
+      : cache_(cache), shard_(shard), purger_(purger) {
     }
 
     bool operator()(Page *page) {
       if (purger_(page))
-        cache_->del(page);
+        cache_->del_unlocked(shard_, page, false);
       // don't remove page from list; it was already removed above
       return false;
     }
 
     Cache *cache_;
+    CacheShard *shard_;
     Purger &purger_;
   };
 
@@ -86,58 +104,123 @@ struct Cache
 
   // Fills in the current metrics
   void fill_metrics(ups_env_metrics_t *metrics) const {
-    metrics->cache_hits = state.cache_hits;
-    metrics->cache_misses = state.cache_misses;
+    metrics->cache_hits = 0;
+    metrics->cache_misses = 0;
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      metrics->cache_hits += state.shards[i].cache_hits;
+      metrics->cache_misses += state.shards[i].cache_misses;
+    }
   }
 
   // Retrieves a page from the cache, also removes the page from the cache
   // and re-inserts it at the front. Returns null if the page was not cached.
-  Page *get(uint64_t address) {
+  // A miss is not counted if |count_miss| is false (i.e. because the
+  // caller will repeat the lookup).
+  Page *get(uint64_t address, bool count_miss = true) {
     size_t hash = Impl::calc_hash(address);
+    CacheShard *shard = shard_of(hash);
+    ScopedSpinlock lock(shard->mutex);
 
     Page *page = state.buckets[hash].get(address);
     if (!page) {
-      state.cache_misses++;
+      if (count_miss)
+        shard->cache_misses++;
       return 0;
     }
 
     // Now re-insert the page at the head of the "totallist", and
     // thus move far away from the tail. The pages at the tail are highest
     // candidates to be deleted when the cache is purged.
-    state.totallist.del(page);
-    state.totallist.put(page);
-    state.cache_hits++;
+    //
+    // Pages in the 2Q FIFO are not moved; repeated accesses shortly after
+    // the first one are usually correlated (i.e. by a scan).
+    // CLOCK only sets the reference bit.
+    if (state.policy == UPS_CACHE_POLICY_CLOCK)
+      page->cache_referenced = true;
+    else if (shard->totallist.del(page))
+      shard->totallist.put(page);
+    shard->cache_hits++;
     return page;
   }
 
+  // Retrieves a page from the cache without updating the statistics or
+  // the replacement order. Returns null if the page was not cached.
+  Page *peek(uint64_t address) {
+    size_t hash = Impl::calc_hash(address);
+    CacheShard *shard = shard_of(hash);
+    ScopedSpinlock lock(shard->mutex);
+    return state.buckets[hash].get(address);
+  }
+
   // Stores a page in the cache
   void put(Page *page) {
     size_t hash = Impl::calc_hash(page->address());
+    CacheShard *shard = shard_of(hash);
+    ScopedSpinlock lock(shard->mutex);
+    bool is_new = false;
 
     /* First remove the page from the cache, if it's already cached
      *
      * Then re-insert the page at the head of the list. The tail will
      * point to the least recently used page.
+     *
+     * 2Q: new pages are stored in the FIFO, unless they were evicted
+     * from the FIFO recently.
      */
-    state.totallist.del(page);
-    state.totallist.put(page);
-    if (page->is_allocated())
-      state.alloc_elements++;
+    if (shard->totallist.has(page)) {
+      if (state.policy == UPS_CACHE_POLICY_CLOCK)
+        page->cache_referenced = true;
+      else {
+        shard->totallist.del(page);
+        shard->totallist.put(page);
+      }
+    }
+    else if (!shard->a1list.has(page)) {
+      is_new = true;
+      page->cache_referenced = false;
+      if (state.policy == UPS_CACHE_POLICY_2Q
+              && !forget_ghost(shard, page->address()))
+        shard->a1list.put(page);
+      else
+        shard->totallist.put(page);
+    }
+
+    if (is_new && page->is_allocated())
+      shard->alloc_elements++;
 
     state.buckets[hash].put(page);
   }
 
-  // Removes a page from the cache
+  // Removes a page from the cache (i.e. because it was freed or its
+  // Database is closed). The page is not remembered in the 2Q ghost list.
   void del(Page *page) {
     assert(page->address() != 0);
 
-    /* remove it from the list of all cached pages */
-    if (state.totallist.del(page) && page->is_allocated())
-      state.alloc_elements--;
+    CacheShard *shard = shard_of(Impl::calc_hash(page->address()));
+    ScopedSpinlock lock(shard->mutex);
+    del_unlocked(shard, page, false);
+  }
 
-    /* remove the page from the cache buckets */
-    size_t hash = Impl::calc_hash(page->address());
-    state.buckets[hash].del(page);
+  // Removes a page which was evicted by purge_candidates(). With 2Q its
+  // address is remembered; if it is fetched again then it is promoted
+  // to the LRU list.
+  void evict(Page *page) {
+    assert(page->address() != 0);
+
+    CacheShard *shard = shard_of(Impl::calc_hash(page->address()));
+    ScopedSpinlock lock(shard->mutex);
+    del_unlocked(shard, page, true);
+  }
+
+  // Forgets a remembered (evicted) address, i.e. because the page was
+  // freed. A page which is later allocated at this address then starts
+  // in the FIFO queue.
+  void forget(uint64_t address) {
+    if (state.ghost_limit == 0)
+      return;
+    CacheShard *shard = shard_of(Impl::calc_hash(address));
+    ScopedSpinlock lock(shard->mutex);
+    forget_ghost(shard, address);
   }
 
   // Purges the cache. Implements a LRU eviction algorithm. Dirty pages are
@@ -145,27 +228,24 @@ struct Cache
   // The |ignore_page| is passed by the caller; this page will not be purged
   // under any circumstance. This is used by the PageManager to make sure
   // that the "last blob page" is not evicted by the cache.
+  //
+  // Each shard contributes candidates in proportion to its size.
   void purge_candidates(std::vector<uint64_t> &candidates,
                   std::vector<Page *> &garbage,
                   Page *ignore_page) {
-    int limit = (int)(current_elements()
-                      - (state.capacity_bytes / state.page_size_bytes));
-
-    Page *page = state.totallist.tail();
-    for (int i = 0; i < limit && page != 0; i++) {
-      if (page->mutex().try_lock()) {
-        if (page->cursor_list.size() == 0
-              && page != ignore_page
-              && page->type() != Page::kTypeBroot) {
-          if (page->is_dirty())
-            candidates.push_back(page->address());
-          else
-            garbage.push_back(page);
-        }
-        page->mutex().unlock();
-      }
-
-      page = page->previous(Page::kListCache);
+    uint64_t total = current_elements();
+    uint64_t capacity = state.capacity_bytes / state.page_size_bytes;
+    if (total <= capacity)
+      return;
+
+    uint64_t limit = total - capacity;
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      CacheShard *shard = &state.shards[i];
+      ScopedSpinlock lock(shard->mutex);
+      uint64_t size = shard->totallist.size() + shard->a1list.size();
+      // round up, otherwise small shards would never be purged
+      int share = (int)((limit * size + total - 1) / total);
+      purge_shard(shard, share, candidates, garbage, ignore_page);
     }
   }
 
@@ -174,13 +254,18 @@ struct Cache
   // to flush (and delete) pages.
   template<typename Purger>
   void purge_if(Purger &purger) {
-    PurgeIfSelector<Purger> selector(this, purger);
-    state.totallist.extract(selector);
+    for (size_t i = 0; i < state.shards.size(); i++) {
+      CacheShard *shard = &state.shards[i];
+      ScopedSpinlock lock(shard->mutex);
+      PurgeIfSelector<Purger> selector(this, shard, purger);
+      shard->totallist.extract(selector);
+      shard->a1list.extract(selector);
+    }
   }
 
   // Returns true if the capacity limits are exceeded
   bool is_cache_full() const {
-    return state.totallist.size() * state.page_size_bytes
+    return current_elements() * state.page_size_bytes
             > state.capacity_bytes;
   }
 
@@ -189,15 +274,135 @@ struct Cache
     return state.capacity_bytes;
   }
 
-  // Returns the number of currently cached elements
+  // Returns the number of currently cached elements. The result is not
+  // exact if other threads modify the cache concurrently.
   size_t current_elements() const {
-    return state.totallist.size();
+    size_t count = 0;
+    for (size_t i = 0; i < state.shards.size(); i++)
+      count += state.shards[i].totallist.size()
+                  + state.shards[i].a1list.size();
+    return count;
   }
 
   // Returns the number of currently cached elements (excluding those that
   // are mmapped)
   size_t allocated_elements() const {
-    return state.alloc_elements;
+    size_t count = 0;
+    for (size_t i = 0; i < state.shards.size(); i++)
+      count += state.shards[i].alloc_elements;
+    return count;
+  }
+
+  // Returns the shard which owns the bucket with the |hash|
+  CacheShard *shard_of(size_t hash) {
+    return &state.shards[hash % state.shards.size()];
+  }
+
+  // Removes a page from the cache; the shard has to be locked by the caller.
+  // Only evicted pages are remembered in the ghost list.
+  void del_unlocked(CacheShard *shard, Page *page, bool is_evicted) {
+    /* remove it from the list of all cached pages */
+    bool is_cached = shard->totallist.del(page);
+    if (!is_cached && shard->a1list.del(page)) {
+      is_cached = true;
+      if (is_evicted)
+        remember_ghost(shard, page->address());
+    }
+
+    if (is_cached && page->is_allocated())
+      shard->alloc_elements--;
+
+    /* remove the page from the cache buckets */
+    size_t hash = Impl::calc_hash(page->address());
+    state.buckets[hash].del(page);
+  }
+
+  // Collects up to |limit| purge candidates of a single shard.
+  //
+  // 2Q: pages are evicted from the FIFO as long as the FIFO exceeds its
+  // limit, then from the LRU list.
+  void purge_shard(CacheShard *shard, int limit,
+                  std::vector<uint64_t> &candidates,
+                  std::vector<Page *> &garbage, Page *ignore_page) {
+    Page *a1 = shard->a1list.tail();
+    if (limit > 0 && shard->a1list.size() > state.a1_limit) {
+      int excess = std::min(limit, (int)(shard->a1list.size()
+                                            - state.a1_limit));
+      int remaining = excess;
+      a1 = collect_candidates(shard->a1list, a1, remaining, candidates,
+                      garbage, ignore_page);
+      limit -= excess - remaining;
+    }
+
+    collect_candidates(shard->totallist, shard->totallist.tail(), limit,
+                    candidates, garbage, ignore_page);
+    collect_candidates(shard->a1list, a1, limit, candidates,
+                    garbage, ignore_page);
+  }
+
+  // Walks a list from the |page| towards the head, and collects purge
+  // candidates till |limit| pages were visited. Decrements |limit| for each
+  // visited page. Returns the page where the walk stopped.
+  //
+  // CLOCK: referenced pages are not visited, but moved to the head.
+  template<int ID>
+  Page *collect_candidates(PageCollection<ID> &list, Page *page, int &limit,
+                  std::vector<uint64_t> &candidates,
+                  std::vector<Page *> &garbage, Page *ignore_page) {
+    for (size_t steps = list.size();
+            limit > 0 && page != 0 && steps > 0;
+            steps--) {
+      Page *previous = page->previous(ID);
+
+      if (state.policy == UPS_CACHE_POLICY_CLOCK && page->cache_referenced) {
+        page->cache_referenced = false;
+        list.del(page);
+        list.put(page);
+        page = previous;
+        continue;
+      }
+
+      if (page->mutex().try_lock()) {
+        if (page->cursor_list.size() == 0
+              && page != ignore_page
+              && page->type() != Page::kTypeBroot) {
+          if (page->is_dirty())
+            candidates.push_back(page->address());
+          else
+            garbage.push_back(page);
+        }
+        page->mutex().unlock();
+      }
+
+      limit--;
+      page = previous;
+    }
+    return page;
+  }
+
+  // 2Q: remembers the address of a page which was evicted from the FIFO
+  void remember_ghost(CacheShard *shard, uint64_t address) {
+    if (state.ghost_limit == 0 || shard->ghostindex.count(address))
+      return;
+
+    shard->ghostlist.push_front(address);
+    shard->ghostindex[address] = shard->ghostlist.begin();
+
+    if (shard->ghostlist.size() > state.ghost_limit) {
+      shard->ghostindex.erase(shard->ghostlist.back());
+      shard->ghostlist.pop_back();
+    }
+  }
+
+  // 2Q: removes an address from the ghost list. Returns true if the address
+  // was found, otherwise false.
+  bool forget_ghost(CacheShard *shard, uint64_t address) {
+    CacheShard::GhostIndex::iterator it = shard->ghostindex.find(address);
+    if (it == shard->ghostindex.end())
+      return false;
+    shard->ghostlist.erase(it->second);
+    shard->ghostindex.erase(it);
+    return true;
   }
 
   CacheState state;
@@ -22,10 +22,14 @@
 #include "0root/root.h"
 
 #include <vector>
+#include <list>
+#include <map>
+#include <algorithm>
 
 #include "ups/types.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/spinlock.h"
 #include "2page/page.h"
 #include "2page/page_collection.h"
 #include "2config/env_config.h"
@@ -36,6 +40,46 @@
 
 namespace upscaledb {
 
+/*
+ * A shard of the cache. Each shard manages the pages of a subset of the
+ * hash buckets, and has its own lock and its own replacement lists.
+ */
+struct CacheShard
+{
+  typedef std::list<uint64_t> GhostList;
+  typedef std::map<uint64_t, GhostList::iterator> GhostIndex;
+
+  CacheShard()
+    : alloc_elements(0), cache_hits(0), cache_misses(0) {
+  }
+
+  // For serializing access to this shard and its hash buckets
+  Spinlock mutex;
+
+  // the current number of cached elements that were allocated (and not
+  // mapped)
+  size_t alloc_elements;
+
+  // linked list of cached pages, ordered by their last access; with the
+  // 2Q policy this list only contains pages which were accessed repeatedly
+  PageCollection<Page::kListCache> totallist;
+
+  // 2Q: FIFO of the cached pages which were accessed only once
+  PageCollection<Page::kListCacheA1> a1list;
+
+  // 2Q: FIFO of the addresses of pages which were evicted from |a1list|
+  GhostList ghostlist;
+
+  // 2Q: index into |ghostlist|
+  GhostIndex ghostindex;
+
+  // counts the cache hits
+  uint64_t cache_hits;
+
+  // counts the cache misses
+  uint64_t cache_misses;
+};
+
 struct CacheState
 {
   typedef PageCollection<Page::kListBucket> CacheLine;
@@ -44,15 +88,31 @@ struct CacheState
     // The number of buckets should be a prime number or similar, as it
     // is used in a MODULO hash scheme
     kBucketSize = 10317,
+
+    // The maximum number of shards
+    kMaxShards = 64
   };
 
   CacheState(const EnvConfig &config)
     : capacity_bytes(ISSET(config.flags, UPS_CACHE_UNLIMITED)
                             ? std::numeric_limits<uint64_t>::max()
                             : config.cache_size_bytes),
-      page_size_bytes(config.page_size_bytes), alloc_elements(0),
-      buckets(kBucketSize), cache_hits(0), cache_misses(0) {
+      page_size_bytes(config.page_size_bytes),
+      policy(config.cache_policy), a1_limit(0), ghost_limit(0),
+      shards(std::max<int>(config.cache_shards, 1)),
+      buckets(kBucketSize) {
     assert(capacity_bytes > 0);
+    assert(shards.size() <= kMaxShards);
+
+    // 2Q: reserve 25% of the capacity for pages which were accessed only
+    // once, and remember the addresses of the recently evicted pages
+    // for another 50% of the capacity. The limits are per shard.
+    if (policy == UPS_CACHE_POLICY_2Q) {
+      uint64_t capacity_pages = capacity_bytes / page_size_bytes
+                                    / shards.size();
+      a1_limit = std::max<uint64_t>(capacity_pages / 4, 1);
+      ghost_limit = std::max<uint64_t>(capacity_pages / 2, 1);
+    }
   }
 
   // the capacity (in bytes)
@@ -61,21 +121,20 @@ struct CacheState
   // the current page size (in bytes)
   uint64_t page_size_bytes;
 
-  // the current number of cached elements that were allocated (and not
-  // mapped)
-  size_t alloc_elements;
+  // the replacement policy (UPS_CACHE_POLICY_*)
+  int policy;
 
-  // linked list of ALL cached pages
-  PageCollection<Page::kListCache> totallist;
+  // 2Q: the maximum number of pages in a shard's |a1list|
+  uint64_t a1_limit;
 
-  // The hash table buckets - each is a linked list of Page pointers
-  std::vector<CacheLine> buckets;
+  // 2Q: the maximum number of addresses in a shard's |ghostlist|
+  uint64_t ghost_limit;
 
-  // counts the cache hits
-  uint64_t cache_hits;
+  // The shards; bucket |i| is owned by shard |i % shards.size()|
+  std::vector<CacheShard> shards;
 
-  // counts the cache misses
-  uint64_t cache_misses;
+  // The hash table buckets - each is a linked list of Page pointers
+  std::vector<CacheLine> buckets;
 };
 
 } // namespace upscaledb
@@ -79,9 +79,15 @@ flush_changeset_to_file(std::vector<Page *> list, Device *device,
 
     if (likely(page->is_without_header() == false))
       page->set_lsn(lsn);
+  }
 
-    page->flush();
-    page->mutex().unlock();
+  // write all pages at once; devices with asynchronous I/O submit them
+  // in a single batch
+  if (!list.empty())
+    Page::flush_multiple(&list[0], list.size());
+
+  for (it = list.begin(); it != list.end(); it++) {
+    (*it)->mutex().unlock();
     UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
   }
 
@@ -90,6 +96,9 @@ flush_changeset_to_file(std::vector<Page *> list, Device *device,
     device->flush();
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
+
+  /* the next checkpoint no longer lists these pages */
+  journal->changeset_flushed(lsn);
 }
 
 void
@@ -129,10 +138,12 @@ Changeset::flush(uint64_t lsn)
     g_CHANGESET_POST_LOG_HOOK();
 
   // The modified pages are now flushed (and unlocked) asynchronously
-  // to the database file
+  // to the database file. A page is locked till it was flushed, therefore
+  // subsequent changesets never overlap and can be flushed in parallel.
   env->page_manager->run_async(boost::bind(&flush_changeset_to_file,
                           visitor.list, env->device.get(), env->journal.get(),
-                          lsn, ISSET(env->config.flags, UPS_ENABLE_FSYNC)));
+                          lsn, ISSET(env->config.flags, UPS_ENABLE_FSYNC)),
+                          (size_t)lsn);
 }
 
 } // namespace upscaledb
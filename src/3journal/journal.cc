@@ -19,6 +19,7 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <algorithm>
 #ifndef WIN32
 #  include <libgen.h>
 #endif
@@ -30,7 +31,7 @@
 #include "2compressor/compressor_factory.h"
 #include "3journal/journal.h"
 #include "3page_manager/page_manager.h"
-#include "4db/db.h"
+#include "4db/db_local.h"
 #include "4txn/txn_local.h"
 #include "4env/env_local.h"
 #include "4context/context.h"
@@ -51,12 +52,30 @@ enum {
   kBufferLimit = 1024 * 1024, // 1 mb
 };
 
+static inline bool
+is_segmented(const JournalState &state)
+{
+  return state.segmented;
+}
+
 static inline void
 clear_file(JournalState &state, int idx)
 {
+  // page images in this file are lost; the next changeset logs them in full
+  JournalState::FileState &fs = state.file_state[idx];
+  fs.generation++;
+  fs.sequence = 0;
+  fs.size = 0;
+  fs.pending_txns = 0;
+
   if (state.files[idx].is_open()) {
     state.files[idx].truncate(0);
 
+    // truncating discards the stale entries of preallocated files; then
+    // allocate the space again
+    if (state.file_size > 0)
+      state.files[idx].allocate(state.file_size);
+
     // after truncate, the file pointer is far beyond the new end of file;
     // reset the file pointer, or the next write will resize the file to
     // the original size
@@ -64,6 +83,115 @@ clear_file(JournalState &state, int idx)
   }
 }
 
+// Starts using file |idx| of a segmented journal: assigns the next sequence
+// number and writes the file header
+static inline void
+start_file(JournalState &state, int idx)
+{
+  JournalState::FileState &fs = state.file_state[idx];
+  fs.sequence = state.next_sequence++;
+
+  PJournalFileHeader header(fs.sequence);
+  state.files[idx].pwrite(0, &header, sizeof(header));
+  state.files[idx].seek(sizeof(header), File::kSeekSet);
+  fs.size = sizeof(header);
+}
+
+// Reuses file |idx| of a segmented journal. Preallocated files are not
+// truncated; their stale entries are ignored because they are tagged with
+// an older sequence number. The new header is synced immediately, otherwise
+// the stale entries could be recovered after a crash.
+static inline void
+reuse_file(JournalState &state, int idx)
+{
+  if (state.file_size == 0) {
+    clear_file(state, idx);
+    start_file(state, idx);
+    return;
+  }
+
+  JournalState::FileState &fs = state.file_state[idx];
+  fs.generation++;
+  fs.pending_txns = 0;
+  start_file(state, idx);
+  state.files[idx].flush();
+}
+
+// Returns the tag for new entries; starts the current file of a segmented
+// journal if it is not yet in use
+static inline uint64_t
+file_tag(JournalState &state)
+{
+  if (!is_segmented(state))
+    return 0;
+  if (state.file_state[state.current_fd].sequence == 0)
+    start_file(state, state.current_fd);
+  return state.file_state[state.current_fd].sequence;
+}
+
+// Returns the size of an entry header; the entries of a segmented journal
+// are followed by the tag of their file
+static inline size_t
+entry_header_size(const JournalState &state)
+{
+  return sizeof(PJournalEntry)
+            + (is_segmented(state) ? sizeof(PJournalEntryTag) : 0);
+}
+
+// Returns the sequence number from the header of file |idx| of a segmented
+// journal; returns 0 if the file is not in use
+static inline uint64_t
+read_file_sequence(JournalState &state, int idx)
+{
+  PJournalFileHeader header;
+  if (!state.files[idx].is_open()
+      || state.files[idx].file_size() < sizeof(header))
+    return 0;
+  state.files[idx].pread(0, &header, sizeof(header));
+  if (header.magic != PJournalFileHeader::kMagic)
+    return 0;
+  return header.sequence;
+}
+
+// Determines the offset of the first entry in file |idx|, and the tag of
+// its entries. Returns false if the file does not contain entries.
+static inline bool
+file_begin(JournalState &state, int idx, uint64_t *offset, uint64_t *tag)
+{
+  *offset = 0;
+  *tag = 0;
+  if (!is_segmented(state))
+    return true;
+
+  uint64_t sequence = read_file_sequence(state, idx);
+  if (sequence == 0)
+    return false;
+
+  *offset = sizeof(PJournalFileHeader);
+  *tag = sequence;
+  return true;
+}
+
+// Reads the header of the entry at |offset| in file |idx|, which has
+// |file_size| bytes. Returns false after the last entry of the file.
+static inline bool
+read_entry_header(JournalState &state, int idx, uint64_t offset,
+                uint64_t file_size, uint64_t tag, PJournalEntry *entry)
+{
+  if (offset + entry_header_size(state) > file_size)
+    return false;
+  state.files[idx].pread(offset, entry, sizeof(*entry));
+
+  // preallocated space is empty; stale entries have a different tag
+  if (is_segmented(state)) {
+    PJournalEntryTag entry_tag;
+    state.files[idx].pread(offset + sizeof(*entry), &entry_tag,
+                    sizeof(entry_tag));
+    return entry->lsn != 0 && entry_tag.sequence == tag;
+  }
+  return true;
+}
+
 static inline std::string
 log_file_path(JournalState &state, int i)
 {
@@ -86,12 +214,9 @@ log_file_path(JournalState &state, int i)
     path += ::basename((char *)state.env->config.filename.c_str());
 #endif
   }
-  if (i == 0)
-    path += ".jrn0";
-  else if (i == 1)
-    path += ".jrn1";
-  else
-    assert(!"invalid index");
+  char suffix[16];
+  ::snprintf(suffix, sizeof(suffix), ".jrn%d", i);
+  path += suffix;
   return (path);
 }
 
@@ -100,14 +225,185 @@ flush_buffer(JournalState &state, int idx, bool fsync = false)
 {
   if (likely(state.buffer.size() > 0)) {
     state.files[idx].write(state.buffer.data(), state.buffer.size());
+    state.file_state[idx].size += state.buffer.size();
     state.count_bytes_flushed += state.buffer.size();
 
     state.buffer.clear();
     if (unlikely(fsync))
       state.files[idx].flush();
+
+    // pending group commits are now durable as well; with a background
+    // sync they are durable only after the file was synced
+    if (unlikely(state.group.window_usec > 0 || state.group.sync_msec > 0)
+        && (fsync || (NOTSET(state.env->flags(), UPS_ENABLE_FSYNC)
+                        && state.group.sync_msec == 0))) {
+      ScopedLock lock(state.group.mutex);
+      if (state.group.durable_lsn < state.group.appended_lsn) {
+        state.group.durable_lsn = state.group.appended_lsn;
+        state.group.group_count++;
+        state.group.cond.notify_all();
+      }
+    }
+  }
+}
+
+// Returns the number of microseconds since |start|
+static inline uint64_t
+elapsed_usec(const boost::system_time &start)
+{
+  return (uint64_t)(boost::get_system_time() - start).total_microseconds();
+}
+
+// Updates the commit metrics; the caller holds the group mutex
+static inline void
+add_commit_latency(JournalState::GroupCommit &group, uint64_t usec)
+{
+  group.commit_count++;
+  group.latency_usec += usec;
+  if (usec > group.max_latency_usec)
+    group.max_latency_usec = usec;
+}
+
+// Acquires the Environment's lock for the background thread. The thread
+// blocks on the lock, but wakes up periodically to check whether it has to
+// stop, because then the closing thread holds the lock.
+static inline bool
+lock_env_for_syncer(JournalState &state)
+{
+  while (true) {
+    {
+      ScopedLock lock(state.group.mutex);
+      if (state.group.stop_syncer)
+        return false;
+    }
+    if (state.env->mutex.timed_lock(boost::posix_time::milliseconds(10)))
+      return true;
+  }
+}
+
+// Flushes the buffer with all appended commits, then syncs the file
+// without blocking the Environment. The caller holds |lock| (the group
+// mutex); it is released while the file is written.
+static inline void
+flush_commit_group(JournalState &state, ScopedLock &lock, bool is_syncer)
+{
+  JournalState::GroupCommit &group = state.group;
+  group.is_flushing = true;
+  lock.unlock();
+
+  uint64_t flushed_lsn = 0;
+  try {
+    int idx = -1;
+    bool is_locked = true;
+    if (is_syncer)
+      is_locked = lock_env_for_syncer(state);
+    else
+      state.env->mutex.lock();
+
+    if (is_locked) {
+      ScopedWriteLock env_lock(state.env->mutex, boost::adopt_lock);
+      flushed_lsn = group.appended_lsn;
+      idx = state.current_fd;
+      flush_buffer(state, idx);
+    }
+
+    bool needs_sync;
+    {
+      ScopedLock sync_lock(group.mutex);
+      needs_sync = flushed_lsn > group.durable_lsn;
+    }
+    if (idx >= 0 && needs_sync
+        && (ISSET(state.env->flags(), UPS_ENABLE_FSYNC)
+            || group.sync_msec > 0))
+      state.files[idx].flush();
+  }
+  catch (...) {
+    lock.lock();
+    group.is_flushing = false;
+    group.cond.notify_all();
+    throw;
+  }
+
+  lock.lock();
+  group.is_flushing = false;
+  if (group.durable_lsn < flushed_lsn) {
+    group.durable_lsn = flushed_lsn;
+    group.group_count++;
+  }
+  group.cond.notify_all();
+}
+
+// The background thread which syncs the journal every |sync_msec|
+// milliseconds (see UPS_PARAM_JOURNAL_SYNC_MSEC)
+static void
+run_syncer(JournalState *state)
+{
+  JournalState::GroupCommit &group = state->group;
+  ScopedLock lock(group.mutex);
+
+  while (!group.stop_syncer) {
+    boost::system_time deadline = boost::get_system_time()
+            + boost::posix_time::milliseconds(group.sync_msec);
+    while (!group.stop_syncer && group.cond.timed_wait(lock, deadline))
+      ;
+    if (group.stop_syncer)
+      break;
+
+    // a committing thread is already flushing
+    if (group.is_flushing)
+      continue;
+
+    try {
+      flush_commit_group(*state, lock, true);
+    }
+    catch (Exception &ex) {
+      ups_log(("failed to sync the journal: error %d (%s)", ex.code,
+                              ups_strerror(ex.code)));
+    }
   }
 }
 
+// Starts the background thread unless it is already running. The caller
+// holds the Environment's lock.
+static inline void
+start_syncer_maybe(JournalState &state)
+{
+  if (unlikely(!state.group.syncer.get()))
+    state.group.syncer.reset(new Thread(&run_syncer, &state));
+}
+
+// Stops the background thread, if it is running
+static inline void
+stop_syncer(JournalState &state)
+{
+  if (!state.group.syncer.get())
+    return;
+
+  {
+    ScopedLock lock(state.group.mutex);
+    state.group.stop_syncer = true;
+    state.group.cond.notify_all();
+  }
+  state.group.syncer->join();
+  state.group.syncer.reset();
+  state.group.stop_syncer = false;
+}
+
+// Flushes the entry of a temporary Txn. With a background sync, the entry
+// remains in the buffer.
+static inline void
+commit_temporary_txn(JournalState &state, uint64_t lsn)
+{
+  state.group.appended_lsn = lsn;
+  if (state.group.sync_msec > 0) {
+    start_syncer_maybe(state);
+    return;
+  }
+
+  flush_buffer(state, state.current_fd,
+                  ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+}
+
 // Sequentially returns the next journal entry, starting with
 // the oldest entry.
 //
@@ -122,45 +418,35 @@ read_entry(JournalState &state, Journal::Iterator *iter, PJournalEntry *entry,
 {
   auxbuffer->clear();
 
-  // if iter->offset is 0, then the iterator was created from scratch
-  // and we start reading from the first (oldest) entry.
-  //
-  // The oldest of the two logfiles is always the "other" one (the one
-  // NOT in current_fd).
-  if (iter->offset == 0) {
-    iter->fdstart = iter->fdidx =
-                        state.current_fd == 0
-                            ? 1
-                            : 0;
-  }
-
-  // get the size of the journal file
-  uint64_t filesize = state.files[iter->fdidx].file_size();
+  int num_files = (int)state.files.size();
 
-  // reached EOF? then either skip to the next file or we're done
-  if (filesize == iter->offset) {
-    if (iter->fdstart == iter->fdidx) {
-      iter->fdidx = iter->fdidx == 1 ? 0 : 1;
-      iter->offset = 0;
-      filesize = state.files[iter->fdidx].file_size();
-    }
-    else {
-      entry->lsn = 0;
-      return;
+  try {
+    // if iter->offset is 0, then the iterator was created from scratch
+    // and we start reading from the first (oldest) entry.
+    //
+    // The oldest of the logfiles is always the one following the
+    // current_fd in the ring
+    bool is_valid = true;
+    if (iter->offset == 0) {
+      iter->fdstart = iter->fdidx = (state.current_fd + 1) % num_files;
+      is_valid = file_begin(state, iter->fdidx, &iter->offset, &iter->tag);
     }
-  }
-
-  // second file is also empty? then return
-  if (filesize == iter->offset) {
-    entry->lsn = 0;
-    return;
-  }
 
-  // now try to read the next entry
-  try {
-    state.files[iter->fdidx].pread(iter->offset, entry, sizeof(*entry));
+    // reached the end of the file? then either skip to the next file or
+    // we're done
+    while (!is_valid
+            || !read_entry_header(state, iter->fdidx, iter->offset,
+                            state.files[iter->fdidx].file_size(), iter->tag,
+                            entry)) {
+      iter->fdidx = (iter->fdidx + 1) % num_files;
+      if (iter->fdidx == iter->fdstart) {
+        entry->lsn = 0;
+        return;
+      }
+      is_valid = file_begin(state, iter->fdidx, &iter->offset, &iter->tag);
+    }
 
-    iter->offset += sizeof(*entry);
+    iter->offset += entry_header_size(state);
 
     // read auxiliary data if it's available
     if (entry->followup_size) {
@@ -199,23 +485,60 @@ append_entry(JournalState &state, int idx,
     state.buffer.append(ptr5, ptr5_size);
 }
 
+// Appends the header of an entry to the journal; in a segmented journal
+// it is followed by the |tag| of the file
+static inline void
+append_entry_header(JournalState &state, int idx, const PJournalEntry &entry,
+                uint64_t tag)
+{
+  append_entry(state, idx, (const uint8_t *)&entry, sizeof(entry));
+  if (is_segmented(state)) {
+    PJournalEntryTag entry_tag(tag);
+    append_entry(state, idx, (const uint8_t *)&entry_tag, sizeof(entry_tag));
+  }
+}
+
 // Switches the log file if necessary; returns the new log descriptor in the
 // transaction
 static inline int
 switch_files_maybe(JournalState &state)
 {
-  int other = state.current_fd ? 0 : 1;
-
   // determine the journal file which is used for this transaction 
   // if the "current" file is not yet full, continue to write to this file
-  //
-  // otherwise delete the other file and use the other file as the current file
-  if (unlikely(state.num_transactions > state.threshold)) {
-    clear_file(state, other);
-    state.current_fd = other;
-    state.num_transactions = 0;
+  bool is_full = state.file_size > 0
+          ? state.file_state[state.current_fd].size + state.buffer.size()
+                >= state.file_size
+          : state.num_transactions > state.threshold;
+  if (likely(!is_full))
+    return state.current_fd;
+
+  // otherwise clear the next file in the ring and use it as the current
+  // file. But if the next file still has transactions which were not yet
+  // flushed then the current file continues to grow.
+  int next = (state.current_fd + 1) % state.files.size();
+  if (state.file_state[next].pending_txns > 0)
+    return state.current_fd;
+
+  // the changesets of the next file are discarded; their pages must be
+  // written to the database file
+  state.env->page_manager->wait_for_async_messages();
+
+  // with a background sync, the background thread only syncs the current
+  // file; the file which is left behind is synced now
+  if (state.group.sync_msec > 0)
+    flush_buffer(state, state.current_fd, true);
+
+  if (is_segmented(state)) {
+    // the buffered entries are tagged for the current file
+    flush_buffer(state, state.current_fd,
+                    ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+    reuse_file(state, next);
   }
+  else
+    clear_file(state, next);
 
+  state.current_fd = next;
+  state.num_transactions = 0;
   return state.current_fd;
 }
 
@@ -237,21 +560,6 @@ get_db(JournalState &state, uint16_t dbname)
   return db;
 }
 
-// Returns a pointer to a Txn object.
-static inline Txn *
-get_txn(JournalState &state, LocalTxnManager *txn_manager,
-                uint64_t txn_id)
-{
-  Txn *txn = txn_manager->oldest_txn();
-  while (txn) {
-    if (txn->id == txn_id)
-      return txn;
-    txn = txn->next();
-  }
-
-  return 0;
-}
-
 // Closes all databases.
 static inline void
 close_all_databases(JournalState &state)
@@ -283,14 +591,129 @@ abort_uncommitted_txns(JournalState &state, LocalTxnManager *txn_manager)
   }
 }
 
+// Returns true if the last journaled image of |page| is still available in
+// the journal files, and a delta can be logged against it
+static inline bool
+has_journal_image(JournalState &state, Page *page)
+{
+  const Page::JournalImage &image = page->journal_image;
+  return image.data != 0
+      && image.address == page->address()
+      && image.generation == state.file_state[image.file].generation;
+}
+
+// Stores the current data of |page| as its last journaled image
+static inline void
+store_journal_image(JournalState &state, Page *page, uint32_t page_size)
+{
+  Page::JournalImage &image = page->journal_image;
+  if (!image.data)
+    image.data = Memory::allocate<uint8_t>(page_size);
+  ::memcpy(image.data, page->data(), page_size);
+  image.address = page->address();
+  image.file = state.current_fd;
+  image.generation = state.file_state[state.current_fd].generation;
+}
+
+// Encodes the byte ranges of |data| which differ from |image| (compared in
+// 8-byte words). Ranges which are separated by a single unmodified word are
+// combined, because a new range header would not be smaller. Returns false
+// if the delta would not be smaller than |limit| bytes.
+static inline bool
+encode_page_delta(const uint8_t *image, const uint8_t *data,
+                uint32_t page_size, uint32_t limit, uint8_t *delta,
+                uint32_t *delta_size)
+{
+  const uint32_t kWord = sizeof(uint64_t);
+  uint32_t size = 0;
+  uint32_t i = 0;
+
+  while (i < page_size) {
+    // skip the unmodified data
+    if (i + 8 * kWord <= page_size
+        && ::memcmp(image + i, data + i, 8 * kWord) == 0) {
+      i += 8 * kWord;
+      continue;
+    }
+    if (::memcmp(image + i, data + i, kWord) == 0) {
+      i += kWord;
+      continue;
+    }
+
+    // find the end of the modified range
+    uint32_t end = i + kWord;
+    while (end < page_size) {
+      if (::memcmp(image + end, data + end, kWord) != 0)
+        end += kWord;
+      else if (end + 2 * kWord <= page_size
+          && ::memcmp(image + end + kWord, data + end + kWord, kWord) != 0)
+        end += 2 * kWord;
+      else
+        break;
+    }
+
+    PJournalEntryPageRange range;
+    range.offset = i;
+    range.length = end - i;
+    if (size + sizeof(range) + range.length >= limit)
+      return false;
+    ::memcpy(delta + size, &range, sizeof(range));
+    ::memcpy(delta + size + sizeof(range), data + i, range.length);
+    size += sizeof(range) + range.length;
+    i = end;
+  }
+
+  *delta_size = size;
+  return true;
+}
+
+// Applies a delta (created with encode_page_delta) to the page |data|
+static inline void
+apply_page_delta(const uint8_t *delta, uint32_t delta_size, uint8_t *data,
+                uint32_t page_size)
+{
+  uint32_t i = 0;
+  while (i < delta_size) {
+    PJournalEntryPageRange range;
+    ::memcpy(&range, delta + i, sizeof(range));
+    i += sizeof(range);
+    if (unlikely(range.offset + range.length > page_size
+          || i + range.length > delta_size)) {
+      ups_log(("invalid page delta in journal"));
+      throw Exception(UPS_INTEGRITY_VIOLATED);
+    }
+    ::memcpy(data + range.offset, delta + i, range.length);
+    i += range.length;
+  }
+}
+
 // Helper function which adds a single page from the changeset to
 // the Journal; returns the page size (or compressed size, if compression
-// was enabled)
+// was enabled, or the size of the delta)
 static inline uint32_t
-append_changeset_page(JournalState &state, Page *page, uint32_t page_size)
+append_changeset_page(JournalState &state, Page *page, uint32_t page_size,
+                ByteArray *delta)
 {
   PJournalEntryPageHeader header(page->address());
 
+  // log only the modified bytes if the previous image of the page can be
+  // restored during recovery
+  if (state.env->config.journal_page_deltas
+      && has_journal_image(state, page)) {
+    uint32_t delta_size;
+    if (encode_page_delta(page->journal_image.data, (uint8_t *)page->data(),
+                page_size, page_size, delta->resize(page_size),
+                &delta_size)) {
+      header.address |= PJournalEntryPageHeader::kDelta;
+      header.compressed_size = delta_size;
+      append_entry(state, state.current_fd, (uint8_t *)&header,
+                    sizeof(header), delta->data(), delta_size);
+      state.count_page_deltas++;
+      state.count_page_bytes_saved += page_size - delta_size;
+      return delta_size + sizeof(header);
+    }
+  }
+
   if (state.compressor.get()) {
     state.count_bytes_before_compression += page_size;
     header.compressed_size = state.compressor->compress((uint8_t *)page->data(),
@@ -307,22 +730,64 @@ append_changeset_page(JournalState &state, Page *page, uint32_t page_size)
   return page_size + sizeof(header);
 }
 
+// Appends a checkpoint if at least |interval| bytes were logged since the
+// previous checkpoint. The checkpoint lists all pages whose changesets were
+// not yet written by the worker threads; it does not wait for them.
+static inline void
+append_checkpoint_maybe(JournalState &state, uint64_t lsn)
+{
+  JournalState::Checkpoint &cp = state.checkpoint;
+  uint64_t bytes = state.count_bytes_flushed + state.buffer.size();
+  if (cp.interval == 0 || bytes < cp.last_bytes_flushed + cp.interval)
+    return;
+
+  PJournalEntryCheckpoint checkpoint;
+  std::vector<uint64_t> pages;
+  {
+    ScopedLock lock(cp.mutex);
+    checkpoint.redo_lsn = cp.pending.empty()
+                            ? lsn + 1
+                            : cp.pending.begin()->first;
+    for (std::map<uint64_t, std::vector<uint64_t> >::iterator it
+                    = cp.pending.begin(); it != cp.pending.end(); ++it)
+      pages.insert(pages.end(), it->second.begin(), it->second.end());
+  }
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+  checkpoint.num_pages = (uint32_t)pages.size();
+
+  PJournalEntry entry;
+  entry.lsn = lsn;
+  entry.type = Journal::kEntryTypeCheckpoint;
+  entry.followup_size = sizeof(checkpoint) + pages.size() * sizeof(uint64_t);
+
+  append_entry_header(state, state.current_fd, entry, file_tag(state));
+  append_entry(state, state.current_fd,
+                (uint8_t *)&checkpoint, sizeof(checkpoint),
+                pages.empty() ? 0 : (uint8_t *)&pages[0],
+                pages.size() * sizeof(uint64_t));
+
+  cp.last_bytes_flushed = state.count_bytes_flushed + state.buffer.size();
+  cp.count++;
+}
+
 // Scans a file for the oldest changeset. Returns the lsn of this
 // changeset.
 static inline uint64_t
-scan_for_oldest_changeset(JournalState &state, File *file)
+scan_for_oldest_changeset(JournalState &state, int idx)
 {
-  Journal::Iterator it;
+  uint64_t offset;
+  uint64_t tag;
   PJournalEntry entry;
-  ByteArray buffer;
 
   // get the next entry
   try {
-    uint64_t filesize = file->file_size();
+    if (!file_begin(state, idx, &offset, &tag))
+      return 0;
 
-    while (it.offset < filesize) {
-      file->pread(it.offset, &entry, sizeof(entry));
+    uint64_t filesize = state.files[idx].file_size();
 
+    while (read_entry_header(state, idx, offset, filesize, tag, &entry)) {
       if (entry.lsn == 0)
         break;
 
@@ -331,7 +796,7 @@ scan_for_oldest_changeset(JournalState &state, File *file)
       }
 
       // increment the offset
-      it.offset += sizeof(entry) + entry.followup_size;
+      offset += entry_header_size(state) + entry.followup_size;
     }
   }
   catch (Exception &ex) {
@@ -341,10 +806,204 @@ scan_for_oldest_changeset(JournalState &state, File *file)
   return 0;
 }
 
-// Redo all Changesets of a log file, in chronological order
+// The newest checkpoint of the journal, as seen during recovery
+struct RecoveryCheckpoint {
+  RecoveryCheckpoint()
+    : lsn(0), redo_lsn(0) {
+  }
+
+  // Returns true if the page at |address| has to be redone for the
+  // changeset with |lsn|
+  bool requires_redo(uint64_t changeset_lsn, uint64_t address) const {
+    if (changeset_lsn > lsn)
+      return true;
+    if (changeset_lsn < redo_lsn)
+      return false;
+    return std::binary_search(dirty_pages.begin(), dirty_pages.end(),
+                    address);
+  }
+
+  // the lsn of the checkpoint; 0 if there is none
+  uint64_t lsn;
+
+  // all changesets with a lower lsn were written to the database file
+  uint64_t redo_lsn;
+
+  // the pages which were not yet written when the checkpoint was created
+  // (sorted)
+  std::vector<uint64_t> dirty_pages;
+};
+
+// Scans all files for the newest checkpoint
+static inline void
+find_newest_checkpoint(JournalState &state, RecoveryCheckpoint *checkpoint)
+{
+  for (size_t idx = 0; idx < state.files.size(); idx++) {
+    uint64_t offset;
+    uint64_t tag;
+    PJournalEntry entry;
+
+    try {
+      if (!file_begin(state, idx, &offset, &tag))
+        continue;
+
+      uint64_t filesize = state.files[idx].file_size();
+
+      while (read_entry_header(state, idx, offset, filesize, tag, &entry)) {
+        if (entry.lsn == 0)
+          break;
+
+        if (entry.type == Journal::kEntryTypeCheckpoint
+            && entry.lsn >= checkpoint->lsn) {
+          PJournalEntryCheckpoint cp;
+          state.files[idx].pread(offset + entry_header_size(state), &cp,
+                          sizeof(cp));
+          checkpoint->lsn = entry.lsn;
+          checkpoint->redo_lsn = cp.redo_lsn;
+          checkpoint->dirty_pages.resize(cp.num_pages);
+          if (cp.num_pages > 0)
+            state.files[idx].pread(offset + entry_header_size(state)
+                          + sizeof(cp),
+                          &checkpoint->dirty_pages[0],
+                          cp.num_pages * sizeof(uint64_t));
+        }
+
+        // increment the offset
+        offset += entry_header_size(state) + entry.followup_size;
+      }
+    }
+    catch (Exception &ex) {
+      ups_log(("exception (error %d) while reading journal", ex.code));
+    }
+  }
+}
+
+// The shared state of the asynchronous page writes during recovery
+struct RedoState {
+  enum {
+    // minimum number of pages which can be queued for the worker threads
+    kMinPendingPages = 64
+  };
+
+  RedoState(Device *device_, uint32_t page_size_, uint64_t cache_size)
+    : device(device_), page_size(page_size_), status(0), pending(0) {
+    // the queued pages are buffered in memory; do not use more than the
+    // cache would
+    max_pending = std::max((size_t)(cache_size / page_size),
+                    (size_t)kMinPendingPages);
+  }
+
+  // Stores the first error
+  void set_error(ups_status_t st) {
+    ScopedLock lock(mutex);
+    if (status == 0)
+      status = st;
+  }
+
+  // Called before a page is queued; blocks while too many pages are
+  // pending
+  void acquire() {
+    ScopedLock lock(mutex);
+    while (pending >= max_pending)
+      cond.wait(lock);
+    pending++;
+  }
+
+  // Called by a worker thread when a queued page was processed
+  void release() {
+    ScopedLock lock(mutex);
+    assert(pending > 0);
+    pending--;
+    cond.notify_one();
+  }
+
+  // the device which receives the pages
+  Device *device;
+
+  // the page size
+  uint32_t page_size;
+
+  // Protects |status| and |pending|
+  Mutex mutex;
+
+  // Signalled when a queued page was processed
+  Condition cond;
+
+  // The first error of a worker thread
+  ups_status_t status;
+
+  // number of pages which are queued or processed by the worker threads
+  size_t pending;
+
+  // maximum number of pending pages
+  size_t max_pending;
+};
+
+// A page which is redone by a worker thread
+struct RedoPageMessage {
+  RedoPageMessage(RedoState *redo_, uint64_t address_, bool is_delta_)
+    : redo(redo_), address(address_), is_delta(is_delta_) {
+  }
+
+  // the shared state
+  RedoState *redo;
+
+  // the page address
+  uint64_t address;
+
+  // true if |data| is a delta, otherwise it's the full page
+  bool is_delta;
+
+  // the logged page data
+  ByteArray data;
+};
+
+// Overwrites the (fetched) |page| with the logged data, then flushes it
+static inline void
+redo_page(RedoPageMessage *message, Page *page)
+{
+  assert(page->address() == message->address);
+
+  // a delta is applied to the page image which was restored by a
+  // previous changeset
+  if (message->is_delta)
+    apply_page_delta(message->data.data(), message->data.size(),
+                    (uint8_t *)page->data(), message->redo->page_size);
+  else
+    ::memcpy(page->data(), message->data.data(), message->redo->page_size);
+
+  // flush the modified page to disk
+  page->set_dirty(true);
+  page->flush();
+}
+
+// Redoes a page in a worker thread. Pages with the same address are
+// always processed by the same thread, and in order. The buffered page
+// data is released as soon as the page was written.
+static void
+redo_page_async(RedoPageMessage *message)
+{
+  RedoState *redo = message->redo;
+  try {
+    Page page(redo->device);
+    page.fetch(message->address);
+    redo_page(message, &page);
+  }
+  catch (Exception &ex) {
+    redo->set_error(ex.code);
+  }
+  delete message;
+  redo->release();
+}
+
+// Redo all Changesets of a log file, in chronological order. Pages which
+// were written before the |checkpoint| are skipped. The pages are written
+// asynchronously; the caller has to wait for the worker threads. Reading
+// the journal blocks while too many pages are pending.
 // Returns the highest lsn of the last changeset applied
 static inline uint64_t
-redo_all_changesets(JournalState &state, int fdidx)
+redo_all_changesets(JournalState &state, int fdidx,
+                const RecoveryCheckpoint &checkpoint, RedoState *redo)
 {
   Journal::Iterator it;
   PJournalEntry entry;
@@ -353,20 +1012,22 @@ redo_all_changesets(JournalState &state, int fdidx)
 
   // for each entry...
   try {
-    uint64_t log_file_size = state.files[fdidx].file_size();
+    if (!file_begin(state, fdidx, &it.offset, &it.tag))
+      return 0;
 
-    while (it.offset < log_file_size) {
-      state.files[fdidx].pread(it.offset, &entry, sizeof(entry));
+    uint64_t log_file_size = state.files[fdidx].file_size();
 
+    while (read_entry_header(state, fdidx, it.offset, log_file_size, it.tag,
+                            &entry)) {
       // Skip all log entries which are NOT from a changeset
       if (entry.type != Journal::kEntryTypeChangeset) {
-        it.offset += sizeof(entry) + entry.followup_size;
+        it.offset += entry_header_size(state) + entry.followup_size;
         continue;
       }
 
       max_lsn = entry.lsn;
 
-      it.offset += sizeof(entry);
+      it.offset += entry_header_size(state);
 
       // Read the Changeset header
       PJournalEntryChangeset changeset;
@@ -387,53 +1048,70 @@ redo_all_changesets(JournalState &state, int fdidx)
         state.files[fdidx].pread(it.offset, &page_header,
                         sizeof(page_header));
         it.offset += sizeof(page_header);
-        if (page_header.compressed_size > 0) {
+        uint64_t address = page_header.page_address();
+
+        // skip the page if it was already written to the database file
+        if (!checkpoint.requires_redo(entry.lsn, address)) {
+          if (page_header.is_delta() || page_header.compressed_size > 0)
+            it.offset += page_header.compressed_size;
+          else
+            it.offset += page_size;
+          state.checkpoint.skipped_pages++;
+          continue;
+        }
+
+        RedoPageMessage *message = new RedoPageMessage(redo, address,
+                        page_header.is_delta());
+        if (page_header.is_delta()) {
+          message->data.resize(page_header.compressed_size);
+          if (page_header.compressed_size > 0)
+            state.files[fdidx].pread(it.offset, message->data.data(),
+                          page_header.compressed_size);
+          it.offset += page_header.compressed_size;
+        }
+        else if (page_header.compressed_size > 0) {
           tmp.resize(page_size);
           state.files[fdidx].pread(it.offset, tmp.data(),
                         page_header.compressed_size);
           it.offset += page_header.compressed_size;
           state.compressor->decompress(tmp.data(),
                         page_header.compressed_size, page_size, &arena);
+          message->data.append(arena.data(), page_size);
         }
         else {
-          state.files[fdidx].pread(it.offset, arena.data(), page_size);
+          message->data.resize(page_size);
+          state.files[fdidx].pread(it.offset, message->data.data(),
+                          page_size);
           it.offset += page_size;
         }
 
-        Page *page;
-
-        // now write the page to disk
-        if (page_header.address == file_size) {
-          file_size += page_size;
-
-          page = new Page(state.env->device.get());
-          page->alloc(0);
-        }
-        else if (page_header.address > file_size) {
-          file_size = (size_t)page_header.address + page_size;
+        // grow the file if the page is beyond its end
+        if (address >= file_size) {
+          file_size = address + page_size;
           state.env->device->truncate(file_size);
+        }
 
-          page = new Page(state.env->device.get());
-          page->fetch(page_header.address);
+        state.count_recovery_pages++;
+
+        // the header page is also updated in memory; all other pages are
+        // written by the worker threads
+        if (address == 0) {
+          Page *page = state.env->header->header_page;
+          try {
+            page->fetch(address);
+            redo_page(message, page);
+          }
+          catch (Exception &) {
+            delete message;
+            throw;
+          }
+          delete message;
         }
         else {
-          if (page_header.address == 0)
-            page = state.env->header->header_page;
-          else
-            page = new Page(state.env->device.get());
-          page->fetch(page_header.address);
+          redo->acquire();
+          state.env->page_manager->run_async(boost::bind(&redo_page_async,
+                                  message), (size_t)(address / page_size));
         }
-        assert(page->address() == page_header.address);
-
-        // overwrite the page data
-        ::memcpy(page->data(), arena.data(), page_size);
-
-        // flush the modified page to disk
-        page->set_dirty(true);
-        page->flush();
-
-        if (page_header.address != 0)
-          delete page;
       }
     }
   }
@@ -446,14 +1124,27 @@ redo_all_changesets(JournalState &state, int fdidx)
   return max_lsn;
 }
 
-// Recovers (re-applies) the physical changelog; returns the lsn of the
-// Changelog
+// Redoes the changesets of all files in chronological order; returns the
+// lsn of the newest changeset
 static inline uint64_t
-recover_changeset(JournalState &state)
+redo_changesets(JournalState &state, const RecoveryCheckpoint &checkpoint,
+                RedoState *redo)
 {
+  // the files of a segmented journal are ordered by their sequence number;
+  // the oldest file follows the current file
+  if (is_segmented(state)) {
+    uint64_t max_lsn = 0;
+    for (size_t i = 1; i <= state.files.size(); i++) {
+      int idx = (state.current_fd + i) % state.files.size();
+      max_lsn = std::max(max_lsn,
+                      redo_all_changesets(state, idx, checkpoint, redo));
+    }
+    return max_lsn;
+  }
+
   // scan through both files, look for the file with the oldest changeset.
-  uint64_t lsn1 = scan_for_oldest_changeset(state, &state.files[0]);
-  uint64_t lsn2 = scan_for_oldest_changeset(state, &state.files[1]);
+  uint64_t lsn1 = scan_for_oldest_changeset(state, 0);
+  uint64_t lsn2 = scan_for_oldest_changeset(state, 1);
 
   // both files are empty or do not contain a changeset?
   if (lsn1 == 0 && lsn2 == 0)
@@ -462,14 +1153,376 @@ recover_changeset(JournalState &state)
   // now redo all changesets chronologically
   state.current_fd = lsn1 < lsn2 ? 0 : 1;
 
-  uint64_t max_lsn1 = redo_all_changesets(state, state.current_fd);
-  uint64_t max_lsn2 = redo_all_changesets(state, state.current_fd == 0 ? 1 : 0);
+  uint64_t max_lsn1 = redo_all_changesets(state, state.current_fd,
+                  checkpoint, redo);
+  uint64_t max_lsn2 = redo_all_changesets(state,
+                  state.current_fd == 0 ? 1 : 0, checkpoint, redo);
 
   // return the lsn of the newest changeset
   return std::max(max_lsn1, max_lsn2);
 }
 
-// Recovers the logical journal
+// Recovers (re-applies) the physical changelog; returns the lsn of the
+// Changelog
+static inline uint64_t
+recover_changeset(JournalState &state)
+{
+  // the newest checkpoint tells which pages were already written
+  RecoveryCheckpoint checkpoint;
+  find_newest_checkpoint(state, &checkpoint);
+
+  // the journal is read by this thread; the pages are written in parallel
+  // by the worker threads (see UPS_PARAM_WORKER_THREADS)
+  RedoState redo(state.env->device.get(), state.env->config.page_size_bytes,
+                  state.env->config.cache_size_bytes);
+  uint64_t max_lsn;
+  try {
+    max_lsn = redo_changesets(state, checkpoint, &redo);
+  }
+  catch (Exception &) {
+    state.env->page_manager->wait_for_async_messages();
+    throw;
+  }
+
+  state.env->page_manager->wait_for_async_messages();
+  if (redo.status)
+    throw Exception(redo.status);
+  return max_lsn;
+}
+
+// The shared state of the parallel replay of the logical journal. The
+// recovering thread reads the journal; the worker threads stage the
+// inserts and erases in the TxnIndex. The operations of a database are
+// always processed by the same worker thread, and in journal order.
+// Staging does not modify the btree; the page manager and the blob
+// manager are only used by the recovering thread, when the committed
+// Txns are flushed while the workers are idle (see flush_replay()).
+struct ReplayState {
+  enum {
+    // maximum number of operations which can be queued for the worker
+    // threads
+    kMaxPendingOperations = 4096,
+
+    // maximum number of non-transactional operations which are staged
+    // in the same Txn
+    kMaxBatchOperations = 1024,
+
+    // the committed Txns are flushed when this limit is exceeded
+    kFlushThreshold = 256,
+
+    // minimum number of queued operations before a full cache is purged
+    kMinPurgeOperations = 256
+  };
+
+  // A Txn of the journal, or a batch of non-transactional operations
+  struct ReplayTxn {
+    ReplayTxn()
+      : txn(0), operations(0) {
+    }
+
+    // the Txn which stages the operations
+    Txn *txn;
+
+    // the databases with operations of this Txn
+    std::vector<uint16_t> dbnames;
+
+    // number of queued operations
+    size_t operations;
+  };
+
+  typedef std::map<uint64_t, ReplayTxn> TxnMap;
+  typedef std::map<uint16_t, ReplayTxn> BatchMap;
+  typedef std::map<uint16_t, size_t> PendingMap;
+
+  ReplayState()
+    : status(0), pending(0), committed(0), queued(0) {
+  }
+
+  // Stores the first error
+  void set_error(ups_status_t st) {
+    ScopedLock lock(mutex);
+    if (status == 0)
+      status = st;
+  }
+
+  // Called before an operation of |dbname| is queued; blocks while too
+  // many operations are pending
+  void acquire(uint16_t dbname) {
+    ScopedLock lock(mutex);
+    while (pending >= kMaxPendingOperations)
+      cond.wait(lock);
+    pending++;
+    pending_per_db[dbname]++;
+  }
+
+  // Called by a worker thread when a queued operation was processed
+  void release(uint16_t dbname) {
+    ScopedLock lock(mutex);
+    assert(pending > 0 && pending_per_db[dbname] > 0);
+    pending--;
+    pending_per_db[dbname]--;
+    cond.notify_all();
+  }
+
+  // Blocks till all queued operations of |dbname| were processed
+  void wait(uint16_t dbname) {
+    ScopedLock lock(mutex);
+    while (pending_per_db[dbname] > 0)
+      cond.wait(lock);
+  }
+
+  // Blocks till all queued operations were processed
+  void wait_all() {
+    ScopedLock lock(mutex);
+    while (pending > 0)
+      cond.wait(lock);
+  }
+
+  // Protects |status|, |pending| and |pending_per_db|
+  Mutex mutex;
+
+  // Signalled when a queued operation was processed
+  Condition cond;
+
+  // The first error of a worker thread
+  ups_status_t status;
+
+  // number of operations which are queued or processed by the workers
+  size_t pending;
+
+  // the pending operations, per database
+  PendingMap pending_per_db;
+
+  // The active Txns of the journal, indexed by their id
+  TxnMap txns;
+
+  // The open batches of non-transactional operations, per database
+  BatchMap batches;
+
+  // number of Txns which were committed since the last flush
+  size_t committed;
+
+  // number of operations which were queued since the last flush
+  size_t queued;
+};
+
+// An insert or erase which is staged by a worker thread
+struct ReplayMessage {
+  ReplayMessage(ReplayState *replay_, Db *db_, Txn *txn_, uint16_t dbname_,
+                  bool is_erase_, uint32_t flags_)
+    : replay(replay_), db(db_), txn(txn_), dbname(dbname_),
+      is_erase(is_erase_), flags(flags_) {
+  }
+
+  // the shared state
+  ReplayState *replay;
+
+  // the database and its name
+  Db *db;
+
+  // the Txn which stages the operation
+  Txn *txn;
+
+  // the name of the database
+  uint16_t dbname;
+
+  // true for an erase, otherwise it's an insert
+  bool is_erase;
+
+  // the flags of the logged operation
+  uint32_t flags;
+
+  // the (uncompressed) key
+  ByteArray key;
+
+  // the (uncompressed) record of an insert
+  ByteArray record;
+};
+
+// Stages an insert or erase in a worker thread. The operation is staged
+// concurrently to the operations of the other databases (see
+// LocalDb::may_stage_concurrently()); it only reads the btree.
+static void
+replay_operation_async(ReplayMessage *message)
+{
+  ReplayState *replay = message->replay;
+  uint16_t dbname = message->dbname;
+  ups_key_t key = ups_make_key(message->key.data(),
+                  (uint16_t)message->key.size());
+  ups_status_t st;
+
+  try {
+    if (message->is_erase) {
+      st = message->db->erase(0, message->txn, &key, message->flags, true);
+      // key might have already been erased when the changeset
+      // was flushed
+      if (st == UPS_KEY_NOT_FOUND)
+        st = 0;
+    }
+    else {
+      ups_record_t record = ups_make_record(message->record.data(),
+                      (uint32_t)message->record.size());
+      st = message->db->insert(0, message->txn, &key, &record,
+                      message->flags, true);
+      if (st == UPS_DUPLICATE_KEY) // ok if key already exists
+        st = 0;
+    }
+  }
+  catch (Exception &ex) {
+    st = ex.code;
+  }
+
+  if (st)
+    replay->set_error(st);
+  delete message;
+  replay->release(dbname);
+}
+
+// Returns true if the operations of |db| are staged by the worker threads
+static inline bool
+is_replayed_in_parallel(JournalState &state, Db *db)
+{
+  return state.env->config.worker_threads > 1
+          && ((LocalDb *)db)->may_stage_concurrently();
+}
+
+// Returns a pointer to database; see get_db(). Opening a database modifies
+// the Environment, therefore the worker threads have to be idle.
+static inline Db *
+get_replay_db(JournalState &state, ReplayState &replay, uint16_t dbname)
+{
+  if (state.database_map.find(dbname) == state.database_map.end())
+    replay.wait_all();
+  return get_db(state, dbname);
+}
+
+// Returns the active Txn with the journal id |txn_id|, or null
+static inline ReplayState::ReplayTxn *
+get_replay_txn(ReplayState &replay, uint64_t txn_id)
+{
+  ReplayState::TxnMap::iterator it = replay.txns.find(txn_id);
+  return it != replay.txns.end() ? &it->second : 0;
+}
+
+// Commits a Txn with queued operations as soon as the workers processed
+// them. The Txn is not yet flushed; see flush_replay().
+static inline void
+commit_replay_txn(ReplayState &replay, ReplayState::ReplayTxn *rt)
+{
+  for (std::vector<uint16_t>::iterator it = rt->dbnames.begin();
+                  it != rt->dbnames.end();
+                  it++)
+    replay.wait(*it);
+  ((LocalTxn *)rt->txn)->commit();
+  replay.committed++;
+}
+
+// Commits all open batches of non-transactional operations
+static inline void
+commit_replay_batches(ReplayState &replay)
+{
+  for (ReplayState::BatchMap::iterator it = replay.batches.begin();
+                  it != replay.batches.end();
+                  it++)
+    commit_replay_txn(replay, &it->second);
+  replay.batches.clear();
+}
+
+// Waits till the worker threads are idle, then flushes the committed Txns
+// to the btree and purges the cache
+static inline void
+flush_replay(JournalState &state, Context *context, ReplayState &replay,
+                LocalTxnManager *txn_manager)
+{
+  replay.wait_all();
+  commit_replay_batches(replay);
+  txn_manager->flush_committed_txns(context);
+  state.env->page_manager->purge_cache(context);
+  replay.committed = 0;
+  replay.queued = 0;
+}
+
+// Returns the Txn which stages an operation of |dbname|. Non-transactional
+// operations are collected in one Txn per database. This batch is committed
+// before an operation of a journal Txn is staged in the same database,
+// otherwise both Txns would conflict.
+static inline Txn *
+get_staging_txn(JournalState &state, ReplayState &replay, uint64_t txn_id,
+                uint16_t dbname)
+{
+  ReplayState::ReplayTxn *rt = txn_id ? get_replay_txn(replay, txn_id) : 0;
+
+  if (rt) {
+    ReplayState::BatchMap::iterator it = replay.batches.find(dbname);
+    if (it != replay.batches.end()) {
+      commit_replay_txn(replay, &it->second);
+      replay.batches.erase(it);
+    }
+  }
+  else {
+    rt = &replay.batches[dbname];
+    if (rt->operations >= ReplayState::kMaxBatchOperations) {
+      commit_replay_txn(replay, rt);
+      *rt = ReplayState::ReplayTxn();
+    }
+    if (!rt->txn) {
+      ups_status_t st = ups_txn_begin((ups_txn_t **)&rt->txn,
+                      (ups_env_t *)state.env, 0, 0, UPS_DONT_LOCK);
+      if (unlikely(st)) {
+        replay.batches.erase(dbname);
+        throw Exception(st);
+      }
+    }
+  }
+
+  if (std::find(rt->dbnames.begin(), rt->dbnames.end(), dbname)
+                  == rt->dbnames.end())
+    rt->dbnames.push_back(dbname);
+  rt->operations++;
+  return rt->txn;
+}
+
+// Queues an insert or erase of |db| for the worker threads (see
+// is_replayed_in_parallel())
+static inline void
+replay_async(JournalState &state, Context *context, ReplayState &replay,
+                LocalTxnManager *txn_manager, Db *db,
+                const PJournalEntry &entry, uint32_t flags, ups_key_t *key,
+                ups_record_t *record)
+{
+  // the TxnIndex and the cache are only cleaned up when the committed Txns
+  // are flushed
+  if (replay.committed >= ReplayState::kFlushThreshold
+        || (replay.queued >= ReplayState::kMinPurgeOperations
+              && state.env->page_manager->is_cache_full()))
+    flush_replay(state, context, replay, txn_manager);
+
+  Txn *txn = get_staging_txn(state, replay, entry.txn_id, entry.dbname);
+  ReplayMessage *message = new ReplayMessage(&replay, db, txn, entry.dbname,
+                  record == 0, flags);
+  message->key.append((uint8_t *)key->data, key->size);
+  if (record)
+    message->record.append((uint8_t *)record->data, record->size);
+
+  replay.acquire(entry.dbname);
+  try {
+    state.env->page_manager->run_async(boost::bind(&replay_operation_async,
+                            message), (size_t)entry.dbname);
+  }
+  catch (Exception &) {
+    delete message;
+    replay.release(entry.dbname);
+    throw;
+  }
+
+  replay.queued++;
+  state.count_recovery_parallel_operations++;
+}
+
+// Recovers the logical journal. The inserts and erases of databases which
+// support concurrent staging are staged in parallel by the worker threads,
+// grouped by database; all other entries are replayed by this thread
+// while the workers are idle.
 static inline void
 recover_journal(JournalState &state, Context *context,
                 LocalTxnManager *txn_manager, uint64_t start_lsn)
@@ -477,6 +1530,7 @@ recover_journal(JournalState &state, Context *context,
   ups_status_t st = 0;
   Journal::Iterator it;
   ByteArray buffer;
+  ReplayState replay;
 
   /* recovering the journal is rather simple - we iterate over the
    * files and re-apply EVERY operation (incl. txn_begin and txn_abort),
@@ -497,149 +1551,214 @@ recover_journal(JournalState &state, Context *context,
   // do not append to the journal during recovery
   state.disable_logging = true;
 
-  do {
-    PJournalEntry entry;
+  try {
+    do {
+      PJournalEntry entry;
 
-    // get the next entry
-    read_entry(state, &it, &entry, &buffer);
+      // get the next entry
+      read_entry(state, &it, &entry, &buffer);
 
-    // reached end of logfile?
-    if (!entry.lsn)
-      break;
+      // reached end of logfile?
+      if (!entry.lsn)
+        break;
 
-    // re-apply this operation
-    switch (entry.type) {
-      case Journal::kEntryTypeTxnBegin: {
-        Txn *txn = 0;
-        st = ups_txn_begin((ups_txn_t **)&txn, (ups_env_t *)state.env, 
-                (const char *)buffer.data(), 0, UPS_DONT_LOCK);
-        // on success: patch the txn ID
-        if (st == 0) {
-          txn->id = entry.txn_id;
-          txn_manager->set_txn_id(entry.txn_id);
+      // re-apply this operation
+      switch (entry.type) {
+        case Journal::kEntryTypeTxnBegin: {
+          Txn *txn = 0;
+          st = ups_txn_begin((ups_txn_t **)&txn, (ups_env_t *)state.env, 
+                  (const char *)buffer.data(), 0, UPS_DONT_LOCK);
+          // on success: patch the txn ID
+          if (st == 0) {
+            txn->id = entry.txn_id;
+            txn_manager->set_txn_id(entry.txn_id);
+            replay.txns[entry.txn_id].txn = txn;
+          }
+          break;
         }
-        break;
-      }
-      case Journal::kEntryTypeTxnAbort: {
-        Txn *txn = get_txn(state, txn_manager, entry.txn_id);
-        st = ups_txn_abort((ups_txn_t *)txn, UPS_DONT_LOCK);
-        break;
-      }
-      case Journal::kEntryTypeTxnCommit: {
-        Txn *txn = get_txn(state, txn_manager, entry.txn_id);
-        st = ups_txn_commit((ups_txn_t *)txn, UPS_DONT_LOCK);
-        break;
-      }
-      case Journal::kEntryTypeInsert: {
-        PJournalEntryInsert *ins = (PJournalEntryInsert *)buffer.data();
-        Txn *txn = 0;
-        Db *db;
-        ups_key_t key = {0};
-        ups_record_t record = {0};
-        if (!ins) {
-          st = UPS_IO_ERROR;
-          goto bail;
+        case Journal::kEntryTypeTxnAbort: {
+          ReplayState::ReplayTxn *rt = get_replay_txn(replay, entry.txn_id);
+          // a Txn with queued operations is aborted as soon as they were
+          // processed; otherwise the workers have to be idle, because
+          // ups_txn_abort() can flush the committed Txns
+          if (rt && !rt->dbnames.empty()) {
+            for (std::vector<uint16_t>::iterator it2 = rt->dbnames.begin();
+                            it2 != rt->dbnames.end();
+                            it2++)
+              replay.wait(*it2);
+            ((LocalTxn *)rt->txn)->abort();
+          }
+          else {
+            replay.wait_all();
+            st = ups_txn_abort((ups_txn_t *)(rt ? rt->txn : 0),
+                            UPS_DONT_LOCK);
+          }
+          replay.txns.erase(entry.txn_id);
+          break;
         }
-
-        // do not insert if the key was already flushed to disk
-        if (entry.lsn <= start_lsn)
-          continue;
-
-        uint8_t *payload = ins->key_data();
-
-        // extract the key - it can be compressed or uncompressed
-        ByteArray keyarena;
-        if (ins->compressed_key_size != 0) {
-          state.compressor->decompress(payload, ins->compressed_key_size,
-                          ins->key_size);
-          keyarena.append(state.compressor->arena.data(), ins->key_size);
-          key.data = keyarena.data();
-          payload += ins->compressed_key_size;
+        case Journal::kEntryTypeTxnCommit: {
+          ReplayState::ReplayTxn *rt = get_replay_txn(replay, entry.txn_id);
+          // same as above: ups_txn_commit() can flush the committed Txns
+          if (rt && !rt->dbnames.empty()) {
+            commit_replay_txn(replay, rt);
+          }
+          else {
+            replay.wait_all();
+            st = ups_txn_commit((ups_txn_t *)(rt ? rt->txn : 0),
+                            UPS_DONT_LOCK);
+          }
+          replay.txns.erase(entry.txn_id);
+          break;
         }
-        else {
-          key.data = payload;
-          payload += ins->key_size;
+        case Journal::kEntryTypeInsert: {
+          PJournalEntryInsert *ins = (PJournalEntryInsert *)buffer.data();
+          Txn *txn = 0;
+          Db *db;
+          ups_key_t key = {0};
+          ups_record_t record = {0};
+          if (!ins) {
+            st = UPS_IO_ERROR;
+            goto bail;
+          }
+
+          // do not insert if the key was already flushed to disk
+          if (entry.lsn <= start_lsn)
+            continue;
+          state.count_recovery_operations++;
+
+          uint8_t *payload = ins->key_data();
+
+          // extract the key - it can be compressed or uncompressed
+          ByteArray keyarena;
+          if (ins->compressed_key_size != 0) {
+            state.compressor->decompress(payload, ins->compressed_key_size,
+                            ins->key_size);
+            keyarena.append(state.compressor->arena.data(), ins->key_size);
+            key.data = keyarena.data();
+            payload += ins->compressed_key_size;
+          }
+          else {
+            key.data = payload;
+            payload += ins->key_size;
+          }
+          key.size = ins->key_size;
+          // extract the record - it can be compressed or uncompressed
+          ByteArray recarena;
+          if (ins->compressed_record_size != 0) {
+            state.compressor->decompress(payload, ins->compressed_record_size,
+                            ins->record_size);
+            recarena.append(state.compressor->arena.data(), ins->record_size);
+            record.data = recarena.data();
+            payload += ins->compressed_record_size;
+          }
+          else {
+            record.data = payload;
+            payload += ins->record_size;
+          }
+          record.size = ins->record_size;
+          db = get_replay_db(state, replay, entry.dbname);
+
+          if (is_replayed_in_parallel(state, db)) {
+            replay_async(state, context, replay, txn_manager, db, entry,
+                            ins->insert_flags, &key, &record);
+            break;
+          }
+
+          replay.wait_all();
+          if (entry.txn_id) {
+            ReplayState::ReplayTxn *rt = get_replay_txn(replay, entry.txn_id);
+            txn = rt ? rt->txn : 0;
+          }
+
+          // always use a cursor; otherwise flags like
+          // UPS_DUPLICATE_INSERT_FIRST will cause errors
+          ups_cursor_t *cursor;
+          st = ups_cursor_create(&cursor, (ups_db_t *)db, (ups_txn_t *)txn, 0);
+          if (unlikely(st))
+            break;
+          st = ups_cursor_insert(cursor, &key, &record,
+                          ins->insert_flags | UPS_DONT_LOCK);
+          ups_cursor_close(cursor);
+          if (st == UPS_DUPLICATE_KEY) // ok if key already exists
+            st = 0;
+          break;
         }
-        key.size = ins->key_size;
-        // extract the record - it can be compressed or uncompressed
-        ByteArray recarena;
-        if (ins->compressed_record_size != 0) {
-          state.compressor->decompress(payload, ins->compressed_record_size,
-                          ins->record_size);
-          recarena.append(state.compressor->arena.data(), ins->record_size);
-          record.data = recarena.data();
-          payload += ins->compressed_record_size;
+        case Journal::kEntryTypeErase: {
+          PJournalEntryErase *e = (PJournalEntryErase *)buffer.data();
+          Txn *txn = 0;
+          Db *db;
+          ups_key_t key = {0};
+          if (!e) {
+            st = UPS_IO_ERROR;
+            goto bail;
+          }
+
+          // do not erase if the key was already erased from disk
+          if (entry.lsn <= start_lsn)
+            continue;
+          state.count_recovery_operations++;
+
+          db = get_replay_db(state, replay, entry.dbname);
+          key.data = e->key_data();
+          if (e->compressed_key_size != 0) {
+            state.compressor->decompress(e->key_data(), e->compressed_key_size,
+                            e->key_size);
+            key.data = state.compressor->arena.data();
+          }
+          else
+            key.data = e->key_data();
+          key.size = e->key_size;
+
+          if (is_replayed_in_parallel(state, db)) {
+            replay_async(state, context, replay, txn_manager, db, entry,
+                            e->erase_flags, &key, 0);
+            break;
+          }
+
+          replay.wait_all();
+          if (entry.txn_id) {
+            ReplayState::ReplayTxn *rt = get_replay_txn(replay, entry.txn_id);
+            txn = rt ? rt->txn : 0;
+          }
+          st = ups_db_erase((ups_db_t *)db, (ups_txn_t *)txn, &key,
+                          e->erase_flags | UPS_DONT_LOCK);
+          // key might have already been erased when the changeset
+          // was flushed
+          if (st == UPS_KEY_NOT_FOUND)
+            st = 0;
+          break;
         }
-        else {
-          record.data = payload;
-          payload += ins->record_size;
+        case Journal::kEntryTypeChangeset: {
+          // skip this; the changeset was already applied
+          break;
         }
-        record.size = ins->record_size;
-        if (entry.txn_id)
-          txn = get_txn(state, txn_manager, entry.txn_id);
-        db = get_db(state, entry.dbname);
-
-        // always use a cursor; otherwise flags like UPS_DUPLICATE_INSERT_FIRST
-        // will cause errors
-        ups_cursor_t *cursor;
-        st = ups_cursor_create(&cursor, (ups_db_t *)db, (ups_txn_t *)txn, 0);
-        if (unlikely(st))
+        case Journal::kEntryTypeCheckpoint: {
+          // skip this; the checkpoint was already evaluated
           break;
-        st = ups_cursor_insert(cursor, &key, &record,
-                        ins->insert_flags | UPS_DONT_LOCK);
-        ups_cursor_close(cursor);
-        if (st == UPS_DUPLICATE_KEY) // ok if key already exists
-          st = 0;
-        break;
-      }
-      case Journal::kEntryTypeErase: {
-        PJournalEntryErase *e = (PJournalEntryErase *)buffer.data();
-        Txn *txn = 0;
-        Db *db;
-        ups_key_t key = {0};
-        if (!e) {
-          st = UPS_IO_ERROR;
-          goto bail;
         }
-
-        // do not erase if the key was already erased from disk
-        if (entry.lsn <= start_lsn)
-          continue;
-
-        if (entry.txn_id)
-          txn = get_txn(state, txn_manager, entry.txn_id);
-        db = get_db(state, entry.dbname);
-        key.data = e->key_data();
-        if (e->compressed_key_size != 0) {
-          state.compressor->decompress(e->key_data(), e->compressed_key_size,
-                          e->key_size);
-          key.data = state.compressor->arena.data();
+        default:
+          ups_log(("invalid journal entry type or journal is corrupt"));
+          st = UPS_IO_ERROR;
         }
-        else
-          key.data = e->key_data();
-        key.size = e->key_size;
-        st = ups_db_erase((ups_db_t *)db, (ups_txn_t *)txn, &key,
-                        e->erase_flags | UPS_DONT_LOCK);
-        // key might have already been erased when the changeset
-        // was flushed
-        if (st == UPS_KEY_NOT_FOUND)
-          st = 0;
-        break;
-      }
-      case Journal::kEntryTypeChangeset: {
-        // skip this; the changeset was already applied
-        break;
-      }
-      default:
-        ups_log(("invalid journal entry type or journal is corrupt"));
-        st = UPS_IO_ERROR;
-      }
 
-      if (st)
-        goto bail;
-  } while (1);
+        if (st)
+          goto bail;
+    } while (1);
+  }
+  catch (Exception &) {
+    // the queued operations refer to |replay|
+    replay.wait_all();
+    throw;
+  }
 
 bail:
+  // wait for the queued operations, then commit the open batches
+  replay.wait_all();
+  if (st == 0)
+    st = replay.status;
+  if (st == 0)
+    commit_replay_batches(replay);
+
   // all transactions which are not yet committed will be aborted
   abort_uncommitted_txns(state, txn_manager);
 
@@ -662,10 +1781,22 @@ JournalState::JournalState(LocalEnv *env_)
   : env(env_), current_fd(0), num_transactions(0),
     threshold(env_->config.journal_switch_threshold),
     disable_logging(false), count_bytes_flushed(0),
-    count_bytes_before_compression(0), count_bytes_after_compression(0)
+    count_bytes_before_compression(0), count_bytes_after_compression(0),
+    count_page_deltas(0), count_page_bytes_saved(0),
+    count_recovery_pages(0), count_recovery_operations(0),
+    count_recovery_parallel_operations(0), recovery_usec(0)
 {
+  files.resize(env_->config.journal_files);
+  file_state.resize(env_->config.journal_files);
+  file_size = env_->config.journal_file_size;
+  checkpoint.interval = env_->config.journal_checkpoint_interval;
+  segmented = files.size() != 2 || file_size > 0;
+  next_sequence = 1;
   if (threshold == 0)
     threshold = kSwitchTxnThreshold;
+  group.window_usec = env_->config.group_commit_usec;
+  group.max_size = env_->config.group_commit_size;
+  group.sync_msec = env_->config.journal_sync_msec;
 }
 
 Journal::Journal(LocalEnv *env)
@@ -676,31 +1807,106 @@ Journal::Journal(LocalEnv *env)
     state.compressor.reset(CompressorFactory::create(algo));
 }
 
+Journal::~Journal()
+{
+  stop_syncer(state);
+}
+
 void
 Journal::create()
 {
-  // create the two files
-  for (int i = 0; i < 2; i++) {
+  // create the files
+  for (size_t i = 0; i < state.files.size(); i++) {
     std::string path = log_file_path(state, i);
     state.files[i].create(path.c_str(), 0644);
+    if (state.file_size > 0)
+      state.files[i].allocate(state.file_size);
   }
 }
 
 void
 Journal::open()
 {
-  // open the two files
+  // open the files. The first two files are always required. If they start
+  // with a file header then the journal was segmented, and all following
+  // files are opened as well. If they contain entries without a header
+  // then the journal was not segmented. Configured files which do not
+  // exist are created.
+  size_t num_files = state.files.size();
+  bool has_header = false;
+  bool has_legacy_entries = false;
   try {
-    std::string path = log_file_path(state, 0);
-    state.files[0].open(path.c_str(), false);
-    path = log_file_path(state, 1);
-    state.files[1].open(path.c_str(), 0);
+    for (size_t i = 0; i < JournalState::kMaxFiles; i++) {
+      if (i == 2) {
+        has_header = read_file_sequence(state, 0) != 0
+                || read_file_sequence(state, 1) != 0;
+        has_legacy_entries = !has_header
+                && (state.files[0].file_size() > 0
+                    || state.files[1].file_size() > 0);
+        if (has_legacy_entries || (!has_header && num_files == 2)) {
+          state.files.resize(2);
+          state.file_state.resize(2);
+          break;
+        }
+      }
+      if (i >= state.files.size()) {
+        state.files.resize(i + 1);
+        state.file_state.resize(i + 1);
+      }
+
+      std::string path = log_file_path(state, i);
+      try {
+        state.files[i].open(path.c_str(), false);
+      }
+      catch (Exception &ex) {
+        if (i < 2 || ex.code != UPS_FILE_NOT_FOUND)
+          throw;
+        if (i >= num_files) {
+          state.files.resize(i);
+          state.file_state.resize(i);
+          break;
+        }
+        state.files[i].create(path.c_str(), 0644);
+        if (state.file_size > 0)
+          state.files[i].allocate(state.file_size);
+      }
+
+      // stale files of an older journal are ignored
+      if (i >= num_files && !has_header) {
+        state.files[i].close();
+        state.files.resize(i);
+        state.file_state.resize(i);
+        break;
+      }
+    }
   }
   catch (Exception &ex) {
-    state.files[1].close();
-    state.files[0].close();
+    for (size_t i = 0; i < state.files.size(); i++)
+      state.files[i].close();
     throw ex;
   }
+
+  // entries without header are recovered with the old file layout
+  if (has_legacy_entries)
+    state.file_size = 0;
+  state.segmented = has_header || state.files.size() != 2
+          || state.file_size > 0;
+  if (!is_segmented(state))
+    return;
+
+  // a segmented journal continues with the newest file
+  for (size_t i = 0; i < state.files.size(); i++) {
+    uint64_t sequence = read_file_sequence(state, i);
+    state.file_state[i].sequence = sequence;
+    if (sequence >= state.next_sequence) {
+      state.next_sequence = sequence + 1;
+      state.current_fd = i;
+    }
+  }
+
+  // if there is nothing to recover then discard the file headers
+  if (is_empty())
+    clear();
 }
 
 void
@@ -719,12 +1925,12 @@ Journal::append_txn_begin(LocalTxn *txn, const char *name, uint64_t lsn)
     entry.followup_size = ::strlen(name) + 1;
 
   int cur = txn->log_descriptor = switch_files_maybe(state);
+  state.file_state[cur].pending_txns++;
 
+  append_entry_header(state, cur, entry, file_tag(state));
   if (unlikely(txn->name.size()))
-    append_entry(state, cur, (uint8_t *)&entry, (uint32_t)sizeof(entry),
-                (uint8_t *)txn->name.c_str(), (uint32_t)txn->name.size() + 1);
-  else
-    append_entry(state, cur, (uint8_t *)&entry, (uint32_t)sizeof(entry));
+    append_entry(state, cur, (uint8_t *)txn->name.c_str(),
+                (uint32_t)txn->name.size() + 1);
 
   state.num_transactions++;
 }
@@ -742,11 +1948,100 @@ Journal::append_txn_commit(LocalTxn *txn, uint64_t lsn)
   entry.txn_id = txn->id;
   entry.type = Journal::kEntryTypeTxnCommit;
 
-  append_entry(state, txn->log_descriptor, (uint8_t *)&entry, sizeof(entry));
+  append_entry_header(state, txn->log_descriptor, entry, file_tag(state));
+  state.group.appended_lsn = lsn;
+
+  // with a background sync, the buffer is flushed by the background thread
+  // (or by ups_env_wait_for_commit)
+  if (state.group.sync_msec > 0) {
+    start_syncer_maybe(state);
+    ScopedLock lock(state.group.mutex);
+    add_commit_latency(state.group, 0);
+    return;
+  }
+
+  // with group commit, the buffer is flushed by the leader of the group
+  if (state.group.window_usec > 0)
+    return;
 
   // flush after commit
+  boost::system_time start = boost::get_system_time();
   flush_buffer(state, state.current_fd,
                   ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+
+  ScopedLock lock(state.group.mutex);
+  add_commit_latency(state.group, elapsed_usec(start));
+  state.group.group_count++;
+}
+
+void
+Journal::wait_for_durable_commit(uint64_t lsn)
+{
+  JournalState::GroupCommit &group = state.group;
+  if (group.sync_msec == 0)
+    return;
+
+  ScopedLock lock(group.mutex);
+  while (group.durable_lsn < lsn) {
+    // another thread is already flushing; wait till it is done
+    if (group.is_flushing) {
+      group.cond.wait(lock);
+      continue;
+    }
+
+    flush_commit_group(state, lock, false);
+  }
+}
+
+uint64_t
+Journal::durable_commit_lsn()
+{
+  if (state.group.sync_msec == 0 && state.group.window_usec == 0)
+    return state.group.appended_lsn;
+
+  ScopedLock lock(state.group.mutex);
+  return state.group.durable_lsn;
+}
+
+void
+Journal::wait_for_commit(uint64_t lsn)
+{
+  JournalState::GroupCommit &group = state.group;
+  boost::system_time start = boost::get_system_time();
+
+  ScopedLock lock(group.mutex);
+  group.waiting++;
+  if (group.waiting >= group.max_size)
+    group.cond.notify_all();
+
+  try {
+    while (group.durable_lsn < lsn) {
+      // another thread is the leader; wait till it flushed its group
+      if (group.is_flushing) {
+        group.cond.wait(lock);
+        continue;
+      }
+
+      // otherwise this thread becomes the leader. Wait till the group
+      // is complete or the time window expired
+      group.is_flushing = true;
+      boost::system_time deadline = start
+              + boost::posix_time::microseconds(group.window_usec);
+      while (group.waiting < group.max_size
+              && group.cond.timed_wait(lock, deadline))
+        ;
+
+      // flush the buffer with all commits of the group
+      flush_commit_group(state, lock, false);
+    }
+  }
+  catch (...) {
+    group.waiting--;
+    throw;
+  }
+
+  group.waiting--;
+  add_commit_latency(group, elapsed_usec(start));
 }
 
 void
@@ -771,13 +2066,15 @@ Journal::append_insert(Db *db, LocalTxn *txn,
   int idx;
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY)) {
     entry.txn_id = 0;
-    idx = switch_files_maybe(state);
+    idx = txn->log_descriptor = switch_files_maybe(state);
+    state.file_state[idx].pending_txns++;
     state.num_transactions++;
   }
   else {
     entry.txn_id = txn->id;
     idx = txn->log_descriptor;
   }
+  uint64_t tag = file_tag(state);
 
   PJournalEntryInsert insert;
   insert.key_size = key->size;
@@ -790,7 +2087,8 @@ Journal::append_insert(Db *db, LocalTxn *txn,
   uint32_t entry_position = state.buffer.size();
 
   // write the header information
-  append_entry(state, idx, (uint8_t *)&entry, sizeof(entry),
+  append_entry_header(state, idx, entry, tag);
+  append_entry(state, idx,
               (uint8_t *)&insert, sizeof(PJournalEntryInsert) - 1);
 
   // try to compress the payload; if the compressed result is smaller than
@@ -830,12 +2128,11 @@ Journal::append_insert(Db *db, LocalTxn *txn,
   // now overwrite the patched entry
   state.buffer.overwrite(entry_position,
                   (uint8_t *)&entry, sizeof(entry));
-  state.buffer.overwrite(entry_position + sizeof(entry),
+  state.buffer.overwrite(entry_position + entry_header_size(state),
                   (uint8_t *)&insert, sizeof(PJournalEntryInsert) - 1);
 
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY))
-    flush_buffer(state, state.current_fd,
-                    ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+    commit_temporary_txn(state, lsn);
 }
 
 void
@@ -874,7 +2171,8 @@ Journal::append_erase(Db *db, LocalTxn *txn, ups_key_t *key,
   int idx;
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY)) {
     entry.txn_id = 0;
-    idx = switch_files_maybe(state);
+    idx = txn->log_descriptor = switch_files_maybe(state);
+    state.file_state[idx].pending_txns++;
     state.num_transactions++;
   }
   else {
@@ -883,13 +2181,12 @@ Journal::append_erase(Db *db, LocalTxn *txn, ups_key_t *key,
   }
 
   // append the entry to the logfile
-  append_entry(state, idx, (uint8_t *)&entry, sizeof(entry),
-                (uint8_t *)&erase, sizeof(PJournalEntryErase) - 1,
+  append_entry_header(state, idx, entry, file_tag(state));
+  append_entry(state, idx, (uint8_t *)&erase, sizeof(PJournalEntryErase) - 1,
                 (uint8_t *)payload_data, payload_size);
 
   if (ISSET(txn->flags, UPS_TXN_TEMPORARY))
-    flush_buffer(state, state.current_fd,
-                    ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
+    commit_temporary_txn(state, lsn);
 }
 
 int
@@ -908,6 +2205,7 @@ Journal::append_changeset(std::vector<Page *> &pages,
   entry.dbname = 0;
   entry.txn_id = 0;
   entry.type = Journal::kEntryTypeChangeset;
+  uint64_t tag = file_tag(state);
   // followup_size is incomplete - the actual page sizes are added later
   entry.followup_size = sizeof(PJournalEntryChangeset);
   changeset.num_pages = pages.size();
@@ -919,14 +2217,17 @@ Journal::append_changeset(std::vector<Page *> &pages,
   uint32_t entry_position = state.buffer.size();
 
   // write the data to the file
-  append_entry(state, state.current_fd, (uint8_t *)&entry, sizeof(entry),
+  append_entry_header(state, state.current_fd, entry, tag);
+  append_entry(state, state.current_fd,
                 (uint8_t *)&changeset, sizeof(PJournalEntryChangeset));
 
   size_t page_size = state.env->config.page_size_bytes;
+  ByteArray delta;
   for (std::vector<Page *>::iterator it = pages.begin();
                   it != pages.end();
                   ++it) {
-    entry.followup_size += append_changeset_page(state, *it, page_size);
+    entry.followup_size += append_changeset_page(state, *it, page_size,
+                    &delta);
   }
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
@@ -936,18 +2237,45 @@ Journal::append_changeset(std::vector<Page *> &pages,
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
+  // the pages are dirty till the worker thread wrote them (see
+  // changeset_flushed())
+  if (state.checkpoint.interval > 0) {
+    std::vector<uint64_t> addresses;
+    addresses.reserve(pages.size());
+    for (std::vector<Page *>::iterator it = pages.begin();
+                    it != pages.end();
+                    ++it)
+      addresses.push_back((*it)->address());
+
+    ScopedLock lock(state.checkpoint.mutex);
+    state.checkpoint.pending[lsn].swap(addresses);
+  }
+
+  append_checkpoint_maybe(state, lsn);
+
   // and flush the file
   flush_buffer(state, state.current_fd,
                   ISSET(state.env->flags(), UPS_ENABLE_FSYNC));
 
   UPS_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
+  // the logged pages are the base for the next deltas
+  if (state.env->config.journal_page_deltas) {
+    for (std::vector<Page *>::iterator it = pages.begin();
+                    it != pages.end();
+                    ++it)
+      store_journal_image(state, *it, page_size);
+  }
+
   return state.current_fd;
 }
 
 void
 Journal::close(bool noclear)
 {
+  // the background thread must not access the files after they were closed
+  stop_syncer(state);
+
   // the noclear flag is set during testing, for checking whether the files
   // contain the correct data. Flush the buffers, otherwise the tests will
   // fail because data is missing
@@ -957,7 +2285,7 @@ Journal::close(bool noclear)
   if (likely(!noclear))
     clear();
 
-  for (int i = 0; i < 2; i++)
+  for (size_t i = 0; i < state.files.size(); i++)
     state.files[i].close();
 
   state.buffer.clear();
@@ -967,6 +2295,7 @@ void
 Journal::recover(LocalTxnManager *txn_manager)
 {
   Context context(state.env, 0, 0);
+  boost::system_time start = boost::get_system_time();
 
   // first redo the changesets
   uint64_t start_lsn = recover_changeset(state);
@@ -982,14 +2311,63 @@ Journal::recover(LocalTxnManager *txn_manager)
   if (ISSET(state.env->flags(), UPS_ENABLE_TRANSACTIONS))
     recover_journal(state, &context, txn_manager, start_lsn);
 
+  state.recovery_usec = elapsed_usec(start);
+
   // clear the journal files
   clear();
 }
 
+bool
+Journal::is_empty()
+{
+  for (size_t i = 0; i < state.files.size(); i++) {
+    if (!state.files[i].is_open())
+      continue;
+
+    if (!is_segmented(state)) {
+      if (state.files[i].file_size() > 0)
+        return false;
+      continue;
+    }
+
+    uint64_t offset;
+    uint64_t tag;
+    PJournalEntry entry;
+    if (file_begin(state, i, &offset, &tag)
+        && read_entry_header(state, i, offset, state.files[i].file_size(),
+                        tag, &entry))
+      return false;
+  }
+
+  return true;
+}
+
+void
+Journal::txn_flushed(LocalTxn *txn)
+{
+  if (txn->log_descriptor < 0)
+    return;
+
+  JournalState::FileState &fs = state.file_state[txn->log_descriptor];
+  if (fs.pending_txns > 0)
+    fs.pending_txns--;
+  txn->log_descriptor = -1;
+}
+
+void
+Journal::changeset_flushed(uint64_t lsn)
+{
+  if (state.checkpoint.interval == 0)
+    return;
+
+  ScopedLock lock(state.checkpoint.mutex);
+  state.checkpoint.pending.erase(lsn);
+}
+
 void
 Journal::clear()
 {
-  for (int i = 0; i < 2; i++)
+  for (size_t i = 0; i < state.files.size(); i++)
     clear_file(state, i);
 }
 
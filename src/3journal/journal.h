@@ -29,9 +29,17 @@
  *
  * The journal is organized in two files. If one of the files grows too large
  * then all new Txns are stored in the other file
- * ("Log file switching"). When all Txns from file #0 are committed,
+ * ("Log file switching"). When all Txns from file #0 are flushed,
  * and file #1 exceeds a limit, then the files are switched back again.
  *
+ * A "segmented" journal uses more than two files (UPS_PARAM_JOURNAL_FILES)
+ * and/or preallocated files of a fixed size (UPS_PARAM_JOURNAL_FILE_SIZE).
+ * The files are used in a ring; each file starts with a header which
+ * stores a 64bit sequence number, and each entry is followed by this number
+ * (PJournalEntryTag). Preallocated files are not truncated when they are
+ * reused; the tag identifies the stale entries of the previous use. The
+ * entries of the default journal are not tagged; its layout is unchanged.
+ *
  * For writing, files are buffered. The buffers are flushed when they
  * exceed a certain threshold, when a Txn is committed or a Changeset
  * was written. In case of a commit or a changeset there will also be an
@@ -64,6 +72,14 @@
  * already applied, and we know that all older changesets
  * have already been written successfully to the database file.
  *
+ * The pages of the changesets are redone in parallel by the worker threads
+ * (UPS_PARAM_WORKER_THREADS); each page is assigned to a worker by its
+ * address. Afterwards the inserts and erases are replayed. The recovering
+ * thread reads the journal and assigns the operations to a worker by
+ * their database; the workers only stage them in the TxnIndex. The
+ * btree is only modified by the recovering thread while the workers are
+ * idle, when the committed Txns are flushed.
+ *
  * @exception_safe: basic
  * @thread_safe: no
  */
@@ -128,7 +144,10 @@ struct Journal
     kEntryTypeErase      = 5,
 
     // marks a whole changeset operation (writes modified pages)
-    kEntryTypeChangeset  = 6
+    kEntryTypeChangeset  = 6,
+
+    // marks a checkpoint (lists the pages which were not yet written)
+    kEntryTypeCheckpoint = 7
   };
 
   //
@@ -136,22 +155,28 @@ struct Journal
   //
   struct Iterator {
     Iterator()
-      : fdidx(0), fdstart(0), offset(0) {
+      : fdidx(0), fdstart(0), offset(0), tag(0) {
     }
 
-    // selects the file descriptor [0..1]
+    // selects the file descriptor
     int fdidx;
 
-    // which file descriptor did we start with? [0..1]
+    // which file descriptor did we start with?
     int fdstart;
 
     // the offset in the file of the NEXT entry
     uint64_t offset;
+
+    // the tag of the entries in the current file
+    uint64_t tag;
   };
 
   // Constructor
   Journal(LocalEnv *env);
 
+  // Destructor; stops the background thread
+  ~Journal();
+
   // Creates a new journal
   void create();
 
@@ -159,26 +184,47 @@ struct Journal
   void open();
 
   // Returns true if the journal is empty
-  bool is_empty() const {
-    if (!state.files[0].is_open() && !state.files[1].is_open())
-      return true;
-
-    for (int i = 0; i < 2; i++) {
-      uint64_t size = state.files[i].file_size();
-      if (size > 0)
-        return false;
-    }
-
-    return true;
-  }
+  bool is_empty();
 
   // Appends a journal entry for ups_txn_begin/kEntryTypeTxnBegin
   void append_txn_begin(LocalTxn *txn, const char *name,
                   uint64_t lsn);
 
-  // Appends a journal entry for ups_txn_commit/kEntryTypeTxnCommit
+  // Appends a journal entry for ups_txn_commit/kEntryTypeTxnCommit. With
+  // group commit, the entry is flushed by wait_for_commit().
   void append_txn_commit(LocalTxn *txn, uint64_t lsn);
 
+  // Returns the lsn of the last commit if group commit is enabled,
+  // otherwise 0 (also if the journal is synced in the background). The
+  // caller must hold the Environment's lock.
+  uint64_t pending_commit_lsn() const {
+    return state.group.window_usec > 0 && state.group.sync_msec == 0
+              ? state.group.appended_lsn
+              : 0;
+  }
+
+  // Waits till the commit with |lsn| was flushed (and synced). One of the
+  // waiting threads becomes the leader of the group and flushes the
+  // commits of all threads which arrived within the time window.
+  // The caller must NOT hold the Environment's lock.
+  void wait_for_commit(uint64_t lsn);
+
+  // Returns the lsn of the most recent commit. The caller must hold the
+  // Environment's lock.
+  uint64_t last_commit_lsn() const {
+    return state.group.appended_lsn;
+  }
+
+  // Returns the lsn up to which all commits are durable. The caller must
+  // hold the Environment's lock.
+  uint64_t durable_commit_lsn();
+
+  // With a background sync (UPS_PARAM_JOURNAL_SYNC_MSEC), flushes and syncs
+  // the journal unless the commit with |lsn| is already durable. Otherwise
+  // commits are durable when ups_txn_commit returns, and this method does
+  // nothing. The caller must NOT hold the Environment's lock.
+  void wait_for_durable_commit(uint64_t lsn);
+
   // Appends a journal entry for ups_insert/kEntryTypeInsert
   void append_insert(Db *db, LocalTxn *txn,
                   ups_key_t *key, ups_record_t *record, uint32_t flags,
@@ -195,6 +241,14 @@ struct Journal
   int append_changeset(std::vector<Page *> &pages, uint64_t last_blob_page,
                   uint64_t lsn);
 
+  // Called by the worker thread when the pages of the changeset with |lsn|
+  // were written to the database file
+  void changeset_flushed(uint64_t lsn);
+
+  // Called when a committed Txn was flushed to the database (or an aborted
+  // Txn was discarded); its journal file can then be reused
+  void txn_flushed(LocalTxn *txn);
+
   // Empties the journal, removes all entries
   void clear();
 
@@ -212,6 +266,21 @@ struct Journal
             = state.count_bytes_before_compression;
     metrics->journal_bytes_after_compression
             = state.count_bytes_after_compression;
+    metrics->journal_page_deltas = state.count_page_deltas;
+    metrics->journal_page_bytes_saved = state.count_page_bytes_saved;
+    metrics->journal_checkpoints = state.checkpoint.count;
+    metrics->journal_recovery_skipped_pages = state.checkpoint.skipped_pages;
+    metrics->journal_recovery_pages = state.count_recovery_pages;
+    metrics->journal_recovery_operations = state.count_recovery_operations;
+    metrics->journal_recovery_parallel_operations =
+            state.count_recovery_parallel_operations;
+    metrics->journal_recovery_usec = state.recovery_usec;
+
+    ScopedLock lock(state.group.mutex);
+    metrics->journal_commit_count = state.group.commit_count;
+    metrics->journal_commit_groups = state.group.group_count;
+    metrics->journal_commit_latency_usec = state.group.latency_usec;
+    metrics->journal_commit_max_latency_usec = state.group.max_latency_usec;
   }
 
   // Flushes all buffers to disk. Used for testing.
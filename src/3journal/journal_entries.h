@@ -74,6 +74,56 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntry {
 #include "1base/packstop.h"
 
 
+#include "1base/packstart.h"
+
+/*
+ * In a segmented journal, each PJournalEntry is followed by the sequence
+ * number of its file; entries from a previous use of the file have a
+ * different tag. The default journal does not write the tag.
+ */
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryTag {
+  // Constructor
+  PJournalEntryTag(uint64_t _sequence = 0)
+    : sequence(_sequence) {
+  }
+
+  // the sequence number of the file
+  uint64_t sequence;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
+#include "1base/packstart.h"
+
+/*
+ * The header of a journal file; only used by segmented journals (see
+ * UPS_PARAM_JOURNAL_FILES and UPS_PARAM_JOURNAL_FILE_SIZE)
+ */
+UPS_PACK_0 struct UPS_PACK_1 PJournalFileHeader {
+  enum {
+    // the magic number
+    kMagic = ('J' << 24) | ('R' << 16) | ('N' << 8) | 'S'
+  };
+
+  // Constructor
+  PJournalFileHeader(uint64_t _sequence = 0)
+    : magic(kMagic), _reserved(0), sequence(_sequence) {
+  }
+
+  // the magic number
+  uint32_t magic;
+
+  // a reserved value - reqd for padding
+  uint32_t _reserved;
+
+  // the sequence number; incremented whenever a file is (re)used
+  uint64_t sequence;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
 #include "1base/packstart.h"
 
 //
@@ -181,24 +231,79 @@ UPS_PACK_0 struct UPS_PACK_1 PJournalEntryChangeset {
 #include "1base/packstop.h"
 
 
+#include "1base/packstart.h"
+
+//
+// a Journal entry for a checkpoint; followed by the addresses of the
+// pages which were not yet written to the database file (|num_pages|
+// 64bit values)
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryCheckpoint {
+  // Constructor - sets all fields to 0
+  PJournalEntryCheckpoint()
+    : redo_lsn(0), num_pages(0), _reserved(0) {
+  }
+
+  // all changesets with a lower lsn were written to the database file
+  uint64_t redo_lsn;
+
+  // number of dirty pages
+  uint32_t num_pages;
+
+  // unused
+  uint32_t _reserved;
+} UPS_PACK_2;
+
+#include "1base/packstop.h"
+
+
 #include "1base/packstart.h"
 
 //
 // a Journal entry for a single page
 //
 UPS_PACK_0 struct UPS_PACK_1 PJournalEntryPageHeader {
+  enum {
+    // The lowest bit of the address is set if the entry stores the
+    // modified byte ranges of the page, not the full page
+    kDelta = 1
+  };
+
   // Constructor - sets all fields to 0
   PJournalEntryPageHeader(uint64_t _address = 0)
     : address(_address), compressed_size(0) {
   }
 
+  // Returns true if the entry stores a delta
+  bool is_delta() const {
+    return (address & kDelta) != 0;
+  }
+
+  // Returns the page address
+  uint64_t page_address() const {
+    return address & ~(uint64_t)kDelta;
+  }
+
   // the page address
   uint64_t address;
 
-  // the compressed size, if compression is enabled
+  // the compressed size, if compression is enabled; for deltas, the size
+  // of the delta
   uint32_t compressed_size;
 } UPS_PACK_2;
 
+//
+// A delta stores a sequence of modified byte ranges; each range starts
+// with this header, followed by |length| bytes of page data
+//
+UPS_PACK_0 struct UPS_PACK_1 PJournalEntryPageRange {
+  // the offset of the range in the page
+  uint32_t offset;
+
+  // the length of the range
+  uint32_t length;
+} UPS_PACK_2;
+
 #include "1base/packstop.h"
 
 } // namespace upscaledb
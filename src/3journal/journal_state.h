@@ -21,12 +21,14 @@
 
 #include "0root/root.h"
 
+#include <map>
 #include <vector>
 #include <string>
 
 #include "ups/types.h" // for metrics
 
 #include "1base/dynamic_array.h"
+#include "1base/mutex.h"
 #include "1base/scoped_ptr.h"
 #include "1os/file.h"
 #include "2page/page_collection.h"
@@ -44,16 +46,148 @@ struct Db;
 struct LocalEnv;
 
 struct JournalState {
+  // The state of the group commit (see UPS_PARAM_GROUP_COMMIT_USEC). Only
+  // |appended_lsn| is protected by the Environment's lock; all other
+  // members are protected by |mutex|.
+  struct GroupCommit {
+    GroupCommit()
+      : window_usec(0), max_size(0), sync_msec(0), is_flushing(false),
+        waiting(0), stop_syncer(false), appended_lsn(0), durable_lsn(0),
+        commit_count(0), group_count(0), latency_usec(0),
+        max_latency_usec(0) {
+    }
+
+    // The time window, in microseconds; 0 if group commit is disabled
+    uint32_t window_usec;
+
+    // The max. number of commits per group
+    uint32_t max_size;
+
+    // The interval of the background sync, in milliseconds; 0 if commits
+    // are flushed before ups_txn_commit returns (see
+    // UPS_PARAM_JOURNAL_SYNC_MSEC)
+    uint32_t sync_msec;
+
+    // Protects the members below
+    Mutex mutex;
+
+    // Signalled when a group was flushed, or a new commit is waiting
+    Condition cond;
+
+    // True while the leader of a group collects and flushes the group
+    bool is_flushing;
+
+    // Number of commits which wait for their group
+    uint32_t waiting;
+
+    // Set to true when the background thread has to stop
+    bool stop_syncer;
+
+    // The background thread which periodically syncs the journal; can
+    // be null
+    ScopedPtr<Thread> syncer;
+
+    // The lsn of the newest commit in the journal buffer
+    uint64_t appended_lsn;
+
+    // All commits up to this lsn were flushed
+    uint64_t durable_lsn;
+
+    // Number of journaled commits (for ups_env_get_metrics)
+    uint64_t commit_count;
+
+    // Number of flushes for these commits (for ups_env_get_metrics)
+    uint64_t group_count;
+
+    // Accumulated and max. commit latency (for ups_env_get_metrics)
+    uint64_t latency_usec;
+    uint64_t max_latency_usec;
+  };
+
+  // The state of the fuzzy checkpoints (see
+  // UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL). |pending| is protected by
+  // |mutex|, because the worker threads remove the changesets when their
+  // pages were written; all other members are protected by the
+  // Environment's lock.
+  struct Checkpoint {
+    Checkpoint()
+      : interval(0), last_bytes_flushed(0), count(0), skipped_pages(0) {
+    }
+
+    // The max. number of journal bytes between two checkpoints; 0 if
+    // checkpoints are disabled
+    uint64_t interval;
+
+    // The value of |count_bytes_flushed| when the last checkpoint was
+    // written
+    uint64_t last_bytes_flushed;
+
+    // Protects |pending|
+    Mutex mutex;
+
+    // The changesets whose pages were not yet written to the database
+    // file: lsn => page addresses
+    std::map<uint64_t, std::vector<uint64_t> > pending;
+
+    // Number of written checkpoints (for ups_env_get_metrics)
+    uint64_t count;
+
+    // Number of pages which were not redone during recovery because
+    // they were already written (for ups_env_get_metrics)
+    uint64_t skipped_pages;
+  };
+
+  // The state of a single journal file
+  struct FileState {
+    FileState()
+      : generation(0), sequence(0), size(0), pending_txns(0) {
+    }
+
+    // Incremented whenever the file is cleared; a page is logged as a
+    // delta only if its previous image is still in the file
+    uint64_t generation;
+
+    // The sequence number of the file (segmented journals only); 0 if the
+    // file is not in use
+    uint64_t sequence;
+
+    // The number of bytes written to the file
+    uint64_t size;
+
+    // Number of committed transactions with entries in this file which
+    // were not yet flushed to the database; the file is not cleared
+    // while transactions are pending
+    uint32_t pending_txns;
+  };
+
+  enum {
+    // The max. number of journal files
+    kMaxFiles = 64
+  };
+
   JournalState(LocalEnv *env_);
 
   // References the Environment this journal file is for
   LocalEnv *env;
 
-  // The index of the file descriptor we are currently writing to (0 or 1)
+  // The index of the file descriptor we are currently writing to
   uint32_t current_fd;
 
-  // The two file descriptors
-  File files[2];
+  // The file descriptors; the files are used in a ring
+  std::vector<File> files;
+
+  // The state of each file
+  std::vector<FileState> file_state;
+
+  // The preallocated size of each file; 0 if the files grow on demand
+  uint64_t file_size;
+
+  // True if more than two files or preallocated files are used; then each
+  // file starts with a PJournalFileHeader
+  bool segmented;
+
+  // The sequence number of the next file that is used
+  uint64_t next_sequence;
 
   // Buffer for writing data to the files
   ByteArray buffer;
@@ -77,12 +211,39 @@ struct JournalState {
   // Counting the bytes after compression (for ups_env_get_metrics)
   uint64_t count_bytes_after_compression;
 
+  // Counting the pages which were logged as deltas (for ups_env_get_metrics)
+  uint64_t count_page_deltas;
+
+  // Counting the bytes saved by page deltas (for ups_env_get_metrics)
+  uint64_t count_page_bytes_saved;
+
+  // Counting the pages which were redone during recovery (for
+  // ups_env_get_metrics)
+  uint64_t count_recovery_pages;
+
+  // Counting the operations which were replayed during recovery (for
+  // ups_env_get_metrics)
+  uint64_t count_recovery_operations;
+
+  // Counting the replayed operations which were staged by the worker
+  // threads (for ups_env_get_metrics)
+  uint64_t count_recovery_parallel_operations;
+
+  // The duration of the recovery, in microseconds (for ups_env_get_metrics)
+  uint64_t recovery_usec;
+
   // A map of all opened databases
   typedef std::map<uint16_t, Db *> DatabaseMap;
   DatabaseMap database_map;
 
   // The compressor; can be null
   ScopedPtr<Compressor> compressor;
+
+  // The group commit state
+  GroupCommit group;
+
+  // The state of the checkpoints
+  Checkpoint checkpoint;
 };
 
 } // namespace upscaledb
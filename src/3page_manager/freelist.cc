@@ -18,6 +18,8 @@
 
 #include "0root/root.h"
 
+#include <algorithm>
+
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
 #include "1base/pickle.h"
@@ -29,16 +31,25 @@
 
 namespace upscaledb {
 
-std::pair<bool, Freelist::FreeMap::const_iterator>
-Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
-                uint8_t *data, size_t data_size)
+std::pair<bool, uint64_t>
+Freelist::encode_state(std::pair<bool, uint64_t> cont, uint8_t *data,
+                size_t data_size)
 {
   uint32_t page_size = config.page_size_bytes;
-  Freelist::FreeMap::const_iterator it = cont.second;
-  if (cont.first == false)
+  uint64_t current = cont.second;
+  FreeMap::const_iterator it;
+  if (cont.first == false) {
     it = free_pages.begin();
-  else
-    assert(it != free_pages.end());
+    if (it != free_pages.end())
+      current = it->first;
+  }
+  else {
+    // find the extent which contains |current|
+    it = free_pages.upper_bound(current);
+    assert(it != free_pages.begin());
+    it--;
+    assert(current < it->first + it->second * page_size);
+  }
   
   uint32_t counter = 0;
   uint8_t *p = data;
@@ -51,20 +62,17 @@ Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
     if ((p + 9) - data >= (ptrdiff_t)data_size)
       break;
 
-    // check if the next entry (and the following) are adjacent; if yes then
-    // they are merged. Up to 16 pages can be merged.
-    uint32_t page_counter = 1;
-    uint64_t base = it->first;
+    // an entry stores up to 15 pages; larger extents are split
+    uint64_t end = it->first + it->second * page_size;
+    uint64_t base = current;
     assert(base % page_size == 0);
-    uint64_t current = it->first;
-
-    // move to the next entry, then merge all adjacent pages
-    for (it++; it != free_pages.end() && page_counter < 16 - 1; it++) {
-      if (it->first != current + page_size)
-        break;
-      current += page_size;
-      page_counter++;
-    }
+    uint32_t page_counter = (uint32_t)std::min<uint64_t>(15,
+                    (end - base) / page_size);
+
+    // move to the next extent if this one is complete
+    current += page_counter * page_size;
+    if (current == end && ++it != free_pages.end())
+      current = it->first;
 
     // now |base| is the start of a sequence of free pages, and the
     // sequence has |page_counter| pages
@@ -74,7 +82,7 @@ Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
     //   - 4 bits for |page_counter|
     //   - 4 bits for the number of bytes following ("n")
     // - n byte page-id (div page_size)
-    assert(page_counter < 16);
+    assert(page_counter > 0 && page_counter < 16);
     int num_bytes = Pickle::encode_u64(p + 1, base / page_size);
     *p = (page_counter << 4) | num_bytes;
     p += 1 + num_bytes;
@@ -85,10 +93,7 @@ Freelist::encode_state(std::pair<bool, Freelist::FreeMap::const_iterator> cont,
   // now store the counter
   *(uint32_t *)(data + 8) = counter;
 
-  std::pair<bool, Freelist::FreeMap::const_iterator> retval;
-  retval.first = (it != free_pages.end());
-  retval.second = it;
-  return retval;
+  return std::make_pair(it != free_pages.end(), current);
 }
 
 void
@@ -112,7 +117,7 @@ Freelist::decode_state(uint8_t *data)
     uint64_t id = Pickle::decode_u64(num_bytes, data);
     data += num_bytes;
 
-    free_pages[id * page_size] = page_counter;
+    put(id * page_size, page_counter);
   }
 }
 
@@ -122,20 +127,19 @@ Freelist::alloc(size_t num_pages)
   uint64_t address = 0;
   uint32_t page_size = config.page_size_bytes;
 
-  for (FreeMap::iterator it = free_pages.begin();
-            it != free_pages.end();
-            it++) {
-    if (it->second == num_pages) {
-      address = it->first;
-      free_pages.erase(it);
-      break;
-    }
-    if (it->second > num_pages) {
-      address = it->first;
-      free_pages[it->first + num_pages * page_size] = it->second - num_pages;
-      free_pages.erase(it);
-      break;
-    }
+  // pick the smallest extent which is large enough; if there are several
+  // then pick the one with the lowest address
+  SizeIndex::iterator sit = free_extents.lower_bound(
+                  std::make_pair(num_pages, (uint64_t)0));
+  if (sit != free_extents.end()) {
+    address = sit->second;
+    size_t page_count = sit->first;
+    erase_extent(free_pages.find(address));
+
+    // the remaining pages cannot be adjacent to another extent, otherwise
+    // they would have been merged
+    if (page_count > num_pages)
+      insert_extent(address + num_pages * page_size, page_count - num_pages);
   }
 
   if (address != 0)
@@ -149,13 +153,41 @@ Freelist::alloc(size_t num_pages)
 void
 Freelist::put(uint64_t page_id, size_t page_count)
 {
-  free_pages[page_id] = page_count;
+  uint32_t page_size = config.page_size_bytes;
+
+  // merge with the following extent
+  FreeMap::iterator next = free_pages.lower_bound(page_id);
+  if (next != free_pages.end()) {
+    assert(next->first >= page_id + page_count * page_size);
+    if (next->first == page_id + page_count * page_size) {
+      page_count += next->second;
+      erase_extent(next);
+    }
+  }
+
+  // merge with the preceding extent
+  FreeMap::iterator prev = free_pages.lower_bound(page_id);
+  if (prev != free_pages.begin()) {
+    prev--;
+    assert(prev->first + prev->second * page_size <= page_id);
+    if (prev->first + prev->second * page_size == page_id) {
+      page_id = prev->first;
+      page_count += prev->second;
+      erase_extent(prev);
+    }
+  }
+
+  insert_extent(page_id, page_count);
 }
 
 bool
 Freelist::has(uint64_t page_id) const
 {
-  return free_pages.find(page_id) != free_pages.end();
+  FreeMap::const_iterator it = free_pages.upper_bound(page_id);
+  if (it == free_pages.begin())
+    return false;
+  it--;
+  return page_id < it->first + it->second * config.page_size_bytes;
 }
 
 uint64_t
@@ -177,9 +209,8 @@ Freelist::truncate(uint64_t file_size)
   }
 
   // remove all truncated pages
-  while (!free_pages.empty() && free_pages.rbegin()->first >= lower_bound) {
-    free_pages.erase(free_pages.rbegin()->first);
-  }
+  while (!free_pages.empty() && free_pages.rbegin()->first >= lower_bound)
+    erase_extent(--free_pages.end());
 
   return lower_bound;
 }
@@ -19,6 +19,11 @@
 /*
  * The Freelist manages the list of currently unused (free) pages.
  *
+ * Free pages are stored as extents (runs of adjacent pages), which are
+ * indexed by address and by size. Adjacent extents are merged when pages
+ * are added. Allocations use the smallest extent which is large enough
+ * ("best fit"); both operations are O(log n).
+ *
  * @exception_safe: basic
  * @thread_safe: no
  */
@@ -29,6 +34,7 @@
 #include "0root/root.h"
 
 #include <map>
+#include <set>
 
 // Always verify that a file of level N does not include headers > N!
 #include "2config/env_config.h"
@@ -41,9 +47,12 @@ namespace upscaledb {
 
 struct Freelist
 {
-  // The freelist maps page-id to number of free pages (usually 1)
+  // The freelist maps page-id to number of free pages in the extent
   typedef std::map<uint64_t, size_t> FreeMap;
 
+  // Indexes the extents by number of pages, then by page-id
+  typedef std::set<std::pair<size_t, uint64_t> > SizeIndex;
+
   // Constructor
   Freelist(const EnvConfig &config_)
     : config(config_) {
@@ -55,6 +64,7 @@ struct Freelist
     freelist_hits = 0;
     freelist_misses = 0;
     free_pages.clear();
+    free_extents.clear();
   }
 
   // Returns true if the freelist is empty
@@ -64,11 +74,9 @@ struct Freelist
 
   // Encodes the freelist's state in |data|. Returns a bool which is set to
   // true if there is additional data, or false if the whole state was
-  // encoded.
+  // encoded. The second value is the page-id where the next call continues.
   // Set |cont.first| to false for the first call.
-  std::pair<bool, Freelist::FreeMap::const_iterator>
-                    encode_state(
-                        std::pair<bool, Freelist::FreeMap::const_iterator> cont,
+  std::pair<bool, uint64_t> encode_state(std::pair<bool, uint64_t> cont,
                         uint8_t *data, size_t data_size);
 
   // Decodes the freelist's state from raw data and adds it to the internal
@@ -79,7 +87,7 @@ struct Freelist
   // page id of the first page, or 0 if not successfull
   uint64_t alloc(size_t num_pages);
 
-  // Stores a page in the freelist
+  // Stores a page in the freelist; merges it with adjacent extents
   void put(uint64_t page_id, size_t page_count);
 
   // Returns true if a page is in the freelist
@@ -90,12 +98,27 @@ struct Freelist
   // if there are no unused pages at the end.
   uint64_t truncate(uint64_t file_size);
 
+  // Adds an extent to both indices
+  void insert_extent(uint64_t page_id, size_t page_count) {
+    free_pages[page_id] = page_count;
+    free_extents.insert(std::make_pair(page_count, page_id));
+  }
+
+  // Removes an extent from both indices
+  void erase_extent(FreeMap::iterator it) {
+    free_extents.erase(std::make_pair(it->second, it->first));
+    free_pages.erase(it);
+  }
+
   // Copy of the Environment's configuration
   const EnvConfig &config;
 
   // The map with free pages
   FreeMap free_pages;
 
+  // The same extents, sorted by size
+  SizeIndex free_extents;
+
   // number of successful freelist hits
   uint64_t freelist_hits;
 
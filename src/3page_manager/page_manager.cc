@@ -72,6 +72,11 @@ struct AsyncFlushMessage
 static void
 async_flush_pages(AsyncFlushMessage *message)
 {
+  std::vector<Page *> locked_pages;
+  std::vector<Page *> dirty_pages;
+  locked_pages.reserve(message->page_ids.size());
+  dirty_pages.reserve(message->page_ids.size());
+
   for (std::vector<uint64_t>::iterator it = message->page_ids.begin();
                   it != message->page_ids.end();
                   it++) {
@@ -80,24 +85,88 @@ async_flush_pages(AsyncFlushMessage *message)
     if (!page)
       continue;
     assert(page->mutex().try_lock() == false);
+    locked_pages.push_back(page);
 
     // flush page if it's dirty
-    if (page->is_dirty()) {
-      try {
-        page->flush();
-      }
-      catch (Exception &) {
-        // ignore page, fall through
-      }
+    if (page->is_dirty())
+      dirty_pages.push_back(page);
+  }
+
+  // write all dirty pages at once; devices with asynchronous I/O submit
+  // them in a single batch
+  if (!dirty_pages.empty()) {
+    try {
+      Page::flush_multiple(&dirty_pages[0], dirty_pages.size());
+    }
+    catch (Exception &) {
+      // ignore pages, fall through
     }
-    page->mutex().unlock();
   }
+
+  for (std::vector<Page *>::iterator it = locked_pages.begin();
+                  it != locked_pages.end();
+                  it++)
+    (*it)->mutex().unlock();
+
   if (message->in_progress)
     message->in_progress = false;
   if (message->signal)
     message->signal->notify();
 }
 
+// Pages of the same file region are always flushed by the same worker
+// thread, otherwise adjacent pages could not be combined in a single write
+static inline size_t
+flush_region(PageManagerState *state, uint64_t address)
+{
+  enum { kFlushRegionPages = 64 };
+  return (size_t)(address / ((uint64_t)state->config.page_size_bytes
+                                * kFlushRegionPages));
+}
+
+// Distributes the pages over the worker threads, then waits till all of
+// them were flushed
+static void
+flush_pages_and_wait(PageManager *page_manager, PageManagerState *state,
+                std::vector<uint64_t> &page_ids)
+{
+  size_t num_threads = state->worker->size();
+  std::vector<Signal> signals(num_threads);
+  std::vector<AsyncFlushMessage *> messages(num_threads);
+  for (size_t i = 0; i < num_threads; i++)
+    messages[i] = new AsyncFlushMessage(page_manager, state->device,
+                                    &signals[i]);
+
+  for (std::vector<uint64_t>::iterator it = page_ids.begin();
+                  it != page_ids.end();
+                  it++)
+    messages[flush_region(state, *it) % num_threads]->page_ids.push_back(*it);
+
+  for (size_t i = 0; i < num_threads; i++) {
+    if (messages[i]->page_ids.size() > 0)
+      page_manager->run_async(boost::bind(&async_flush_pages, messages[i]), i);
+  }
+
+  for (size_t i = 0; i < num_threads; i++) {
+    if (messages[i]->page_ids.size() > 0)
+      signals[i].wait();
+    delete messages[i];
+  }
+}
+
+// Returns true if a "purge cache" operation is still pending
+static inline bool
+is_purge_in_progress(PageManagerState *state)
+{
+  for (std::vector<AsyncFlushMessage *>::iterator it = state->messages.begin();
+                  it != state->messages.end();
+                  it++) {
+    if ((*it)->in_progress)
+      return true;
+  }
+  return false;
+}
+
 static inline void
 verify_crc32(Page *page)
 {
@@ -113,9 +182,14 @@ verify_crc32(Page *page)
 }
 
 static inline Page *
-add_to_changeset(Changeset *changeset, Page *page)
+add_to_changeset(Context *context, Page *page)
 {
-  changeset->put(page);
+  // Concurrent readers do not lock their pages. This is safe because
+  // pages are only deleted by writers, which have exclusive access to
+  // the Environment.
+  if (context->is_shared_read)
+    return page;
+  context->changeset.put(page);
   assert(page->mutex().try_lock() == false);
   return page;
 }
@@ -170,9 +244,9 @@ store_state_impl(PageManagerState *state, Context *context)
     return state->state_page->address();
   }
 
-  std::pair<bool, Freelist::FreeMap::const_iterator> continuation;
+  std::pair<bool, uint64_t> continuation;
   continuation.first = false;   // initialization
-  continuation.second = state->freelist.free_pages.end();
+  continuation.second = 0;
   do {
     int offset = page == state->state_page
                       ? sizeof(uint64_t)
@@ -241,7 +315,7 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
 
   if (page) {
     page->set_without_header(ISSET(flags, PageManager::kNoHeader));
-    return add_to_changeset(&context->changeset, page);
+    return add_to_changeset(context, page);
   }
 
   if (ISSET(flags, PageManager::kOnlyFromCache)
@@ -264,7 +338,8 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
 
   /* write state to disk (if necessary) */
   if (NOTSET(flags, PageManager::kDisableStoreState)
-          && NOTSET(flags, PageManager::kReadOnly))
+          && NOTSET(flags, PageManager::kReadOnly)
+          && !context->is_shared_read)
     maybe_store_state(state, context, false);
 
   /* only verify crc if the page has a header */
@@ -274,7 +349,7 @@ fetch_unlocked(PageManagerState *state, Context *context, uint64_t address,
     verify_crc32(page);
 
   state->page_count_fetched++;
-  return add_to_changeset(&context->changeset, page);
+  return add_to_changeset(context, page);
 }
 
 static inline Page *
@@ -298,6 +373,9 @@ alloc_unlocked(PageManagerState *state, Context *context, uint32_t page_type,
       page = state->cache.get(address);
       if (page)
         goto done;
+      /* the page was freed; it must not be promoted by the cache because
+       * its address was evicted earlier */
+      state->cache.forget(address);
       /* otherwise fetch the page from disk */
       page = new Page(state->device, context->db);
       page->fetch(address);
@@ -338,7 +416,7 @@ done:
 
   /* store the page in the cache and the Changeset */
   state->cache.put(page);
-  add_to_changeset(&context->changeset, page);
+  add_to_changeset(context, page);
 
   /* write to disk (if necessary) */
   if (NOTSET(flags, PageManager::kDisableStoreState)
@@ -372,15 +450,18 @@ PageManagerState::PageManagerState(LocalEnv *_env)
     cache(_env->config), freelist(config), needs_flush(false),
     state_page(0), last_blob_page(0), last_blob_page_id(0),
     page_count_fetched(0), page_count_index(0), page_count_blob(0),
-    page_count_page_manager(0), cache_hits(0), cache_misses(0), message(0),
-    worker(new WorkerPool(1))
+    page_count_page_manager(0), cache_hits(0), cache_misses(0),
+    worker(new WorkerPool(config.worker_threads))
 {
 }
 
 PageManagerState::~PageManagerState()
 {
-  delete message;
-  message = 0;
+  for (std::vector<AsyncFlushMessage *>::iterator it = messages.begin();
+                  it != messages.end();
+                  it++)
+    delete *it;
+  messages.clear();
 
   delete state_page;
   state_page = 0;
@@ -398,6 +479,9 @@ PageManager::initialize(uint64_t pageid)
     delete state->state_page;
   state->state_page = new Page(state->device);
   state->state_page->fetch(pageid);
+
+  // the state page is never stored in the cache (see fetch())
+  assert(state->cache.peek(pageid) == 0);
   if (ISSET(state->config.flags, UPS_ENABLE_CRC32))
     verify_crc32(state->state_page);
 
@@ -430,10 +514,38 @@ PageManager::initialize(uint64_t pageid)
 Page *
 PageManager::fetch(Context *context, uint64_t address, uint32_t flags)
 {
+  // Fast path: cached pages can be retrieved without locking the
+  // PageManager, because the cache synchronizes the access to its shards
+  // (a hit locks the shard's spinlock). The header page and the state page
+  // are never stored in the cache, therefore a cached page cannot be one
+  // of them.
+  //
+  // The page is shared with other threads and is not modified. If it was
+  // cached with a different |kNoHeader| flag then the slow path updates
+  // the flag.
+  if (likely(address != 0)) {
+    Page *page = state->cache.get(address, false);
+    if (page && page->is_without_header()
+                    == ISSET(flags, PageManager::kNoHeader))
+      return add_to_changeset(context, page);
+  }
+
   ScopedSpinlock lock(state->mutex);
   return fetch_unlocked(state.get(), context, address, flags);
 }
 
+void
+PageManager::read_ahead(uint64_t address)
+{
+  if (NOTSET(state->config.flags, UPS_ENABLE_IO_URING)
+      || ISSET(state->config.flags, UPS_IN_MEMORY)
+      || address == 0
+      || state->cache.peek(address) != 0)
+    return;
+
+  state->device->read_ahead(address);
+}
+
 Page *
 PageManager::alloc(Context *context, uint32_t page_type, uint32_t flags)
 {
@@ -456,6 +568,9 @@ PageManager::alloc_multiple_blob_pages(Context *context, size_t num_pages)
   // Now check the freelist
   uint64_t address = state->freelist.alloc(num_pages);
   if (address != 0) {
+    for (size_t i = 0; i < num_pages; i++)
+      state->cache.forget(address + (i * page_size));
+
     for (size_t i = 0; i < num_pages; i++) {
       if (i == 0) {
         page = fetch_unlocked(state.get(), context, address, 0);
@@ -497,6 +612,8 @@ PageManager::fill_metrics(ups_env_metrics_t *metrics) const
 {
   metrics->page_count_fetched = state->page_count_fetched;
   metrics->page_count_flushed = Page::ms_page_count_flushed;
+  metrics->page_count_flushed_batched = state->device->batched_pages;
+  metrics->page_count_flush_writes = state->device->batched_writes;
   metrics->page_count_type_index = state->page_count_index;
   metrics->page_count_type_blob = state->page_count_blob;
   metrics->page_count_type_page_manager = state->page_count_page_manager;
@@ -507,27 +624,24 @@ PageManager::fill_metrics(ups_env_metrics_t *metrics) const
 
 struct FlushAllPagesVisitor
 {
-  FlushAllPagesVisitor(AsyncFlushMessage *message_)
-    : message(message_) {
+  FlushAllPagesVisitor(std::vector<uint64_t> &page_ids_)
+    : page_ids(page_ids_) {
   }
 
   bool operator()(Page *page) {
     if (page->is_dirty())
-      message->page_ids.push_back(page->address());
+      page_ids.push_back(page->address());
     return false;
   }
 
-  AsyncFlushMessage *message;
+  std::vector<uint64_t> &page_ids;
 };
 
 void
 PageManager::flush_all_pages()
 {
-  Signal signal;
-  AsyncFlushMessage *message = new AsyncFlushMessage(this, state->device,
-                                    &signal);
-
-  FlushAllPagesVisitor visitor(message);
+  std::vector<uint64_t> page_ids;
+  FlushAllPagesVisitor visitor(page_ids);
 
   {
     ScopedSpinlock lock(state->mutex);
@@ -535,18 +649,21 @@ PageManager::flush_all_pages()
     state->cache.purge_if(visitor);
 
     if (state->header->header_page->is_dirty())
-      message->page_ids.push_back(0);
+      page_ids.push_back(0);
 
     if (state->state_page && state->state_page->is_dirty())
-      message->page_ids.push_back(state->state_page->address());
+      page_ids.push_back(state->state_page->address());
   }
 
-  if (message->page_ids.size() > 0) {
-    run_async(boost::bind(&async_flush_pages, message));
-    signal.wait();
-  }
+  if (page_ids.size() > 0)
+    flush_pages_and_wait(this, state.get(), page_ids);
+}
 
-  delete message;
+bool
+PageManager::is_cache_full() const
+{
+  return NOTSET(state->config.flags, UPS_IN_MEMORY)
+            && state->cache.is_cache_full();
 }
 
 void
@@ -559,23 +676,41 @@ PageManager::purge_cache(Context *context)
   //   2. there's still a "purge cache" operation pending
   //   3. the cache is not full
   if (ISSET(state->config.flags, UPS_IN_MEMORY)
-      || (state->message && state->message->in_progress == true)
+      || is_purge_in_progress(state.get())
       || !state->cache.is_cache_full())
     return;
 
-  if (unlikely(!state->message))
-    state->message = new AsyncFlushMessage(this, state->device, 0);
+  size_t num_threads = state->worker->size();
+  if (unlikely(state->messages.empty())) {
+    for (size_t i = 0; i < num_threads; i++)
+      state->messages.push_back(new AsyncFlushMessage(this, state->device, 0));
+  }
 
-  state->message->page_ids.clear();
+  state->purge_candidates.clear();
   state->garbage.clear();
 
-  state->cache.purge_candidates(state->message->page_ids, state->garbage,
+  state->cache.purge_candidates(state->purge_candidates, state->garbage,
           state->last_blob_page);
 
   // don't bother if there are only few pages
-  if (state->message->page_ids.size() > 10) {
-    state->message->in_progress = true;
-    run_async(boost::bind(&async_flush_pages, state->message));
+  if (state->purge_candidates.size() > 10) {
+    for (size_t i = 0; i < num_threads; i++)
+      state->messages[i]->page_ids.clear();
+
+    for (std::vector<uint64_t>::iterator it = state->purge_candidates.begin();
+                    it != state->purge_candidates.end();
+                    it++) {
+      size_t i = flush_region(state.get(), *it) % num_threads;
+      state->messages[i]->page_ids.push_back(*it);
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+      AsyncFlushMessage *message = state->messages[i];
+      if (message->page_ids.empty())
+        continue;
+      message->in_progress = true;
+      run_async(boost::bind(&async_flush_pages, message), i);
+    }
   }
 
   for (std::vector<Page *>::iterator it = state->garbage.begin();
@@ -584,7 +719,7 @@ PageManager::purge_cache(Context *context)
     Page *page = *it;
     if (likely(page->mutex().try_lock())) {
       assert(page->cursor_list.is_empty());
-      state->cache.del(page);
+      state->cache.evict(page);
       page->mutex().unlock();
       delete page;
     }
@@ -611,7 +746,7 @@ PageManager::reclaim_space(Context *context)
     for (uint64_t page_id = address;
             page_id <= file_size - page_size;
             page_id += page_size) {
-      Page *page = state->cache.get(page_id);
+      Page *page = state->cache.peek(page_id);
       if (page) {
         state->cache.del(page);
         delete page;
@@ -631,13 +766,13 @@ PageManager::reclaim_space(Context *context)
 
 struct CloseDatabaseVisitor
 {
-  CloseDatabaseVisitor(LocalDb *db_, AsyncFlushMessage *message_)
-    : db(db_), message(message_) {
+  CloseDatabaseVisitor(LocalDb *db_, std::vector<uint64_t> &page_ids_)
+    : db(db_), page_ids(page_ids_) {
   }
 
   bool operator()(Page *page) {
     if (page->db() == db && page->address() != 0) {
-      message->page_ids.push_back(page->address());
+      page_ids.push_back(page->address());
       pages.push_back(page);
     }
     return false;
@@ -645,17 +780,14 @@ struct CloseDatabaseVisitor
 
   LocalDb *db;
   std::vector<Page *> pages;
-  AsyncFlushMessage *message;
+  std::vector<uint64_t> &page_ids;
 };
 
 void
 PageManager::close_database(Context *context, LocalDb *db)
 {
-  Signal signal;
-  AsyncFlushMessage *message = new AsyncFlushMessage(this, state->device,
-                                    &signal);
-
-  CloseDatabaseVisitor visitor(db, message);
+  std::vector<uint64_t> page_ids;
+  CloseDatabaseVisitor visitor(db, page_ids);
 
   {
     ScopedSpinlock lock(state->mutex);
@@ -669,15 +801,11 @@ PageManager::close_database(Context *context, LocalDb *db)
     state->cache.purge_if(visitor);
 
     if (state->header->header_page->is_dirty())
-      message->page_ids.push_back(0);
+      page_ids.push_back(0);
   }
 
-  if (message->page_ids.size() > 0) {
-    run_async(boost::bind(&async_flush_pages, message));
-    signal.wait();
-  }
-
-  delete message;
+  if (page_ids.size() > 0)
+    flush_pages_and_wait(this, state.get(), page_ids);
 
   ScopedSpinlock lock(state->mutex);
   // now delete the pages
@@ -707,7 +835,7 @@ PageManager::del(Context *context, Page *page, size_t page_count)
   if (page_count > 1) {
     uint32_t page_size = state->config.page_size_bytes;
     for (size_t i = 1; i < page_count; i++) {
-      Page *p = state->cache.get(page->address() + i * page_size);
+      Page *p = state->cache.peek(page->address() + i * page_size);
       if (p && context->changeset.has(p))
         context->changeset.del(p);
     }
@@ -778,7 +906,7 @@ PageManager::last_blob_page(Context *context)
   ScopedSpinlock lock(state->mutex);
 
   if (state->last_blob_page)
-    return add_to_changeset(&context->changeset, state->last_blob_page);
+    return add_to_changeset(context, state->last_blob_page);
   if (state->last_blob_page_id)
     return fetch_unlocked(state.get(), context, state->last_blob_page_id, 0);
   return 0;
@@ -826,7 +954,7 @@ PageManager::try_lock_purge_candidate(uint64_t address)
   else if (state->state_page && address == state->state_page->address())
     page = state->state_page;
   else
-    page = state->cache.get(address);
+    page = state->cache.peek(address);
 
   if (!page || !page->mutex().try_lock())
     return 0;
@@ -88,6 +88,11 @@ struct PageManager
   // The page is locked and stored in |context->changeset|.
   Page *fetch(Context *context, uint64_t address, uint32_t flags = 0);
 
+  // Starts reading the page at |address| in the background if it is not
+  // cached (only if UPS_ENABLE_IO_URING is set). Used by scans to fetch
+  // the next leaf while the current one is processed.
+  void read_ahead(uint64_t address);
+
   // Allocates a new page. |page_type| is one of Page::kType* in page.h.
   // |flags| are either 0 or kClearWithZero
   // The page is locked and stored in |context->changeset|.
@@ -106,6 +111,10 @@ struct PageManager
   // exceeded
   void purge_cache(Context *context);
 
+  // Returns true if the cache limits are exceeded and purge_cache() would
+  // have to purge pages. Not exact if other threads use the cache.
+  bool is_cache_full() const;
+
   // Reclaim file space; truncates unused file space at the end of the file.
   void reclaim_space(Context *context);
 
@@ -149,6 +158,18 @@ struct PageManager
     return state->worker->enqueue(message);
   }
 
+  // Adds a message to the worker's queue; messages with the same |key|
+  // are processed in order, all others can run in parallel
+  template<typename WorkerMessage>
+  void run_async(WorkerMessage message, size_t key) {
+    return state->worker->enqueue(message, key);
+  }
+
+  // Waits till all messages in the worker's queue were processed
+  void wait_for_async_messages() {
+    state->worker->wait();
+  }
+
   // Stores the state to disk. Returns the page-Id with the persisted state.
   // Exposed here because it's required by the unittests.
   uint64_t test_store_state();
@@ -30,6 +30,7 @@
 
 #include "0root/root.h"
 
+#include <vector>
 #include <boost/atomic.hpp>
 
 // Always verify that a file of level N does not include headers > N!
@@ -117,14 +118,17 @@ struct PageManagerState {
   // tracks number of cache misses
   uint64_t cache_misses;
 
-  // For sending information to the worker thread; cached to avoid memory
-  // allocations
-  AsyncFlushMessage *message;
+  // For sending information to the worker threads (one message per
+  // thread); cached to avoid memory allocations
+  std::vector<AsyncFlushMessage *> messages;
+
+  // For collecting purge candidates; cached to avoid memory allocations
+  std::vector<uint64_t> purge_candidates;
 
   // For collecting unused pages; cached to avoid memory allocations
   std::vector<Page *> garbage;
 
-  // The worker thread which flushes dirty pages
+  // The worker threads which flush dirty pages
   ScopedPtr<WorkerPool> worker;
 };
 
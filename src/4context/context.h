@@ -32,7 +32,8 @@ struct LocalEnv;
 
 struct Context {
   Context(LocalEnv *env, LocalTxn *txn = 0, LocalDb *db = 0)
-    : txn(txn), db(db), changeset(env) {
+    : txn(txn), db(db), is_shared_read(false),
+      is_shared_write(false), changeset(env) {
   }
 
   ~Context() {
@@ -42,6 +43,17 @@ struct Context {
   LocalTxn *txn;
   LocalDb *db;
 
+  // True if this is a lookup which only holds a shared lock on the
+  // Environment (see UPS_ENABLE_CONCURRENT_READS). Fetched pages are then
+  // not locked and not added to the changeset.
+  bool is_shared_read;
+
+  // True if this is an insert or erase which runs concurrently to
+  // lookups (see UPS_ENABLE_CONCURRENT_READS). Modified btree nodes are
+  // then latched, and nodes are not merged. With Transactions, the
+  // operation is staged concurrently to other Txns (see TxnIndex).
+  bool is_shared_write;
+
   // Each operation has its own changeset which stores all locked pages
   Changeset changeset;
 };
@@ -91,11 +91,14 @@ append_txn_duplicates(LocalCursor *cursor, Context *context)
 
   // now start integrating the items from the transactions
   for (op = node->oldest_op; op; op = op->next_in_node) {
-    Txn *optxn = op->txn;
+    LocalTxn *optxn = op->txn;
     // collect all ops that are valid (even those that are
-    // from conflicting transactions)
+    // from conflicting transactions), unless they are hidden from the
+    // snapshot of a read-only transaction
     if (unlikely(optxn->is_aborted()))
       continue;
+    if (unlikely(is_hidden_from_snapshot(context->txn, optxn)))
+      continue;
 
     // a normal (overwriting) insert will overwrite ALL duplicates,
     // but an overwrite of a duplicate will only overwrite
@@ -1043,14 +1046,14 @@ LocalCursor::overwrite(ups_record_t *record, uint32_t flags)
     if (is_btree_active()) {
       btree_cursor.uncouple_from_page(&context);
       st = ldb(this)->insert(this, txn, btree_cursor.uncoupled_key(),
-                      record, flags | UPS_OVERWRITE);
+                      record, flags | UPS_OVERWRITE, false);
     }
     else {
       if (txn_cursor.is_nil())
         st = UPS_CURSOR_IS_NIL;
       else
         st = ldb(this)->insert(this, txn, txn_cursor.coupled_key(), record,
-                        flags | UPS_OVERWRITE);
+                        flags | UPS_OVERWRITE, false);
     }
 
     duplicate_cache_index = old_index;
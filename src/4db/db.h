@@ -88,13 +88,17 @@ struct Db
   // Returns the number of keys (ups_db_count)
   virtual uint64_t count(Txn *txn, bool distinct) = 0;
 
-  // Inserts a key/value pair (ups_db_insert, ups_cursor_insert)
+  // Inserts a key/value pair (ups_db_insert, ups_cursor_insert).
+  // |shared_write| is true if the caller only holds the upgrade lock of
+  // the Environment, and lookups run concurrently
   virtual ups_status_t insert(Cursor *cursor, Txn *txn,
-                  ups_key_t *key, ups_record_t *record, uint32_t flags) = 0;
+                  ups_key_t *key, ups_record_t *record, uint32_t flags,
+                  bool shared_write) = 0;
 
-  // Erase a key/value pair (ups_db_erase, ups_cursor_erase)
+  // Erase a key/value pair (ups_db_erase, ups_cursor_erase); see insert()
+  // for |shared_write|
   virtual ups_status_t erase(Cursor *cursor, Txn *txn, ups_key_t *key,
-                  uint32_t flags) = 0;
+                  uint32_t flags, bool shared_write) = 0;
 
   // Lookup of a key/value pair (ups_db_find, ups_cursor_find)
   virtual ups_status_t find(Cursor *cursor, Txn *txn, ups_key_t *key,
@@ -110,6 +114,25 @@ struct Db
   virtual ups_status_t cursor_move(Cursor *cursor, ups_key_t *key,
                   ups_record_t *record, uint32_t flags) = 0;
 
+  // Returns true if lookups (ups_db_find) can run in parallel to other
+  // lookups (see UPS_ENABLE_CONCURRENT_READS)
+  virtual bool supports_concurrent_reads() const {
+    return false;
+  }
+
+  // Returns true if updates (ups_db_insert, ups_db_erase) can run in
+  // parallel to lookups. Returns false if the cache is full, because
+  // purging the cache requires exclusive access.
+  virtual bool supports_concurrent_writes() const {
+    return false;
+  }
+
+  // Returns true if Txns can stage updates (ups_db_insert, ups_db_erase)
+  // in parallel to each other
+  virtual bool supports_concurrent_staging() const {
+    return false;
+  }
+
   // Performs bulk operations
   virtual ups_status_t bulk_operations(Txn *txn, ups_operation_t *operations,
                   size_t operations_length, uint32_t flags) = 0;
@@ -124,19 +147,34 @@ struct Db
   void remove_cursor(Cursor *cursor);
 
   // Returns the memory buffer for the key data: the per-database buffer
-  // if |txn| is null or temporary, otherwise the buffer from the |txn|
+  // if |txn| is null or temporary, otherwise the buffer from the |txn|.
+  // If concurrent reads are enabled then the per-database buffer is
+  // replaced by a per-thread buffer.
   ByteArray &key_arena(Txn *txn) {
-    return (txn == 0 || ISSET(txn->flags, UPS_TXN_TEMPORARY))
-               ? _key_arena
-               : txn->key_arena;
+    if (txn == 0 || ISSET(txn->flags, UPS_TXN_TEMPORARY))
+      return ISSET(env->flags(), UPS_ENABLE_CONCURRENT_READS)
+               ? thread_arena(_thread_key_arena)
+               : _key_arena;
+    return txn->key_arena;
   }
 
   // Returns the memory buffer for the record data: the per-database buffer
-  // if |txn| is null or temporary, otherwise the buffer from the |txn|
+  // if |txn| is null or temporary, otherwise the buffer from the |txn|.
+  // If concurrent reads are enabled then the per-database buffer is
+  // replaced by a per-thread buffer.
   ByteArray &record_arena(Txn *txn) {
-    return (txn == 0 || ISSET(txn->flags, UPS_TXN_TEMPORARY))
-               ? _record_arena
-               : txn->record_arena;
+    if (txn == 0 || ISSET(txn->flags, UPS_TXN_TEMPORARY))
+      return ISSET(env->flags(), UPS_ENABLE_CONCURRENT_READS)
+               ? thread_arena(_thread_record_arena)
+               : _record_arena;
+    return txn->record_arena;
+  }
+
+  // Returns the calling thread's instance of a per-thread buffer
+  static ByteArray &thread_arena(boost::thread_specific_ptr<ByteArray> &tsp) {
+    if (unlikely(tsp.get() == 0))
+      tsp.reset(new ByteArray());
+    return *tsp;
   }
 
   // the current Environment
@@ -158,6 +196,11 @@ struct Db
   // This is where record->data points to when returning a
   // record to the user; used if Txns are disabled
   ByteArray _record_arena;
+
+  // Per-thread replacements for |_key_arena| and |_record_arena|; used
+  // if UPS_ENABLE_CONCURRENT_READS is set
+  boost::thread_specific_ptr<ByteArray> _thread_key_arena;
+  boost::thread_specific_ptr<ByteArray> _thread_record_arena;
 };
 
 } // namespace upscaledb
@@ -83,6 +83,17 @@ copy_key(LocalDb *db, Txn *txn, ups_key_t *source, ups_key_t *key)
     ::memcpy(key->data, source->data, source->size);
 }
 
+// Prepares an operation which is staged concurrently to other Txns (see
+// LocalDb::supports_concurrent_staging()). The operation only reads the
+// btree. It locks the Txn, in case the Txn is shared by several threads.
+static inline void
+prepare_concurrent_staging(Context *context, ScopedLock &txn_lock)
+{
+  assert(context->txn != 0);
+  context->is_shared_read = true;
+  txn_lock = ScopedLock(context->txn->mutex);
+}
+
 static inline LocalTxn *
 begin_temp_txn(LocalEnv *env)
 {
@@ -144,8 +155,8 @@ is_key_erased(Context *context, TxnIndex *txn_index, ups_key_t *key)
   for (TxnOperation *op = node->newest_op;
                   op != 0;
                   op = op->previous_in_node) {
-    Txn *optxn = op->txn;
-    if (optxn->is_aborted())
+    LocalTxn *optxn = op->txn;
+    if (optxn->is_aborted() || is_hidden_from_snapshot(context->txn, optxn))
       continue;
     if (optxn->is_committed() || context->txn == optxn) {
       if (ISSET(op->flags, TxnOperation::kIsFlushed))
@@ -165,10 +176,11 @@ is_key_erased(Context *context, TxnIndex *txn_index, ups_key_t *key)
 }
 
 // Checks if an erase operation conflicts with another txn; this is the
-// case if the same key is modified by another active txn.
+// case if the same key is modified by another active txn. |node| can be
+// null. The btree is only checked if |lookup_btree| is true.
 static inline ups_status_t
 check_erase_conflicts(LocalDb *db, Context *context, TxnNode *node,
-                    ups_key_t *key, uint32_t flags)
+                    ups_key_t *key, uint32_t flags, bool lookup_btree = true)
 {
   //
   // pick the tree_node of this key, and walk through each operation
@@ -181,7 +193,7 @@ check_erase_conflicts(LocalDb *db, Context *context, TxnNode *node,
   // - if a committed txn has erased the item then there's no need
   //    to continue checking older, committed txns
   //
-  for (TxnOperation *op = node->newest_op;
+  for (TxnOperation *op = node ? node->newest_op : 0;
                   op != 0;
                   op = op->previous_in_node) {
     LocalTxn *optxn = op->txn;
@@ -209,21 +221,26 @@ check_erase_conflicts(LocalDb *db, Context *context, TxnNode *node,
     }
 
     // txn is still active
-    return UPS_TXN_CONFLICT;
+    return report_conflict(context->txn, optxn);
   }
 
   // we've successfully checked all un-flushed transactions and there
   // were no conflicts. Now check all transactions which are already
   // flushed - basically that's identical to a btree lookup. Fail if the
   // key does not exist.
+  if (!lookup_btree)
+    return 0;
+  if (!db->key_filter.may_contain(key))
+    return UPS_KEY_NOT_FOUND;
   return db->btree_index->find(context, 0, key, 0, 0, 0, flags);
 }
 
 // Checks if an insert operation conflicts with another txn; this is the
-// case if the same key is modified by another active txn.
+// case if the same key is modified by another active txn. |node| can be
+// null. The btree is only checked if |lookup_btree| is true.
 static inline ups_status_t
 check_insert_conflicts(LocalDb *db, Context *context, TxnNode *node,
-                    ups_key_t *key, uint32_t flags)
+                    ups_key_t *key, uint32_t flags, bool lookup_btree = true)
 {
   //
   // pick the tree_node of this key, and walk through each operation
@@ -236,7 +253,7 @@ check_insert_conflicts(LocalDb *db, Context *context, TxnNode *node,
   // - if a committed txn has erased the item then there's no need
   //    to continue checking older, committed txns
   ///
-  for (TxnOperation *op = node->newest_op;
+  for (TxnOperation *op = node ? node->newest_op : 0;
                   op != 0;
                   op = op->previous_in_node) {
     LocalTxn *optxn = op->txn;
@@ -267,7 +284,7 @@ check_insert_conflicts(LocalDb *db, Context *context, TxnNode *node,
     }
 
     // txn is still active
-    return UPS_TXN_CONFLICT;
+    return report_conflict(context->txn, optxn);
   }
 
   // we've successfully checked all un-flushed transactions and there
@@ -275,10 +292,15 @@ check_insert_conflicts(LocalDb *db, Context *context, TxnNode *node,
   // flushed - basically that's identical to a btree lookup.
   //
   // we can skip this check if we do not care about duplicates.
-  if (ISSETANY(flags, UPS_OVERWRITE | UPS_DUPLICATE
+  if (!lookup_btree
+          || ISSETANY(flags, UPS_OVERWRITE | UPS_DUPLICATE
                           | UPS_HINT_APPEND | UPS_HINT_PREPEND))
     return 0;
 
+  // the same if the key filter knows that the key does not exist
+  if (!db->key_filter.may_contain(key))
+    return 0;
+
   ByteArray *arena = &db->key_arena(context->txn);
   ups_status_t st = db->btree_index->find(context, 0, key, arena, 0, 0, flags);
   switch (st) {
@@ -291,6 +313,45 @@ check_insert_conflicts(LocalDb *db, Context *context, TxnNode *node,
   }
 }
 
+typedef ups_status_t (*CheckConflicts)(LocalDb *db, Context *context,
+                TxnNode *node, ups_key_t *key, uint32_t flags,
+                bool lookup_btree);
+
+// Returns the locked node for an operation which is staged concurrently to
+// other Txns (see LocalDb::supports_concurrent_staging()), or fails if
+// the operation conflicts with another Txn. Other threads can access a
+// new node as soon as it is stored, and it cannot be removed if the check
+// fails. The btree is therefore checked before a node is created;
+// afterwards, only the operations of other Txns (which were attached
+// while the node was not yet locked) can cause a conflict.
+static inline ups_status_t
+store_concurrently(LocalDb *db, Context *context, ups_key_t *key,
+                uint32_t flags, CheckConflicts check_conflicts,
+                TxnNode **pnode, boost::unique_lock<Spinlock> &node_lock)
+{
+  TxnNode *node = db->txn_index->get(key, 0);
+  bool is_btree_checked = (node == 0);
+  if (is_btree_checked) {
+    ups_status_t st = check_conflicts(db, context, 0, key, flags, true);
+    if (unlikely(st))
+      return st;
+  }
+
+  bool node_created = false;
+  node = db->txn_index->store(key, &node_created, true);
+  node_lock = boost::unique_lock<Spinlock>(node->mutex);
+
+  ups_status_t st = check_conflicts(db, context, node, key, flags,
+                  !is_btree_checked);
+  if (unlikely(st)) {
+    assert(node->newest_op != 0 || !node_created);
+    return st;
+  }
+
+  *pnode = node;
+  return 0;
+}
+
 // Lookup of a key/record pair in the Txn index and in the btree,
 // if transactions are disabled/not successful; copies the
 // record into |record|. Also performs approx. matching.
@@ -332,8 +393,8 @@ retry:
     op = node->newest_op;
 
   for (; op != 0; op = op->previous_in_node) {
-    Txn *optxn = op->txn;
-    if (optxn->is_aborted())
+    LocalTxn *optxn = op->txn;
+    if (optxn->is_aborted() || is_hidden_from_snapshot(context->txn, optxn))
       continue;
 
     if (optxn->is_committed() || context->txn == optxn) {
@@ -407,7 +468,7 @@ retry:
       continue;
     }
 
-    return UPS_TXN_CONFLICT;
+    return report_conflict(context->txn, optxn);
   }
 
   // if there was an approximate match: check if the btree provides
@@ -565,20 +626,32 @@ static inline ups_status_t
 erase_txn(LocalDb *db, Context *context, ups_key_t *key, uint32_t flags,
                 LocalCursor *cursor)
 {
-  // get (or create) the node for this key
-  bool node_created = false;
-  TxnNode *node = db->txn_index->store(key, &node_created);
+  TxnNode *node;
+  boost::unique_lock<Spinlock> node_lock;
 
-  // check for conflicts of this key - but only if we're not erasing a
-  // duplicate key. Duplicates are checked for conflicts in LocalCursor::move
-  if (!cursor || !cursor->duplicate_cache_index) {
-    ups_status_t st = check_erase_conflicts(db, context, node, key, flags);
-    if (unlikely(st)) {
-      if (node_created) {
-        db->txn_index->remove(node);
-        delete node;
-      }
+  if (unlikely(context->is_shared_write)) {
+    ups_status_t st = store_concurrently(db, context, key, flags,
+                    check_erase_conflicts, &node, node_lock);
+    if (unlikely(st))
       return st;
+  }
+  else {
+    // get (or create) the node for this key
+    bool node_created = false;
+    node = db->txn_index->store(key, &node_created);
+
+    // check for conflicts of this key - but only if we're not erasing a
+    // duplicate key. Duplicates are checked for conflicts in
+    // LocalCursor::move
+    if (!cursor || !cursor->duplicate_cache_index) {
+      ups_status_t st = check_erase_conflicts(db, context, node, key, flags);
+      if (unlikely(st)) {
+        if (node_created) {
+          db->txn_index->remove(node);
+          db->txn_index->release_node(node);
+        }
+        return st;
+      }
     }
   }
 
@@ -658,7 +731,10 @@ LocalDb::create(Context *context, PBtreeHeader *btree_header)
             | UPS_ENABLE_FSYNC
             | UPS_READ_ONLY
             | UPS_AUTO_RECOVERY
-            | UPS_ENABLE_TRANSACTIONS);
+            | UPS_ENABLE_TRANSACTIONS
+            | UPS_ENABLE_CONCURRENT_READS
+            | UPS_ENABLE_IO_URING
+            | UPS_DIRECT_IO);
 
   switch (config.key_type) {
     case UPS_TYPE_UINT8:
@@ -743,6 +819,13 @@ LocalDb::create(Context *context, PBtreeHeader *btree_header)
   // and the TxnIndex
   txn_index.reset(new TxnIndex(this));
 
+  // the key filter is not thread-safe and cannot be used by concurrent
+  // lookups
+  if (config.key_filter_bits && !supports_concurrent_reads()) {
+    key_filter.initialize(config.key_filter_bits);
+    key_filter.create();
+  }
+
   return 0;
 }
 
@@ -793,6 +876,15 @@ LocalDb::open(Context *context, PBtreeHeader *btree_header)
                                     config.record_compressor));
   }
 
+  // load the persisted key filter, or rebuild it
+  if (config.key_filter_bits && !supports_concurrent_reads()) {
+    key_filter.initialize(config.key_filter_bits);
+    key_filter.open(context);
+  }
+  // the database can be modified even if this session does not maintain
+  // the filter (i.e. with UPS_ENABLE_CONCURRENT_READS)
+  key_filter.invalidate();
+
   // fetch the current record number
   if (ISSETANY(flags(), UPS_RECORD_NUMBER32 | UPS_RECORD_NUMBER64))
     return fetch_record_number(context, this);
@@ -880,6 +972,9 @@ LocalDb::get_parameters(ups_parameter_t *param)
     case UPS_PARAM_KEY_COMPRESSION:
       p->value = config.key_compressor;
       break;
+    case UPS_PARAM_KEY_FILTER_BITS:
+      p->value = config.key_filter_bits;
+      break;
     default:
       ups_trace(("unknown parameter %d", (int)p->name));
       return UPS_INV_PARAMETER;
@@ -999,18 +1094,29 @@ static inline ups_status_t
 insert_txn(LocalDb *db, Context *context, ups_key_t *key, ups_record_t *record,
                 uint32_t flags, LocalCursor *cursor)
 {
-  // get (or create) the node for this key
-  bool node_created = false;
-  TxnNode *node = db->txn_index->store(key, &node_created);
+  TxnNode *node;
+  boost::unique_lock<Spinlock> node_lock;
 
-  // check for conflicts of this key
-  ups_status_t st = check_insert_conflicts(db, context, node, key, flags);
-  if (unlikely(st)) {
-    if (node_created) {
-      db->txn_index->remove(node);
-      delete node;
+  if (unlikely(context->is_shared_write)) {
+    ups_status_t st = store_concurrently(db, context, key, flags,
+                    check_insert_conflicts, &node, node_lock);
+    if (unlikely(st))
+      return st;
+  }
+  else {
+    // get (or create) the node for this key
+    bool node_created = false;
+    node = db->txn_index->store(key, &node_created);
+
+    // check for conflicts of this key
+    ups_status_t st = check_insert_conflicts(db, context, node, key, flags);
+    if (unlikely(st)) {
+      if (node_created) {
+        db->txn_index->remove(node);
+        db->txn_index->release_node(node);
+      }
+      return st;
     }
-    return st;
   }
 
   uint64_t lsn = lenv(db)->lsn_manager.next();
@@ -1086,10 +1192,31 @@ insert_impl(LocalDb *db, Context *context, LocalCursor *cursor,
   return 0;
 }
 
+bool
+LocalDb::supports_concurrent_writes() const
+{
+  return may_write_concurrently()
+            && !((LocalEnv *)env)->page_manager->is_cache_full();
+}
+
+bool
+LocalDb::supports_concurrent_staging() const
+{
+  return ISSET(flags(), UPS_ENABLE_CONCURRENT_READS)
+            && may_stage_concurrently()
+            && cursor_list == 0
+            && !((LocalEnv *)env)->page_manager->is_cache_full();
+}
+
 ups_status_t
 LocalDb::insert(Cursor *hcursor, Txn *txn, ups_key_t *key,
-                ups_record_t *record, uint32_t flags)
+                ups_record_t *record, uint32_t flags, bool shared_write)
 {
+  if (unlikely(txn && ISSET(txn->flags, UPS_TXN_READ_ONLY))) {
+    ups_trace(("cannot modify the database in a read-only transaction"));
+    return UPS_WRITE_PROTECTED;
+  }
+
   if (config.flags & (UPS_RECORD_NUMBER32 | UPS_RECORD_NUMBER64)) {
     if (unlikely(key->size == 0 && key->data != 0)) {
       ups_trace(("for record number keys set key size to 0, "
@@ -1125,6 +1252,11 @@ LocalDb::insert(Cursor *hcursor, Txn *txn, ups_key_t *key,
   LocalTxn *local_txn = 0;
   LocalCursor *cursor = (LocalCursor *)hcursor;
   Context context(lenv(this), (LocalTxn *)txn, this);
+  context.is_shared_write = shared_write;
+
+  ScopedLock txn_lock;
+  if (shared_write && ISSET(this->flags(), UPS_ENABLE_TRANSACTIONS))
+    prepare_concurrent_staging(&context, txn_lock);
 
   if (cursor && NOTSET(flags, UPS_DUPLICATE) && NOTSET(flags, UPS_OVERWRITE))
     cursor->duplicate_cache_index = 0;
@@ -1140,22 +1272,30 @@ LocalDb::insert(Cursor *hcursor, Txn *txn, ups_key_t *key,
   // otherwise we overwrite the internal memory used by the record number)
   if (ISSET(this->flags(), UPS_ENABLE_TRANSACTIONS)
       && !ISSETANY(this->flags(), UPS_RECORD_NUMBER32 | UPS_RECORD_NUMBER64)) {
-    if (histogram.test_and_update_if_lower(context.txn, key))
-      flags |= UPS_HINT_PREPEND;
-    if (histogram.test_and_update_if_greater(context.txn, key))
-      flags |= UPS_HINT_APPEND;
+    flags |= histogram.test_and_update(context.txn, key,
+                    context.is_shared_write);
   }
 
-  // purge the cache
-  lenv(this)->page_manager->purge_cache(&context);
+  // purge the cache (unless lookups run concurrently and might still
+  // access the purged pages)
+  if (!context.is_shared_write)
+    lenv(this)->page_manager->purge_cache(&context);
 
   ups_status_t st = insert_impl(this, &context, cursor, key, record, flags);
+  if (likely(st == 0))
+    key_filter.insert(key);
   return finalize(lenv(this), &context, st, local_txn);
 }
 
 ups_status_t
-LocalDb::erase(Cursor *hcursor, Txn *txn, ups_key_t *key, uint32_t flags)
+LocalDb::erase(Cursor *hcursor, Txn *txn, ups_key_t *key, uint32_t flags,
+                bool shared_write)
 {
+  if (unlikely(txn && ISSET(txn->flags, UPS_TXN_READ_ONLY))) {
+    ups_trace(("cannot modify the database in a read-only transaction"));
+    return UPS_WRITE_PROTECTED;
+  }
+
   LocalCursor *cursor = (LocalCursor *)hcursor;
 
   if (unlikely(cursor && cursor->is_nil()))
@@ -1172,6 +1312,11 @@ LocalDb::erase(Cursor *hcursor, Txn *txn, ups_key_t *key, uint32_t flags)
 
   LocalTxn *local_txn = 0;
   Context context(lenv(this), (LocalTxn *)txn, this);
+  context.is_shared_write = shared_write;
+
+  ScopedLock txn_lock;
+  if (shared_write && ISSET(this->flags(), UPS_ENABLE_TRANSACTIONS))
+    prepare_concurrent_staging(&context, txn_lock);
 
   if (!txn && ISSET(this->flags(), UPS_ENABLE_TRANSACTIONS)) {
     local_txn = begin_temp_txn(lenv(this));
@@ -1183,6 +1328,7 @@ LocalDb::erase(Cursor *hcursor, Txn *txn, ups_key_t *key, uint32_t flags)
   if (likely(st == 0)) {
     if (cursor)
       cursor->set_to_nil();
+    key_filter.erase();
   }
 
   return finalize(lenv(this), &context, st, local_txn);
@@ -1201,6 +1347,12 @@ LocalDb::find(Cursor *hcursor, Txn *txn, ups_key_t *key,
 
   LocalCursor *cursor = (LocalCursor *)hcursor;
 
+  // Ask the key filter if the key exists. This is not done for Cursors,
+  // because the state of the Cursor would not be updated.
+  if (!cursor && NOTSET(flags, UPS_FIND_LT_MATCH | UPS_FIND_GT_MATCH)
+        && !key_filter.may_contain(key))
+    return UPS_KEY_NOT_FOUND;
+
   // Transactions require a Cursor because only Cursors can build lists
   // of duplicates.
   if (!cursor
@@ -1212,8 +1364,13 @@ LocalDb::find(Cursor *hcursor, Txn *txn, ups_key_t *key,
 
   Context context(lenv(this), (LocalTxn *)txn, this);
 
-  // purge cache if necessary
-  lenv(this)->page_manager->purge_cache(&context);
+  // Concurrent lookups only hold a shared lock; they must not purge
+  // the cache because other threads might still access the purged pages.
+  // ups_db_find() purges it afterwards with exclusive access
+  if (!cursor && supports_concurrent_reads())
+    context.is_shared_read = true;
+  else
+    lenv(this)->page_manager->purge_cache(&context);
 
   // if Transactions are disabled then read from the Btree
   if (NOTSET(this->flags(), UPS_ENABLE_TRANSACTIONS)) {
@@ -1279,7 +1436,8 @@ LocalDb::bulk_operations(Txn *txn, ups_operation_t *ops, size_t ops_length,
   for (size_t i = 0; i < ops_length; i++, ops++) {
     switch (ops->type) {
       case UPS_OP_INSERT:
-        ops->result = insert(0, txn, &ops->key, &ops->record, ops->flags);
+        ops->result = insert(0, txn, &ops->key, &ops->record, ops->flags,
+                        false);
         // if this a record number database? then we might have to copy the key
         if (likely(ops->result == 0)
                 && ISSETANY(flags(), UPS_RECORD_NUMBER32 | UPS_RECORD_NUMBER64)
@@ -1302,7 +1460,7 @@ LocalDb::bulk_operations(Txn *txn, ups_operation_t *ops, size_t ops_length,
         }
         break;
       case UPS_OP_ERASE:
-        ops->result = erase(0, txn, &ops->key, ops->flags);
+        ops->result = erase(0, txn, &ops->key, ops->flags, false);
         break;
       default:
         return UPS_INV_PARAMETER;
@@ -1410,6 +1568,13 @@ LocalDb::close(uint32_t flags)
   if (btree_index && ISSET(env->flags(), UPS_IN_MEMORY))
    btree_index->drop(&context);
 
+  // persist the key filter
+  if (key_filter.is_built()) {
+    key_filter.close(&context);
+    if (lenv(this)->journal.get())
+      context.changeset.flush(lenv(this)->lsn_manager.next());
+  }
+
   // write all pages of this database to disk
   lenv(this)->page_manager->close_database(&context, this);
 
@@ -1680,6 +1845,7 @@ LocalDb::flush_txn_operation(Context *context, LocalTxn *txn, TxnOperation *op)
 ups_status_t
 LocalDb::drop(Context *context)
 {
+  key_filter.drop(context);
   btree_index->drop(context);
   return 0;
 }
@@ -33,6 +33,7 @@
 #include "4txn/txn_local.h"
 #include "4db/db.h"
 #include "4db/histogram.h"
+#include "4db/key_filter.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -56,7 +57,7 @@ struct LocalDb : public Db {
   // Constructor
   LocalDb(Env *env, DbConfig &config)
     : Db(env, config), compare_function(0), _current_record_number(0),
-      histogram(this) {
+      histogram(this), key_filter(this) {
   }
 
   // Creates a new database
@@ -82,11 +83,11 @@ struct LocalDb : public Db {
 
   // Inserts a key/value pair (ups_db_insert, ups_cursor_insert)
   virtual ups_status_t insert(Cursor *cursor, Txn *txn, ups_key_t *key,
-                  ups_record_t *record, uint32_t flags);
+                  ups_record_t *record, uint32_t flags, bool shared_write);
 
   // Erase a key/value pair (ups_db_erase, ups_cursor_erase)
   virtual ups_status_t erase(Cursor *cursor, Txn *txn, ups_key_t *key,
-                  uint32_t flags);
+                  uint32_t flags, bool shared_write);
 
   // Lookup of a key/value pair (ups_db_find, ups_cursor_find)
   virtual ups_status_t find(Cursor *cursor, Txn *txn, ups_key_t *key,
@@ -102,6 +103,50 @@ struct LocalDb : public Db {
   // Clones a cursor (ups_cursor_clone)
   virtual Cursor *cursor_clone(Cursor *src);
 
+  // Returns true if lookups can run in parallel. Transactions and
+  // duplicate keys require a Cursor, and the compressors are not
+  // thread-safe.
+  virtual bool supports_concurrent_reads() const {
+    return ISSET(flags(), UPS_ENABLE_CONCURRENT_READS)
+            && NOTSET(flags(), UPS_ENABLE_TRANSACTIONS
+                                | UPS_ENABLE_DUPLICATE_KEYS)
+            && config.key_compressor == 0
+            && config.record_compressor == 0;
+  }
+
+  // Returns true if inserts and erases can run in parallel to lookups.
+  // This requires fixed-length keys and inline records, because extended
+  // keys and record blobs cannot be validated by the concurrent lookups.
+  virtual bool supports_concurrent_writes() const;
+
+  // Returns true if the configuration allows inserts and erases to run
+  // in parallel to lookups; they still require exclusive access whenever
+  // the cache is full (see supports_concurrent_writes)
+  bool may_write_concurrently() const {
+    return supports_concurrent_reads()
+            && config.key_size != UPS_KEY_SIZE_UNLIMITED
+            && config.record_size != UPS_RECORD_SIZE_UNLIMITED
+            && ISSET(flags(), UPS_FORCE_RECORDS_INLINE);
+  }
+
+  // Returns true if Txns can stage inserts and erases in parallel to each
+  // other (see TxnIndex). Cursors could be coupled to the modified keys,
+  // therefore the database must not have open Cursors.
+  virtual bool supports_concurrent_staging() const;
+
+  // Returns true if the configuration allows Txns to stage inserts and
+  // erases in parallel, regardless of UPS_ENABLE_CONCURRENT_READS (see
+  // supports_concurrent_staging). Also used by the recovery. The KeyFilter
+  // is not thread-safe, therefore it must be disabled.
+  bool may_stage_concurrently() const {
+    return ISSET(flags(), UPS_ENABLE_TRANSACTIONS)
+            && NOTSET(flags(), UPS_ENABLE_DUPLICATE_KEYS
+                                | UPS_RECORD_NUMBER32
+                                | UPS_RECORD_NUMBER64)
+            && config.key_compressor == 0
+            && !key_filter.is_enabled();
+  }
+
   // Performs bulk operations
   virtual ups_status_t bulk_operations(Txn *txn, ups_operation_t *operations,
                   size_t operations_length, uint32_t flags);
@@ -134,6 +179,9 @@ struct LocalDb : public Db {
 
   // Lower/upper boundaries
   Histogram histogram;
+
+  // Rules out lookups of keys which do not exist
+  KeyFilter key_filter;
 };
 
 } // namespace upscaledb
@@ -149,7 +149,7 @@ RemoteDb::count(Txn *htxn, bool distinct)
 
 ups_status_t
 RemoteDb::insert(Cursor *hcursor, Txn *htxn, ups_key_t *key,
-            ups_record_t *record, uint32_t flags)
+            ups_record_t *record, uint32_t flags, bool)
 {
   RemoteCursor *cursor = (RemoteCursor *)hcursor;
   bool recno = ISSETANY(this->flags(),
@@ -243,7 +243,7 @@ RemoteDb::insert(Cursor *hcursor, Txn *htxn, ups_key_t *key,
 
 ups_status_t
 RemoteDb::erase(Cursor *hcursor, Txn *htxn, ups_key_t *key,
-            uint32_t flags)
+            uint32_t flags, bool)
 {
   RemoteCursor *cursor = (RemoteCursor *)hcursor;
 
@@ -60,11 +60,12 @@ struct RemoteDb : public Db
 
   // Inserts a key/value pair (ups_db_insert, ups_cursor_insert)
   virtual ups_status_t insert(Cursor *cursor, Txn *txn,
-                  ups_key_t *key, ups_record_t *record, uint32_t flags);
+                  ups_key_t *key, ups_record_t *record, uint32_t flags,
+                  bool shared_write);
 
   // Erase a key/value pair (ups_db_erase, ups_cursor_erase)
   virtual ups_status_t erase(Cursor *cursor, Txn *txn, ups_key_t *key,
-                  uint32_t flags);
+                  uint32_t flags, bool shared_write);
 
   // Lookup of a key/value pair (ups_db_find, ups_cursor_find)
   virtual ups_status_t find(Cursor *cursor, Txn *txn, ups_key_t *key,
@@ -97,9 +97,24 @@ Histogram::test_and_update_if_greater(Txn *txn, ups_key_t *key)
   return false;
 }
 
+uint32_t
+Histogram::test_and_update(Txn *txn, ups_key_t *key, bool is_shared)
+{
+  ScopedSpinlock lock(mutex);
+
+  uint32_t hints = 0;
+  if ((!is_shared || lower.size > 0) && test_and_update_if_lower(txn, key))
+    hints |= UPS_HINT_PREPEND;
+  if ((!is_shared || upper.size > 0) && test_and_update_if_greater(txn, key))
+    hints |= UPS_HINT_APPEND;
+  return hints;
+}
+
 void
 Histogram::reset_if_equal(ups_key_t *key)
 {
+  ScopedSpinlock lock(mutex);
+
   if (unlikely(lower.size > 0
                 && db->btree_index->compare_keys(&lower, key) == 0))
     ::memset(&lower, 0, sizeof(lower));
@@ -25,6 +25,7 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/dynamic_array.h"
+#include "1base/spinlock.h"
 
 #ifndef UPS_ROOT_H
 #  error "root.h was not included"
@@ -46,6 +47,10 @@ struct LocalDb;
  * Transaction is aborted. It can therefore incorrect results, which are
  * however not problematic for the caller (it can return "The key maybe already
  * exists" although it doesn't, but never the other way around).
+ *
+ * Transactional inserts and erases can run concurrently (see
+ * LocalDb::supports_concurrent_staging()); they call test_and_update() and
+ * reset_if_equal(), which are serialized by |mutex|.
  */
 struct Histogram {
   Histogram(LocalDb *db_)
@@ -68,10 +73,19 @@ struct Histogram {
   // the cached key
   bool test_and_update_if_greater(Txn *txn, ups_key_t *key);
 
+  // Compares key to the lower and the upper key and updates the cached
+  // keys; returns UPS_HINT_PREPEND if the key is lower, UPS_HINT_APPEND if
+  // it's greater. If |is_shared| is true then the cached keys are not
+  // initialized, because this requires a Cursor.
+  uint32_t test_and_update(Txn *txn, ups_key_t *key, bool is_shared);
+
   // resets the stored key(s) if it's equal to |key|. Used when deleting
   // keys
   void reset_if_equal(ups_key_t *key);
 
+  // serializes concurrent calls of test_and_update() and reset_if_equal()
+  Spinlock mutex;
+
   // the database (used to fetch and compare keys)
   LocalDb *db;
 
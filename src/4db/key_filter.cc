@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+#include "0root/root.h"
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include "3rdparty/murmurhash3/MurmurHash3.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "3btree/btree_visitor.h"
+#include "3btree/btree_node_proxy.h"
+#include "4db/key_filter.h"
+#include "4db/db_local.h"
+#include "4env/env_local.h"
+#include "4txn/txn_local.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+#include "1base/packstart.h"
+
+// The persistent header of a key filter blob. It is followed by one
+// PKeyFilterSegment per segment, and then by the bit arrays of all segments.
+typedef UPS_PACK_0 struct UPS_PACK_1 PKeyFilterHeader {
+  // number of bits per key
+  uint32_t bits_per_key;
+
+  // number of segments
+  uint32_t segment_count;
+
+  // number of keys which were erased since the filter was built
+  uint64_t erased_count;
+} UPS_PACK_2 PKeyFilterHeader;
+
+// The persistent descriptor of a segment
+typedef UPS_PACK_0 struct UPS_PACK_1 PKeyFilterSegment {
+  // number of blocks
+  uint64_t block_count;
+
+  // number of keys which the segment was sized for
+  uint64_t capacity;
+
+  // number of keys which were added
+  uint64_t key_count;
+} UPS_PACK_2 PKeyFilterSegment;
+
+#include "1base/packstop.h"
+
+//
+// visitor object which adds all keys of the leaf nodes to the filter
+//
+struct KeyFilterVisitor : public BtreeVisitor {
+  KeyFilterVisitor(KeyFilter *filter_)
+    : filter(filter_) {
+  }
+
+  virtual bool is_read_only() const {
+    return true;
+  }
+
+  virtual void operator()(Context *context, BtreeNodeProxy *node) {
+    size_t length = node->length();
+    for (size_t i = 0; i < length; i++) {
+      ups_key_t key = {0};
+      node->key(context, i, &arena, &key);
+      filter->insert(&key);
+    }
+  }
+
+  KeyFilter *filter;
+  ByteArray arena;
+};
+
+void
+KeyFilter::create()
+{
+  reset();
+  add_segment(kMinCapacity);
+}
+
+void
+KeyFilter::open(Context *context)
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+  size_t i = slot();
+
+  bool is_valid = i < env->key_filter_blobs.size()
+                    && env->key_filter_valid[i];
+  if (!is_valid || !load(context, env->key_filter_blobs[i]))
+    build(context);
+}
+
+void
+KeyFilter::invalidate()
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+  size_t i = slot();
+
+  if (i < env->key_filter_valid.size() && NOTSET(db->flags(), UPS_READ_ONLY))
+    env->key_filter_valid[i] = false;
+}
+
+void
+KeyFilter::close(Context *context)
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+  size_t i = slot();
+
+  if (!is_built()
+        || i >= env->key_filter_blobs.size()
+        || ISSETANY(db->flags(), UPS_READ_ONLY | UPS_IN_MEMORY))
+    return;
+
+  // an outdated filter is not stored; it is rebuilt when the database is
+  // opened again. The same is true if the filter does not fit into a blob.
+  if (is_outdated())
+    return;
+  uint64_t size = sizeof(PKeyFilterHeader)
+                    + segments.size() * sizeof(PKeyFilterSegment);
+  for (size_t s = 0; s < segments.size(); s++)
+    size += segments[s].block_count * kBlockWords * sizeof(uint64_t);
+  if (size > std::numeric_limits<uint32_t>::max())
+    return;
+
+  env->key_filter_blobs[i] = store(context, env->key_filter_blobs[i]);
+  env->key_filter_valid[i] = true;
+}
+
+void
+KeyFilter::drop(Context *context)
+{
+  reset();
+
+  LocalEnv *env = (LocalEnv *)db->env;
+  size_t i = slot();
+  if (i < env->key_filter_blobs.size() && env->key_filter_blobs[i]) {
+    env->blob_manager->erase(context, env->key_filter_blobs[i]);
+    env->key_filter_blobs[i] = 0;
+    env->key_filter_valid[i] = false;
+  }
+}
+
+void
+KeyFilter::add_segment(uint64_t capacity)
+{
+  Segment segment;
+  segment.capacity = capacity;
+  segment.block_count = (capacity * bits_per_key + kBlockBits - 1)
+                            / kBlockBits;
+  segment.key_count = 0;
+
+  segments.reserve(segments.size() + 1);
+  size_t size = segment.block_count * kBlockWords * sizeof(uint64_t);
+  segment.bits = Memory::allocate_aligned<uint64_t>(size, 64);
+  ::memset(segment.bits, 0, size);
+  segments.push_back(segment);
+}
+
+size_t
+KeyFilter::slot() const
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+  return env->btree_header_slot(db->btree_index->state.btree_header);
+}
+
+void
+KeyFilter::build(Context *context)
+{
+  create();
+
+  // the filter grows while the keys are added
+  KeyFilterVisitor visitor(this);
+  db->btree_index->visit_nodes(context, visitor, false);
+
+  // also add the keys of the TxnIndex; this includes keys which were
+  // erased or inserted by aborted Transactions, which is not a problem
+  for (TxnNode *node = db->txn_index->first();
+                  node != 0;
+                  node = node->next_sibling())
+    insert(node->key());
+
+  Globals::ms_key_filter_rebuilds++;
+}
+
+bool
+KeyFilter::load(Context *context, uint64_t blob_id)
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+
+  ByteArray arena;
+  ups_record_t record = {0};
+  env->blob_manager->read(context, blob_id, &record, UPS_FORCE_DEEP_COPY,
+                  &arena);
+
+  const uint8_t *p = (const uint8_t *)record.data;
+  const uint8_t *end = p + record.size;
+  if (record.size < sizeof(PKeyFilterHeader))
+    return false;
+
+  const PKeyFilterHeader *header = (const PKeyFilterHeader *)p;
+  p += sizeof(PKeyFilterHeader);
+  if (header->bits_per_key != (uint32_t)bits_per_key
+        || header->segment_count == 0
+        || (size_t)(end - p) < header->segment_count
+                                    * sizeof(PKeyFilterSegment))
+    return false;
+
+  const PKeyFilterSegment *descriptors = (const PKeyFilterSegment *)p;
+  p += header->segment_count * sizeof(PKeyFilterSegment);
+
+  reset();
+  for (uint32_t s = 0; s < header->segment_count; s++) {
+    add_segment(descriptors[s].capacity);
+    Segment *segment = &segments.back();
+    size_t size = segment->block_count * kBlockWords * sizeof(uint64_t);
+    if (segment->block_count != descriptors[s].block_count
+          || (size_t)(end - p) < size) {
+      reset();
+      return false;
+    }
+    ::memcpy(segment->bits, p, size);
+    segment->key_count = descriptors[s].key_count;
+    p += size;
+  }
+
+  erased_count = header->erased_count;
+  return true;
+}
+
+uint64_t
+KeyFilter::store(Context *context, uint64_t blob_id)
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+
+  PKeyFilterHeader header;
+  header.bits_per_key = bits_per_key;
+  header.segment_count = (uint32_t)segments.size();
+  header.erased_count = erased_count;
+
+  ByteArray arena;
+  arena.append((uint8_t *)&header, sizeof(header));
+  for (size_t s = 0; s < segments.size(); s++) {
+    PKeyFilterSegment descriptor;
+    descriptor.block_count = segments[s].block_count;
+    descriptor.capacity = segments[s].capacity;
+    descriptor.key_count = segments[s].key_count;
+    arena.append((uint8_t *)&descriptor, sizeof(descriptor));
+  }
+  for (size_t s = 0; s < segments.size(); s++)
+    arena.append((uint8_t *)segments[s].bits,
+                    segments[s].block_count * kBlockWords * sizeof(uint64_t));
+
+  ups_record_t record = ups_make_record(arena.data(), (uint32_t)arena.size());
+  if (blob_id)
+    return env->blob_manager->overwrite(context, blob_id, &record,
+                    BlobManager::kDisableCompression);
+  return env->blob_manager->allocate(context, &record,
+                    BlobManager::kDisableCompression);
+}
+
+void
+KeyFilter::hash(const ups_key_t *key, uint64_t h[2]) const
+{
+  // +0.0 and -0.0 are equal, but have a different binary representation
+  if (db->config.key_type == UPS_TYPE_REAL32) {
+    float f = *(float *)key->data;
+    if (f == 0)
+      f = 0;
+    MurmurHash3_x64_128(&f, sizeof(f), 0, h);
+    return;
+  }
+  if (db->config.key_type == UPS_TYPE_REAL64) {
+    double d = *(double *)key->data;
+    if (d == 0)
+      d = 0;
+    MurmurHash3_x64_128(&d, sizeof(d), 0, h);
+    return;
+  }
+
+  MurmurHash3_x64_128(key->data, key->size, 0, h);
+}
+
+} // namespace upscaledb
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2005-2017 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * See the file COPYING for License information.
+ */
+
+/*
+ * A Bloom filter over the keys of a database (see UPS_PARAM_KEY_FILTER_BITS).
+ * It is used by the LocalDb to skip the btree lookup of keys which definitely
+ * do not exist.
+ *
+ * The filter is "blocked": all bits of a key are set in the same 512-bit
+ * block (a cache line), therefore a lookup causes at most one cache miss
+ * per segment.
+ *
+ * The filter consists of one or more segments. When the newest segment is
+ * full, a new segment with four times the capacity is appended; the keys
+ * are therefore never re-inserted. Keys are never removed either. Like the
+ * Histogram, the filter can return "the key maybe exists" although it
+ * doesn't, but never the other way around.
+ *
+ * The filter is persisted in a blob when the database is closed. The blob
+ * ids are stored in a directory blob which is referenced from the
+ * Environment header; the directory is indexed by the slot of the
+ * database in the header page. Whenever a database is opened for writing
+ * its persisted filter is marked as outdated, also if the session does
+ * not use the filter. The filter is only loaded if it was stored again
+ * and the Environment was closed cleanly. Otherwise, or if too many keys were
+ * erased, the filter is rebuilt by scanning the btree when the database
+ * is opened.
+ *
+ * @exception_safe: basic
+ * @thread_safe: no
+ */
+
+#ifndef UPS_KEY_FILTER_H
+#define UPS_KEY_FILTER_H
+
+#include "0root/root.h"
+
+#include <vector>
+
+#include "ups/upscaledb_int.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1globals/globals.h"
+#include "1mem/mem.h"
+
+#ifndef UPS_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace upscaledb {
+
+struct Context;
+struct LocalDb;
+
+struct KeyFilter {
+  enum {
+    // number of bits per block; a block fills a cache line
+    kBlockBits = 512,
+
+    // number of 64bit words per block
+    kBlockWords = kBlockBits / 64,
+
+    // number of keys which the first segment is sized for
+    kMinCapacity = 1024,
+
+    // each new segment has a higher capacity than the previous one
+    kGrowthFactor = 4,
+  };
+
+  // A segment of the filter
+  struct Segment {
+    // the bit array
+    uint64_t *bits;
+
+    // number of blocks in |bits|
+    uint64_t block_count;
+
+    // number of keys which the segment was sized for
+    uint64_t capacity;
+
+    // number of keys which were added
+    uint64_t key_count;
+  };
+
+  // Constructor; the filter is disabled
+  KeyFilter(LocalDb *db_)
+    : db(db_), bits_per_key(0), probes(0), erased_count(0) {
+  }
+
+  // Destructor
+  ~KeyFilter() {
+    reset();
+  }
+
+  // Enables the filter with |bits_per_key_| bits per key
+  void initialize(int bits_per_key_) {
+    bits_per_key = bits_per_key_;
+    // the optimal number of probes is bits_per_key * ln(2)
+    probes = (bits_per_key * 69 + 50) / 100;
+    if (probes < 1)
+      probes = 1;
+    if (probes > 16)
+      probes = 16;
+  }
+
+  // Returns true if the filter is enabled
+  bool is_enabled() const {
+    return bits_per_key != 0;
+  }
+
+  // Returns true if the filter was built and can be used
+  bool is_built() const {
+    return !segments.empty();
+  }
+
+  // Creates an empty filter for a new database
+  void create();
+
+  // Loads the persisted filter of an existing database, or rebuilds it
+  // from the keys of the btree if it is missing or outdated
+  void open(Context *context);
+
+  // Marks the persisted filter as outdated if the database is writable.
+  // Called whenever the database is opened, even if the filter is not
+  // used in this session; it is valid again if close() stores it.
+  void invalidate();
+
+  // Persists the filter when the database is closed
+  void close(Context *context);
+
+  // Discards the filter and its persisted blob; called when the database
+  // is erased
+  void drop(Context *context);
+
+  // Returns false if |key| definitely does not exist. Always returns true
+  // if the filter was not built.
+  bool may_contain(const ups_key_t *key) const {
+    if (unlikely(!is_built()))
+      return true;
+
+    uint64_t h[2];
+    hash(key, h);
+    for (size_t i = 0; i < segments.size(); i++) {
+      if (test(&segments[i], h))
+        return true;
+    }
+    Globals::ms_key_filter_negatives++;
+    return false;
+  }
+
+  // Adds a newly inserted key. If the newest segment is full then a new
+  // one is appended.
+  void insert(const ups_key_t *key) {
+    if (!is_built())
+      return;
+    if (unlikely(segments.back().key_count >= segments.back().capacity))
+      add_segment(segments.back().capacity * kGrowthFactor);
+    add(key);
+  }
+
+  // Counts an erased key. If too many keys were erased then the filter is
+  // not persisted, and rebuilt when the database is opened again.
+  void erase() {
+    if (is_built())
+      erased_count++;
+  }
+
+  // Discards the filter
+  void reset() {
+    for (size_t i = 0; i < segments.size(); i++)
+      Memory::release(segments[i].bits);
+    segments.clear();
+    erased_count = 0;
+  }
+
+  // Returns the usage metrics
+  static void fill_metrics(ups_env_metrics_t *metrics) {
+    metrics->key_filter_negatives = Globals::ms_key_filter_negatives;
+    metrics->key_filter_rebuilds = Globals::ms_key_filter_rebuilds;
+  }
+
+  // Returns true if the bits of a key are set in |segment|
+  bool test(const Segment *segment, const uint64_t h[2]) const {
+    const uint64_t *block = &segment->bits[(h[0] % segment->block_count)
+                                                * kBlockWords];
+    uint32_t bit = (uint32_t)h[1];
+    uint32_t delta = (uint32_t)(h[1] >> 32) | 1;
+    for (int i = 0; i < probes; i++, bit += delta) {
+      uint32_t b = bit & (kBlockBits - 1);
+      if ((block[b >> 6] & (1ull << (b & 63))) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  // Sets the bits of a key in the newest segment
+  void add(const ups_key_t *key) {
+    Segment *segment = &segments.back();
+    uint64_t h[2];
+    hash(key, h);
+    uint64_t *block = &segment->bits[(h[0] % segment->block_count)
+                                                * kBlockWords];
+    uint32_t bit = (uint32_t)h[1];
+    uint32_t delta = (uint32_t)(h[1] >> 32) | 1;
+    for (int i = 0; i < probes; i++, bit += delta) {
+      uint32_t b = bit & (kBlockBits - 1);
+      block[b >> 6] |= 1ull << (b & 63);
+    }
+    segment->key_count++;
+  }
+
+  // Appends an empty segment for |capacity| keys
+  void add_segment(uint64_t capacity);
+
+  // Returns the total number of keys which were added
+  uint64_t key_count() const {
+    uint64_t count = 0;
+    for (size_t i = 0; i < segments.size(); i++)
+      count += segments[i].key_count;
+    return count;
+  }
+
+  // Returns true if too many keys were erased; the false positive rate
+  // then grows, and the filter should be rebuilt
+  bool is_outdated() const {
+    return erased_count > key_count() / 2;
+  }
+
+  // Returns the slot of the database in the Environment's header page
+  size_t slot() const;
+
+  // Rebuilds the filter from the keys of the btree
+  void build(Context *context);
+
+  // Loads the filter from a blob; returns false if the blob does not
+  // match the current configuration
+  bool load(Context *context, uint64_t blob_id);
+
+  // Stores the filter in a blob; returns the new blob id
+  uint64_t store(Context *context, uint64_t blob_id);
+
+  // Calculates the 128bit hash of a key
+  void hash(const ups_key_t *key, uint64_t h[2]) const;
+
+  // The database
+  LocalDb *db;
+
+  // number of bits per key; 0 if the filter is disabled
+  int bits_per_key;
+
+  // number of bits which are set per key
+  int probes;
+
+  // the segments; empty if the filter was not built
+  std::vector<Segment> segments;
+
+  // number of keys which were erased since the filter was built
+  uint64_t erased_count;
+};
+
+} // namespace upscaledb
+
+#endif // UPS_KEY_FILTER_H
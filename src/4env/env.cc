@@ -95,7 +95,7 @@ Env::close(uint32_t flags)
 {
   ups_status_t st = 0;
 
-  ScopedLock lock(mutex);
+  ScopedWriteLock lock(mutex);
 
   /* auto-abort (or commit) all pending transactions */
   if (txn_manager.get()) {
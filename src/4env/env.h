@@ -65,6 +65,8 @@ struct Env
   // Constructor
   Env(EnvConfig &config_)
     : config(config_) {
+    if (ISSET(config.flags, UPS_ENABLE_CONCURRENT_READS))
+      mutex.enable_shared();
   }
 
   virtual ~Env() {
@@ -116,6 +118,32 @@ struct Env
   // Commits a transaction (ups_txn_abort)
   virtual ups_status_t txn_abort(Txn *txn, uint32_t flags) = 0;
 
+  // Returns the lsn of the last commit if it waits for its commit group
+  // to be flushed (see UPS_PARAM_GROUP_COMMIT_USEC); otherwise returns 0.
+  // The caller must hold |mutex|.
+  virtual uint64_t pending_commit_lsn() {
+    return 0;
+  }
+
+  // Waits till the commit with |lsn| was flushed; the caller must NOT
+  // hold |mutex|
+  virtual ups_status_t wait_for_commit(uint64_t lsn) {
+    return 0;
+  }
+
+  // Returns the lsn of the most recent commit. The caller must hold
+  // |mutex|.
+  virtual uint64_t last_commit_lsn() {
+    return 0;
+  }
+
+  // Waits till the commit with |lsn| is durable, even if the journal is
+  // synced in the background (see UPS_PARAM_JOURNAL_SYNC_MSEC); the caller
+  // must NOT hold |mutex|
+  virtual ups_status_t wait_for_durable_commit(uint64_t lsn) {
+    return 0;
+  }
+
   // Fills in the current metrics
   virtual void fill_metrics(ups_env_metrics_t *metrics) = 0;
 
@@ -135,12 +163,18 @@ struct Env
   // Closes the Environment (ups_env_close)
   ups_status_t close(uint32_t flags);
 
-  // A mutex to serialize access to this Environment
-  Mutex mutex;
+  // A mutex to serialize access to this Environment; lookups acquire
+  // a shared lock if UPS_ENABLE_CONCURRENT_READS is set
+  ReadWriteMutex mutex;
 
   // The Environment's configuration
   EnvConfig config;
 
+  // Signalled when a Txn was committed or aborted; used with |mutex|
+  // by operations which wait for a conflicting Txn (see
+  // UPS_PARAM_TXN_CONFLICT_WAIT_MSEC)
+  Condition txn_ended;
+
   // The Txn manager; can be null
   ScopedPtr<TxnManager> txn_manager;
 
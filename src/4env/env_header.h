@@ -49,8 +49,8 @@ typedef UPS_PACK_0 struct UPS_PACK_1
   // version information - major, minor, rev, file
   uint8_t version[4];
 
-  // reserved
-  uint64_t _reserved1;
+  // blob id of the directory of the persisted key filters
+  uint64_t key_filter_blobid;
 
   // size of the page
   uint32_t page_size;
@@ -61,8 +61,8 @@ typedef UPS_PACK_0 struct UPS_PACK_1
   // for storing journal compression algorithm
   uint8_t journal_compression;
 
-  // reserved
-  uint8_t _reserved2;
+  // 1 if the persisted key filters are up to date
+  uint8_t key_filters_valid;
 
   // blob id of the PageManager's state
   uint64_t page_manager_blobid;
@@ -79,6 +79,14 @@ typedef UPS_PACK_0 struct UPS_PACK_1
 
 struct EnvHeader
 {
+  enum {
+    // The file version while persisted key filters are valid. Older
+    // releases refuse to open such a file, therefore they cannot modify
+    // the database without invalidating the filters. Otherwise the file
+    // version is UPS_FILE_VERSION.
+    kKeyFilterFileVersion = UPS_FILE_VERSION + 1
+  };
+
   // Constructor
   EnvHeader(Page *page)
     : header_page(page) {
@@ -119,6 +127,12 @@ struct EnvHeader
     header()->version[3] = file;
   }
 
+  // Returns true if the file version can be opened
+  bool verify_file_version() {
+    return header()->version[3] == UPS_FILE_VERSION
+            || header()->version[3] == kKeyFilterFileVersion;
+  }
+
   // Returns get the maximum number of databases for this file
   uint16_t max_databases() {
     return header()->max_databases;
@@ -149,6 +163,26 @@ struct EnvHeader
     header()->page_manager_blobid = blobid;
   }
 
+  // Returns the blob id of the directory of the persisted key filters
+  uint64_t key_filter_blobid() {
+    return header()->key_filter_blobid;
+  }
+
+  // Sets the blob id of the directory of the persisted key filters
+  void set_key_filter_blobid(uint64_t blobid) {
+    header()->key_filter_blobid = blobid;
+  }
+
+  // Returns true if the persisted key filters are up to date
+  bool key_filters_valid() {
+    return header()->key_filters_valid != 0;
+  }
+
+  // Sets the flag whether the persisted key filters are up to date
+  void set_key_filters_valid(bool valid) {
+    header()->key_filters_valid = valid ? 1 : 0;
+  }
+
   // Returns the Journal compression configuration
   int journal_compression() {
     return header()->journal_compression >> 4;
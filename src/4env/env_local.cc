@@ -44,7 +44,9 @@ using namespace upscaledb;
 
 namespace upscaledb {
 
-static inline void
+// Opens the journal and performs recovery, if required. Returns true if
+// the journal was replayed
+static inline bool
 recover(LocalEnv *env, uint32_t flags)
 {
   assert(ISSET(env->flags(), UPS_ENABLE_TRANSACTIONS));
@@ -58,14 +60,16 @@ recover(LocalEnv *env, uint32_t flags)
   catch (Exception &ex) {
     if (ex.code == UPS_FILE_NOT_FOUND) {
       env->journal->create();
-      return;
+      return false;
     }
   }
 
   /* success - check if we need recovery */
+  bool recovered = false;
   if (!env->journal->is_empty()) {
     if (ISSET(flags, UPS_AUTO_RECOVERY)) {
       env->journal->recover((LocalTxnManager *)env->txn_manager.get());
+      recovered = true;
     }
     else {
       /* otherwise close log and journal, but do not delete the files */
@@ -76,6 +80,7 @@ recover(LocalEnv *env, uint32_t flags)
 
   /* reset the page manager */
   env->page_manager->reset(&context);
+  return recovered;
 }
 
 static inline PBtreeHeader *
@@ -115,6 +120,91 @@ mark_header_page_dirty(LocalEnv *env, Context *context)
     context->changeset.put(page);
 }
 
+// Loads the directory of the persisted key filters. The filters are only
+// valid if the Environment was closed cleanly. If the Environment is
+// modified then they are invalidated on disk right away, and the file
+// version is reset to UPS_FILE_VERSION; they are valid again when the
+// Environment is closed.
+static inline void
+load_key_filters(LocalEnv *env, Context *context, bool recovered)
+{
+  size_t max_databases = env->header->max_databases();
+  env->key_filter_blobs.assign(max_databases, 0);
+  env->key_filter_valid.assign(max_databases, false);
+
+  uint64_t blob_id = env->header->key_filter_blobid();
+  if (!blob_id)
+    return;
+
+  ByteArray arena;
+  ups_record_t record = {0};
+  env->blob_manager->read(context, blob_id, &record, UPS_FORCE_DEEP_COPY,
+                  &arena);
+
+  bool is_valid = env->header->key_filters_valid()
+                    && env->header->version(3)
+                            == EnvHeader::kKeyFilterFileVersion
+                    && !recovered;
+  const uint64_t *entries = (const uint64_t *)record.data;
+  size_t count = std::min(max_databases,
+                  (size_t)record.size / (2 * sizeof(uint64_t)));
+  for (size_t i = 0; i < count; i++) {
+    env->key_filter_blobs[i] = entries[2 * i];
+    env->key_filter_valid[i] = is_valid && entries[2 * i + 1] != 0;
+  }
+
+  if (env->header->key_filters_valid() && NOTSET(env->flags(), UPS_READ_ONLY)) {
+    env->header->set_key_filters_valid(false);
+    env->header->set_version(UPS_VERSION_MAJ, UPS_VERSION_MIN,
+                    UPS_VERSION_REV, UPS_FILE_VERSION);
+    Page *page = env->header->header_page;
+    page->set_dirty(true);
+    page->flush();
+    env->device->flush();
+  }
+}
+
+// Stores the directory of the persisted key filters, and marks them
+// as valid. Only then the file version is set to kKeyFilterFileVersion;
+// files without persisted filters can still be opened by older releases.
+static inline void
+store_key_filters(LocalEnv *env, Context *context)
+{
+  if (ISSETANY(env->flags(), UPS_READ_ONLY | UPS_IN_MEMORY)
+        || !env->blob_manager
+        || env->key_filter_blobs.empty())
+    return;
+
+  ByteArray arena;
+  bool is_empty = true;
+  for (size_t i = 0; i < env->key_filter_blobs.size(); i++) {
+    uint64_t entry[2] = {env->key_filter_blobs[i], env->key_filter_valid[i]};
+    arena.append((uint8_t *)&entry[0], sizeof(entry));
+    if (entry[0])
+      is_empty = false;
+  }
+
+  uint64_t blob_id = env->header->key_filter_blobid();
+  if (is_empty && !blob_id)
+    return;
+
+  ups_record_t record = ups_make_record(arena.data(), (uint32_t)arena.size());
+  if (blob_id)
+    blob_id = env->blob_manager->overwrite(context, blob_id, &record,
+                    BlobManager::kDisableCompression);
+  else
+    blob_id = env->blob_manager->allocate(context, &record,
+                    BlobManager::kDisableCompression);
+
+  env->header->set_key_filter_blobid(blob_id);
+  env->header->set_key_filters_valid(true);
+  env->header->set_version(UPS_VERSION_MAJ, UPS_VERSION_MIN, UPS_VERSION_REV,
+                  EnvHeader::kKeyFilterFileVersion);
+  mark_header_page_dirty(env, context);
+  if (env->journal)
+    context->changeset.flush(env->lsn_manager.next());
+}
+
 ups_status_t
 LocalEnv::create()
 {
@@ -163,6 +253,10 @@ LocalEnv::create()
   if (config.journal_compressor)
     header->set_journal_compression(config.journal_compressor);
 
+  /* there are no persisted key filters */
+  key_filter_blobs.assign(config.max_databases, 0);
+  key_filter_valid.assign(config.max_databases, false);
+
   /* flush the header page - this will write through disk if logging is
    * enabled */
   if (journal.get())
@@ -236,8 +330,9 @@ LocalEnv::open()
     }
 
     // Check the database version; everything with a different file version
-    // is incompatible.
-    if (header->version(3) != UPS_FILE_VERSION) {
+    // is incompatible. Files with persisted key filters have a higher
+    // version (see EnvHeader::kKeyFilterFileVersion).
+    if (!header->verify_file_version()) {
       ups_log(("invalid file version"));
       st = UPS_INV_FILE_VERSION;
       goto fail_with_fake_cleansing;
@@ -275,13 +370,17 @@ fail_with_fake_cleansing:
   blob_manager.reset(BlobManagerFactory::create(this, config.flags));
 
   /* check if recovery is required */
+  bool recovered = false;
   if (ISSET(flags(), UPS_ENABLE_TRANSACTIONS))
-    recover(this, config.flags);
+    recovered = recover(this, config.flags);
 
   /* load the state of the PageManager */
   if (header->page_manager_blobid() != 0)
     page_manager->initialize(header->page_manager_blobid());
 
+  /* load the directory of the persisted key filters */
+  load_key_filters(this, &context, recovered);
+
   return 0;
 }
 
@@ -347,6 +446,48 @@ LocalEnv::get_parameters(ups_parameter_t *param)
       case UPS_PARAM_POSIX_FADVISE:
         p->value = config.posix_advice;
         break;
+      case UPS_PARAM_CACHE_POLICY:
+        p->value = config.cache_policy;
+        break;
+      case UPS_PARAM_CACHE_SHARDS:
+        p->value = config.cache_shards;
+        break;
+      case UPS_PARAM_WORKER_THREADS:
+        p->value = config.worker_threads;
+        break;
+      case UPS_PARAM_GROUP_COMMIT_USEC:
+        p->value = config.group_commit_usec;
+        break;
+      case UPS_PARAM_GROUP_COMMIT_SIZE:
+        p->value = config.group_commit_size;
+        break;
+      case UPS_PARAM_JOURNAL_PAGE_DELTAS:
+        p->value = config.journal_page_deltas ? 1 : 0;
+        break;
+      case UPS_PARAM_JOURNAL_FILES:
+        p->value = config.journal_files;
+        break;
+      case UPS_PARAM_JOURNAL_FILE_SIZE:
+        p->value = config.journal_file_size;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        p->value = config.journal_checkpoint_interval;
+        break;
+      case UPS_PARAM_JOURNAL_SYNC_MSEC:
+        p->value = config.journal_sync_msec;
+        break;
+      case UPS_PARAM_TXN_MERGE_LIMIT:
+        p->value = config.txn_merge_limit;
+        break;
+      case UPS_PARAM_TXN_CONFLICT_WAIT_MSEC:
+        p->value = config.txn_conflict_wait_msec;
+        break;
+      case UPS_PARAM_JOURNAL_COMMIT_LSN:
+        p->value = last_commit_lsn();
+        break;
+      case UPS_PARAM_JOURNAL_DURABLE_LSN:
+        p->value = journal.get() ? journal->durable_commit_lsn() : 0;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)p->name));
         return (UPS_INV_PARAMETER);
@@ -433,7 +574,8 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
           dbconfig.record_compressor = (int)param->value;
           break;
         case UPS_PARAM_KEY_COMPRESSION:
-          if (unlikely(!CompressorFactory::is_available(param->value))) {
+          if (unlikely(param->value != UPS_COMPRESSOR_PREFIX
+                && !CompressorFactory::is_available(param->value))) {
             ups_trace(("unknown algorithm for key compression"));
             throw Exception(UPS_INV_PARAMETER);
           }
@@ -476,6 +618,14 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
         case UPS_PARAM_CUSTOM_COMPARE_NAME:
           dbconfig.compare_name = reinterpret_cast<const char *>(param->value);
           break;
+        case UPS_PARAM_KEY_FILTER_BITS:
+          if (unlikely(param->value > 32)) {
+            ups_trace(("invalid key filter size %u - must be <= 32",
+                       (unsigned)param->value));
+            throw Exception(UPS_INV_PARAMETER);
+          }
+          dbconfig.key_filter_bits = (int)param->value;
+          break;
         default:
           ups_trace(("invalid parameter 0x%x (%d)", param->name, param->name));
           throw Exception(UPS_INV_PARAMETER);
@@ -533,11 +683,12 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
     }
   }
 
-  // all heavy-weight compressors are only allowed for
-  // variable-length binary keys
+  // all heavy-weight compressors and the prefix compression are only
+  // allowed for variable-length binary keys
   if (dbconfig.key_compressor == UPS_COMPRESSOR_LZF
         || dbconfig.key_compressor == UPS_COMPRESSOR_SNAPPY
-        || dbconfig.key_compressor == UPS_COMPRESSOR_ZLIB) {
+        || dbconfig.key_compressor == UPS_COMPRESSOR_ZLIB
+        || dbconfig.key_compressor == UPS_COMPRESSOR_PREFIX) {
     if (unlikely(dbconfig.key_type != UPS_TYPE_BINARY
           || dbconfig.key_size != UPS_KEY_SIZE_UNLIMITED)) {
       ups_trace(("Key compression only allowed for unlimited binary keys "
@@ -546,8 +697,26 @@ LocalEnv::do_create_db(DbConfig &dbconfig, const ups_parameter_t *param)
     }
   }
 
+  // normalized keys are only allowed for variable-length binary keys
+  if (ISSET(dbconfig.flags, UPS_ENABLE_NORMALIZED_KEYS)) {
+    if (unlikely(dbconfig.key_type != UPS_TYPE_BINARY
+          || dbconfig.key_size != UPS_KEY_SIZE_UNLIMITED)) {
+      ups_trace(("UPS_ENABLE_NORMALIZED_KEYS only allowed for unlimited "
+                 "binary keys (UPS_TYPE_BINARY)"));
+      throw Exception(UPS_INV_PARAMETER);
+    }
+  }
+
+  // custom compare functions can treat keys as equal although their
+  // bytes differ; the key filter would then miss these keys
+  if (dbconfig.key_filter_bits && dbconfig.key_type == UPS_TYPE_CUSTOM) {
+    ups_trace(("UPS_PARAM_KEY_FILTER_BITS not allowed for UPS_TYPE_CUSTOM"));
+    throw Exception(UPS_INV_PARAMETER);
+  }
+
   uint32_t mask = UPS_FORCE_RECORDS_INLINE
                     | UPS_ENABLE_DUPLICATE_KEYS
+                    | UPS_ENABLE_NORMALIZED_KEYS
                     | UPS_IGNORE_MISSING_CALLBACK
                     | UPS_RECORD_NUMBER32
                     | UPS_RECORD_NUMBER64;
@@ -623,6 +792,10 @@ LocalEnv::do_open_db(DbConfig &dbconfig, const ups_parameter_t *param)
           ups_trace(("Key compression parameters are only allowed in "
                      "ups_env_create_db"));
           throw Exception(UPS_INV_PARAMETER);
+        case UPS_PARAM_KEY_FILTER_BITS:
+          ups_trace(("Key filter parameters are only allowed in "
+                     "ups_env_create_db"));
+          throw Exception(UPS_INV_PARAMETER);
         default:
           ups_trace(("invalid parameter 0x%x (%d)", param->name, param->name));
           throw Exception(UPS_INV_PARAMETER);
@@ -777,14 +950,59 @@ LocalEnv::txn_abort(Txn *txn, uint32_t)
   return txn_manager->abort(txn);
 }
 
+uint64_t
+LocalEnv::pending_commit_lsn()
+{
+  return journal.get() ? journal->pending_commit_lsn() : 0;
+}
+
+ups_status_t
+LocalEnv::wait_for_commit(uint64_t lsn)
+{
+  try {
+    journal->wait_for_commit(lsn);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+  return 0;
+}
+
+uint64_t
+LocalEnv::last_commit_lsn()
+{
+  return journal.get() ? journal->last_commit_lsn() : 0;
+}
+
+ups_status_t
+LocalEnv::wait_for_durable_commit(uint64_t lsn)
+{
+  if (!journal.get())
+    return 0;
+
+  try {
+    journal->wait_for_durable_commit(lsn);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+  return 0;
+}
+
 ups_status_t
 LocalEnv::do_close(uint32_t flags)
 {
   Context context(this);
 
-  /* flush all committed transactions */
-  if (likely(txn_manager.get() != 0))
+  /* stop the background merge, then flush all committed transactions */
+  if (likely(txn_manager.get() != 0)) {
+    ((LocalTxnManager *)txn_manager.get())->stop_background_merge();
     txn_manager->flush_committed_txns(&context);
+  }
+
+  /* persist the directory of the key filters */
+  if (likely(header && header->header_page))
+    store_key_filters(this, &context);
 
   /* flush all pages and the freelist, reduce the file size */
   if (likely(page_manager.get() != 0))
@@ -813,6 +1031,12 @@ LocalEnv::do_close(uint32_t flags)
   return 0;
 }
 
+size_t
+LocalEnv::btree_header_slot(const PBtreeHeader *hdr)
+{
+  return hdr - btree_header(header.get(), 0);
+}
+
 void
 LocalEnv::fill_metrics(ups_env_metrics_t *metrics)
 {
@@ -830,6 +1054,8 @@ LocalEnv::fill_metrics(ups_env_metrics_t *metrics)
   }
   // and of the btrees
   BtreeIndex::fill_metrics(metrics);
+  // and of the key filters
+  KeyFilter::fill_metrics(metrics);
 }
 
 } // namespace upscaledb
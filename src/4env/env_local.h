@@ -83,6 +83,18 @@ struct LocalEnv : public Env
   // Commits a transaction (ups_txn_abort)
   virtual ups_status_t txn_abort(Txn *txn, uint32_t flags);
 
+  // Returns the lsn of the last commit if it waits for its commit group
+  virtual uint64_t pending_commit_lsn();
+
+  // Waits till the commit group with |lsn| was flushed
+  virtual ups_status_t wait_for_commit(uint64_t lsn);
+
+  // Returns the lsn of the most recent commit
+  virtual uint64_t last_commit_lsn();
+
+  // Waits till the commit with |lsn| is durable
+  virtual ups_status_t wait_for_durable_commit(uint64_t lsn);
+
   // Renames a database in the Environment (ups_env_rename_db)
   virtual ups_status_t rename_db(uint16_t oldname, uint16_t newname,
                   uint32_t flags);
@@ -100,6 +112,9 @@ struct LocalEnv : public Env
   // Closes the Environment (ups_env_close)
   virtual ups_status_t do_close(uint32_t flags);
 
+  // Returns the slot of a PBtreeHeader in the header page
+  size_t btree_header_slot(const PBtreeHeader *btree_header);
+
   // The Environment's header page/configuration
   ScopedPtr<EnvHeader> header;
 
@@ -117,6 +132,13 @@ struct LocalEnv : public Env
 
   // The lsn manager
   LsnManager lsn_manager;
+
+  // The blob ids of the persisted key filters, indexed by the slot of the
+  // database in the header page (see KeyFilter)
+  std::vector<uint64_t> key_filter_blobs;
+
+  // For each slot: true if the persisted key filter is up to date
+  std::vector<bool> key_filter_valid;
 };
 
 } // namespace upscaledb
@@ -26,7 +26,7 @@
  * When a Database is created, it contains a BtreeIndex for persistent
  * (committed and flushed) data, and a TxnIndex for active transactions
  * and those transactions which were committed but not yet flushed to disk.
- * This TxnTree is implemented as a binary search tree (see rb.h).
+ * This TxnTree is implemented as a skiplist (see TxnIndex).
  *
  * Each node in the TxnTree is implemented by TxnNode. Each
  * node is identified by its database key, and groups all modifications of this
@@ -90,7 +90,7 @@ struct Txn : ReferenceCounted {
   // Constructor; "begins" the Txn
   // supported flags: UPS_TXN_READ_ONLY, UPS_TXN_TEMPORARY
   Txn(Env *env_, const char *name_, uint32_t flags_)
-    : id(0), env(env_), flags(flags_) {
+    : id(0), env(env_), flags(flags_), conflicting_txn_id(0) {
       if (unlikely(name_ != 0))
         name = name_;
   }
@@ -129,6 +129,10 @@ struct Txn : ReferenceCounted {
   // flags for this Txn
   uint32_t flags;
 
+  // the id of the Txn which caused the most recent UPS_TXN_CONFLICT;
+  // 0 if there was no conflict
+  uint64_t conflicting_txn_id;
+
   // This is a node in a linked list
   IntrusiveListNode<Txn> list_node;
 
@@ -183,6 +187,11 @@ struct TxnManager {
     list.del(txn);
   }
 
+  // Removes a transaction which is not necessarily the oldest one
+  void remove_txn(Txn *txn) {
+    list.del(txn);
+  }
+
   Txn *newest_txn() {
     return list.tail();
   }
@@ -71,11 +71,16 @@ move_top_in_node(TxnCursor *cursor, TxnNode *node, bool ignore_conflicts,
                 uint32_t flags)
 {
   TxnCursorState &state_ = cursor->state_;
+  LocalTxn *txn = (LocalTxn *)state_.parent->txn;
 
   for (TxnOperation *op = node->newest_op;
                   op != 0;
                   op = op->previous_in_node) {
-    Txn *optxn = op->txn;
+    LocalTxn *optxn = op->txn;
+    // a read-only transaction skips the ops which are not in its snapshot
+    if (is_hidden_from_snapshot(txn, optxn))
+      continue;
+
     // only look at ops from the current transaction and from
     // committed transactions
     if (optxn == state_.parent->txn || optxn->is_committed()) {
@@ -114,7 +119,7 @@ move_top_in_node(TxnCursor *cursor, TxnNode *node, bool ignore_conflicts,
     // functions will need to know about the op when consolidating the trees
     if (!ignore_conflicts) {
       cursor->couple_to(op);
-      return UPS_TXN_CONFLICT;
+      return report_conflict(txn, optxn);
     }
   }
 
@@ -168,19 +173,28 @@ TxnCursor::move(uint32_t flags)
   if (ISSET(flags, UPS_CURSOR_FIRST)) {
     set_to_nil();
 
-    node = db(state_)->txn_index->first();
-    if (unlikely(!node))
-      return UPS_KEY_NOT_FOUND;
-    return move_top_in_node(this, node, false, flags);
+    // skip the nodes without visible ops
+    for (node = db(state_)->txn_index->first();
+                    node != 0;
+                    node = node->next_sibling()) {
+      st = move_top_in_node(this, node, false, flags);
+      if (st != UPS_KEY_NOT_FOUND)
+        return st;
+    }
+    return UPS_KEY_NOT_FOUND;
   }
 
   if (ISSET(flags, UPS_CURSOR_LAST)) {
     set_to_nil();
 
-    node = db(state_)->txn_index->last();
-    if (unlikely(!node))
-      return UPS_KEY_NOT_FOUND;
-    return move_top_in_node(this, node, false, flags);
+    for (node = db(state_)->txn_index->last();
+                    node != 0;
+                    node = node->previous_sibling()) {
+      st = move_top_in_node(this, node, false, flags);
+      if (st != UPS_KEY_NOT_FOUND)
+        return st;
+    }
+    return UPS_KEY_NOT_FOUND;
   }
 
   if (ISSET(flags, UPS_CURSOR_NEXT)) {
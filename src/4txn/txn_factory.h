@@ -43,14 +43,15 @@ struct TxnFactory {
             TxnNode *node, uint32_t flags, uint32_t orig_flags,
             uint64_t lsn, ups_key_t *key, ups_record_t *record) {
     TxnOperation *op;
-    op = Memory::allocate<TxnOperation>(sizeof(*op)
+    op = (TxnOperation *)txn->arena.allocate(sizeof(*op)
                                             + (record ? record->size : 0)
                                             + (key ? key->size : 0));
     op->initialize(txn, node, flags, orig_flags, lsn, key, record);
     return op;
   }
 
-  // Destroys a TxnOperation
+  // Destroys a TxnOperation; the memory is released with the arena of
+  // its Txn
   static void destroy_operation(TxnOperation *op) {
     op->destroy();
   }
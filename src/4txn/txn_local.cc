@@ -18,6 +18,8 @@
 
 #include "0root/root.h"
 
+#include <limits>
+
 // Always verify that a file of level N does not include headers > N!
 #include "3btree/btree_index.h"
 #include "3journal/journal.h"
@@ -35,42 +37,48 @@
 
 namespace upscaledb {
 
-// stuff for rb.h
-#ifndef __ssize_t_defined
-typedef signed ssize_t;
-#endif
-#ifndef __cplusplus
-typedef int bool;
-#define true 1
-#define false (!true)
-#endif // __cpluscplus
-
-static int
-compare(void *vlhs, void *vrhs)
+static inline int
+compare(LocalDb *db, ups_key_t *lhs, ups_key_t *rhs)
 {
-  TxnNode *lhs = (TxnNode *)vlhs;
-  TxnNode *rhs = (TxnNode *)vrhs;
-  LocalDb *db = lhs->db;
-
-  if (unlikely(lhs == rhs))
-    return 0;
+  return db->btree_index->compare_keys(lhs, rhs);
+}
 
-  ups_key_t *lhskey = lhs->key();
-  ups_key_t *rhskey = rhs->key();
-  assert(lhskey && rhskey);
-  return db->btree_index->compare_keys(lhskey, rhskey);
+// Returns the begin-lsn of the oldest active read-only Txn, or the max.
+// lsn if there is none
+static inline uint64_t
+oldest_snapshot_lsn(LocalTxnManager *tm)
+{
+  for (Txn *txn = tm->oldest_txn(); txn; txn = txn->next()) {
+    if (ISSET(txn->flags, UPS_TXN_READ_ONLY)
+          && !txn->is_committed() && !txn->is_aborted())
+      return ((LocalTxn *)txn)->lsn;
+  }
+  return std::numeric_limits<uint64_t>::max();
 }
 
-rb_proto(static, rbt_, TxnIndex, TxnNode)
-rb_gen(static, rbt_, TxnIndex, TxnNode, node, compare)
+// Returns true if |txn| is skipped when the committed Txns are flushed,
+// but the younger Txns can still be flushed. Active read-only Txns do not
+// have operations. Txns which were committed after |snapshot_lsn| are
+// hidden from a snapshot; they stay in the TxnIndex, where the snapshot
+// can skip them.
+static inline bool
+is_skipped_by_flush(LocalTxn *txn, uint64_t snapshot_lsn)
+{
+  if (txn->is_committed())
+    return txn->commit_lsn > snapshot_lsn;
+  return !txn->is_aborted() && ISSET(txn->flags, UPS_TXN_READ_ONLY);
+}
 
 static inline int
 count_flushable_transactions(LocalTxnManager *tm)
 {
   int to_flush = 0;
+  uint64_t snapshot_lsn = oldest_snapshot_lsn(tm);
 
   LocalTxn *oldest = (LocalTxn *)tm->oldest_txn();
   for (; oldest; oldest = (LocalTxn *)oldest->next()) {
+    if (is_skipped_by_flush(oldest, snapshot_lsn))
+      continue;
     // a transaction can be flushed if it's committed or aborted, and if there
     // are no cursors coupled to it
     if (oldest->is_committed() || oldest->is_aborted()) {
@@ -90,14 +98,29 @@ count_flushable_transactions(LocalTxnManager *tm)
 static inline void
 flush_committed_txns_impl(LocalTxnManager *tm, Context *context)
 {
-  LocalTxn *oldest;
+  LocalTxn *oldest, *next;
   uint64_t highest_lsn = 0;
 
   assert(context->changeset.is_empty());
 
-  // always get the oldest transaction; if it was committed: flush
-  // it; if it was aborted: discard it; otherwise return
-  while ((oldest = (LocalTxn *)tm->oldest_txn())) {
+  // Txns which were committed after an active read-only Txn began are
+  // not flushed; the btree must not contain data which is hidden from
+  // the snapshot of the read-only Txn. These Txns (and the read-only
+  // Txns) are skipped, and the younger Txns which are visible to all
+  // snapshots are flushed. A skipped Txn did not modify the keys of a
+  // younger Txn before that one committed (this would have been a
+  // conflict), therefore the operations of each key are still flushed
+  // in their original order.
+  uint64_t snapshot_lsn = oldest_snapshot_lsn(tm);
+
+  // start with the oldest transaction; if it was committed: flush
+  // it; if it was aborted: discard it; if it is still active: return
+  for (oldest = (LocalTxn *)tm->oldest_txn(); oldest; oldest = next) {
+    next = (LocalTxn *)oldest->next();
+
+    if (is_skipped_by_flush(oldest, snapshot_lsn))
+      continue;
+
     if (oldest->is_committed()) {
       uint64_t lsn = tm->flush_txn_to_changeset(context, (LocalTxn *)oldest);
       if (lsn > highest_lsn)
@@ -109,8 +132,13 @@ flush_committed_txns_impl(LocalTxnManager *tm, Context *context)
     else
       break;
 
+    // the journal file of this txn can be reused as soon as the changeset
+    // (see below) was written
+    if (tm->lenv()->journal.get())
+      tm->lenv()->journal->txn_flushed(oldest);
+
     // now remove the txn from the linked list
-    tm->remove_txn_from_head(oldest);
+    tm->remove_txn(oldest);
 
     // and release the memory
     delete oldest;
@@ -124,6 +152,99 @@ flush_committed_txns_impl(LocalTxnManager *tm, Context *context)
   assert(context->changeset.is_empty());
 }
 
+// Acquires the Environment's lock for the background merge. The thread
+// blocks on the lock, but wakes up periodically to check whether it has to
+// stop, because then the closing thread holds the lock.
+static inline bool
+lock_env_for_merge(LocalTxnManager *tm)
+{
+  while (true) {
+    {
+      ScopedLock lock(tm->merge.mutex);
+      if (tm->merge.stop)
+        return false;
+    }
+    if (tm->lenv()->mutex.timed_lock(boost::posix_time::milliseconds(10)))
+      return true;
+  }
+}
+
+// The background thread which merges committed Txns into the btree (see
+// UPS_PARAM_TXN_MERGE_LIMIT)
+static void
+run_background_merge(LocalTxnManager *tm)
+{
+  LocalTxnManager::BackgroundMerge &merge = tm->merge;
+  ScopedLock lock(merge.mutex);
+
+  while (true) {
+    while (!merge.stop && !merge.is_requested)
+      merge.cond.wait(lock);
+    if (merge.stop)
+      break;
+    merge.is_requested = false;
+    lock.unlock();
+
+    bool is_merged = false;
+    if (lock_env_for_merge(tm)) {
+      ScopedWriteLock env_lock(tm->lenv()->mutex, boost::adopt_lock);
+      try {
+        Context context(tm->lenv(), 0, 0);
+        flush_committed_txns_impl(tm, &context);
+        is_merged = true;
+      }
+      catch (Exception &ex) {
+        ups_log(("failed to merge committed transactions: error %d (%s)",
+                                ex.code, ups_strerror(ex.code)));
+      }
+    }
+
+    lock.lock();
+    if (is_merged)
+      merge.merge_count++;
+  }
+}
+
+// Hands the committed Txns to the background thread; starts the thread
+// unless it is already running. The caller holds the Environment's lock.
+static inline void
+request_background_merge(LocalTxnManager *tm)
+{
+  LocalTxnManager::BackgroundMerge &merge = tm->merge;
+  ScopedLock lock(merge.mutex);
+  if (unlikely(!merge.thread.get()))
+    merge.thread.reset(new Thread(&run_background_merge, tm));
+  merge.is_requested = true;
+  merge.cond.notify_one();
+}
+
+// Flushes the committed Txns as soon as |Globals::ms_flush_threshold| of
+// them are waiting. With a background merge, the committing thread only
+// merges them if the background thread falls behind by more than
+// |txn_merge_limit| Txns.
+static inline void
+flush_committed_txns_maybe(LocalTxnManager *tm, Context *context)
+{
+  LocalEnv *env = tm->lenv();
+  if (unlikely(ISSET(env->flags(), UPS_DONT_FLUSH_TRANSACTIONS)))
+    return;
+
+  if (unlikely(ISSET(env->flags(), UPS_FLUSH_TRANSACTIONS_IMMEDIATELY))) {
+    flush_committed_txns_impl(tm, context);
+    return;
+  }
+
+  int count = count_flushable_transactions(tm);
+  if (likely(count < Globals::ms_flush_threshold))
+    return;
+
+  uint32_t limit = env->config.txn_merge_limit;
+  if (limit > 0 && (uint32_t)count <= limit)
+    request_background_merge(tm);
+  else
+    flush_committed_txns_impl(tm, context);
+}
+
 void
 TxnOperation::initialize(LocalTxn *txn_, TxnNode *node_,
             uint32_t flags_, uint32_t original_flags_, uint64_t lsn_,
@@ -187,26 +308,30 @@ TxnOperation::destroy()
     previous_in_txn->next_in_txn = next_in_txn;
 
   if (delete_node)
-    delete node;
-
-  Memory::release(this);
+    node->db->txn_index->release_node(node);
 }
 
-TxnNode *
-TxnNode::next_sibling()
-{
-  return rbt_next(db->txn_index.get(), this);
-}
-
-TxnNode *
-TxnNode::previous_sibling()
+TxnNode::TxnNode(LocalDb *db_, ups_key_t *key, int height_, bool copy_key)
+  : db(db_), oldest_op(0), newest_op(0), _key(key), is_key_copied(copy_key),
+    previous(0), height(height_)
 {
-  return rbt_prev(db->txn_index.get(), this);
+  for (int i = 0; i < height; i++)
+    next[i].store(0, boost::memory_order_relaxed);
+
+  if (copy_key) {
+    _key = (ups_key_t *)Memory::allocate<uint8_t>(sizeof(ups_key_t)
+                    + key->size);
+    *_key = *key;
+    _key->data = _key + 1;
+    if (likely(key->size))
+      ::memcpy(_key->data, key->data, key->size);
+  }
 }
 
-TxnNode::TxnNode(LocalDb *db_, ups_key_t *key)
-  : db(db_), oldest_op(0), newest_op(0), _key(key)
+TxnNode::~TxnNode()
 {
+  if (is_key_copied)
+    Memory::release(_key);
 }
 
 TxnOperation *
@@ -244,20 +369,112 @@ TxnNode::append(LocalTxn *txn, uint32_t orig_flags, uint32_t flags,
 
   // now that an operation is attached make sure that the node no
   // longer uses the temporary key pointer
-  _key = 0;
+  if (!is_key_copied)
+    _key = 0;
 
   return op;
 }
 
 TxnNode *
-TxnIndex::store(ups_key_t *key, bool *node_created)
+TxnIndex::lower_bound(ups_key_t *key, TxnNode **predecessors)
 {
+  TxnNode *node = 0; // the head of the list
+  TxnNode *next = 0;
+
+  for (int level = height.load(boost::memory_order_acquire) - 1;
+                  level >= 0;
+                  level--) {
+    next = node
+            ? node->next[level].load(boost::memory_order_acquire)
+            : head[level].load(boost::memory_order_acquire);
+    while (next && compare(db, next->key(), key) < 0) {
+      node = next;
+      next = node->next[level].load(boost::memory_order_acquire);
+    }
+    if (predecessors)
+      predecessors[level] = node;
+  }
+
+  return next;
+}
+
+int
+TxnIndex::random_height()
+{
+  // the seed is advanced atomically because nodes can be stored
+  // concurrently, and then scrambled (murmur3 finalizer); each level has
+  // a probability of 1/4
+  uint32_t x = random_state.fetch_add(0x9e3779b9u,
+                  boost::memory_order_relaxed);
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+
+  int h = 1;
+  while (h < kMaxHeight && (x & 3) == 0) {
+    x >>= 2;
+    h++;
+  }
+  return h;
+}
+
+TxnNode *
+TxnIndex::store(ups_key_t *key, bool *node_created, bool is_shared)
+{
+  // levels which are not yet used start at the head of the list
+  TxnNode *predecessors[kMaxHeight] = {0};
+
   *node_created = false;
-  TxnNode *node = get(key, 0);
-  if (!node) {
-    node = new TxnNode(db, key);
-    *node_created = true;
-    rbt_insert(this, node);
+  TxnNode *node = lower_bound(key, predecessors);
+  if (node && compare(db, key, node->key()) == 0)
+    return node;
+
+  int h = random_height();
+  int current = height.load(boost::memory_order_acquire);
+  while (current < h
+          && !height.compare_exchange_weak(current, h,
+                  boost::memory_order_acq_rel))
+    ;
+
+  // link the node, starting with the lowest level. Other threads may have
+  // linked nodes since the predecessors were determined; therefore each
+  // level is latched, and the predecessor is moved forward if necessary.
+  // Nodes are not removed concurrently, the predecessors remain valid.
+  node = 0;
+  for (int level = 0; level < h; level++) {
+    ScopedSpinlock lock(latches[level]);
+
+    TxnNode *pred = predecessors[level];
+    TxnNode *next = pred
+                      ? pred->next[level].load(boost::memory_order_acquire)
+                      : head[level].load(boost::memory_order_acquire);
+    while (next && compare(db, next->key(), key) < 0) {
+      pred = next;
+      next = pred->next[level].load(boost::memory_order_acquire);
+    }
+
+    if (level == 0) {
+      // another thread stored the same key in the meantime
+      if (next && compare(db, key, next->key()) == 0)
+        return next;
+
+      node = allocate_node(key, h, is_shared);
+      *node_created = true;
+
+      node->previous = pred;
+      if (next)
+        next->previous = node;
+      else
+        tail = node;
+    }
+
+    node->next[level].store(next, boost::memory_order_relaxed);
+    if (pred)
+      pred->next[level].store(node, boost::memory_order_release);
+    else
+      head[level].store(node, boost::memory_order_release);
   }
 
   return node;
@@ -266,7 +483,55 @@ TxnIndex::store(ups_key_t *key, bool *node_created)
 void
 TxnIndex::remove(TxnNode *node)
 {
-  rbt_remove(this, node);
+  TxnNode *predecessors[kMaxHeight];
+  lower_bound(node->key(), predecessors);
+
+  for (int level = node->height - 1; level >= 0; level--) {
+    boost::atomic<TxnNode *> &link = predecessors[level]
+                        ? predecessors[level]->next[level]
+                        : head[level];
+    assert(link.load() == node);
+    link.store(node->next[level].load());
+  }
+
+  TxnNode *next = node->next_sibling();
+  if (next)
+    next->previous = node->previous;
+  else
+    tail = node->previous;
+
+  int h = height.load();
+  while (h > 0 && head[h - 1].load() == 0)
+    h--;
+  height.store(h);
+}
+
+TxnNode *
+TxnIndex::allocate_node(ups_key_t *key, int h, bool copy_key)
+{
+  void *p;
+  {
+    ScopedSpinlock lock(node_mutex);
+    if (free_nodes[h - 1]) {
+      p = free_nodes[h - 1];
+      free_nodes[h - 1] = *(TxnNode **)p;
+    }
+    else
+      p = node_arena.allocate(sizeof(TxnNode)
+                      + (h - 1) * sizeof(boost::atomic<TxnNode *>));
+  }
+  return new (p) TxnNode(db, key, h, copy_key);
+}
+
+void
+TxnIndex::release_node(TxnNode *node)
+{
+  int h = node->height;
+  node->~TxnNode();
+
+  ScopedSpinlock lock(node_mutex);
+  *(TxnNode **)node = free_nodes[h - 1];
+  free_nodes[h - 1] = node;
 }
 
 static inline void
@@ -277,6 +542,10 @@ flush_transaction_to_journal(LocalTxn *txn)
 
   if (unlikely(journal == 0))
     return;
+
+  // read-only transactions do not modify the database
+  if (ISSET(txn->flags, UPS_TXN_READ_ONLY))
+    return;
  
   if (NOTSET(txn->flags, UPS_TXN_TEMPORARY))
     journal->append_txn_begin(txn, txn->name.empty() ? 0 : txn->name.c_str(),
@@ -317,7 +586,9 @@ flush_transaction_to_journal(LocalTxn *txn)
 }
 
 LocalTxn::LocalTxn(LocalEnv *env, const char *name, uint32_t flags)
-  : Txn(env, name, flags), log_descriptor(0), oldest_op(0), newest_op(0)
+  : Txn(env, name, flags),
+    arena(&((LocalTxnManager *)env->txn_manager.get())->arena_pool),
+    log_descriptor(-1), commit_lsn(0), oldest_op(0), newest_op(0)
 {
   LocalTxnManager *ltm = (LocalTxnManager *)env->txn_manager.get();
   id = ltm->incremented_txn_id();
@@ -340,6 +611,7 @@ LocalTxn::commit()
 
   // this transaction is now committed!
   flags |= kStateCommitted;
+  commit_lsn = ((LocalEnv *)env)->lsn_manager.current.load();
 }
 
 void
@@ -371,65 +643,65 @@ LocalTxn::free_operations()
 
   oldest_op = 0;
   newest_op = 0;
+
+  // now release the memory of all operations at once
+  arena.clear();
 }
 
 TxnIndex::TxnIndex(LocalDb *db)
-  : db(db)
+  : db(db), tail(0), height(0), random_state(0x9e3779b9u)
 {
-  rbt_new(this);
+  for (int i = 0; i < kMaxHeight; i++) {
+    head[i] = 0;
+    free_nodes[i] = 0;
+  }
 }
 
 TxnIndex::~TxnIndex()
 {
-  TxnNode *node;
-
-  while ((node = rbt_last(this))) {
-    remove(node);
-    delete node;
+  // the nodes are released with |node_arena|, but their copied keys
+  // are not
+  TxnNode *node = first();
+  while (node) {
+    TxnNode *next = node->next_sibling();
+    node->~TxnNode();
+    node = next;
   }
-
-  // re-initialize the tree
-  rbt_new(this);
 }
 
 TxnNode *
 TxnIndex::get(ups_key_t *key, uint32_t flags)
 {
-  TxnNode *node = 0;
+  TxnNode *predecessors[kMaxHeight];
+  TxnNode *node = lower_bound(key, predecessors);
+  TxnNode *previous = height > 0 ? predecessors[0] : 0;
   int match = 0;
 
-  // create a temporary node that we can search for
-  TxnNode tmp(db, key);
+  bool is_equal = node && compare(db, key, node->key()) == 0;
 
   // search if node already exists - if yes, return it
   if (ISSET(flags, UPS_FIND_GEQ_MATCH)) {
-    node = rbt_nsearch(this, &tmp);
     if (node)
-      match = compare(&tmp, node);
+      match = compare(db, key, node->key());
   }
   else if (ISSET(flags, UPS_FIND_LEQ_MATCH)) {
-    node = rbt_psearch(this, &tmp);
-    if (node)
-      match = compare(&tmp, node);
+    if (!is_equal) {
+      node = previous;
+      if (node)
+        match = compare(db, key, node->key());
+    }
   }
   else if (ISSET(flags, UPS_FIND_GT_MATCH)) {
-    node = rbt_search(this, &tmp);
-    if (node)
+    if (is_equal)
       node = node->next_sibling();
-    else
-      node = rbt_nsearch(this, &tmp);
     match = 1;
   }
   else if (ISSET(flags, UPS_FIND_LT_MATCH)) {
-    node = rbt_search(this, &tmp);
-    if (node)
-      node = node->previous_sibling();
-    else
-      node = rbt_psearch(this, &tmp);
+    node = previous;
     match = -1;
   }
   else
-    return rbt_search(this, &tmp);
+    return is_equal ? node : 0;
 
   // Nothing found?
   if (!node)
@@ -446,26 +718,14 @@ TxnIndex::get(ups_key_t *key, uint32_t flags)
   return node;
 }
 
-TxnNode *
-TxnIndex::first()
-{
-  return rbt_first(this);
-}
-
-TxnNode *
-TxnIndex::last()
-{
-  return rbt_last(this);
-}
-
 void
 TxnIndex::enumerate(Context *context, TxnIndex::Visitor *visitor)
 {
-  TxnNode *node = rbt_first(this);
+  TxnNode *node = first();
 
   while (node) {
     visitor->visit(context, node);
-    node = rbt_next(this, node);
+    node = node->next_sibling();
   }
 }
 
@@ -494,7 +754,7 @@ struct KeyCounter : TxnIndex::Visitor {
                     op != 0;
                     op = op->previous_in_node) {
       LocalTxn *optxn = op->txn;
-      if (optxn->is_aborted())
+      if (optxn->is_aborted() || is_hidden_from_snapshot(txn, optxn))
         continue;
 
       if (optxn->is_committed() || txn == optxn) {
@@ -564,6 +824,11 @@ TxnIndex::count(Context *context, LocalTxn *txn, bool distinct)
   return k.counter;
 }
 
+LocalTxnManager::~LocalTxnManager()
+{
+  stop_background_merge();
+}
+
 void
 LocalTxnManager::begin(Txn *txn)
 {
@@ -584,14 +849,7 @@ LocalTxnManager::commit(Txn *htxn)
     flush_transaction_to_journal(txn);
 
     // flush committed transactions
-    if (likely(NOTSET(lenv()->flags(), UPS_DONT_FLUSH_TRANSACTIONS))) {
-      if (unlikely(ISSET(lenv()->flags(), UPS_FLUSH_TRANSACTIONS_IMMEDIATELY)
-                || count_flushable_transactions(this)
-                        >= Globals::ms_flush_threshold)) {
-        flush_committed_txns_impl(this, &context);
-        return 0;
-      }
-    }
+    flush_committed_txns_maybe(this, &context);
   }
   catch (Exception &ex) {
     return ex.code;
@@ -610,14 +868,7 @@ LocalTxnManager::abort(Txn *htxn)
     txn->abort();
 
     // flush committed transactions
-    if (likely(NOTSET(lenv()->flags(), UPS_DONT_FLUSH_TRANSACTIONS))) {
-      if (unlikely(ISSET(lenv()->flags(), UPS_FLUSH_TRANSACTIONS_IMMEDIATELY)
-                || count_flushable_transactions(this)
-                        >= Globals::ms_flush_threshold)) {
-        flush_committed_txns_impl(this, &context);
-        return 0;
-      }
-    }
+    flush_committed_txns_maybe(this, &context);
   }
   catch (Exception &ex) {
     return ex.code;
@@ -636,6 +887,23 @@ LocalTxnManager::flush_committed_txns(Context *context /* = 0 */)
     flush_committed_txns_impl(this, context);
 }
 
+void
+LocalTxnManager::stop_background_merge()
+{
+  if (!merge.thread.get())
+    return;
+
+  {
+    ScopedLock lock(merge.mutex);
+    merge.stop = true;
+    merge.cond.notify_all();
+  }
+  merge.thread->join();
+  merge.thread.reset();
+  merge.stop = false;
+  merge.is_requested = false;
+}
+
 uint64_t
 LocalTxnManager::flush_txn_to_changeset(Context *context, LocalTxn *txn)
 {
@@ -21,8 +21,13 @@
 
 #include "0root/root.h"
 
+#include <boost/atomic.hpp>
+
 // Always verify that a file of level N does not include headers > N!
-#include "1rb/rb.h"
+#include "1base/mutex.h"
+#include "1base/scoped_ptr.h"
+#include "1base/spinlock.h"
+#include "1mem/arena.h"
 #include "4txn/txn.h"
 
 #ifndef UPS_ROOT_H
@@ -71,12 +76,12 @@ struct TxnOperation {
   }
 
   // Initialization
-  // TODO use placement new??
   void initialize(LocalTxn *txn, TxnNode *node,
                   uint32_t flags, uint32_t orig_flags, uint64_t lsn,
                   ups_key_t *key, ups_record_t *record);
 
-  // Destructor
+  // Removes the operation from its node and from its Txn. The memory is
+  // owned by the arena of the Txn.
   void destroy();
 
   // the Txn of this operation
@@ -130,47 +135,55 @@ struct TxnOperation {
 
 
 //
-// A node in the Txn Index, used as the node structure in rb.h.
-// Manages a group of TxnOperation objects which all modify the
-// same key.
+// A node in the Txn Index (a skiplist). Manages a group of TxnOperation
+// objects which all modify the same key.
 //
 // To avoid chicken-egg problems when inserting a new TxnNode
-// into the TxnTree, it is possible to assign a temporary key
+// into the TxnIndex, it is possible to assign a temporary key
 // to this node. However, as soon as an operation is attached to this node,
 // the TxnNode class will use the key structure in this operation.
 //
-// This basically avoids one memory allocation.
+// This basically avoids one memory allocation. Nodes which are stored
+// concurrently (see TxnIndex) own a copy of the key instead, because other
+// threads can compare the key before an operation is attached.
+//
+// The node is allocated with |height| forward pointers (see
+// TxnIndex::allocate_node()).
 //
 struct TxnNode {
   // Constructor;
-  // The default parameters are required for the compilation of rb.h.
   // |key| is just a temporary pointer which allows to create a
   // TxnNode without further memory allocations/copying. The actual
   // key is then fetched from |oldest_op| as soon as this node is fully
-  // initialized.
-  TxnNode(LocalDb *db = 0, ups_key_t *key = 0);
+  // initialized. If |copy_key| is true then the node keeps a copy
+  // of |key|.
+  TxnNode(LocalDb *db, ups_key_t *key, int height, bool copy_key);
+
+  // Destructor; releases the copy of the key
+  ~TxnNode();
 
   // Returns the modified key
   ups_key_t *key() {
-    return oldest_op ? &oldest_op->key : _key;
+    return _key ? _key : &oldest_op->key;
   }
 
   // Retrieves the next larger sibling of a given node, or NULL if there
   // is no sibling
-  TxnNode *next_sibling();
+  TxnNode *next_sibling() {
+    return next[0].load(boost::memory_order_acquire);
+  }
 
   // Retrieves the previous larger sibling of a given node, or NULL if there
   // is no sibling
-  TxnNode *previous_sibling();
+  TxnNode *previous_sibling() {
+    return previous;
+  }
 
   // Appends an actual operation to this node
   TxnOperation *append(LocalTxn *txn, uint32_t orig_flags,
               uint32_t flags, uint64_t lsn, ups_key_t *key,
               ups_record_t *record);
 
-  // red-black tree stub, required for rb.h
-  rb_node(TxnNode) node;
-
   // the database - need this to get the compare function
   LocalDb *db;
 
@@ -181,16 +194,48 @@ struct TxnNode {
   TxnOperation *newest_op;
 
   // Pointer to the key data; only used as long as there are no operations
-  // attached. Otherwise we have a chicken-egg problem in rb.h.
+  // attached, or if the node owns a copy of the key
   ups_key_t *_key;
+
+  // True if |_key| is a copy which is owned by this node
+  bool is_key_copied;
+
+  // Serializes the concurrent Txns which check for conflicts and append
+  // operations to this node
+  Spinlock mutex;
+
+  // the previous node on the lowest level of the skiplist
+  TxnNode *previous;
+
+  // the number of forward pointers
+  int height;
+
+  // the forward pointers, one per level; the node is allocated with
+  // |height| entries
+  boost::atomic<TxnNode *> next[1];
 };
 
 
 //
-// Each Database has a binary tree which stores the current Txn
-// operations; this tree is implemented in TxnIndex
+// Each Database has a skiplist which stores the current Txn
+// operations; this skiplist is implemented in TxnIndex.
+//
+// The lowest level is a doubly linked list of all nodes, therefore cursors
+// move to the next or previous node in O(1).
+//
+// Txns can store nodes concurrently while they hold a shared lock on the
+// Environment (see LocalDb::supports_concurrent_staging()). Lookups do not
+// acquire locks; a new node is linked into each level while a latch for
+// this level is held, starting with the lowest level. The nodes are only
+// removed, and the previous pointers and the tail are only read, while
+// the Environment is locked exclusively.
 //
 struct TxnIndex {
+  enum {
+    // the max. number of levels; sufficient for 4^12 (16 million) nodes
+    kMaxHeight = 12
+  };
+
   // Traverses a TxnIndex; for each node, a callback is executed
   struct Visitor {
     virtual void visit(Context *context, TxnNode *node) = 0;
@@ -199,16 +244,24 @@ struct TxnIndex {
   // Constructor
   TxnIndex(LocalDb *db);
 
-  // Destructor; frees all nodes and their operations
+  // Destructor; frees all nodes
   ~TxnIndex();
 
   // Stores a new TxnNode in the index, but only if the node does not yet
-  // exist. Returns the new (or existing) node.
-  TxnNode *store(ups_key_t *key, bool *node_created);
+  // exist. Returns the new (or existing) node. |is_shared| is true if
+  // other threads can store nodes concurrently.
+  TxnNode *store(ups_key_t *key, bool *node_created, bool is_shared = false);
 
-  // Removes a TxnNode from the index
+  // Removes a TxnNode from the index; requires exclusive access
   void remove(TxnNode *node);
 
+  // Allocates a new TxnNode with |height| levels; recycles nodes which
+  // were released
+  TxnNode *allocate_node(ups_key_t *key, int height, bool copy_key = false);
+
+  // Releases a TxnNode which was removed from the index
+  void release_node(TxnNode *node);
+
   // Visits every node in the TxnTree
   void enumerate(Context *context, Visitor *visitor);
 
@@ -219,22 +272,55 @@ struct TxnIndex {
 
   // Returns the first (= "smallest") node of the tree, or NULL if the
   // tree is empty
-  TxnNode *first();
+  TxnNode *first() {
+    return head[0].load(boost::memory_order_acquire);
+  }
 
   // Returns the last (= "greatest") node of the tree, or NULL if the
   // tree is empty
-  TxnNode *last();
+  TxnNode *last() {
+    return tail;
+  }
 
   // Returns the key count of this index
   uint64_t count(Context *context, LocalTxn *txn, bool distinct);
 
+  // Returns the first node with a key >= |key|, or NULL. If |predecessors|
+  // is not null then it receives the last node < |key| on each level
+  // (NULL if this is the head of the list).
+  TxnNode *lower_bound(ups_key_t *key, TxnNode **predecessors);
+
+  // Returns a random height for a new node
+  int random_height();
+
   // the Database for all operations in this tree
   // TODO is this required?
   LocalDb *db;
 
-  // stuff for rb.h
-  TxnNode *rbt_root;
-  TxnNode rbt_nil;
+  // The first node on each level
+  boost::atomic<TxnNode *> head[kMaxHeight];
+
+  // The last node on the lowest level
+  TxnNode *tail;
+
+  // The number of levels which are currently used
+  boost::atomic<int> height;
+
+  // The state of the random number generator for the node heights
+  boost::atomic<uint32_t> random_state;
+
+  // One latch per level; held while a node is linked into this level
+  Spinlock latches[kMaxHeight];
+
+  // Protects |node_arena| and |free_nodes|
+  Spinlock node_mutex;
+
+  // The memory for the nodes; a node can outlive the Txn which created it,
+  // therefore the nodes are not allocated in the arena of the Txn
+  ArenaAllocator node_arena;
+
+  // Released nodes, which are recycled; one linked list per height
+  TxnNode *free_nodes[kMaxHeight];
 };
 
 
@@ -261,12 +347,26 @@ struct LocalTxn : Txn {
   // (before it's deleted by the Environment).
   void free_operations();
 
-  // index of the log file descriptor for this transaction [0..1]
+  // The memory for the TxnOperations (and their keys and records); it is
+  // released at once when the Txn is flushed or aborted
+  ArenaAllocator arena;
+
+  // Serializes the operations which are staged concurrently (see
+  // LocalDb::supports_concurrent_staging()), in case this Txn is shared
+  // by several threads
+  Mutex mutex;
+
+  // index of the log file descriptor for this transaction, or -1
   int log_descriptor;
 
   // the lsn of the "txn begin" operation
   uint64_t lsn;
 
+  // the next unused lsn at the time of the commit; 0 if the Txn is not
+  // committed. A snapshot which began with a lower lsn does not see
+  // this Txn.
+  uint64_t commit_lsn;
+
   // the linked list of operations - head is oldest operation
   TxnOperation *oldest_op;
 
@@ -274,6 +374,28 @@ struct LocalTxn : Txn {
   TxnOperation *newest_op;
 };
 
+// Returns true if the operations of |optxn| are hidden from |txn| (which
+// can be null). A read-only Txn reads from a snapshot: it only sees the
+// Txns which were committed before it began. Hidden operations are
+// skipped, and never cause a conflict.
+static inline bool
+is_hidden_from_snapshot(const LocalTxn *txn, const LocalTxn *optxn)
+{
+  return txn != 0
+          && ISSET(txn->flags, UPS_TXN_READ_ONLY)
+          && (!optxn->is_committed() || optxn->commit_lsn > txn->lsn);
+}
+
+// Records that |txn| (which can be null) ran into a conflict with the
+// active Txn |other|; returns UPS_TXN_CONFLICT
+static inline ups_status_t
+report_conflict(LocalTxn *txn, const LocalTxn *other)
+{
+  if (txn)
+    txn->conflicting_txn_id = other->id;
+  return UPS_TXN_CONFLICT;
+}
+
 
 //
 // A TxnManager for local Txns
@@ -284,6 +406,9 @@ struct LocalTxnManager : TxnManager {
     : TxnManager(env), _txn_id(0) {
   }
 
+  // Destructor; stops the background merge
+  virtual ~LocalTxnManager();
+
   // Begins a new Txn
   virtual void begin(Txn *txn);
 
@@ -298,6 +423,10 @@ struct LocalTxnManager : TxnManager {
   // Flushes committed (queued) transactions
   virtual void flush_committed_txns(Context *context = 0);
 
+  // Stops the background merge, if it is running. Committed Txns which
+  // were not yet merged remain in memory.
+  void stop_background_merge();
+
   // Increments the global transaction ID and returns the new value. 
   uint64_t incremented_txn_id() {
     return ++_txn_id;
@@ -312,6 +441,35 @@ struct LocalTxnManager : TxnManager {
   // last operation in this transaction
   uint64_t flush_txn_to_changeset(Context *context, LocalTxn *txn);
 
+  // Recycles the memory chunks of the Txn arenas
+  ArenaPool arena_pool;
+
+  // The state of the background merge (see UPS_PARAM_TXN_MERGE_LIMIT);
+  // all members are protected by |mutex|
+  struct BackgroundMerge {
+    BackgroundMerge()
+      : is_requested(false), stop(false), merge_count(0) {
+    }
+
+    // Protects the members below
+    Mutex mutex;
+
+    // Signalled when a merge is requested, or the thread has to stop
+    Condition cond;
+
+    // True if committed Txns wait for the background thread
+    bool is_requested;
+
+    // Set to true when the background thread has to stop
+    bool stop;
+
+    // Number of merges performed by the background thread
+    uint64_t merge_count;
+
+    // The background thread; can be null
+    ScopedPtr<Thread> thread;
+  } merge;
+
   // Casts env to a LocalEnv
   LocalEnv *lenv() const {
     return (LocalEnv *)env;
@@ -36,6 +36,7 @@
 #endif
 #include "2compressor/compressor_factory.h"
 #include "2device/device.h"
+#include "2worker/worker.h"
 #include "3btree/btree_stats.h"
 #include "3blob_manager/blob_manager.h"
 #include "3btree/btree_index.h"
@@ -116,6 +117,107 @@ check_recno_key(ups_key_t *key, uint32_t flags)
   return 0;
 }
 
+// Wakes up the operations which wait for a conflicting Txn (see
+// UPS_PARAM_TXN_CONFLICT_WAIT_MSEC). The caller holds the Environment's
+// lock.
+static inline void
+notify_txn_ended(Env *env)
+{
+  if (unlikely(env->config.txn_conflict_wait_msec > 0))
+    env->txn_ended.notify_all();
+}
+
+// If an operation failed with UPS_TXN_CONFLICT: waits till a Txn was
+// committed or aborted, or till |deadline| (which is initialized with
+// the first conflict) expired. |lock| is released while waiting.
+// Returns true if the operation should be retried.
+static inline bool
+wait_on_conflict(Env *env, ScopedWriteLock &lock, ups_status_t st,
+                boost::system_time *deadline)
+{
+  if (likely(st != UPS_TXN_CONFLICT)
+        || env->config.txn_conflict_wait_msec == 0
+        || !lock.owns_lock())
+    return false;
+
+  boost::system_time now = boost::get_system_time();
+  if (deadline->is_not_a_date_time())
+    *deadline = now + boost::posix_time::milliseconds(
+                            env->config.txn_conflict_wait_msec);
+  else if (now >= *deadline)
+    return false;
+
+  env->txn_ended.timed_wait(lock, *deadline);
+  return true;
+}
+
+// Concurrent lookups do not purge the cache, because the other lookups
+// might still access the purged pages. If the cache is full then the lock
+// is acquired exclusively, and the cache is purged.
+static inline void
+purge_after_shared_read(Db *db)
+{
+  LocalEnv *env = (LocalEnv *)db->env;
+  if (likely(!env->page_manager->is_cache_full()))
+    return;
+
+  ScopedWriteLock lock(env->mutex);
+  Context context(env);
+  env->page_manager->purge_cache(&context);
+}
+
+// Acquires the Environment's lock for ups_db_insert and ups_db_erase.
+// Returns true if the update runs concurrently to other operations; then
+// |shared_lock| (see Db::supports_concurrent_writes) or |read_lock| (see
+// Db::supports_concurrent_staging) is held instead of |lock|.
+static inline bool
+lock_for_update(Db *db, Txn *txn, ScopedWriteLock &lock,
+                ScopedUpgradeLock &shared_lock, ScopedReadLock &read_lock)
+{
+  Env *env = db->env;
+
+  if (db->supports_concurrent_reads()) {
+    // the upgrade lock excludes other updates; only then it's safe to
+    // check whether this update can run concurrently. Otherwise upgrade
+    // to the exclusive lock
+    shared_lock = ScopedUpgradeLock(env->mutex);
+    if (db->supports_concurrent_writes())
+      return true;
+    lock = ScopedWriteLock(boost::move(shared_lock));
+    return false;
+  }
+
+  if (txn && ISSET(env->flags(), UPS_ENABLE_CONCURRENT_READS)) {
+    // Txns stage their updates concurrently; all other operations on
+    // this Database acquire the lock exclusively
+    read_lock = ScopedReadLock(env->mutex);
+    if (db->supports_concurrent_staging())
+      return true;
+    read_lock.unlock();
+  }
+
+  lock = ScopedWriteLock(env->mutex);
+  return false;
+}
+
+// A staged update can only wait for a conflicting Txn (see
+// wait_on_conflict) while it holds the exclusive lock. Returns true if
+// the shared |read_lock| was therefore replaced by |lock|; the update
+// then has to be retried.
+static inline bool
+relock_on_conflict(Env *env, ScopedWriteLock &lock, ScopedReadLock &read_lock,
+                ups_status_t st)
+{
+  if (likely(st != UPS_TXN_CONFLICT)
+        || env->config.txn_conflict_wait_msec == 0
+        || !read_lock.owns_lock())
+    return false;
+
+  read_lock.unlock();
+  lock = ScopedWriteLock(env->mutex);
+  return true;
+}
+
 ups_status_t
 ups_txn_begin(ups_txn_t **htxn, ups_env_t *henv, const char *name,
                 void *, uint32_t flags)
@@ -134,9 +236,9 @@ ups_txn_begin(ups_txn_t **htxn, ups_env_t *henv, const char *name,
   Env *env = (Env *)henv;
 
   try {
-    ScopedLock lock;
+    ScopedWriteLock lock;
     if (NOTSET(flags, UPS_DONT_LOCK))
-      lock = ScopedLock(env->mutex);
+      lock = ScopedWriteLock(env->mutex);
 
     if (unlikely(NOTSET(env->config.flags, UPS_ENABLE_TRANSACTIONS))) {
       ups_trace(("transactions are disabled (see UPS_ENABLE_TRANSACTIONS)"));
@@ -164,6 +266,30 @@ ups_txn_get_name(ups_txn_t *htxn)
   return txn->name.empty() ? 0 : txn->name.c_str();
 }
 
+UPS_EXPORT uint64_t
+ups_txn_get_id(ups_txn_t *htxn)
+{
+  Txn *txn = (Txn *)htxn;
+  if (unlikely(!txn)) {
+    ups_trace(("parameter 'txn' must not be NULL"));
+    return 0;
+  }
+
+  return txn->id;
+}
+
+UPS_EXPORT uint64_t
+ups_txn_get_conflicting_txn_id(ups_txn_t *htxn)
+{
+  Txn *txn = (Txn *)htxn;
+  if (unlikely(!txn)) {
+    ups_trace(("parameter 'txn' must not be NULL"));
+    return 0;
+  }
+
+  return txn->conflicting_txn_id;
+}
+
 ups_status_t
 ups_txn_commit(ups_txn_t *htxn, uint32_t flags)
 {
@@ -176,8 +302,24 @@ ups_txn_commit(ups_txn_t *htxn, uint32_t flags)
   Env *env = txn->env;
 
   try {
-    ScopedLock lock(env->mutex);
-    return env->txn_commit(txn, flags);
+    uint64_t lsn = 0;
+    {
+      ScopedWriteLock lock(env->mutex);
+      // a read-only Txn does not write to the journal
+      bool is_read_only = ISSET(txn->flags, UPS_TXN_READ_ONLY);
+      ups_status_t st = env->txn_commit(txn, flags);
+      if (unlikely(st))
+        return st;
+      notify_txn_ended(env);
+      if (!is_read_only)
+        lsn = env->pending_commit_lsn();
+    }
+
+    // with group commit, the journal is flushed by one of the committing
+    // threads; this must not block the Environment
+    if (lsn)
+      return env->wait_for_commit(lsn);
+    return 0;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -195,8 +337,11 @@ ups_txn_abort(ups_txn_t *htxn, uint32_t flags)
   Txn *txn = (Txn *)htxn;
   Env *env = txn->env;
   try {
-    ScopedLock lock(env->mutex);
-    return env->txn_abort(txn, flags);
+    ScopedWriteLock lock(env->mutex);
+    ups_status_t st = env->txn_abort(txn, flags);
+    if (likely(st == 0))
+      notify_txn_ended(env);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -319,6 +464,17 @@ ups_env_create(ups_env_t **henv, const char *filename,
     return UPS_INV_PARAMETER;
   }
 
+  /* in-memory? direct I/O is not possible */
+  if (unlikely(ISSET(flags, UPS_IN_MEMORY) && ISSET(flags, UPS_DIRECT_IO))) {
+    ups_trace(("combination of UPS_IN_MEMORY and UPS_DIRECT_IO "
+            "not allowed"));
+    return UPS_INV_PARAMETER;
+  }
+
+  /* direct I/O bypasses the file system cache, and therefore mmap */
+  if (ISSET(flags, UPS_DIRECT_IO))
+    flags |= UPS_DISABLE_MMAP;
+
   /* flag UPS_AUTO_RECOVERY implies UPS_ENABLE_TRANSACTIONS */
   if (ISSET(flags, UPS_AUTO_RECOVERY))
     flags |= UPS_ENABLE_TRANSACTIONS;
@@ -388,6 +544,68 @@ ups_env_create(ups_env_t **henv, const char *filename,
       case UPS_PARAM_POSIX_FADVISE:
         config.posix_advice = (int)param->value;
         break;
+      case UPS_PARAM_CACHE_POLICY:
+        if (param->value != UPS_CACHE_POLICY_LRU
+              && param->value != UPS_CACHE_POLICY_2Q
+              && param->value != UPS_CACHE_POLICY_CLOCK) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_POLICY"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_policy = (int)param->value;
+        break;
+      case UPS_PARAM_CACHE_SHARDS:
+        if (param->value < 1 || param->value > CacheState::kMaxShards) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_SHARDS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_shards = (int)param->value;
+        break;
+      case UPS_PARAM_WORKER_THREADS:
+        if (param->value < 1 || param->value > WorkerPool::kMaxThreads) {
+          ups_trace(("invalid value for UPS_PARAM_WORKER_THREADS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.worker_threads = (int)param->value;
+        break;
+      case UPS_PARAM_GROUP_COMMIT_USEC:
+        config.group_commit_usec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_GROUP_COMMIT_SIZE:
+        if (param->value < 1) {
+          ups_trace(("invalid value for UPS_PARAM_GROUP_COMMIT_SIZE"));
+          return UPS_INV_PARAMETER;
+        }
+        config.group_commit_size = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_PAGE_DELTAS:
+        if (param->value > 1) {
+          ups_trace(("invalid value for UPS_PARAM_JOURNAL_PAGE_DELTAS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_page_deltas = param->value == 1;
+        break;
+      case UPS_PARAM_JOURNAL_FILES:
+        if (param->value < 2 || param->value > JournalState::kMaxFiles) {
+          ups_trace(("invalid value for UPS_PARAM_JOURNAL_FILES"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_files = (int)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_FILE_SIZE:
+        config.journal_file_size = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        config.journal_checkpoint_interval = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_SYNC_MSEC:
+        config.journal_sync_msec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_TXN_MERGE_LIMIT:
+        config.txn_merge_limit = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_TXN_CONFLICT_WAIT_MSEC:
+        config.txn_conflict_wait_msec = (uint32_t)param->value;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)param->name));
         return UPS_INV_PARAMETER;
@@ -486,6 +704,10 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
   if (ISSET(flags, UPS_AUTO_RECOVERY))
     flags |= UPS_ENABLE_TRANSACTIONS;
 
+  /* direct I/O bypasses the file system cache, and therefore mmap */
+  if (ISSET(flags, UPS_DIRECT_IO))
+    flags |= UPS_DISABLE_MMAP;
+
   if (unlikely(config.filename.empty() && NOTSET(flags, UPS_IN_MEMORY))) {
     ups_trace(("filename is missing"));
     return UPS_INV_PARAMETER;
@@ -534,6 +756,68 @@ ups_env_open(ups_env_t **henv, const char *filename, uint32_t flags,
       case UPS_PARAM_POSIX_FADVISE:
         config.posix_advice = (int)param->value;
         break;
+      case UPS_PARAM_CACHE_POLICY:
+        if (param->value != UPS_CACHE_POLICY_LRU
+              && param->value != UPS_CACHE_POLICY_2Q
+              && param->value != UPS_CACHE_POLICY_CLOCK) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_POLICY"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_policy = (int)param->value;
+        break;
+      case UPS_PARAM_CACHE_SHARDS:
+        if (param->value < 1 || param->value > CacheState::kMaxShards) {
+          ups_trace(("invalid value for UPS_PARAM_CACHE_SHARDS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.cache_shards = (int)param->value;
+        break;
+      case UPS_PARAM_WORKER_THREADS:
+        if (param->value < 1 || param->value > WorkerPool::kMaxThreads) {
+          ups_trace(("invalid value for UPS_PARAM_WORKER_THREADS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.worker_threads = (int)param->value;
+        break;
+      case UPS_PARAM_GROUP_COMMIT_USEC:
+        config.group_commit_usec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_GROUP_COMMIT_SIZE:
+        if (param->value < 1) {
+          ups_trace(("invalid value for UPS_PARAM_GROUP_COMMIT_SIZE"));
+          return UPS_INV_PARAMETER;
+        }
+        config.group_commit_size = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_PAGE_DELTAS:
+        if (param->value > 1) {
+          ups_trace(("invalid value for UPS_PARAM_JOURNAL_PAGE_DELTAS"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_page_deltas = param->value == 1;
+        break;
+      case UPS_PARAM_JOURNAL_FILES:
+        if (param->value < 2 || param->value > JournalState::kMaxFiles) {
+          ups_trace(("invalid value for UPS_PARAM_JOURNAL_FILES"));
+          return UPS_INV_PARAMETER;
+        }
+        config.journal_files = (int)param->value;
+        break;
+      case UPS_PARAM_JOURNAL_FILE_SIZE:
+        config.journal_file_size = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL:
+        config.journal_checkpoint_interval = param->value;
+        break;
+      case UPS_PARAM_JOURNAL_SYNC_MSEC:
+        config.journal_sync_msec = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_TXN_MERGE_LIMIT:
+        config.txn_merge_limit = (uint32_t)param->value;
+        break;
+      case UPS_PARAM_TXN_CONFLICT_WAIT_MSEC:
+        config.txn_conflict_wait_msec = (uint32_t)param->value;
+        break;
       default:
         ups_trace(("unknown parameter %d", (int)param->name));
         return UPS_INV_PARAMETER;
@@ -608,7 +892,7 @@ ups_env_create_db(ups_env_t *henv, ups_db_t **hdb, uint16_t db_name,
   config.flags = flags;
 
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
 
     if (unlikely(ISSET(env->flags(), UPS_READ_ONLY))) {
       ups_trace(("cannot create database in a read-only environment"));
@@ -650,7 +934,7 @@ ups_env_open_db(ups_env_t *henv, ups_db_t **hdb, uint16_t db_name,
   config.db_name = db_name;
 
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
 
     if (unlikely(ISSET(env->flags(), UPS_IN_MEMORY))) {
       ups_trace(("cannot open a Database in an In-Memory Environment"));
@@ -694,7 +978,7 @@ ups_env_rename_db(ups_env_t *henv, uint16_t oldname, uint16_t newname,
 
   /* rename the database */
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
     return env->rename_db(oldname, newname, flags);
   }
   catch (Exception &ex) {
@@ -717,7 +1001,7 @@ ups_env_erase_db(ups_env_t *henv, uint16_t name, uint32_t flags)
 
   /* erase the database */
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
     return env->erase_db(name, flags);
   }
   catch (Exception &ex) {
@@ -744,7 +1028,7 @@ ups_env_get_database_names(ups_env_t *henv, uint16_t *names, uint32_t *length)
 
   /* get all database names */
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
 
     std::vector<uint16_t> vec = env->get_database_names();
     if (unlikely(vec.size() > *length)) {
@@ -779,7 +1063,7 @@ ups_env_get_parameters(ups_env_t *henv, ups_parameter_t *param)
 
   /* get the parameters */
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
     return env->get_parameters(param);
   }
   catch (Exception &ex) {
@@ -801,7 +1085,7 @@ ups_env_flush(ups_env_t *henv, uint32_t flags)
   }
 
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
     return env->flush(flags);
   }
   catch (Exception &ex) {
@@ -809,6 +1093,31 @@ ups_env_flush(ups_env_t *henv, uint32_t flags)
   }
 }
 
+ups_status_t UPS_CALLCONV
+ups_env_wait_for_commit(ups_env_t *henv, uint64_t lsn)
+{
+  Env *env = (Env *)henv;
+  if (unlikely(!env)) {
+    ups_trace(("parameter 'env' must not be NULL"));
+    return UPS_INV_PARAMETER;
+  }
+
+  try {
+    {
+      ScopedWriteLock lock(env->mutex);
+      uint64_t last_lsn = env->last_commit_lsn();
+      if (lsn == 0 || lsn > last_lsn)
+        lsn = last_lsn;
+    }
+
+    // the journal is flushed without blocking the Environment
+    return env->wait_for_durable_commit(lsn);
+  }
+  catch (Exception &ex) {
+    return ex.code;
+  }
+}
+
 ups_status_t UPS_CALLCONV
 ups_env_close(ups_env_t *henv, uint32_t flags)
 {
@@ -849,7 +1158,7 @@ ups_db_get_parameters(ups_db_t *hdb, ups_parameter_t *param)
 
   /* get the parameters */
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
     return db->get_parameters(param);
   }
   catch (Exception &ex) {
@@ -884,7 +1193,7 @@ ups_db_set_compare_func(ups_db_t *hdb, ups_compare_func_t foo)
     return UPS_INV_PARAMETER; 
   }
 
-  ScopedLock lock(ldb->env->mutex);
+  ScopedWriteLock lock(ldb->env->mutex);
 
   if (unlikely(db->config.key_type != UPS_TYPE_CUSTOM)) {
     ups_trace(("ups_set_compare_func only allowed for UPS_TYPE_CUSTOM "
@@ -922,8 +1231,6 @@ ups_db_find(ups_db_t *hdb, ups_txn_t *htxn, ups_key_t *key,
   Env *env = db->env;
 
   try {
-    ScopedLock lock(env->mutex);
-  
     if (unlikely(ISSETANY(db->flags(),
                             UPS_RECORD_NUMBER32 | UPS_RECORD_NUMBER64)
           && !key->data)) {
@@ -931,7 +1238,23 @@ ups_db_find(ups_db_t *hdb, ups_txn_t *htxn, ups_key_t *key,
       return UPS_INV_PARAMETER;
     }
 
-    return db->find(0, txn, key, record, flags);
+    // lookups can share the lock with other lookups
+    if (db->supports_concurrent_reads()) {
+      ups_status_t st;
+      {
+        ScopedReadLock lock(env->mutex);
+        st = db->find(0, txn, key, record, flags);
+      }
+      purge_after_shared_read(db);
+      return st;
+    }
+
+    ScopedWriteLock lock(env->mutex);
+    boost::system_time deadline;
+    ups_status_t st = db->find(0, txn, key, record, flags);
+    while (wait_on_conflict(env, lock, st, &deadline))
+      st = db->find(0, txn, key, record, flags);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -983,9 +1306,14 @@ ups_db_insert(ups_db_t *hdb, ups_txn_t *htxn, ups_key_t *key,
   Env *env = db->env;
 
   try {
-    ScopedLock lock;
+    // inserts can run in parallel to lookups, or to the updates of other
+    // Txns
+    ScopedWriteLock lock;
+    ScopedUpgradeLock shared_lock;
+    ScopedReadLock read_lock;
+    bool shared_write = false;
     if (likely(NOTSET(flags, UPS_DONT_LOCK)))
-      lock = ScopedLock(env->mutex);
+      shared_write = lock_for_update(db, txn, lock, shared_lock, read_lock);
 
     if (unlikely(ISSET(db->flags(), UPS_READ_ONLY))) {
       ups_trace(("cannot insert in a read-only database"));
@@ -1005,7 +1333,13 @@ ups_db_insert(ups_db_t *hdb, ups_txn_t *htxn, ups_key_t *key,
 
     flags &= ~UPS_DONT_LOCK;
 
-    return db->insert(0, txn, key, record, flags);
+    boost::system_time deadline;
+    ups_status_t st = db->insert(0, txn, key, record, flags, shared_write);
+    if (relock_on_conflict(env, lock, read_lock, st))
+      st = db->insert(0, txn, key, record, flags, false);
+    while (wait_on_conflict(env, lock, st, &deadline))
+      st = db->insert(0, txn, key, record, flags, false);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -1032,9 +1366,14 @@ ups_db_erase(ups_db_t *hdb, ups_txn_t *htxn, ups_key_t *key, uint32_t flags)
   Env *env = db->env;
 
   try {
-    ScopedLock lock;
+    // erases can run in parallel to lookups, or to the updates of other
+    // Txns
+    ScopedWriteLock lock;
+    ScopedUpgradeLock shared_lock;
+    ScopedReadLock read_lock;
+    bool shared_write = false;
     if (likely(NOTSET(flags, UPS_DONT_LOCK)))
-      lock = ScopedLock(env->mutex);
+      shared_write = lock_for_update(db, txn, lock, shared_lock, read_lock);
 
     if (unlikely(ISSET(db->flags(), UPS_READ_ONLY))) {
       ups_trace(("cannot erase from a read-only database"));
@@ -1043,7 +1382,13 @@ ups_db_erase(ups_db_t *hdb, ups_txn_t *htxn, ups_key_t *key, uint32_t flags)
 
     flags &= ~UPS_DONT_LOCK;
 
-    return db->erase(0, txn, key, flags);
+    boost::system_time deadline;
+    ups_status_t st = db->erase(0, txn, key, flags, shared_write);
+    if (relock_on_conflict(env, lock, read_lock, st))
+      st = db->erase(0, txn, key, flags, false);
+    while (wait_on_conflict(env, lock, st, &deadline))
+      st = db->erase(0, txn, key, flags, false);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -1065,7 +1410,7 @@ ups_db_check_integrity(ups_db_t *hdb, uint32_t flags)
   }
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
     return db->check_integrity(flags);
   }
   catch (Exception &ex) {
@@ -1098,9 +1443,9 @@ ups_db_close(ups_db_t *hdb, uint32_t flags)
   }
 
   try {
-    ScopedLock lock;
+    ScopedWriteLock lock;
     if (likely(NOTSET(flags, UPS_DONT_LOCK)))
-      lock = ScopedLock(env->mutex);
+      lock = ScopedWriteLock(env->mutex);
 
     // auto-cleanup cursors?
     if (ISSET(flags, UPS_AUTO_CLEANUP)) {
@@ -1145,9 +1490,9 @@ ups_cursor_create(ups_cursor_t **hcursor, ups_db_t *hdb, ups_txn_t *htxn,
   Env *env = db->env;
 
   try {
-    ScopedLock lock;
+    ScopedWriteLock lock;
     if (likely(NOTSET(flags, UPS_DONT_LOCK)))
-      lock = ScopedLock(env->mutex);
+      lock = ScopedWriteLock(env->mutex);
 
     *cursor = db->cursor_create(txn, flags);
     db->add_cursor(*cursor);
@@ -1178,7 +1523,7 @@ ups_cursor_clone(ups_cursor_t *hsrc, ups_cursor_t **hdest)
   Db *db = src->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
 
     *dest = db->cursor_clone(src);
     (*dest)->previous = 0;
@@ -1217,7 +1562,7 @@ ups_cursor_overwrite(ups_cursor_t *hcursor, ups_record_t *record,
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
 
     if (unlikely(ISSET(db->flags(), UPS_READ_ONLY))) {
       ups_trace(("cannot overwrite in a read-only database"));
@@ -1256,7 +1601,7 @@ ups_cursor_move(ups_cursor_t *hcursor, ups_key_t *key,
   Env *env = db->env;
 
   try {
-    ScopedLock lock(env->mutex);
+    ScopedWriteLock lock(env->mutex);
     return db->cursor_move(cursor, key, record, flags);
   }
   catch (Exception &ex) {
@@ -1287,13 +1632,17 @@ ups_cursor_find(ups_cursor_t *hcursor, ups_key_t *key, ups_record_t *record,
   Env *env = db->env;
 
   try {
-    ScopedLock lock;
+    ScopedWriteLock lock;
     if (likely(NOTSET(flags, UPS_DONT_LOCK)))
-      lock = ScopedLock(env->mutex);
+      lock = ScopedWriteLock(env->mutex);
 
     flags &= ~UPS_DONT_LOCK;
 
-    return db->find(cursor, cursor->txn, key, record, flags);
+    boost::system_time deadline;
+    ups_status_t st = db->find(cursor, cursor->txn, key, record, flags);
+    while (wait_on_conflict(env, lock, st, &deadline))
+      st = db->find(cursor, cursor->txn, key, record, flags);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -1328,7 +1677,7 @@ ups_cursor_insert(ups_cursor_t *hcursor, ups_key_t *key, ups_record_t *record,
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
 
     if (unlikely(ISSET(db->flags(), UPS_READ_ONLY))) {
       ups_trace(("cannot insert to a read-only database"));
@@ -1356,7 +1705,13 @@ ups_cursor_insert(ups_cursor_t *hcursor, ups_key_t *key, ups_record_t *record,
 
     flags &= ~UPS_DONT_LOCK;
 
-    return db->insert(cursor, cursor->txn, key, record, flags);
+    boost::system_time deadline;
+    ups_status_t st = db->insert(cursor, cursor->txn, key, record, flags,
+                            false);
+    while (wait_on_conflict(db->env, lock, st, &deadline))
+      st = db->insert(cursor, cursor->txn, key, record, flags,
+                            false);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -1376,14 +1731,18 @@ ups_cursor_erase(ups_cursor_t *hcursor, uint32_t flags)
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
 
     if (ISSET(db->flags(), UPS_READ_ONLY)) {
       ups_trace(("cannot erase from a read-only database"));
       return UPS_WRITE_PROTECTED;
     }
 
-    return db->erase(cursor, cursor->txn, 0, flags);
+    boost::system_time deadline;
+    ups_status_t st = db->erase(cursor, cursor->txn, 0, flags, false);
+    while (wait_on_conflict(db->env, lock, st, &deadline))
+      st = db->erase(cursor, cursor->txn, 0, flags, false);
+    return st;
   }
   catch (Exception &ex) {
     return ex.code;
@@ -1408,7 +1767,7 @@ ups_cursor_get_duplicate_count(ups_cursor_t *hcursor, uint32_t *count,
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
     *count = cursor->get_duplicate_count(flags);
     return 0;
   }
@@ -1435,7 +1794,7 @@ ups_cursor_get_duplicate_position(ups_cursor_t *hcursor, uint32_t *position)
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
     *position = cursor->get_duplicate_position();
     return 0;
   }
@@ -1462,7 +1821,7 @@ ups_cursor_get_record_size(ups_cursor_t *hcursor, uint32_t *size)
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
     *size = cursor->get_record_size();
     return 0;
   }
@@ -1485,7 +1844,7 @@ ups_cursor_close(ups_cursor_t *hcursor)
   Db *db = cursor->db;
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
     cursor->close();
     if (cursor->txn)
       cursor->txn->release();
@@ -1505,7 +1864,7 @@ ups_set_context_data(ups_db_t *hdb, void *data)
   if (unlikely(!db))
     return;
 
-  ScopedLock lock(db->env->mutex);
+  ScopedWriteLock lock(db->env->mutex);
   db->context = data;
 }
 
@@ -1519,7 +1878,7 @@ ups_get_context_data(ups_db_t *hdb, ups_bool_t dont_lock)
   if (dont_lock)
     return db->context;
 
-  ScopedLock lock(db->env->mutex);
+  ScopedWriteLock lock(db->env->mutex);
   return db->context;
 }
 
@@ -1580,7 +1939,7 @@ ups_db_count(ups_db_t *hdb, ups_txn_t *htxn, uint32_t flags,
   }
 
   try {
-    ScopedLock lock(db->env->mutex);
+    ScopedWriteLock lock(db->env->mutex);
 
     *count = db->count(txn, ISSET(flags, UPS_SKIP_DUPLICATES));
     return 0;
@@ -1701,7 +2060,7 @@ ups_db_bulk_operations(ups_db_t *hdb, ups_txn_t *txn,
 
   Db *db = (Db *)hdb;
   try {
-    ScopedLock lock = ScopedLock(db->env->mutex);
+    ScopedWriteLock lock = ScopedWriteLock(db->env->mutex);
     return db->bulk_operations((Txn *)txn, operations,
                     operations_length, flags);
   }
@@ -93,7 +93,14 @@ struct Configuration
       journal_compression(0), record_compression(0), key_compression(0),
       read_only(false), enable_crc32(false), record_number32(false),
       record_number64(false), posix_fadvice(UPS_POSIX_FADVICE_NORMAL),
-      simulate_crashes(false), flush_txn_immediately(false) {
+      simulate_crashes(false), flush_txn_immediately(false),
+      cache_policy(UPS_CACHE_POLICY_LRU), cache_shards(1),
+      enable_concurrent_reads(false), enable_io_uring(false),
+      direct_io(false), worker_threads(1), group_commit_usec(0),
+      group_commit_size(32), journal_page_deltas(false), journal_files(2),
+      journal_file_size(0), journal_checkpoint_interval(0),
+      journal_sync_msec(0), txn_merge_limit(0), normalized_keys(false),
+      key_filter_bits(0) {
   }
 
   const char *
@@ -134,6 +141,7 @@ struct Configuration
       "zint32_maskedvbyte",
       "zint32_for",
       "zint32_simdfor",
+      "prefix",
     };
     std::cout << "Configuration: --seed=" << seed << " ";
     if (journal_compression)
@@ -209,6 +217,41 @@ struct Configuration
                                ? "random"
                                : "??unknown??")
                 << " ";
+    if (cache_policy)
+      std::cout << "--cache-policy="
+                << (cache_policy == UPS_CACHE_POLICY_2Q
+                               ? "2q"
+                               : cache_policy == UPS_CACHE_POLICY_CLOCK
+                                  ? "clock"
+                                  : "??unknown??")
+                << " ";
+    if (cache_shards > 1)
+      std::cout << "--cache-shards=" << cache_shards << " ";
+    if (enable_concurrent_reads)
+      std::cout << "--enable-concurrent-reads ";
+    if (enable_io_uring)
+      std::cout << "--enable-io-uring ";
+    if (direct_io)
+      std::cout << "--direct-io ";
+    if (worker_threads > 1)
+      std::cout << "--worker-threads=" << worker_threads << " ";
+    if (group_commit_usec)
+      std::cout << "--group-commit-usec=" << group_commit_usec << " ";
+    if (group_commit_size != 32)
+      std::cout << "--group-commit-size=" << group_commit_size << " ";
+    if (journal_page_deltas)
+      std::cout << "--journal-page-deltas ";
+    if (journal_files != 2)
+      std::cout << "--journal-files=" << journal_files << " ";
+    if (journal_file_size)
+      std::cout << "--journal-file-size=" << journal_file_size << " ";
+    if (journal_checkpoint_interval)
+      std::cout << "--journal-checkpoint-interval="
+              << journal_checkpoint_interval << " ";
+    if (journal_sync_msec)
+      std::cout << "--journal-sync-msec=" << journal_sync_msec << " ";
+    if (txn_merge_limit)
+      std::cout << "--txn-merge-limit=" << txn_merge_limit << " ";
     if (simulate_crashes)
       std::cout << "--simulate-crashes ";
     if (flush_txn_immediately)
@@ -229,6 +272,10 @@ struct Configuration
         std::cout << "--recsize-fixed=" << rec_size_fixed << " ";
       if (force_records_inline)
         std::cout << "--force-records-inline ";
+      if (normalized_keys)
+        std::cout << "--normalized-keys ";
+      if (key_filter_bits)
+        std::cout << "--key-filter-bits=" << key_filter_bits << " ";
       std::cout << "--recsize=" << rec_size << " ";
       if (distribution == kDistributionRandom)
         std::cout << "--distribution=random ";
@@ -312,6 +359,22 @@ struct Configuration
   int posix_fadvice;
   bool simulate_crashes;
   bool flush_txn_immediately;
+  int cache_policy;
+  int cache_shards;
+  bool enable_concurrent_reads;
+  bool enable_io_uring;
+  bool direct_io;
+  int worker_threads;
+  int group_commit_usec;
+  int group_commit_size;
+  bool journal_page_deltas;
+  int journal_files;
+  uint64_t journal_file_size;
+  uint64_t journal_checkpoint_interval;
+  int journal_sync_msec;
+  int txn_merge_limit;
+  bool normalized_keys;
+  int key_filter_bits;
 };
 
 #endif /* UPS_BENCH_CONFIGURATION_H */
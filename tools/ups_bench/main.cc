@@ -91,6 +91,22 @@
 #define ARG_POSIX_FADVICE                       71
 #define ARG_SIMULATE_CRASHES                    72
 #define ARG_FLUSH_TXN_IMMEDIATELY               73
+#define ARG_CACHE_POLICY                        74
+#define ARG_CACHE_SHARDS                        75
+#define ARG_ENABLE_CONCURRENT_READS             76
+#define ARG_ENABLE_IO_URING                     77
+#define ARG_DIRECT_IO                           78
+#define ARG_WORKER_THREADS                      79
+#define ARG_GROUP_COMMIT_USEC                   80
+#define ARG_GROUP_COMMIT_SIZE                   81
+#define ARG_JOURNAL_PAGE_DELTAS                 82
+#define ARG_JOURNAL_FILES                       83
+#define ARG_JOURNAL_FILE_SIZE                   84
+#define ARG_JOURNAL_CHECKPOINT_INTERVAL         85
+#define ARG_JOURNAL_SYNC_MSEC                   86
+#define ARG_TXN_MERGE_LIMIT                     87
+#define ARG_NORMALIZED_KEYS                     88
+#define ARG_KEY_FILTER_BITS                     89
 
 /*
  * command line parameters
@@ -383,7 +399,8 @@ static option_t opts[] = {
     ARG_KEY_COMPRESSION,
     0,
     "key-compression",
-    "Pro: Enables key compression ('none', 'zlib', 'snappy', 'lzf')",
+    "Pro: Enables key compression ('none', 'zlib', 'snappy', 'lzf', "
+            "'prefix')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_READ_ONLY,
@@ -427,6 +444,102 @@ static option_t opts[] = {
     "flush-txn-immediately",
     "Immediately flushes transactions after they are committed",
     0 },
+  {
+    ARG_CACHE_POLICY,
+    0,
+    "cache-policy",
+    "Sets the cache replacement policy: 'lru' (default), '2q', 'clock'",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_CACHE_SHARDS,
+    0,
+    "cache-shards",
+    "Sets the number of cache shards (default: 1)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_ENABLE_CONCURRENT_READS,
+    0,
+    "enable-concurrent-reads",
+    "Uses the UPS_ENABLE_CONCURRENT_READS flag",
+    0 },
+  {
+    ARG_ENABLE_IO_URING,
+    0,
+    "enable-io-uring",
+    "Uses the UPS_ENABLE_IO_URING flag (Linux only)",
+    0 },
+  {
+    ARG_DIRECT_IO,
+    0,
+    "direct-io",
+    "Uses the UPS_DIRECT_IO flag",
+    0 },
+  {
+    ARG_WORKER_THREADS,
+    0,
+    "worker-threads",
+    "Sets the number of threads which flush pages (default: 1)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_GROUP_COMMIT_USEC,
+    0,
+    "group-commit-usec",
+    "Enables group commit with a time window (in microseconds)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_GROUP_COMMIT_SIZE,
+    0,
+    "group-commit-size",
+    "Sets the max. number of commits per group (default: 32)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_JOURNAL_PAGE_DELTAS,
+    0,
+    "journal-page-deltas",
+    "Logs only the modified bytes of pages in the journal",
+    0 },
+  {
+    ARG_JOURNAL_FILES,
+    0,
+    "journal-files",
+    "Sets the number of journal files (default: 2)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_JOURNAL_FILE_SIZE,
+    0,
+    "journal-file-size",
+    "Preallocates the journal files with this size (default: 0)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_JOURNAL_CHECKPOINT_INTERVAL,
+    0,
+    "journal-checkpoint-interval",
+    "Writes a checkpoint after this many journal bytes (default: 0)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_JOURNAL_SYNC_MSEC,
+    0,
+    "journal-sync-msec",
+    "Commits return immediately; syncs the journal every n msec (default: 0)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_TXN_MERGE_LIMIT,
+    0,
+    "txn-merge-limit",
+    "Merges committed Txns in the background; max. waiting Txns (default: 0)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_NORMALIZED_KEYS,
+    0,
+    "normalized-keys",
+    "Stores the first 4 bytes of variable length binary keys as integers",
+    0 },
+  {
+    ARG_KEY_FILTER_BITS,
+    0,
+    "key-filter-bits",
+    "Skips lookups of missing keys with a Bloom filter; n bits per key",
+    GETOPTS_NEED_ARGUMENT },
   {0, 0}
 };
 
@@ -453,10 +566,12 @@ parse_compression_type(std::string param)
     return (UPS_COMPRESSOR_UINT32_GROUPVARINT);
   if (param == "zint32_streamvbyte")
     return (UPS_COMPRESSOR_UINT32_STREAMVBYTE);
+  if (param == "prefix")
+    return (UPS_COMPRESSOR_PREFIX);
   ::printf("invalid compression specifier '%s': expecting 'none', 'zlib', "
               "'snappy', 'lzf', 'zint32_varbyte', 'zint32_simdcomp', "
               "'zint32_groupvarint', 'zint32_streamvbyte', "
-              "'zint32_for', 'zint32_simdfor'\n",
+              "'zint32_for', 'zint32_simdfor', 'prefix'\n",
               param.c_str());
   ::exit(-1);
 }
@@ -821,6 +936,83 @@ parse_config(int argc, char **argv, Configuration *c)
     else if (opt == ARG_FLUSH_TXN_IMMEDIATELY) {
       c->flush_txn_immediately = true;
     }
+    else if (opt == ARG_CACHE_POLICY) {
+      if (!strcmp(param, "lru"))
+        c->cache_policy = UPS_CACHE_POLICY_LRU;
+      else if (!strcmp(param, "2q"))
+        c->cache_policy = UPS_CACHE_POLICY_2Q;
+      else if (!strcmp(param, "clock"))
+        c->cache_policy = UPS_CACHE_POLICY_CLOCK;
+      else {
+        printf("[FAIL] invalid parameter for 'cache-policy'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_CACHE_SHARDS) {
+      c->cache_shards = strtoul(param, 0, 0);
+      if (c->cache_shards < 1) {
+        printf("[FAIL] invalid parameter for 'cache-shards'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_ENABLE_CONCURRENT_READS) {
+      c->enable_concurrent_reads = true;
+    }
+    else if (opt == ARG_ENABLE_IO_URING) {
+      c->enable_io_uring = true;
+    }
+    else if (opt == ARG_DIRECT_IO) {
+      c->direct_io = true;
+    }
+    else if (opt == ARG_WORKER_THREADS) {
+      c->worker_threads = strtoul(param, 0, 0);
+      if (c->worker_threads < 1 || c->worker_threads > 64) {
+        printf("[FAIL] invalid parameter for 'worker-threads'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_GROUP_COMMIT_USEC) {
+      c->group_commit_usec = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_GROUP_COMMIT_SIZE) {
+      c->group_commit_size = strtoul(param, 0, 0);
+      if (c->group_commit_size < 1) {
+        printf("[FAIL] invalid parameter for 'group-commit-size'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_JOURNAL_PAGE_DELTAS) {
+      c->journal_page_deltas = true;
+    }
+    else if (opt == ARG_JOURNAL_FILES) {
+      c->journal_files = strtoul(param, 0, 0);
+      if (c->journal_files < 2 || c->journal_files > 64) {
+        printf("[FAIL] invalid parameter for 'journal-files'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_JOURNAL_FILE_SIZE) {
+      c->journal_file_size = strtoull(param, 0, 0);
+    }
+    else if (opt == ARG_JOURNAL_CHECKPOINT_INTERVAL) {
+      c->journal_checkpoint_interval = strtoull(param, 0, 0);
+    }
+    else if (opt == ARG_JOURNAL_SYNC_MSEC) {
+      c->journal_sync_msec = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_TXN_MERGE_LIMIT) {
+      c->txn_merge_limit = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_NORMALIZED_KEYS) {
+      c->normalized_keys = true;
+    }
+    else if (opt == ARG_KEY_FILTER_BITS) {
+      c->key_filter_bits = strtoul(param, 0, 0);
+      if (c->key_filter_bits < 1 || c->key_filter_bits > 32) {
+        printf("[FAIL] invalid parameter for 'key-filter-bits'\n");
+        exit(-1);
+      }
+    }
     else if (opt == ARG_READ_ONLY) {
       c->read_only = true;
     }
@@ -952,6 +1144,10 @@ print_metrics(Metrics *metrics, Configuration *conf)
           (long unsigned int)metrics->upscaledb_metrics.page_count_fetched);
   printf("\tupscaledb page_count_flushed          %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.page_count_flushed);
+  printf("\tupscaledb page_count_flushed_batched  %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.page_count_flushed_batched);
+  printf("\tupscaledb page_count_flush_writes     %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.page_count_flush_writes);
   printf("\tupscaledb page_count_type_index       %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.page_count_type_index);
   printf("\tupscaledb page_count_type_blob        %lu\n",
@@ -978,8 +1174,36 @@ print_metrics(Metrics *metrics, Configuration *conf)
           (long unsigned int)metrics->upscaledb_metrics.extended_keys);
   printf("\tupscaledb extended_duptables          %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.extended_duptables);
+  printf("\tupscaledb key_filter_negatives        %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.key_filter_negatives);
+  printf("\tupscaledb key_filter_rebuilds         %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.key_filter_rebuilds);
   printf("\tupscaledb journal_bytes_flushed       %lu\n",
           (long unsigned int)metrics->upscaledb_metrics.journal_bytes_flushed);
+  printf("\tupscaledb journal_commit_count        %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_commit_count);
+  printf("\tupscaledb journal_commit_groups       %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_commit_groups);
+  printf("\tupscaledb journal_commit_latency_usec %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_commit_latency_usec);
+  printf("\tupscaledb journal_commit_max_latency  %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_commit_max_latency_usec);
+  printf("\tupscaledb journal_page_deltas         %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_page_deltas);
+  printf("\tupscaledb journal_page_bytes_saved    %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_page_bytes_saved);
+  printf("\tupscaledb journal_checkpoints         %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_checkpoints);
+  printf("\tupscaledb journal_recovery_skipped_pages %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_recovery_skipped_pages);
+  printf("\tupscaledb journal_recovery_pages      %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_recovery_pages);
+  printf("\tupscaledb journal_recovery_operations %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_recovery_operations);
+  printf("\tupscaledb journal_recovery_parallel_operations %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_recovery_parallel_operations);
+  printf("\tupscaledb journal_recovery_usec       %lu\n",
+          (long unsigned int)metrics->upscaledb_metrics.journal_recovery_usec);
 }
 
 struct Callable {
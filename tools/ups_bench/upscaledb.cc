@@ -73,7 +73,7 @@ UpscaleDatabase::do_create_env()
 {
   ups_status_t st = 0;
   uint32_t flags = 0;
-  ups_parameter_t params[6] = {{0, 0}};
+  ups_parameter_t params[20] = {{0, 0}};
 
   ScopedLock lock(ms_mutex);
 
@@ -93,6 +93,41 @@ UpscaleDatabase::do_create_env()
     params[p].name = UPS_PARAM_POSIX_FADVISE;
     params[p].value = m_config->posix_fadvice;
     p++;
+    params[p].name = UPS_PARAM_CACHE_POLICY;
+    params[p].value = m_config->cache_policy;
+    p++;
+    params[p].name = UPS_PARAM_CACHE_SHARDS;
+    params[p].value = m_config->cache_shards;
+    p++;
+    params[p].name = UPS_PARAM_WORKER_THREADS;
+    params[p].value = m_config->worker_threads;
+    p++;
+    params[p].name = UPS_PARAM_GROUP_COMMIT_USEC;
+    params[p].value = m_config->group_commit_usec;
+    p++;
+    params[p].name = UPS_PARAM_GROUP_COMMIT_SIZE;
+    params[p].value = m_config->group_commit_size;
+    p++;
+    if (m_config->journal_page_deltas) {
+      params[p].name = UPS_PARAM_JOURNAL_PAGE_DELTAS;
+      params[p].value = 1;
+      p++;
+    }
+    params[p].name = UPS_PARAM_JOURNAL_FILES;
+    params[p].value = m_config->journal_files;
+    p++;
+    params[p].name = UPS_PARAM_JOURNAL_FILE_SIZE;
+    params[p].value = m_config->journal_file_size;
+    p++;
+    params[p].name = UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL;
+    params[p].value = m_config->journal_checkpoint_interval;
+    p++;
+    params[p].name = UPS_PARAM_JOURNAL_SYNC_MSEC;
+    params[p].value = m_config->journal_sync_msec;
+    p++;
+    params[p].name = UPS_PARAM_TXN_MERGE_LIMIT;
+    params[p].value = m_config->txn_merge_limit;
+    p++;
     if (m_config->use_encryption) {
       params[p].name = UPS_PARAM_ENCRYPTION_KEY;
       params[p].value = (uint64_t)"1234567890123456";
@@ -112,6 +147,11 @@ UpscaleDatabase::do_create_env()
     flags |= m_config->use_fsync ? UPS_ENABLE_FSYNC : 0;
     flags |= m_config->disable_recovery ? UPS_DISABLE_RECOVERY : 0;
     flags |= m_config->enable_crc32 ? UPS_ENABLE_CRC32 : 0;
+    flags |= m_config->enable_concurrent_reads
+                ? UPS_ENABLE_CONCURRENT_READS
+                : 0;
+    flags |= m_config->enable_io_uring ? UPS_ENABLE_IO_URING : 0;
+    flags |= m_config->direct_io ? UPS_DIRECT_IO : 0;
 
     boost::filesystem::remove("test-ham.db");
 
@@ -156,7 +196,7 @@ UpscaleDatabase::do_open_env()
 {
   ups_status_t st = 0;
   uint32_t flags = 0;
-  ups_parameter_t params[6] = {{0, 0}};
+  ups_parameter_t params[20] = {{0, 0}};
 
   ScopedLock lock(ms_mutex);
 
@@ -174,6 +214,41 @@ UpscaleDatabase::do_open_env()
     params[p].name = UPS_PARAM_POSIX_FADVISE;
     params[p].value = m_config->posix_fadvice;
     p++;
+    params[p].name = UPS_PARAM_CACHE_POLICY;
+    params[p].value = m_config->cache_policy;
+    p++;
+    params[p].name = UPS_PARAM_CACHE_SHARDS;
+    params[p].value = m_config->cache_shards;
+    p++;
+    params[p].name = UPS_PARAM_WORKER_THREADS;
+    params[p].value = m_config->worker_threads;
+    p++;
+    params[p].name = UPS_PARAM_GROUP_COMMIT_USEC;
+    params[p].value = m_config->group_commit_usec;
+    p++;
+    params[p].name = UPS_PARAM_GROUP_COMMIT_SIZE;
+    params[p].value = m_config->group_commit_size;
+    p++;
+    if (m_config->journal_page_deltas) {
+      params[p].name = UPS_PARAM_JOURNAL_PAGE_DELTAS;
+      params[p].value = 1;
+      p++;
+    }
+    params[p].name = UPS_PARAM_JOURNAL_FILES;
+    params[p].value = m_config->journal_files;
+    p++;
+    params[p].name = UPS_PARAM_JOURNAL_FILE_SIZE;
+    params[p].value = m_config->journal_file_size;
+    p++;
+    params[p].name = UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL;
+    params[p].value = m_config->journal_checkpoint_interval;
+    p++;
+    params[p].name = UPS_PARAM_JOURNAL_SYNC_MSEC;
+    params[p].value = m_config->journal_sync_msec;
+    p++;
+    params[p].name = UPS_PARAM_TXN_MERGE_LIMIT;
+    params[p].value = m_config->txn_merge_limit;
+    p++;
     if (m_config->use_encryption) {
       params[p].name = UPS_PARAM_ENCRYPTION_KEY;
       params[p].value = (uint64_t)"1234567890123456";
@@ -190,6 +265,11 @@ UpscaleDatabase::do_open_env()
     flags |= m_config->disable_recovery ? UPS_DISABLE_RECOVERY : 0;
     flags |= m_config->read_only ? UPS_READ_ONLY : 0;
     flags |= m_config->enable_crc32 ? UPS_ENABLE_CRC32 : 0;
+    flags |= m_config->enable_concurrent_reads
+                ? UPS_ENABLE_CONCURRENT_READS
+                : 0;
+    flags |= m_config->enable_io_uring ? UPS_ENABLE_IO_URING : 0;
+    flags |= m_config->direct_io ? UPS_DIRECT_IO : 0;
 
     st = ups_env_open(&ms_env, "test-ham.db", flags, &params[0]);
     if (st) {
@@ -268,7 +348,7 @@ ups_status_t
 UpscaleDatabase::do_create_db(int id)
 {
   ups_status_t st;
-  ups_parameter_t params[8] = {{0, 0}};
+  ups_parameter_t params[10] = {{0, 0}};
 
   int n = 0;
   params[n].name = UPS_PARAM_KEY_SIZE;
@@ -373,6 +453,11 @@ UpscaleDatabase::do_create_db(int id)
     params[n].value = m_config->key_compression;
     n++;
   }
+  if (m_config->key_filter_bits) {
+    params[n].name = UPS_PARAM_KEY_FILTER_BITS;
+    params[n].value = m_config->key_filter_bits;
+    n++;
+  }
   if (m_config->key_type == Configuration::kKeyCustom) {
     ups_register_compare("cmp", compare_keys);
     params[n].name = UPS_PARAM_CUSTOM_COMPARE_NAME;
@@ -387,6 +472,8 @@ UpscaleDatabase::do_create_db(int id)
   flags |= m_config->record_number64 ? UPS_RECORD_NUMBER64 : 0;
   if (m_config->force_records_inline)
     flags |= UPS_FORCE_RECORDS_INLINE;
+  if (m_config->normalized_keys)
+    flags |= UPS_ENABLE_NORMALIZED_KEYS;
 
   st = ups_env_create_db(m_env ? m_env : ms_env, &m_db, 1 + id,
                   flags, &params[0]);
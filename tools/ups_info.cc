@@ -95,6 +95,8 @@ get_compressor_name(int library) {
       return ("streamvbyte");
     case UPS_COMPRESSOR_UINT32_FOR:
       return ("for");
+    case UPS_COMPRESSOR_PREFIX:
+      return ("prefix");
     default:
       return ("???");
   }
@@ -281,6 +283,7 @@ print_database(ups_env_t *env, ups_db_t *db, uint16_t dbname,
     {UPS_PARAM_RECORD_COMPRESSION, 0},
     {UPS_PARAM_KEY_COMPRESSION, 0},
     {UPS_PARAM_RECORD_TYPE, 0},
+    {UPS_PARAM_KEY_FILTER_BITS, 0},
     {0, 0}
   };
 
@@ -312,6 +315,11 @@ print_database(ups_env_t *env, ups_db_t *db, uint16_t dbname,
                       params[4].value & UPS_FORCE_RECORDS_INLINE
                             ? "yes"
                             : "no");
+    if (params[4].value & UPS_ENABLE_NORMALIZED_KEYS)
+      printf("    normalized keys:      yes\n");
+    if (params[8].value)
+      printf("    key filter:           %u bits per key\n",
+                      (unsigned)params[8].value);
   }
 
   if (full)
@@ -18,6 +18,7 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include "3btree/btree_index_factory.h"
 #include "3page_manager/page_manager.h"
 #include "4env/env_local.h"
 #include "4context/context.h"
@@ -25,6 +26,9 @@
 #include "os.hpp"
 #include "fixture.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace upscaledb {
 
 bool g_split = false;
@@ -319,6 +323,77 @@ struct BtreeFixture : BaseFixture {
     REQUIRE(31 == (int)query[3].value);
     REQUIRE(UPS_FORCE_RECORDS_INLINE == (int)query[4].value);
   }
+
+  template<typename T>
+  void blockIndexTest() {
+    uint64_t seed = 1;
+    for (size_t count = 0; count < 3000; count += 1 + count / 8) {
+      std::vector<T> keys(count);
+      for (size_t i = 0; i < count; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        keys[i] = (T)((seed >> 33) % (count * 2 + 1));
+      }
+      std::sort(keys.begin(), keys.end());
+
+      PodBlockIndex<T> index;
+      index.build(keys.data(), count);
+      REQUIRE(index.is_valid(count)
+                      == (count >= PodBlockIndex<T>::kMinKeys));
+      if (!index.is_valid(count))
+        continue;
+      REQUIRE(!index.is_valid(count - 1));
+
+      for (size_t k = 0; k <= count * 2 + 1; k++) {
+        int expected = std::lower_bound(keys.begin(), keys.end(), (T)k)
+                              - keys.begin();
+        REQUIRE(expected == index.lower_bound(keys.data(), (T)k));
+      }
+    }
+  }
+
+  void internalNodeIndexTest() {
+    ups_parameter_t p[] = {
+        { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT64 },
+        { UPS_PARAM_RECORD_SIZE, 8 },
+        { 0, 0 }
+    };
+
+    // the root node has more than PodBlockIndex<uint64_t>::kMinKeys keys
+    require_create(0, nullptr, 0, p);
+
+    const uint64_t count = 100000;
+    ups_record_t rec = {0};
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t k = i * 2;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      rec = ups_make_record(&k, sizeof(k));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    for (int loop = 0; loop < 3; loop++) {
+      for (uint64_t k = 0; k < count * 2; k++) {
+        uint64_t tmp = k;
+        ups_key_t key = ups_make_key(&tmp, sizeof(tmp));
+        bool exists = k % 2 == 0 && (loop == 0 || k % 8 != 0);
+        REQUIRE((exists ? 0 : UPS_KEY_NOT_FOUND)
+                        == ups_db_find(db, 0, &key, &rec, 0));
+        if (exists)
+          REQUIRE(k == *(uint64_t *)rec.data);
+      }
+
+      // erase every 4th key, then reopen the database
+      if (loop == 0) {
+        for (uint64_t k = 0; k < count * 2; k += 8) {
+          ups_key_t key = ups_make_key(&k, sizeof(k));
+          REQUIRE(0 == ups_db_erase(db, 0, &key, 0));
+        }
+      }
+      else if (loop == 1) {
+        close();
+        require_open();
+      }
+    }
+  }
 };
 
 TEST_CASE("Btree/binaryTypeTest", "")
@@ -405,4 +480,19 @@ TEST_CASE("Btree/forceInternalNodeTest", "")
   f.forceInternalNodeTest();
 }
 
+TEST_CASE("Btree/blockIndexTest", "")
+{
+  BtreeFixture f;
+  f.blockIndexTest<uint8_t>();
+  f.blockIndexTest<uint32_t>();
+  f.blockIndexTest<uint64_t>();
+  f.blockIndexTest<double>();
+}
+
+TEST_CASE("Btree/internalNodeIndexTest", "")
+{
+  BtreeFixture f;
+  f.internalNodeIndexTest();
+}
+
 } // namespace upscaledb
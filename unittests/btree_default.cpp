@@ -560,6 +560,131 @@ TEST_CASE("BtreeDefault/varKeysFixedRecordsTest", "")
 #endif
 }
 
+// Inserts keys which are (partially) identical in their first 4 bytes,
+// and verifies lookups and the sort order
+static void
+normalized_keys_test(ups_parameter_t *params)
+{
+  std::vector<std::string> keys;
+  const char *special[] = {"a", "ab", "abc", "abcd", "abcde", "abce",
+                  "abd", "b", "\xff\xff\xff\xff", "\xff\xff\xff\xff\x01"};
+  for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++)
+    keys.push_back(special[i]);
+  keys.push_back(std::string());
+  keys.push_back(std::string("ab\0", 3));
+  keys.push_back(std::string("ab\0\0", 4));
+  keys.push_back(std::string("ab\0\0\0", 5));
+  for (int i = 0; i < 5000; i++) {
+    char buffer[32];
+    ::sprintf(buffer, "key-%06d", (i * 7919) % 5000);
+    keys.push_back(buffer);
+    ::sprintf(buffer, "%08d", i);
+    keys.push_back(buffer);
+    if (i % 50 == 0)
+      keys.push_back(std::string(buffer) + std::string(500, 'x'));
+  }
+
+  BaseFixture f;
+  f.require_create(0, 0, UPS_ENABLE_NORMALIZED_KEYS, params);
+  DbProxy db(f.db);
+  db.require_parameter(UPS_PARAM_FLAGS, UPS_ENABLE_NORMALIZED_KEYS);
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    ups_key_t key = ups_make_key((void *)keys[i].data(),
+                    (uint16_t)keys[i].size());
+    ups_record_t record = ups_make_record(&i, sizeof(i));
+    REQUIRE(0 == ups_db_insert(f.db, 0, &key, &record, 0));
+  }
+  db.require_check_integrity();
+
+  std::sort(keys.begin(), keys.end());
+
+  for (int pass = 0; pass < 2; pass++) {
+    // all keys can be found...
+    for (size_t i = 0; i < keys.size(); i++) {
+      ups_key_t key = ups_make_key((void *)keys[i].data(),
+                      (uint16_t)keys[i].size());
+      ups_record_t record = {0};
+      REQUIRE(0 == ups_db_find(f.db, 0, &key, &record, 0));
+    }
+
+    // ... and are sorted
+    ups_cursor_t *cursor;
+    ups_key_t key = {0};
+    ups_record_t record = {0};
+    REQUIRE(0 == ups_cursor_create(&cursor, f.db, 0, 0));
+    for (size_t i = 0; i < keys.size(); i++) {
+      REQUIRE(0 == ups_cursor_move(cursor, &key, &record, UPS_CURSOR_NEXT));
+      REQUIRE(std::string((char *)key.data, key.size) == keys[i]);
+    }
+    REQUIRE(UPS_KEY_NOT_FOUND
+                  == ups_cursor_move(cursor, &key, &record, UPS_CURSOR_NEXT));
+    REQUIRE(0 == ups_cursor_close(cursor));
+
+    // missing keys are not found
+    const char *missing[] = {"aa", "abcdd", "key-", "\xff\xff\xff"};
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+      ups_key_t key = ups_make_key((void *)missing[i],
+                      (uint16_t)::strlen(missing[i]));
+      ups_record_t record = {0};
+      REQUIRE(UPS_KEY_NOT_FOUND == ups_db_find(f.db, 0, &key, &record, 0));
+    }
+
+    f.close()
+     .require_open();
+    db = DbProxy(f.db);
+    db.require_parameter(UPS_PARAM_FLAGS, UPS_ENABLE_NORMALIZED_KEYS)
+      .require_check_integrity();
+  }
+
+  // erase every 2nd key
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    ups_key_t key = ups_make_key((void *)keys[i].data(),
+                    (uint16_t)keys[i].size());
+    REQUIRE(0 == ups_db_erase(f.db, 0, &key, 0));
+  }
+  db.require_check_integrity();
+  for (size_t i = 0; i < keys.size(); i++) {
+    ups_key_t key = ups_make_key((void *)keys[i].data(),
+                    (uint16_t)keys[i].size());
+    ups_record_t record = {0};
+    REQUIRE((i % 2 ? 0 : UPS_KEY_NOT_FOUND)
+                  == ups_db_find(f.db, 0, &key, &record, 0));
+  }
+}
+
+TEST_CASE("BtreeDefault/normalizedKeysTest", "")
+{
+  normalized_keys_test(0);
+}
+
+TEST_CASE("BtreeDefault/normalizedPrefixKeysTest", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_KEY_COMPRESSION, UPS_COMPRESSOR_PREFIX },
+      { 0, 0 }
+  };
+  normalized_keys_test(params);
+}
+
+TEST_CASE("BtreeDefault/negativeNormalizedKeysTest", "")
+{
+  ups_parameter_t params1[] = {
+      { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT32 },
+      { 0, 0 }
+  };
+  ups_parameter_t params2[] = {
+      { UPS_PARAM_KEY_SIZE, 16 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, 0, UPS_ENABLE_NORMALIZED_KEYS, params1,
+                  UPS_INV_PARAMETER)
+   .require_create(0, 0, UPS_ENABLE_NORMALIZED_KEYS, params2,
+                  UPS_INV_PARAMETER);
+}
+
 TEST_CASE("BtreeDefault/fixedKeysAndRecordsWithDuplicatesTest", "")
 {
   BtreeDefaultFixture::IntVector ivec;
@@ -1696,6 +1821,43 @@ struct UpfrontIndexFixture : BaseFixture {
       }
     }
   }
+
+  void tagsTest() {
+    uint8_t data1[1024 * 16] = {1};
+    uint8_t data2[1024 * 16] = {1};
+    const size_t kMax = 200;
+
+    UpfrontIndex ui1(ldb(), true);
+    REQUIRE(ui1.has_tags() == true);
+    REQUIRE(ui1.full_index_size() == ui1.sizeof_offset + 1 + 4);
+    ui1.create(&data1[0], sizeof(data1), kMax);
+
+    // insert at the front; the tags are moved with the slots
+    for (size_t i = 0; i < kMax; i++) {
+      ui1.insert(i, 0);
+      REQUIRE(ui1.get_chunk_tag(0) == 0);
+      ui1.allocate_space(i + 1, 0, 16);
+      ui1.set_chunk_tag(0, (uint32_t)i);
+    }
+    for (size_t i = 0; i < kMax; i++)
+      REQUIRE(ui1.get_chunk_tag(i) == kMax - 1 - i);
+
+    // erase the first slot
+    ui1.erase(kMax, 0);
+    for (size_t i = 0; i < kMax - 1; i++)
+      REQUIRE(ui1.get_chunk_tag(i) == kMax - 2 - i);
+    ui1.vacuumize(kMax - 1);
+
+    // split and merge
+    UpfrontIndex ui2(ldb(), true);
+    ui2.create(&data2[0], sizeof(data2), kMax);
+    ui1.split(&ui2, kMax - 1, 50);
+    for (size_t i = 0; i < kMax - 1 - 50; i++)
+      REQUIRE(ui2.get_chunk_tag(i) == kMax - 2 - 50 - i);
+    ui1.merge_from(&ui2, 50, kMax - 1 - 50);
+    for (size_t i = 0; i < kMax - 1; i++)
+      REQUIRE(ui1.get_chunk_tag(i) == kMax - 2 - i);
+  }
 };
 
 TEST_CASE("BtreeDefault/UpfrontIndex/createReopenTest", "")
@@ -1761,4 +1923,13 @@ TEST_CASE("BtreeDefault/UpfrontIndex/splitMergeTest", "")
   }
 }
 
+TEST_CASE("BtreeDefault/UpfrontIndex/tagsTest", "")
+{
+  size_t page_sizes[] = {1024 * 16, 1024 * 64};
+  for (int i = 0; i < 2; i++) {
+    UpfrontIndexFixture f(page_sizes[i]);
+    f.tagsTest();
+  }
+}
+
 } // namespace upscaledb
@@ -325,6 +325,136 @@ TEST_CASE("Compression/negativeKey", "")
    .require_create(0, 0, 0, param2, UPS_INV_PARAMETER);
 }
 
+// Creates a key which starts with a long common prefix; every 7th key
+// has a different prefix and every 100th key is an extended key
+static std::vector<uint8_t>
+make_prefix_key(int i)
+{
+  char buffer[64];
+  if (i % 7 == 0)
+    ::sprintf(buffer, "ftp://%08d", i);
+  else
+    ::sprintf(buffer, "http://www.example.com/articles/%08d/", i);
+  std::vector<uint8_t> key(buffer, buffer + ::strlen(buffer));
+  if (i % 100 == 0)
+    key.resize(1000, 'x');
+  return key;
+}
+
+static void
+prefix_key_test(int library)
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_KEY_COMPRESSION, (uint64_t)library },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, 0, 0, library ? params : 0);
+
+  DbProxy db(f.db);
+  db.require_parameter(UPS_PARAM_KEY_COMPRESSION, library);
+
+  const int kMax = 20000;
+
+  // insert in random order, to split nodes in the middle
+  for (int i = 0; i < kMax; i++) {
+    int k = (int)(((uint64_t)i * 7919) % kMax);
+    std::vector<uint8_t> key = make_prefix_key(k);
+    std::vector<uint8_t> record(key);
+    db.require_insert(key, record);
+  }
+  db.require_check_integrity();
+
+  // lookup
+  for (int i = 0; i < kMax; i++) {
+    std::vector<uint8_t> key = make_prefix_key(i);
+    db.require_find(key, key);
+    db.require_find_useralloc(key, key);
+  }
+
+  // the cursor returns the keys in sorted order
+  ups_cursor_t *cursor;
+  ups_key_t key = {0};
+  std::vector<uint8_t> prev;
+  ups_record_t record = {0};
+  int count = 0;
+  REQUIRE(0 == ups_cursor_create(&cursor, f.db, 0, 0));
+  while (0 == ups_cursor_move(cursor, &key, &record, UPS_CURSOR_NEXT)) {
+    REQUIRE(key.size == record.size);
+    REQUIRE(0 == ::memcmp(key.data, record.data, key.size));
+    if (count > 0) {
+      size_t size = std::min(prev.size(), (size_t)key.size);
+      int cmp = ::memcmp(prev.data(), key.data, size);
+      REQUIRE((cmp < 0 || (cmp == 0 && prev.size() < key.size)));
+    }
+    prev.assign((uint8_t *)key.data, (uint8_t *)key.data + key.size);
+    count++;
+  }
+  REQUIRE(count == kMax);
+  REQUIRE(0 == ups_cursor_close(cursor));
+
+  // erase every 2nd key
+  for (int i = 0; i < kMax; i += 2) {
+    std::vector<uint8_t> k = make_prefix_key(i);
+    ups_key_t tmp = ups_make_key(k.data(), (uint16_t)k.size());
+    REQUIRE(0 == ups_db_erase(f.db, 0, &tmp, 0));
+  }
+  db.require_check_integrity();
+
+  f.close()
+   .require_open();
+  db = DbProxy(f.db);
+  db.require_parameter(UPS_PARAM_KEY_COMPRESSION, library)
+    .require_check_integrity();
+
+  for (int i = 0; i < kMax; i++) {
+    std::vector<uint8_t> key = make_prefix_key(i);
+    if (i % 2)
+      db.require_find(key, key);
+    else
+      db.require_find(key, key, UPS_KEY_NOT_FOUND);
+  }
+  db.require_key_count(kMax / 2);
+}
+
+TEST_CASE("Compression/PrefixKey", "")
+{
+  prefix_key_test(UPS_COMPRESSOR_PREFIX);
+}
+
+// the separators in the internal nodes are truncated for all variable
+// length binary keys
+TEST_CASE("Compression/TruncatedSeparators", "")
+{
+  prefix_key_test(UPS_COMPRESSOR_NONE);
+}
+
+TEST_CASE("Compression/negativePrefixKey", "")
+{
+  ups_parameter_t param1[] = {
+      { UPS_PARAM_KEY_COMPRESSION, UPS_COMPRESSOR_PREFIX },
+      { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT64 },
+      { 0, 0 }
+  };
+
+  ups_parameter_t param2[] = {
+      { UPS_PARAM_KEY_COMPRESSION, UPS_COMPRESSOR_PREFIX },
+      { UPS_PARAM_KEY_SIZE, 16 },
+      { 0, 0 }
+  };
+
+  ups_parameter_t param3[] = {
+      { UPS_PARAM_RECORD_COMPRESSION, UPS_COMPRESSOR_PREFIX },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, 0, 0, param1, UPS_INV_PARAMETER)
+   .require_create(0, 0, 0, param2, UPS_INV_PARAMETER)
+   .require_create(0, 0, 0, param3, UPS_INV_PARAMETER);
+}
+
 TEST_CASE("Compression/userAlloc", "")
 {
   ups_parameter_t params[] = {
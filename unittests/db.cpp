@@ -18,7 +18,7 @@
 
 #include "3rdparty/catch/catch.hpp"
 
-#include "ups/upscaledb.h"
+#include "ups/upscaledb_int.h"
 
 #include "4context/context.h"
 
@@ -111,6 +111,308 @@ struct DbFixture : BaseFixture {
   }
 };
 
+struct KeyFilterFixture : BaseFixture {
+  uint32_t m_env_flags;
+
+  KeyFilterFixture(uint32_t env_flags)
+    : m_env_flags(env_flags) {
+    ups_parameter_t params[] = {
+        { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT64 },
+        { UPS_PARAM_KEY_FILTER_BITS, 10 },
+        { 0, 0 }
+    };
+    require_create(env_flags, nullptr, 0, params);
+  }
+
+  ~KeyFilterFixture() {
+    close();
+  }
+
+  uint64_t negatives() {
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    return metrics.key_filter_negatives;
+  }
+
+  uint64_t rebuilds() {
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    return metrics.key_filter_rebuilds;
+  }
+
+  ups_status_t find(uint64_t k) {
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t record = {0};
+    return ups_db_find(db, 0, &key, &record, 0);
+  }
+
+  void verify(int max) {
+    // existing keys are always found; most of the missing keys are
+    // ruled out by the filter
+    uint64_t before = negatives();
+    for (int i = 0; i < max; i++)
+      REQUIRE((i % 2 ? UPS_KEY_NOT_FOUND : 0) == find(i));
+    REQUIRE(negatives() - before > (uint64_t)max / 2 * 9 / 10);
+  }
+
+  void insertFindTest() {
+    const int kMax = 20000;
+    DbProxy dbp(db);
+    dbp.require_parameter(UPS_PARAM_KEY_FILTER_BITS, 10);
+
+    // the filter of a new database is empty, and never rebuilt
+    uint64_t before = rebuilds();
+    REQUIRE(UPS_KEY_NOT_FOUND == find(1));
+
+    // the filter grows by appending segments
+    std::vector<uint8_t> record;
+    for (int i = 0; i < kMax; i += 2) {
+      uint64_t k = i;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      dbp.require_insert(&key, record);
+    }
+    verify(kMax);
+    REQUIRE(rebuilds() == before);
+
+    // approximate matching does not use the filter
+    uint64_t k = 1;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t rec = {0};
+    REQUIRE(0 == ups_db_find(db, 0, &key, &rec, UPS_FIND_GEQ_MATCH));
+    REQUIRE(2ull == *(uint64_t *)key.data);
+
+    // inserting an existing key still fails
+    k = 4;
+    key = ups_make_key(&k, sizeof(k));
+    REQUIRE(UPS_DUPLICATE_KEY == ups_db_insert(db, 0, &key, &rec, 0));
+
+    // erased keys are no longer found
+    for (int i = 0; i < kMax; i += 4) {
+      k = i;
+      key = ups_make_key(&k, sizeof(k));
+      REQUIRE(0 == ups_db_erase(db, 0, &key, 0));
+    }
+    for (int i = 0; i < kMax; i += 2)
+      REQUIRE((i % 4 ? 0 : UPS_KEY_NOT_FOUND) == find(i));
+
+    if (ISSET(m_env_flags, UPS_IN_MEMORY))
+      return;
+
+    // the filter is persisted, and loaded after reopening
+    close().require_open();
+    dbp = DbProxy(db);
+    dbp.require_parameter(UPS_PARAM_KEY_FILTER_BITS, 10);
+    for (int i = 0; i < kMax; i++)
+      REQUIRE((i % 4 == 2 ? 0 : UPS_KEY_NOT_FOUND) == find(i));
+    REQUIRE(rebuilds() == before);
+
+    // after erasing most keys the filter is rebuilt when the database
+    // is opened again
+    for (int i = 2; i < kMax; i += 4) {
+      k = i;
+      key = ups_make_key(&k, sizeof(k));
+      REQUIRE(0 == ups_db_erase(db, 0, &key, 0));
+    }
+    close().require_open();
+    REQUIRE(rebuilds() == before + 1);
+    for (int i = 0; i < kMax; i++)
+      REQUIRE(UPS_KEY_NOT_FOUND == find(i));
+  }
+
+  void recoveryTest() {
+    const int kMax = 2000;
+    std::vector<uint8_t> record;
+    DbProxy dbp(db);
+    for (int i = 0; i < kMax; i += 2) {
+      uint64_t k = i;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      dbp.require_insert(&key, record);
+    }
+
+    // the journal is replayed; the persisted filter is not trusted
+    uint64_t before = rebuilds();
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG)
+      .require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    REQUIRE(rebuilds() == before + 1);
+    verify(kMax);
+
+    // after a clean shutdown it is loaded again
+    close().require_open(UPS_ENABLE_TRANSACTIONS);
+    REQUIRE(rebuilds() == before + 1);
+    verify(kMax);
+  }
+
+  void concurrentReadsTest() {
+    std::vector<uint8_t> record;
+    DbProxy dbp(db);
+    for (uint64_t i = 0; i < 100; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      dbp.require_insert(&key, record);
+    }
+
+    // this session does not maintain the filter, but modifies the database
+    uint64_t k = 5000;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    close().require_open(m_env_flags | UPS_ENABLE_CONCURRENT_READS);
+    DbProxy(db).require_insert(&key, record);
+
+    // the persisted filter is outdated and rebuilt
+    uint64_t before = rebuilds();
+    close().require_open(m_env_flags);
+    REQUIRE(rebuilds() == before + 1);
+    REQUIRE(0 == find(5000));
+    for (uint64_t i = 0; i < 100; i++)
+      REQUIRE(0 == find(i));
+  }
+
+  void fileVersionTest() {
+    std::vector<uint8_t> record;
+    uint64_t k = 1;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    DbProxy(db).require_insert(&key, record);
+    REQUIRE(UPS_FILE_VERSION == lenv()->header->version(3));
+
+    // the persisted filter raises the file version
+    close().require_open(UPS_READ_ONLY);
+    REQUIRE(EnvHeader::kKeyFilterFileVersion == lenv()->header->version(3));
+    REQUIRE(0 == find(1));
+
+    // a writer invalidates the filter and resets the file version
+    close().require_open();
+    REQUIRE(UPS_FILE_VERSION == lenv()->header->version(3));
+    close().require_open(UPS_READ_ONLY);
+    REQUIRE(EnvHeader::kKeyFilterFileVersion == lenv()->header->version(3));
+
+    // files with the plain file version are opened; their filters are
+    // not trusted
+    EnvHeader *header = lenv()->header.get();
+    long offset = (long)(&header->header()->version[3]
+                    - (uint8_t *)header->header_page->data());
+    uint64_t before = rebuilds();
+    close();
+    FILE *f = ::fopen("test.db", "r+b");
+    REQUIRE(f != 0);
+    REQUIRE(0 == ::fseek(f, offset, SEEK_SET));
+    REQUIRE(UPS_FILE_VERSION == ::fputc(UPS_FILE_VERSION, f));
+    ::fclose(f);
+    require_open();
+    REQUIRE(rebuilds() == before + 1);
+    REQUIRE(0 == find(1));
+  }
+
+  void txnTest() {
+    ups_txn_t *txn1, *txn2;
+    uint64_t k = 7;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t record = {0};
+
+    REQUIRE(0 == ups_txn_begin(&txn1, env, 0, 0, 0));
+    REQUIRE(0 == ups_db_insert(db, txn1, &key, &record, 0));
+    REQUIRE(0 == ups_db_find(db, txn1, &key, &record, 0));
+
+    // the key is visible to the filter, but still conflicts
+    REQUIRE(0 == ups_txn_begin(&txn2, env, 0, 0, 0));
+    REQUIRE(UPS_TXN_CONFLICT == ups_db_find(db, txn2, &key, &record, 0));
+    REQUIRE(0 == ups_txn_abort(txn2, 0));
+    REQUIRE(0 == ups_txn_commit(txn1, 0));
+
+    REQUIRE(0 == find(7));
+    REQUIRE(UPS_DUPLICATE_KEY == ups_db_insert(db, 0, &key, &record, 0));
+
+    // erasing a missing key
+    k = 8;
+    REQUIRE(UPS_KEY_NOT_FOUND == ups_db_erase(db, 0, &key, 0));
+    k = 7;
+    REQUIRE(0 == ups_db_erase(db, 0, &key, 0));
+    REQUIRE(UPS_KEY_NOT_FOUND == find(7));
+  }
+};
+
+TEST_CASE("Db/KeyFilter/insertFindTest", "")
+{
+  KeyFilterFixture f(0);
+  f.insertFindTest();
+}
+
+TEST_CASE("Db/KeyFilter/inmem/insertFindTest", "")
+{
+  KeyFilterFixture f(UPS_IN_MEMORY);
+  f.insertFindTest();
+}
+
+TEST_CASE("Db/KeyFilter/txn/insertFindTest", "")
+{
+  KeyFilterFixture f(UPS_ENABLE_TRANSACTIONS);
+  f.insertFindTest();
+}
+
+TEST_CASE("Db/KeyFilter/concurrentReadsTest", "")
+{
+  KeyFilterFixture f(0);
+  f.concurrentReadsTest();
+}
+
+TEST_CASE("Db/KeyFilter/fileVersionTest", "")
+{
+  KeyFilterFixture f(0);
+  f.fileVersionTest();
+}
+
+TEST_CASE("Db/KeyFilter/txn/txnTest", "")
+{
+  KeyFilterFixture f(UPS_ENABLE_TRANSACTIONS);
+  f.txnTest();
+}
+
+TEST_CASE("Db/KeyFilter/txn/recoveryTest", "")
+{
+  KeyFilterFixture f(UPS_ENABLE_TRANSACTIONS);
+  f.recoveryTest();
+}
+
+TEST_CASE("Db/KeyFilter/realTest", "")
+{
+  ups_parameter_t params[] = {
+      { UPS_PARAM_KEY_TYPE, UPS_TYPE_REAL64 },
+      { UPS_PARAM_KEY_FILTER_BITS, 8 },
+      { 0, 0 }
+  };
+  BaseFixture f;
+  f.require_create(0, nullptr, 0, params);
+
+  double d = -0.0;
+  ups_key_t key = ups_make_key(&d, sizeof(d));
+  ups_record_t record = {0};
+  REQUIRE(0 == ups_db_insert(f.db, 0, &key, &record, 0));
+  d = 0.0;
+  REQUIRE(0 == ups_db_find(f.db, 0, &key, &record, 0));
+}
+
+TEST_CASE("Db/KeyFilter/negativeTest", "")
+{
+  ups_parameter_t params1[] = {
+      { UPS_PARAM_KEY_TYPE, UPS_TYPE_CUSTOM },
+      { UPS_PARAM_KEY_FILTER_BITS, 8 },
+      { 0, 0 }
+  };
+  ups_parameter_t params2[] = {
+      { UPS_PARAM_KEY_FILTER_BITS, 33 },
+      { 0, 0 }
+  };
+  ups_parameter_t params3[] = {
+      { UPS_PARAM_KEY_FILTER_BITS, 8 },
+      { 0, 0 }
+  };
+
+  BaseFixture f;
+  f.require_create(0, nullptr, 0, params1, UPS_INV_PARAMETER)
+   .require_create(0, nullptr, 0, params2, UPS_INV_PARAMETER)
+   .require_create(0, nullptr, 0, params3)
+   .close();
+  REQUIRE(0 == ups_env_open(&f.env, "test.db", 0, 0));
+  REQUIRE(UPS_INV_PARAMETER == ups_env_open_db(f.env, &f.db, 1, 0, params3));
+}
+
 TEST_CASE("Db/headerTest", "")
 {
   DbFixture f;
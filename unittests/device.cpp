@@ -19,6 +19,9 @@
 #include "3rdparty/catch/catch.hpp"
 
 #include "2device/device.h"
+#ifdef HAVE_LINUX_IO_URING_H
+#  include "2device/device_io_uring.h"
+#endif
 
 #include "os.hpp"
 #include "fixture.hpp"
@@ -26,8 +29,8 @@
 using namespace upscaledb;
 
 struct DeviceFixture : BaseFixture {
-  DeviceFixture(bool inmemory) {
-    require_create(inmemory ? UPS_IN_MEMORY : 0);
+  DeviceFixture(bool inmemory, uint32_t flags = 0) {
+    require_create((inmemory ? UPS_IN_MEMORY : 0) | flags);
   }
 
   void createCloseTest() {
@@ -178,6 +181,182 @@ struct DeviceFixture : BaseFixture {
       pp.require_payload(temp, page_size - Page::kSizeofPersistentHeader);
     }
   }
+
+  void writeMultipleTest() {
+    uint32_t page_size = UPS_DEFAULT_PAGE_SIZE;
+    Device *dev = device();
+
+    DeviceProxy dp(lenv());
+    dp.require_open()
+      .require_truncate(page_size * 10);
+
+    // pages 1-3 and 7-8 are adjacent
+    uint8_t addresses[] = {1, 2, 3, 5, 7, 8};
+    std::vector<std::vector<uint8_t>> buffers(6);
+    std::vector<DeviceWriteRequest> requests;
+    for (int i = 0; i < 6; i++) {
+      buffers[i].resize(page_size, addresses[i]);
+      DeviceWriteRequest r = {(uint64_t)addresses[i] * page_size,
+                              buffers[i].data(), page_size};
+      requests.push_back(r);
+    }
+
+    uint64_t pages = dev->batched_pages;
+    uint64_t writes = dev->batched_writes;
+    dev->write_multiple(requests.data(), requests.size());
+    REQUIRE(dev->batched_pages == pages + 6);
+    REQUIRE(dev->batched_writes == writes + 3);
+
+    std::vector<uint8_t> temp(page_size);
+    for (int i = 0; i < 6; i++) {
+      dp.require_read(addresses[i] * page_size, temp.data(), page_size);
+      REQUIRE(temp == buffers[i]);
+    }
+  }
+
+  void flushMetricsTest() {
+    ups_parameter_t params[] = {
+        {UPS_PARAM_CACHE_SIZE, 64 * 1024},
+        {0, 0}
+    };
+
+    close();
+    require_create(0, params);
+
+    for (int i = 0; i < 20000; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.page_count_flushed_batched > 0);
+    REQUIRE(metrics.page_count_flush_writes > 0);
+    REQUIRE(metrics.page_count_flush_writes
+                    <= metrics.page_count_flushed_batched);
+  }
+
+  void ioUringTest() {
+    uint32_t page_size = UPS_DEFAULT_PAGE_SIZE;
+    Device *dev = device();
+
+#ifdef HAVE_LINUX_IO_URING_H
+    if (IoUring::is_supported())
+      REQUIRE(dynamic_cast<IoUringDevice *>(dev) != 0);
+#endif
+
+    DeviceProxy dp(lenv());
+    dp.require_open()
+      .require_truncate(page_size * 10);
+
+    std::vector<std::vector<uint8_t>> buffers(10);
+    std::vector<DeviceWriteRequest> requests;
+    for (uint8_t i = 1; i < 10; i++) {
+      buffers[i].resize(page_size, i);
+      DeviceWriteRequest r = {(uint64_t)i * page_size, buffers[i].data(),
+                              page_size};
+      requests.push_back(r);
+    }
+    uint64_t writes = dev->batched_writes;
+    dev->write_multiple(requests.data(), requests.size());
+    // all pages are adjacent
+    REQUIRE(dev->batched_writes == writes + 1);
+
+    for (uint8_t i = 1; i < 10; i++)
+      dev->read_ahead(i * page_size);
+
+    // a write discards the page which was read ahead
+    std::fill(buffers[5].begin(), buffers[5].end(), 55);
+    dp.require_write(5 * page_size, buffers[5].data(), page_size);
+
+    for (uint8_t i = 1; i < 10; i++) {
+      PageProxy pp(lenv());
+      pp.set_address(page_size * i);
+      dp.require_read_page(pp, page_size * i);
+      REQUIRE(0 == ::memcmp(pp.page->data(), buffers[i].data(), page_size));
+    }
+  }
+
+  void ioUringScanTest() {
+    ups_parameter_t params[] = {
+        {UPS_PARAM_CACHE_SIZE, 64 * 1024},
+        {0, 0}
+    };
+    const int kMaxKeys = 20000;
+
+    close();
+    require_create(UPS_ENABLE_IO_URING | UPS_DISABLE_MMAP, params);
+
+    for (int i = 0; i < kMaxKeys; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    close();
+    require_open(UPS_ENABLE_IO_URING | UPS_DISABLE_MMAP, params);
+
+    ups_cursor_t *cursor;
+    REQUIRE(0 == ups_cursor_create(&cursor, db, 0, 0));
+    ups_key_t key = {0};
+    ups_record_t rec = {0};
+    int count = 0;
+    while (0 == ups_cursor_move(cursor, &key, &rec, UPS_CURSOR_NEXT)) {
+      REQUIRE(rec.size == sizeof(int));
+      REQUIRE(0 == ::memcmp(key.data, rec.data, sizeof(int)));
+      count++;
+    }
+    REQUIRE(count == kMaxKeys);
+    REQUIRE(0 == ups_cursor_close(cursor));
+
+    uint64_t keycount;
+    REQUIRE(0 == ups_db_count(db, 0, 0, &keycount));
+    REQUIRE(keycount == (uint64_t)kMaxKeys);
+  }
+
+  void directIoTest(uint32_t page_size, uint32_t flags) {
+    ups_parameter_t params[] = {
+        {UPS_PARAM_CACHE_SIZE, 64 * 1024},
+        {UPS_PARAM_PAGE_SIZE, page_size},
+        {0, 0}
+    };
+    ups_parameter_t open_params[] = {
+        {UPS_PARAM_CACHE_SIZE, 64 * 1024},
+        {0, 0}
+    };
+    const int kMaxKeys = 5000;
+
+    close();
+    require_create(UPS_DIRECT_IO | flags, params);
+    REQUIRE(ISSET(lenv()->config.flags, UPS_DISABLE_MMAP));
+
+    for (int i = 0; i < kMaxKeys; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    close();
+    require_open(UPS_DIRECT_IO | flags, open_params);
+
+    // page buffers are aligned
+    if (page_size % File::kDirectIoAlignment == 0) {
+      Context context(lenv(), 0, 0);
+      Page *page = lenv()->page_manager->fetch(&context, 2 * page_size);
+      REQUIRE(File::is_aligned_for_direct_io(page->address(), page->data(),
+                              page_size));
+      context.changeset.clear();
+    }
+
+    for (int i = 0; i < kMaxKeys; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &rec, 0));
+      REQUIRE(rec.size == sizeof(int));
+      REQUIRE(0 == ::memcmp(&i, rec.data, sizeof(int)));
+    }
+  }
 };
 
 TEST_CASE("Device/newDelete", "")
@@ -234,6 +413,54 @@ TEST_CASE("Device/readWritePage", "")
   f.readWritePageTest();
 }
 
+TEST_CASE("Device/writeMultiple", "")
+{
+  DeviceFixture f(false, UPS_DISABLE_MMAP);
+  f.writeMultipleTest();
+}
+
+TEST_CASE("Device/flushMetrics", "")
+{
+  DeviceFixture f(false);
+  f.flushMetricsTest();
+}
+
+TEST_CASE("Device/ioUring", "")
+{
+  DeviceFixture f(false, UPS_ENABLE_IO_URING | UPS_DISABLE_MMAP);
+  f.ioUringTest();
+}
+
+TEST_CASE("Device/ioUringScan", "")
+{
+  DeviceFixture f(false);
+  f.ioUringScanTest();
+}
+
+TEST_CASE("Device/directIo", "")
+{
+  DeviceFixture f(false);
+  f.directIoTest(UPS_DEFAULT_PAGE_SIZE, 0);
+}
+
+TEST_CASE("Device/directIoSmallPages", "")
+{
+  DeviceFixture f(false);
+  f.directIoTest(1024, 0);
+}
+
+TEST_CASE("Device/directIoIoUring", "")
+{
+  DeviceFixture f(false);
+  f.directIoTest(UPS_DEFAULT_PAGE_SIZE, UPS_ENABLE_IO_URING);
+}
+
+TEST_CASE("Device/directIoInMemory", "")
+{
+  ups_env_t *env;
+  REQUIRE(UPS_INV_PARAMETER == ups_env_create(&env, 0,
+                          UPS_IN_MEMORY | UPS_DIRECT_IO, 0, 0));
+}
 
 TEST_CASE("Device/inmem/newDelete", "")
 {
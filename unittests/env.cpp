@@ -851,6 +851,218 @@ struct EnvFixture {
     for (int i = 0; i < 10; i++)
       REQUIRE(0 == ups_env_create_db(bf.env, &db[i], (uint16_t)i + 1, 0, 0));
   }
+
+  struct ConcurrentFinder {
+    ConcurrentFinder(ups_db_t *db_, int num_keys_)
+      : db(db_), num_keys(num_keys_), failures(0) {
+    }
+
+    void operator()() {
+      char buffer[300] = {0};
+      for (int loop = 0; loop < 3; loop++) {
+        for (int i = 0; i < num_keys; i++) {
+          // every 10th key is an extended key
+          ::sprintf(buffer, "%08d", i);
+          ups_key_t key = ups_make_key(buffer, (uint16_t)(i % 10 == 0
+                                                ? sizeof(buffer)
+                                                : 9));
+          ups_record_t record = {0};
+          if (ups_db_find(db, 0, &key, &record, 0) != 0
+              || record.size != sizeof(i)
+              || *(int *)record.data != i)
+            failures++;
+        }
+      }
+    }
+
+    ups_db_t *db;
+    int num_keys;
+    int failures;
+  };
+
+  void concurrentReadsTest() {
+    const int kNumKeys = 5000;
+    const int kNumThreads = 4;
+    ups_parameter_t params[] = {
+        { UPS_PARAM_CACHE_SIZE, 64 * 1024 },
+        { 0, 0 }
+    };
+    BaseFixture bf;
+    bf.require_create(m_flags | UPS_ENABLE_CONCURRENT_READS, params);
+    REQUIRE(((LocalDb *)bf.db)->supports_concurrent_reads()
+                == NOTSET(m_flags, UPS_ENABLE_TRANSACTIONS));
+
+    char buffer[300] = {0};
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, (uint16_t)(i % 10 == 0
+                                            ? sizeof(buffer)
+                                            : 9));
+      ups_record_t record = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(bf.db, 0, &key, &record, 0));
+    }
+
+    std::vector<ConcurrentFinder> finders(kNumThreads,
+                    ConcurrentFinder(bf.db, kNumKeys));
+    std::vector<boost::thread *> threads;
+    for (int i = 0; i < kNumThreads; i++)
+      threads.push_back(new boost::thread(boost::ref(finders[i])));
+    for (int i = 0; i < kNumThreads; i++) {
+      threads[i]->join();
+      delete threads[i];
+      REQUIRE(finders[i].failures == 0);
+    }
+
+    // the lookups did not modify the file
+    REQUIRE(0 == ups_db_check_integrity(bf.db, 0));
+  }
+
+  void concurrentReadsCacheLimitTest() {
+    const uint64_t kNumKeys = 50000;
+    const int kNumThreads = 4;
+    ups_parameter_t env_params[] = {
+        { UPS_PARAM_CACHE_SIZE, 256 * 1024 },
+        { 0, 0 }
+    };
+    ups_parameter_t db_params[] = {
+        { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT64 },
+        { UPS_PARAM_RECORD_SIZE, sizeof(uint64_t) },
+        { 0, 0 }
+    };
+    BaseFixture bf;
+    bf.require_create(0, env_params, 0, db_params);
+    for (uint64_t i = 0; i < kNumKeys; i++) {
+      uint64_t k = i * 2;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      ups_record_t record = ups_make_record(&k, sizeof(k));
+      REQUIRE(0 == ups_db_insert(bf.db, 0, &key, &record, 0));
+    }
+    bf.close().require_open(UPS_ENABLE_CONCURRENT_READS, env_params);
+
+    // the lookups only hold the shared lock, but the cache is still purged
+    std::vector<ConcurrentNumericFinder> finders(kNumThreads,
+                    ConcurrentNumericFinder(bf.db, kNumKeys));
+    std::vector<boost::thread *> threads;
+    for (int i = 0; i < kNumThreads; i++)
+      threads.push_back(new boost::thread(boost::ref(finders[i])));
+    for (int i = 0; i < kNumThreads; i++) {
+      threads[i]->join();
+      delete threads[i];
+      REQUIRE(finders[i].failures == 0);
+    }
+
+    // the root page is never purged and can exceed the limit
+    Cache &cache = bf.lenv()->page_manager->state->cache;
+    REQUIRE((cache.current_elements() - 1) * bf.lenv()->config.page_size_bytes
+                <= cache.capacity());
+  }
+
+  struct ConcurrentNumericFinder {
+    ConcurrentNumericFinder(ups_db_t *db_, uint64_t num_keys_)
+      : db(db_), num_keys(num_keys_), failures(0) {
+    }
+
+    void operator()() {
+      for (int loop = 0; loop < 3; loop++) {
+        for (uint64_t i = 0; i < num_keys; i++) {
+          // the even keys are always stored
+          uint64_t k = i * 2;
+          ups_key_t key = ups_make_key(&k, sizeof(k));
+          ups_record_t record = {0};
+          if (ups_db_find(db, 0, &key, &record, 0) != 0
+              || record.size != sizeof(k)
+              || *(uint64_t *)record.data != k)
+            failures++;
+
+          // the odd keys are inserted and erased concurrently; an approx.
+          // match returns the odd key or its even predecessor
+          uint64_t odd = k + 1;
+          key = ups_make_key(&odd, sizeof(odd));
+          if (ups_db_find(db, 0, &key, &record, UPS_FIND_LEQ_MATCH) != 0
+              || (*(uint64_t *)key.data != odd && *(uint64_t *)key.data != k)
+              || *(uint64_t *)record.data != *(uint64_t *)key.data)
+            failures++;
+        }
+      }
+    }
+
+    ups_db_t *db;
+    uint64_t num_keys;
+    int failures;
+  };
+
+  struct ConcurrentNumericWriter {
+    ConcurrentNumericWriter(ups_db_t *db_, uint64_t num_keys_)
+      : db(db_), num_keys(num_keys_), failures(0) {
+    }
+
+    void operator()() {
+      for (int loop = 0; loop < 2; loop++) {
+        for (uint64_t i = 0; i < num_keys; i++) {
+          uint64_t odd = i * 2 + 1;
+          ups_key_t key = ups_make_key(&odd, sizeof(odd));
+          ups_record_t record = ups_make_record(&odd, sizeof(odd));
+          if (ups_db_insert(db, 0, &key, &record, 0) != 0)
+            failures++;
+        }
+        for (uint64_t i = 0; i < num_keys; i++) {
+          uint64_t odd = i * 2 + 1;
+          ups_key_t key = ups_make_key(&odd, sizeof(odd));
+          if (ups_db_erase(db, 0, &key, 0) != 0)
+            failures++;
+        }
+      }
+    }
+
+    ups_db_t *db;
+    uint64_t num_keys;
+    int failures;
+  };
+
+  void concurrentReadsAndWritesTest() {
+    const uint64_t kNumKeys = 20000;
+    const int kNumThreads = 3;
+    ups_parameter_t env_params[] = {
+        { UPS_PARAM_CACHE_SIZE, 256 * 1024 },
+        { 0, 0 }
+    };
+    ups_parameter_t db_params[] = {
+        { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT64 },
+        { UPS_PARAM_RECORD_SIZE, sizeof(uint64_t) },
+        { 0, 0 }
+    };
+    BaseFixture bf;
+    bf.require_create(UPS_ENABLE_CONCURRENT_READS, env_params, 0, db_params);
+    REQUIRE(((LocalDb *)bf.db)->supports_concurrent_writes() == true);
+
+    for (uint64_t i = 0; i < kNumKeys; i++) {
+      uint64_t k = i * 2;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      ups_record_t record = ups_make_record(&k, sizeof(k));
+      REQUIRE(0 == ups_db_insert(bf.db, 0, &key, &record, 0));
+    }
+
+    ConcurrentNumericWriter writer(bf.db, kNumKeys);
+    std::vector<ConcurrentNumericFinder> finders(kNumThreads,
+                    ConcurrentNumericFinder(bf.db, kNumKeys));
+    std::vector<boost::thread *> threads;
+    threads.push_back(new boost::thread(boost::ref(writer)));
+    for (int i = 0; i < kNumThreads; i++)
+      threads.push_back(new boost::thread(boost::ref(finders[i])));
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i]->join();
+      delete threads[i];
+    }
+
+    REQUIRE(writer.failures == 0);
+    for (int i = 0; i < kNumThreads; i++)
+      REQUIRE(finders[i].failures == 0);
+
+    uint64_t count;
+    REQUIRE(0 == ups_db_count(bf.db, 0, 0, &count));
+    REQUIRE(count == kNumKeys);
+    REQUIRE(0 == ups_db_check_integrity(bf.db, 0));
+  }
 };
 
 TEST_CASE("Env/createCloseTest", "")
@@ -859,6 +1071,30 @@ TEST_CASE("Env/createCloseTest", "")
   f.createCloseTest();
 }
 
+TEST_CASE("Env/concurrentReadsTest", "")
+{
+  EnvFixture f;
+  f.concurrentReadsTest();
+}
+
+TEST_CASE("Env/concurrentReadsWithTransactionsTest", "")
+{
+  EnvFixture f(UPS_ENABLE_TRANSACTIONS);
+  f.concurrentReadsTest();
+}
+
+TEST_CASE("Env/concurrentReadsCacheLimitTest", "")
+{
+  EnvFixture f;
+  f.concurrentReadsCacheLimitTest();
+}
+
+TEST_CASE("Env/concurrentReadsAndWritesTest", "")
+{
+  EnvFixture f;
+  f.concurrentReadsAndWritesTest();
+}
+
 TEST_CASE("Env/createCloseOpenCloseTest", "")
 {
   EnvFixture f;
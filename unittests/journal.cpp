@@ -1039,6 +1039,483 @@ struct JournalFixture : BaseFixture {
     require_parameter(params[0].name, params[0].value);
   }
 
+  struct GroupCommitter {
+    GroupCommitter(ups_env_t *env_, ups_db_t *db_, uint32_t first_key_,
+                    int num_txns_)
+      : env(env_), db(db_), first_key(first_key_), num_txns(num_txns_),
+        failures(0) {
+    }
+
+    void operator()() {
+      for (int i = 0; i < num_txns; i++) {
+        uint32_t k = first_key + i;
+        ups_key_t key = ups_make_key(&k, sizeof(k));
+        ups_record_t record = ups_make_record(&k, sizeof(k));
+        ups_txn_t *txn;
+        if (ups_txn_begin(&txn, env, 0, 0, 0) != 0
+            || ups_db_insert(db, txn, &key, &record, 0) != 0
+            || ups_txn_commit(txn, 0) != 0)
+          failures++;
+      }
+    }
+
+    ups_env_t *env;
+    ups_db_t *db;
+    uint32_t first_key;
+    int num_txns;
+    int failures;
+  };
+
+  void groupCommitTest() {
+    const int kNumThreads = 4;
+    const int kNumTxns = 25;
+    ups_parameter_t params[] = {
+        { UPS_PARAM_GROUP_COMMIT_USEC, 50000 },
+        { UPS_PARAM_GROUP_COMMIT_SIZE, kNumThreads },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS | UPS_ENABLE_FSYNC, params, 0, 0);
+    require_parameter(UPS_PARAM_GROUP_COMMIT_USEC, 50000);
+    require_parameter(UPS_PARAM_GROUP_COMMIT_SIZE, kNumThreads);
+
+    std::vector<GroupCommitter> committers;
+    for (int i = 0; i < kNumThreads; i++)
+      committers.push_back(GroupCommitter(env, db, i * 1000, kNumTxns));
+    std::vector<boost::thread *> threads;
+    for (int i = 0; i < kNumThreads; i++)
+      threads.push_back(new boost::thread(boost::ref(committers[i])));
+    for (int i = 0; i < kNumThreads; i++) {
+      threads[i]->join();
+      delete threads[i];
+      REQUIRE(committers[i].failures == 0);
+    }
+
+    // concurrent commits were flushed in groups
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_commit_count
+                    == (uint64_t)(kNumThreads * kNumTxns));
+    REQUIRE(metrics.journal_commit_groups > 0);
+    REQUIRE(metrics.journal_commit_groups < metrics.journal_commit_count);
+    REQUIRE(metrics.journal_commit_max_latency_usec > 0);
+    REQUIRE(metrics.journal_commit_latency_usec
+                    >= metrics.journal_commit_max_latency_usec);
+
+    // all committed transactions are recovered
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    for (int i = 0; i < kNumThreads; i++) {
+      for (int j = 0; j < kNumTxns; j++) {
+        uint32_t k = i * 1000 + j;
+        ups_key_t key = ups_make_key(&k, sizeof(k));
+        ups_record_t record = {0};
+        REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+        REQUIRE(k == *(uint32_t *)record.data);
+      }
+    }
+  }
+
+  uint64_t insertPageDeltaKeys(bool deltas, int num_keys) {
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_PAGE_DELTAS, deltas ? 1u : 0u },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_PAGE_DELTAS, deltas ? 1 : 0);
+
+    char buffer[64] = {0};
+    for (int i = 0; i < num_keys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    if (deltas) {
+      REQUIRE(metrics.journal_page_deltas > 0);
+      REQUIRE(metrics.journal_page_bytes_saved > 0);
+    }
+    else {
+      REQUIRE(metrics.journal_page_deltas == 0);
+      REQUIRE(metrics.journal_page_bytes_saved == 0);
+    }
+    return metrics.journal_bytes_flushed;
+  }
+
+  void pageDeltaTest() {
+    const int kNumKeys = 2000;
+
+    // invalid values are rejected
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_PAGE_DELTAS, 2 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS, params, UPS_INV_PARAMETER);
+
+    uint64_t full_bytes = insertPageDeltaKeys(false, kNumKeys);
+    uint64_t delta_bytes = insertPageDeltaKeys(true, kNumKeys);
+    REQUIRE(delta_bytes < full_bytes);
+
+    // the changesets are replayed: full images, followed by the deltas
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    char buffer[64] = {0};
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(i == *(int *)record.data);
+    }
+    REQUIRE(0 == ups_db_check_integrity(db, 0));
+  }
+
+  void segmentedJournalTest() {
+    const int kNumKeys = 2000;
+    const uint64_t kFileSize = 64 * 1024;
+
+    // invalid values are rejected
+    ups_parameter_t invalid[] = {
+        { UPS_PARAM_JOURNAL_FILES, 1 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS, invalid, UPS_INV_PARAMETER);
+    invalid[0].value = JournalState::kMaxFiles + 1;
+    require_create(UPS_ENABLE_TRANSACTIONS, invalid, UPS_INV_PARAMETER);
+
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_FILES, 4 },
+        { UPS_PARAM_JOURNAL_FILE_SIZE, kFileSize },
+        { 0, 0 }
+    };
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_FILES, 4);
+    require_parameter(UPS_PARAM_JOURNAL_FILE_SIZE, kFileSize);
+    REQUIRE(lenv()->journal->state.files.size() == 4);
+
+    char buffer[64] = {0};
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+
+    // the files were reused
+    REQUIRE(lenv()->journal->state.next_sequence > 5);
+
+    // the files are preallocated
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    const char *filenames[] = {
+        "test.db.jrn0", "test.db.jrn1", "test.db.jrn2", "test.db.jrn3"
+    };
+    for (int i = 0; i < 4; i++) {
+      File f;
+      f.open(filenames[i], 0);
+      REQUIRE(f.file_size() >= kFileSize);
+      f.close();
+    }
+
+    // recovery detects the segmented journal, even without the parameters
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    REQUIRE(lenv()->journal->state.files.size() == 4);
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(i == *(int *)record.data);
+    }
+    REQUIRE(0 == ups_db_check_integrity(db, 0));
+  }
+
+  void segmentedJournalTagTest() {
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_FILES, 2 },
+        { UPS_PARAM_JOURNAL_FILE_SIZE, 64 * 1024 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS, params, 0, 0);
+    JournalState &state = lenv()->journal->state;
+    File &file = state.files[state.current_fd];
+
+    // a stale entry from a previous use of the file, which is then reused
+    // with a sequence number that has the same lower 16 bits
+    const uint64_t kStale = 1;
+    const uint64_t kCurrent = kStale + 0x10000;
+    struct TaggedEntry {
+      PJournalEntry entry;
+      PJournalEntryTag tag;
+    } entries[2];
+    REQUIRE(sizeof(entries[0]) == 40u);
+    entries[0].entry.lsn = 10;
+    entries[0].entry.txn_id = 1;
+    entries[0].entry.type = Journal::kEntryTypeTxnBegin;
+    entries[0].tag.sequence = kCurrent;
+    entries[1] = entries[0];
+    entries[1].entry.lsn = 5;
+    entries[1].tag.sequence = kStale;
+    PJournalFileHeader header(kCurrent);
+    file.pwrite(0, &header, sizeof(header));
+    file.pwrite(sizeof(header), &entries[0], sizeof(entries));
+
+    // only the current entry is read
+    Journal::Iterator iter;
+    PJournalEntry entry;
+    ByteArray auxbuffer;
+    lenv()->journal->test_read_entry(&iter, &entry, &auxbuffer);
+    REQUIRE(entry.lsn == 10u);
+    lenv()->journal->test_read_entry(&iter, &entry, &auxbuffer);
+    REQUIRE(entry.lsn == 0u);
+  }
+
+  void checkpointTest() {
+    const int kNumKeys = 2000;
+
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, 16 * 1024 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_CHECKPOINT_INTERVAL, 16 * 1024);
+
+    char buffer[64] = {0};
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_checkpoints > 0);
+
+    // the recovery only redoes the pages after the newest checkpoint
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY);
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_recovery_skipped_pages > 0);
+
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(i == *(int *)record.data);
+    }
+    REQUIRE(0 == ups_db_check_integrity(db, 0));
+  }
+
+  void insertCommitted(int first, int count) {
+    for (int i = first; i < first + count; i++) {
+      ups_txn_t *txn;
+      REQUIRE(0 == ups_txn_begin(&txn, env, 0, 0, 0));
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t record = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, txn, &key, &record, 0));
+      REQUIRE(0 == ups_txn_commit(txn, 0));
+    }
+  }
+
+  uint64_t getParameter(uint32_t name) {
+    ups_parameter_t params[] = {
+        { name, 0 },
+        { 0, 0 }
+    };
+    REQUIRE(0 == ups_env_get_parameters(env, params));
+    return params[0].value;
+  }
+
+  void asyncCommitTest() {
+    ups_parameter_t params[] = {
+        { UPS_PARAM_JOURNAL_SYNC_MSEC, 50 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS | UPS_ENABLE_FSYNC, params, 0, 0);
+    require_parameter(UPS_PARAM_JOURNAL_SYNC_MSEC, 50);
+    REQUIRE(UPS_INV_PARAMETER == ups_env_wait_for_commit(0, 0));
+
+    // commits return before they are durable; wait for the most recent one
+    insertCommitted(0, 20);
+    uint64_t commit_lsn = getParameter(UPS_PARAM_JOURNAL_COMMIT_LSN);
+    REQUIRE(commit_lsn > 0);
+    REQUIRE(0 == ups_env_wait_for_commit(env, 0));
+    REQUIRE(getParameter(UPS_PARAM_JOURNAL_DURABLE_LSN) >= commit_lsn);
+
+    // the background thread syncs the journal as well
+    insertCommitted(20, 20);
+    commit_lsn = getParameter(UPS_PARAM_JOURNAL_COMMIT_LSN);
+    for (int i = 0; i < 100; i++) {
+      if (getParameter(UPS_PARAM_JOURNAL_DURABLE_LSN) >= commit_lsn)
+        break;
+      boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    }
+    REQUIRE(getParameter(UPS_PARAM_JOURNAL_DURABLE_LSN) >= commit_lsn);
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_commit_count == 40ull);
+
+    // all durable transactions are recovered
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, params);
+    for (int i = 0; i < 40; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t record = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(i == *(int *)record.data);
+    }
+  }
+
+  void parallelRedoTest() {
+    const int kNumKeys = 2000;
+
+    // the page deltas must be applied in order
+    ups_parameter_t params[] = {
+        { UPS_PARAM_WORKER_THREADS, 4 },
+        { UPS_PARAM_JOURNAL_PAGE_DELTAS, 1 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY, params, 0, 0);
+
+    char buffer[64] = {0};
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_db_insert(db, 0, &key, &record, 0));
+    }
+
+    // the pages are redone by the worker threads
+    close(UPS_AUTO_CLEANUP | UPS_DONT_CLEAR_LOG);
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, params);
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_recovery_pages > 0);
+    REQUIRE(metrics.journal_recovery_usec > 0);
+
+    for (int i = 0; i < kNumKeys; i++) {
+      ::sprintf(buffer, "%08d", i);
+      ups_key_t key = ups_make_key(buffer, sizeof(buffer));
+      ups_record_t record = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &record, 0));
+      REQUIRE(i == *(int *)record.data);
+    }
+    REQUIRE(0 == ups_db_check_integrity(db, 0));
+  }
+
+  void parallelReplayTest() {
+#ifndef WIN32
+    const int kNumDbs = 4;
+    const int kNumKeys = 300;
+
+    ups_parameter_t params[] = {
+        { UPS_PARAM_WORKER_THREADS, 4 },
+        { 0, 0 }
+    };
+
+    // the committed Txns are only written to the journal
+    close();
+    require_create(UPS_DONT_FLUSH_TRANSACTIONS | UPS_ENABLE_TRANSACTIONS,
+                    params, 0, 0);
+    ups_db_t *dbs[kNumDbs] = {db};
+    for (int d = 1; d < kNumDbs; d++)
+      REQUIRE(0 == ups_env_create_db(env, &dbs[d], d + 1, 0, 0));
+
+    // mix Txns and non-transactional operations in all databases;
+    // every third key is erased again
+    for (int i = 0; i < kNumKeys; i++) {
+      for (int d = 0; d < kNumDbs; d++) {
+        ups_key_t key = ups_make_key(&i, sizeof(i));
+        ups_record_t record = ups_make_record(&d, sizeof(d));
+        if (i % 2) {
+          REQUIRE(0 == ups_db_insert(dbs[d], 0, &key, &record, 0));
+        }
+        else {
+          TxnProxy tp(env, nullptr, true);
+          REQUIRE(0 == ups_db_insert(dbs[d], tp.txn, &key, &record, 0));
+        }
+        if (i % 3 == 0)
+          REQUIRE(0 == ups_db_erase(dbs[d], 0, &key, 0));
+      }
+    }
+
+    // a committed Txn which spans all databases, and an aborted one
+    int i = kNumKeys;
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    {
+      TxnProxy tp(env, nullptr, true);
+      for (int d = 0; d < kNumDbs; d++) {
+        ups_record_t record = ups_make_record(&d, sizeof(d));
+        REQUIRE(0 == ups_db_insert(dbs[d], tp.txn, &key, &record, 0));
+      }
+    }
+    int j = kNumKeys + 1;
+    ups_key_t aborted_key = ups_make_key(&j, sizeof(j));
+    {
+      TxnProxy tp(env);
+      for (int d = 0; d < kNumDbs; d++) {
+        ups_record_t record = ups_make_record(&d, sizeof(d));
+        REQUIRE(0 == ups_db_insert(dbs[d], tp.txn, &aborted_key,
+                                &record, 0));
+      }
+      tp.abort();
+    }
+
+    // the operations are staged by the worker threads
+    backup();
+    close(UPS_AUTO_CLEANUP);
+    restore();
+    require_open(UPS_ENABLE_TRANSACTIONS | UPS_AUTO_RECOVERY, params);
+
+    ups_env_metrics_t metrics;
+    REQUIRE(0 == ups_env_get_metrics(env, &metrics));
+    REQUIRE(metrics.journal_recovery_operations > 0);
+    REQUIRE(metrics.journal_recovery_parallel_operations > 0);
+
+    dbs[0] = db;
+    for (int d = 1; d < kNumDbs; d++)
+      REQUIRE(0 == ups_env_open_db(env, &dbs[d], d + 1, 0, 0));
+
+    for (int d = 0; d < kNumDbs; d++) {
+      ups_record_t record = {0};
+      for (int k = 0; k < kNumKeys; k++) {
+        ups_key_t key2 = ups_make_key(&k, sizeof(k));
+        if (k % 3 == 0) {
+          REQUIRE(UPS_KEY_NOT_FOUND == ups_db_find(dbs[d], 0, &key2,
+                                  &record, 0));
+          continue;
+        }
+        REQUIRE(0 == ups_db_find(dbs[d], 0, &key2, &record, 0));
+        REQUIRE(d == *(int *)record.data);
+      }
+      REQUIRE(0 == ups_db_find(dbs[d], 0, &key, &record, 0));
+      REQUIRE(d == *(int *)record.data);
+      REQUIRE(UPS_KEY_NOT_FOUND == ups_db_find(dbs[d], 0, &aborted_key,
+                              &record, 0));
+      REQUIRE(0 == ups_db_check_integrity(dbs[d], 0));
+    }
+#endif
+  }
+
   void issue45Test() {
     // create a transaction with one insert
     TxnProxy tp(env);
@@ -1259,6 +1736,54 @@ TEST_CASE("Journal/switchThresholdTest", "")
   f.switchThresholdTest();
 }
 
+TEST_CASE("Journal/groupCommitTest", "")
+{
+  JournalFixture f;
+  f.groupCommitTest();
+}
+
+TEST_CASE("Journal/pageDeltaTest", "")
+{
+  JournalFixture f;
+  f.pageDeltaTest();
+}
+
+TEST_CASE("Journal/segmentedJournalTest", "")
+{
+  JournalFixture f;
+  f.segmentedJournalTest();
+}
+
+TEST_CASE("Journal/segmentedJournalTagTest", "")
+{
+  JournalFixture f;
+  f.segmentedJournalTagTest();
+}
+
+TEST_CASE("Journal/checkpointTest", "")
+{
+  JournalFixture f;
+  f.checkpointTest();
+}
+
+TEST_CASE("Journal/asyncCommitTest", "")
+{
+  JournalFixture f;
+  f.asyncCommitTest();
+}
+
+TEST_CASE("Journal/parallelRedoTest", "")
+{
+  JournalFixture f;
+  f.parallelRedoTest();
+}
+
+TEST_CASE("Journal/parallelReplayTest", "")
+{
+  JournalFixture f;
+  f.parallelReplayTest();
+}
+
 TEST_CASE("Journal/issue45Test", "")
 {
   JournalFixture f;
@@ -226,13 +226,259 @@ struct PageManagerFixture : BaseFixture {
     REQUIRE(false == page_manager->state->cache.is_cache_full());
   }
 
+  void cachePolicyParameterTest() {
+    ups_parameter_t param[] = {
+        { UPS_PARAM_CACHE_POLICY, UPS_CACHE_POLICY_2Q },
+        { 0, 0 }
+    };
+
+    close();
+    require_create(0, param)
+      .require_parameter(UPS_PARAM_CACHE_POLICY, UPS_CACHE_POLICY_2Q);
+
+    close();
+    require_open(0, param)
+      .require_parameter(UPS_PARAM_CACHE_POLICY, UPS_CACHE_POLICY_2Q);
+
+    param[0].value = 99;
+    close();
+    require_open(0, param, UPS_INV_PARAMETER);
+  }
+
+  void cache2QScanResistanceTest() {
+    EnvConfig config;
+    config.cache_policy = UPS_CACHE_POLICY_2Q;
+    config.cache_size_bytes = 8 * config.page_size_bytes;
+    Cache cache(config);
+
+    const int kPages = 64;
+    std::vector<PPageData> pers(kPages);
+    std::vector<Page *> pages(kPages);
+    for (int i = 0; i < kPages; i++) {
+      ::memset(&pers[i], 0, sizeof(pers[i]));
+      pages[i] = new Page(lenv()->device.get());
+      pages[i]->set_address((i + 1) * config.page_size_bytes);
+      pages[i]->set_data(&pers[i]);
+    }
+
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+
+    // the "hot" pages 0..3 are fetched, evicted and fetched again;
+    // afterwards they are managed in the LRU list
+    for (int i = 0; i < 4; i++) {
+      cache.put(pages[i]);
+      cache.evict(pages[i]);
+      cache.put(pages[i]);
+    }
+    REQUIRE(4u == cache.state.shards[0].totallist.size());
+    REQUIRE(0u == cache.state.shards[0].a1list.size());
+
+    // now "scan" the remaining pages; each page is accessed only once
+    for (int i = 4; i < kPages; i++) {
+      cache.put(pages[i]);
+      REQUIRE(pages[i] == cache.get(pages[i]->address()));
+
+      garbage.clear();
+      cache.purge_candidates(candidates, garbage, 0);
+      for (size_t j = 0; j < garbage.size(); j++)
+        cache.evict(garbage[j]);
+    }
+
+    // the hot pages must have survived the scan
+    REQUIRE(candidates.empty());
+    for (int i = 0; i < 4; i++)
+      REQUIRE(pages[i] == cache.get(pages[i]->address()));
+    REQUIRE(8u == cache.current_elements());
+
+    for (int i = 0; i < kPages; i++) {
+      cache.del(pages[i]);
+      pages[i]->set_data(0);
+      delete pages[i];
+    }
+    REQUIRE(0u == cache.current_elements());
+  }
+  void cache2QDeleteIsNotEvictionTest() {
+    EnvConfig config;
+    config.cache_policy = UPS_CACHE_POLICY_2Q;
+    config.cache_size_bytes = 8 * config.page_size_bytes;
+    Cache cache(config);
+
+    PPageData pers[2];
+    Page *pages[2];
+    for (int i = 0; i < 2; i++) {
+      ::memset(&pers[i], 0, sizeof(pers[i]));
+      pages[i] = new Page(lenv()->device.get());
+      pages[i]->set_address((i + 1) * config.page_size_bytes);
+      pages[i]->set_data(&pers[i]);
+    }
+
+    // an explicitly deleted page is not remembered; if it is stored again
+    // then it starts in the FIFO queue
+    cache.put(pages[0]);
+    cache.del(pages[0]);
+    REQUIRE(0u == cache.state.shards[0].ghostlist.size());
+    cache.put(pages[0]);
+    REQUIRE(0u == cache.state.shards[0].totallist.size());
+    REQUIRE(1u == cache.state.shards[0].a1list.size());
+
+    // an evicted page is remembered, but forget() drops its address (i.e.
+    // because the page was freed and is now reused)
+    cache.put(pages[1]);
+    cache.evict(pages[1]);
+    REQUIRE(1u == cache.state.shards[0].ghostlist.size());
+    cache.forget(pages[1]->address());
+    REQUIRE(0u == cache.state.shards[0].ghostlist.size());
+    cache.put(pages[1]);
+    REQUIRE(2u == cache.state.shards[0].a1list.size());
+
+    for (int i = 0; i < 2; i++) {
+      cache.del(pages[i]);
+      pages[i]->set_data(0);
+      delete pages[i];
+    }
+    REQUIRE(0u == cache.current_elements());
+  }
+
+
+  void cacheClockSecondChanceTest() {
+    EnvConfig config;
+    config.cache_policy = UPS_CACHE_POLICY_CLOCK;
+    config.cache_size_bytes = 4 * config.page_size_bytes;
+    Cache cache(config);
+
+    const int kPages = 8;
+    std::vector<PPageData> pers(kPages);
+    std::vector<Page *> pages(kPages);
+    for (int i = 0; i < kPages; i++) {
+      ::memset(&pers[i], 0, sizeof(pers[i]));
+      pages[i] = new Page(lenv()->device.get());
+      pages[i]->set_address((i + 1) * config.page_size_bytes);
+      pages[i]->set_data(&pers[i]);
+      cache.put(pages[i]);
+    }
+
+    // a hit does not reorder the list, it only sets the reference bit
+    REQUIRE(pages[0] == cache.get(pages[0]->address()));
+    REQUIRE(pages[0] == cache.state.shards[0].totallist.tail());
+    REQUIRE(true == pages[0]->cache_referenced);
+
+    // peek() does not modify the reference bit
+    REQUIRE(pages[1] == cache.peek(pages[1]->address()));
+    REQUIRE(false == pages[1]->cache_referenced);
+
+    // the referenced page gets a second chance and survives the purge
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(4u == garbage.size());
+    for (size_t i = 0; i < garbage.size(); i++) {
+      REQUIRE(garbage[i] != pages[0]);
+      cache.del(garbage[i]);
+    }
+    REQUIRE(false == pages[0]->cache_referenced);
+    REQUIRE(pages[0] == cache.peek(pages[0]->address()));
+    REQUIRE(pages[0] == cache.state.shards[0].totallist.head());
+
+    for (int i = 0; i < kPages; i++) {
+      cache.del(pages[i]);
+      pages[i]->set_data(0);
+      delete pages[i];
+    }
+    REQUIRE(0u == cache.current_elements());
+  }
+
+  void cacheShardsTest() {
+    EnvConfig config;
+    config.cache_shards = 8;
+    config.cache_size_bytes = 16 * config.page_size_bytes;
+    Cache cache(config);
+    REQUIRE(8u == cache.state.shards.size());
+
+    const int kPages = 64;
+    std::vector<PPageData> pers(kPages);
+    std::vector<Page *> pages(kPages);
+    for (int i = 0; i < kPages; i++) {
+      ::memset(&pers[i], 0, sizeof(pers[i]));
+      pages[i] = new Page(lenv()->device.get());
+      pages[i]->set_address((i + 1) * config.page_size_bytes);
+      pages[i]->set_data(&pers[i]);
+      cache.put(pages[i]);
+    }
+
+    // the pages are distributed over several shards
+    size_t used_shards = 0;
+    for (size_t i = 0; i < cache.state.shards.size(); i++)
+      if (cache.state.shards[i].totallist.size() > 0)
+        used_shards++;
+    REQUIRE(used_shards > 1);
+
+    REQUIRE((size_t)kPages == cache.current_elements());
+    REQUIRE(true == cache.is_cache_full());
+    for (int i = 0; i < kPages; i++)
+      REQUIRE(pages[i] == cache.get(pages[i]->address()));
+
+    std::vector<uint64_t> candidates;
+    std::vector<Page *> garbage;
+    cache.purge_candidates(candidates, garbage, 0);
+    REQUIRE(garbage.size() >= (size_t)kPages - 16);
+    for (size_t i = 0; i < garbage.size(); i++)
+      cache.del(garbage[i]);
+    REQUIRE(false == cache.is_cache_full());
+
+    ups_env_metrics_t metrics = {0};
+    cache.fill_metrics(&metrics);
+    REQUIRE((uint64_t)kPages == metrics.cache_hits);
+
+    for (int i = 0; i < kPages; i++) {
+      if (cache.peek(pages[i]->address()))
+        cache.del(pages[i]);
+      pages[i]->set_data(0);
+      delete pages[i];
+    }
+    REQUIRE(0u == cache.current_elements());
+  }
+
+  void workerThreadsTest() {
+    ups_parameter_t bad[] = {
+        { UPS_PARAM_WORKER_THREADS, 0 },
+        { 0, 0 }
+    };
+    close();
+    require_create(0, bad, UPS_INV_PARAMETER);
+    bad[0].value = 65;
+    require_create(0, bad, UPS_INV_PARAMETER);
+
+    ups_parameter_t params[] = {
+        { UPS_PARAM_WORKER_THREADS, 4 },
+        { UPS_PARAM_CACHE_SIZE, 16 * UPS_DEFAULT_PAGE_SIZE },
+        { 0, 0 }
+    };
+    require_create(0, params);
+    require_parameter(UPS_PARAM_WORKER_THREADS, 4);
+    REQUIRE(4u == lenv()->page_manager->state->worker->size());
+
+    // fill the (small) cache; the dirty pages are purged by all threads
+    std::vector<uint8_t> record(512, 'x');
+    DbProxy dbp(db);
+    for (uint32_t i = 0; i < 10000; i++)
+      dbp.require_insert(i, record);
+
+    close();
+    require_open(0, params);
+    dbp = DbProxy(db);
+    for (uint32_t i = 0; i < 10000; i++)
+      dbp.require_find(i, record);
+    require_parameter(UPS_PARAM_WORKER_THREADS, 4);
+  }
+
   void storeStateTest() {
     PageManagerState *state = lenv()->page_manager->state.get();
     uint32_t page_size = lenv()->config.page_size_bytes;
 
     // fill with freelist pages and blob pages
     for (int i = 0; i < 10; i++)
-      state->freelist.free_pages[page_size * (i + 100)] = 1;
+      state->freelist.put(page_size * (i + 100), 1);
 
     state->needs_flush = true;
     REQUIRE(lenv()->page_manager->test_store_state() == page_size * 2);
@@ -258,9 +504,9 @@ struct PageManagerFixture : BaseFixture {
     // written AFTER the allocated pages, and disable the reclaim
     page_manager->state->needs_flush = true;
     // pretend there is data to write, otherwise test_store_state() is a nop
-    page_manager->state->freelist.free_pages[page_size] = 0;
+    page_manager->state->freelist.put(page_size, 1);
     page_manager->test_store_state();
-    page_manager->state->freelist.free_pages.clear(); // clean up again
+    page_manager->state->freelist.clear(); // clean up again
 
     // allocate 5 pages
     for (int i = 0; i < 5; i++) {
@@ -329,20 +575,73 @@ struct PageManagerFixture : BaseFixture {
     uint32_t page_size = lenv()->config.page_size_bytes;
 
     for (int i = 1; i <= 150; i++)
-      page_manager->state->freelist.free_pages[page_size * i] = 1;
+      page_manager->state->freelist.put(page_size * i, 1);
+
+    // the pages are merged into a single extent
+    REQUIRE(1 == page_manager->state->freelist.free_pages.size());
+    REQUIRE(150 == page_manager->state->freelist.free_pages[page_size]);
 
     // store the state on disk
     page_manager->state->needs_flush = true;
     uint64_t page_id = page_manager->test_store_state();
 
     page_manager->flush_all_pages();
-    page_manager->state->freelist.free_pages.clear();
+    page_manager->state->freelist.clear();
 
     page_manager->initialize(page_id);
 
-    REQUIRE(10 == page_manager->state->freelist.free_pages.size());
-    for (int i = 1; i < 10; i++)
-      REQUIRE(page_manager->state->freelist.free_pages[page_size * (1 + i * 15)] == 15);
+    // the extent is stored in chunks of 15 pages, and merged again when
+    // it is loaded
+    REQUIRE(1 == page_manager->state->freelist.free_pages.size());
+    REQUIRE(150 == page_manager->state->freelist.free_pages[page_size]);
+    REQUIRE(1 == page_manager->state->freelist.free_extents.size());
+  }
+
+  void freelistExtentTest() {
+    EnvConfig config;
+    uint32_t page_size = config.page_size_bytes;
+    Freelist freelist(config);
+
+    // three extents: 10 pages at 100, 3 pages at 200, 1 page at 300
+    for (int i = 0; i < 10; i++)
+      freelist.put(page_size * (100 + i), 1);
+    freelist.put(page_size * 200, 2);
+    freelist.put(page_size * 202, 1);
+    freelist.put(page_size * 300, 1);
+    REQUIRE(3u == freelist.free_pages.size());
+    REQUIRE(3u == freelist.free_extents.size());
+    REQUIRE(10u == freelist.free_pages[page_size * 100]);
+    REQUIRE(3u == freelist.free_pages[page_size * 200]);
+    REQUIRE(true == freelist.has(page_size * 105));
+    REQUIRE(false == freelist.has(page_size * 110));
+
+    // best fit: the smallest extent which is large enough
+    REQUIRE(page_size * 300 == freelist.alloc(1));
+    REQUIRE(page_size * 200 == freelist.alloc(2));
+    REQUIRE(page_size * 202 == freelist.alloc(1));
+    REQUIRE(page_size * 100 == freelist.alloc(4));
+    REQUIRE(6u == freelist.free_pages[page_size * 104]);
+    REQUIRE(0u == freelist.alloc(7));
+    REQUIRE(1u == freelist.freelist_misses);
+
+    // pages on both sides of a gap are merged with the gap
+    freelist.put(page_size * 98, 1);
+    freelist.put(page_size * 100, 4);
+    REQUIRE(2u == freelist.free_pages.size());
+    freelist.put(page_size * 99, 1);
+    REQUIRE(1u == freelist.free_pages.size());
+    REQUIRE(1u == freelist.free_extents.size());
+    REQUIRE(12u == freelist.free_pages[page_size * 98]);
+    REQUIRE(page_size * 98 == freelist.alloc(12));
+    REQUIRE(true == freelist.empty());
+    REQUIRE(true == freelist.free_extents.empty());
+
+    // the extent at the end of the file is truncated
+    freelist.put(page_size * 10, 1);
+    freelist.put(page_size * 20, 5);
+    REQUIRE(page_size * 20 == freelist.truncate(page_size * 25));
+    REQUIRE(1u == freelist.free_pages.size());
+    REQUIRE(1u == freelist.free_extents.size());
   }
 
   void encodeDecodeTest() {
@@ -362,7 +661,7 @@ struct PageManagerFixture : BaseFixture {
 
     for (int i = 1; i <= 30000; i++) {
       if (i & 1) // only store every 2nd page to avoid collapsing
-        page_manager->state->freelist.free_pages[page_size * i] = 1;
+        page_manager->state->freelist.put(page_size * i, 1);
     }
 
     // store the state on disk
@@ -370,7 +669,7 @@ struct PageManagerFixture : BaseFixture {
     uint64_t page_id = page_manager->test_store_state();
 
     page_manager->flush_all_pages();
-    page_manager->state->freelist.free_pages.clear();
+    page_manager->state->freelist.clear();
     page_manager->state->last_blob_page_id = 0;
 
     page_manager->initialize(page_id);
@@ -466,6 +765,42 @@ TEST_CASE("PageManager/cacheFullTest", "")
   f.cacheFullTest();
 }
 
+TEST_CASE("PageManager/cachePolicyParameterTest", "")
+{
+  PageManagerFixture f;
+  f.cachePolicyParameterTest();
+}
+
+TEST_CASE("PageManager/cache2QScanResistanceTest", "")
+{
+  PageManagerFixture f;
+  f.cache2QScanResistanceTest();
+}
+
+TEST_CASE("PageManager/cache2QDeleteIsNotEvictionTest", "")
+{
+  PageManagerFixture f;
+  f.cache2QDeleteIsNotEvictionTest();
+}
+
+TEST_CASE("PageManager/cacheClockSecondChanceTest", "")
+{
+  PageManagerFixture f;
+  f.cacheClockSecondChanceTest();
+}
+
+TEST_CASE("PageManager/cacheShardsTest", "")
+{
+  PageManagerFixture f;
+  f.cacheShardsTest();
+}
+
+TEST_CASE("PageManager/workerThreadsTest", "")
+{
+  PageManagerFixture f;
+  f.workerThreadsTest();
+}
+
 TEST_CASE("PageManager/storeStateTest", "")
 {
   PageManagerFixture f(false, 16 * UPS_DEFAULT_PAGE_SIZE);
@@ -490,6 +825,12 @@ TEST_CASE("PageManager/collapseFreelistTest", "")
   f.collapseFreelistTest();
 }
 
+TEST_CASE("PageManager/freelistExtentTest", "")
+{
+  PageManagerFixture f(false);
+  f.freelistExtentTest();
+}
+
 TEST_CASE("PageManager/encodeDecodeTest", "")
 {
   PageManagerFixture f(false);
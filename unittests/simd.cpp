@@ -20,8 +20,12 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include "1os/os.h"
 #include "2simd/simd.h"
+#include <algorithm>
 #include <array>
+#include <limits>
+#include <vector>
 
 using namespace upscaledb;
 
@@ -68,4 +72,105 @@ TEST_CASE("Simd/doubleSseTest", "")
   test_linear_search_sse<double, 4>();
 }
 
+#ifdef HAVE_SSE2
+
+template<typename T>
+static inline T
+make_key(uint64_t r)
+{
+  return (T)r;
+}
+
+template<>
+inline float
+make_key<float>(uint64_t r)
+{
+  return (float)((int64_t)(r % 2000000) - 1000000) / 16.f;
+}
+
+template<>
+inline double
+make_key<double>(uint64_t r)
+{
+  return (double)((int64_t)(r % 2000000) - 1000000) / 16.;
+}
+
+// Compares |lower_bound| with std::lower_bound for random sorted arrays
+// of various lengths, with and without duplicates
+template<typename T>
+static inline void
+test_lower_bound(int (*lower_bound)(const T *, int, T))
+{
+  uint64_t seed = 0x2545f4914f6cdd1dull;
+  for (int count = 0; count <= 300; count++) {
+    std::vector<T> values(count + 1);
+    uint64_t range = count % 3 == 0 ? 16 : ~0ull;
+    for (int i = 0; i < count; i++) {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      values[i] = make_key<T>((seed >> 11) % range);
+    }
+    std::sort(values.begin(), values.begin() + count);
+
+    std::vector<T> probes;
+    probes.push_back((T)0);
+    probes.push_back(std::numeric_limits<T>::max());
+    probes.push_back(std::numeric_limits<T>::lowest());
+    for (int i = 0; i < count; i++) {
+      probes.push_back(values[i]);
+      probes.push_back(values[i] + 1);
+      probes.push_back(values[i] - 1);
+    }
+
+    for (size_t i = 0; i < probes.size(); i++) {
+      int expected = (int)(std::lower_bound(values.begin(),
+                            values.begin() + count, probes[i])
+                        - values.begin());
+      REQUIRE(expected == lower_bound(&values[0], count, probes[i]));
+    }
+  }
+}
+
+template<typename T>
+static inline void
+test_lower_bound_kernels()
+{
+  if (os_has_avx2())
+    test_lower_bound<T>(lower_bound_avx2);
+  if (os_has_avx512())
+    test_lower_bound<T>(lower_bound_avx512);
+  test_lower_bound<T>(find_lower_bound_simd<T>);
+}
+
+TEST_CASE("Simd/uint8LowerBoundTest")
+{
+  test_lower_bound_kernels<uint8_t>();
+}
+
+TEST_CASE("Simd/uint16LowerBoundTest")
+{
+  test_lower_bound_kernels<uint16_t>();
+}
+
+TEST_CASE("Simd/uint32LowerBoundTest")
+{
+  test_lower_bound_kernels<uint32_t>();
+}
+
+TEST_CASE("Simd/uint64LowerBoundTest")
+{
+  test_lower_bound_kernels<uint64_t>();
+}
+
+TEST_CASE("Simd/floatLowerBoundTest")
+{
+  test_lower_bound_kernels<float>();
+}
+
+TEST_CASE("Simd/doubleLowerBoundTest")
+{
+  test_lower_bound_kernels<double>();
+}
+
+#endif // HAVE_SSE2
+
 #endif // __SSE__
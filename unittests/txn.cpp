@@ -19,6 +19,8 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <algorithm>
+
 #include <ups/upscaledb.h>
 
 #include "4db/db_local.h"
@@ -109,9 +111,9 @@ struct TxnFixture : BaseFixture {
 
     // clean up
     ldb()->txn_index->remove(node1);
-    delete node1;
+    ldb()->txn_index->release_node(node1);
     ldb()->txn_index->remove(node2);
-    delete node2;
+    ldb()->txn_index->release_node(node2);
   }
 
   void txnMultipleNodesTest() {
@@ -128,11 +130,11 @@ struct TxnFixture : BaseFixture {
 
     // clean up
     ldb()->txn_index->remove(node1);
-    delete node1;
+    ldb()->txn_index->release_node(node1);
     ldb()->txn_index->remove(node2);
-    delete node2;
+    ldb()->txn_index->release_node(node2);
     ldb()->txn_index->remove(node3);
-    delete node3;
+    ldb()->txn_index->release_node(node3);
   }
 
   void txnMultipleOpsTest() {
@@ -153,6 +155,113 @@ struct TxnFixture : BaseFixture {
     REQUIRE(op3 != nullptr);
   }
 
+  void arenaTest() {
+    std::vector<uint8_t> large(ArenaAllocator::kMaxBumpSize + 1);
+    LocalTxnManager *ltm = (LocalTxnManager *)lenv()->txn_manager.get();
+
+    // the operations are allocated in the arena of the Txn
+    TxnProxy txnp(env);
+    for (int i = 0; i < 1000; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(&i, sizeof(i));
+      if (i % 100 == 0)
+        rec = ups_make_record(large.data(), (uint32_t)large.size());
+      REQUIRE(0 == ups_db_insert(db, txnp.txn, &key, &rec, 0));
+    }
+    LocalTxn *ltxn = txnp.ltxn();
+    REQUIRE(ltxn->arena.chunks != nullptr);
+    REQUIRE(ltxn->arena.large_chunks != nullptr);
+    REQUIRE(ltxn->arena.allocated_bytes > 1000 * sizeof(TxnOperation));
+    uint64_t node_bytes = ldb()->txn_index->node_arena.allocated_bytes;
+    REQUIRE(node_bytes >= 1000 * sizeof(TxnNode));
+
+    // the abort releases the memory at once; the chunks are pooled, the
+    // nodes are recycled
+    txnp.abort();
+    REQUIRE(ldb()->txn_index->first() == nullptr);
+    REQUIRE(ldb()->txn_index->free_nodes != nullptr);
+    size_t pooled = ltm->arena_pool.chunks.size();
+    REQUIRE(pooled > 0);
+
+    TxnProxy txnp2(env);
+    int i = 1;
+    ups_key_t key = ups_make_key(&i, sizeof(i));
+    ups_record_t rec = ups_make_record(&i, sizeof(i));
+    REQUIRE(0 == ups_db_insert(db, txnp2.txn, &key, &rec, 0));
+    REQUIRE(ltm->arena_pool.chunks.size() == pooled - 1);
+    REQUIRE(ldb()->txn_index->node_arena.allocated_bytes == node_bytes);
+    REQUIRE(0 == ups_db_find(db, txnp2.txn, &key, &rec, 0));
+    REQUIRE(i == *(int *)rec.data);
+  }
+
+  void skiplistTest() {
+    const int kNumKeys = 2000;
+    ups_parameter_t params[] = {
+        { UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT32 },
+        { 0, 0 }
+    };
+    close();
+    require_create(UPS_ENABLE_TRANSACTIONS, 0, 0, params);
+    TxnIndex *index = ldb()->txn_index.get();
+    std::vector<uint32_t> keys;
+    for (int i = 0; i < kNumKeys; i++)
+      keys.push_back(i * 2);
+    std::random_shuffle(keys.begin(), keys.end());
+
+    // store the (even) keys in random order
+    TxnProxy txnp(env);
+    bool node_created;
+    for (int i = 0; i < kNumKeys; i++) {
+      ups_key_t key = ups_make_key(&keys[i], sizeof(uint32_t));
+      REQUIRE(index->store(&key, &node_created) != nullptr);
+      REQUIRE(node_created == true);
+      ups_record_t rec = {0};
+      index->get(&key, 0)->append(txnp.ltxn(), 0, TxnOperation::kInsert,
+                      i + 1, &key, &rec);
+    }
+    ups_key_t key = ups_make_key(&keys[0], sizeof(uint32_t));
+    index->store(&key, &node_created);
+    REQUIRE(node_created == false);
+
+    // the nodes are sorted in both directions
+    int count = 0;
+    for (TxnNode *node = index->first(); node; node = node->next_sibling())
+      REQUIRE(*(uint32_t *)node->key()->data == (uint32_t)count++ * 2);
+    REQUIRE(count == kNumKeys);
+    for (TxnNode *node = index->last(); node;
+                    node = node->previous_sibling())
+      REQUIRE(*(uint32_t *)node->key()->data == (uint32_t)--count * 2);
+    REQUIRE(count == 0);
+
+    // approximate matching
+    uint32_t k = 101;
+    key = ups_make_key(&k, sizeof(k));
+    REQUIRE(index->get(&key, 0) == nullptr);
+    REQUIRE(*(uint32_t *)index->get(&key, UPS_FIND_GEQ_MATCH)->key()->data
+                    == 102);
+    REQUIRE(*(uint32_t *)index->get(&key, UPS_FIND_LEQ_MATCH)->key()->data
+                    == 100);
+    k = 100;
+    REQUIRE(*(uint32_t *)index->get(&key, UPS_FIND_GEQ_MATCH)->key()->data
+                    == 100);
+    REQUIRE(*(uint32_t *)index->get(&key, UPS_FIND_GT_MATCH)->key()->data
+                    == 102);
+    REQUIRE(*(uint32_t *)index->get(&key, UPS_FIND_LT_MATCH)->key()->data
+                    == 98);
+    k = 0;
+    REQUIRE(index->get(&key, UPS_FIND_LT_MATCH) == nullptr);
+    k = kNumKeys * 2;
+    REQUIRE(index->get(&key, UPS_FIND_GEQ_MATCH) == nullptr);
+    REQUIRE(*(uint32_t *)index->get(&key, UPS_FIND_LEQ_MATCH)->key()->data
+                    == (uint32_t)(kNumKeys - 1) * 2);
+
+    // the abort removes all nodes
+    txnp.abort();
+    REQUIRE(index->first() == nullptr);
+    REQUIRE(index->last() == nullptr);
+    REQUIRE(index->height == 0);
+  }
+
   void txnInsertConflict1Test() {
     ups_txn_t *txn1, *txn2;
     ups_key_t key = ups_make_key((void *)"hello", 5);
@@ -463,6 +572,18 @@ TEST_CASE("Txn/txnMultipleOpsTest", "")
   f.txnMultipleOpsTest();
 }
 
+TEST_CASE("Txn/arenaTest", "")
+{
+  TxnFixture f;
+  f.arenaTest();
+}
+
+TEST_CASE("Txn/skiplistTest", "")
+{
+  TxnFixture f;
+  f.skiplistTest();
+}
+
 TEST_CASE("Txn/txnInsertConflict1Test", "")
 {
   TxnFixture f;
@@ -864,6 +985,357 @@ struct HighLevelTxnFixture : BaseFixture {
 
     close();
   }
+
+  ups_status_t find(ups_txn_t *txn, const char *k, int *value) {
+    ups_key_t key = ups_make_key((void *)k, (uint16_t)::strlen(k));
+    ups_record_t rec = {0};
+    ups_status_t st = ups_db_find(db, txn, &key, &rec, 0);
+    if (st == 0)
+      *value = *(int *)rec.data;
+    return st;
+  }
+
+  void insert(ups_txn_t *txn, const char *k, int value,
+                  uint32_t flags = 0) {
+    ups_key_t key = ups_make_key((void *)k, (uint16_t)::strlen(k));
+    ups_record_t rec = ups_make_record(&value, sizeof(value));
+    REQUIRE(0 == ups_db_insert(db, txn, &key, &rec, flags));
+  }
+
+  void snapshotTest() {
+    ups_txn_t *writer1, *writer2, *writer3, *snapshot;
+    int value = 0;
+
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY);
+    insert(0, "a", 1);
+
+    // writer2 is the oldest txn; it would be flushed as soon as it commits
+    REQUIRE(0 == ups_txn_begin(&writer2, env, 0, 0, 0));
+    insert(writer2, "a", 2, UPS_OVERWRITE);
+    REQUIRE(0 == ups_txn_begin(&writer1, env, 0, 0, 0));
+    insert(writer1, "b", 1);
+    REQUIRE(0 == ups_txn_begin(&snapshot, env, 0, 0, UPS_TXN_READ_ONLY));
+    REQUIRE(0 == ups_txn_commit(writer2, 0));
+    REQUIRE(0 == ups_txn_begin(&writer3, env, 0, 0, 0));
+    insert(writer3, "c", 1);
+    REQUIRE(0 == ups_txn_commit(writer3, 0));
+
+    // the snapshot only sees the txns which were committed before it began;
+    // the active writer does not cause a conflict
+    REQUIRE(0 == find(snapshot, "a", &value));
+    REQUIRE(1 == value);
+    REQUIRE(UPS_KEY_NOT_FOUND == find(snapshot, "b", &value));
+    REQUIRE(UPS_KEY_NOT_FOUND == find(snapshot, "c", &value));
+
+    uint64_t count = 0;
+    REQUIRE(0 == ups_db_count(db, snapshot, 0, &count));
+    REQUIRE(1ull == count);
+
+    ups_cursor_t *cursor;
+    ups_key_t key = {0};
+    ups_record_t rec = {0};
+    REQUIRE(0 == ups_cursor_create(&cursor, db, snapshot, 0));
+    REQUIRE(0 == ups_cursor_move(cursor, &key, &rec, UPS_CURSOR_FIRST));
+    REQUIRE(1 == key.size);
+    REQUIRE('a' == *(char *)key.data);
+    REQUIRE(1 == *(int *)rec.data);
+    REQUIRE(UPS_KEY_NOT_FOUND
+                    == ups_cursor_move(cursor, &key, &rec, UPS_CURSOR_NEXT));
+    REQUIRE(0 == ups_cursor_close(cursor));
+
+    // the snapshot is read-only
+    key = ups_make_key((void *)"d", 1);
+    rec = ups_make_record(&value, sizeof(value));
+    REQUIRE(UPS_WRITE_PROTECTED == ups_db_insert(db, snapshot, &key, &rec, 0));
+    REQUIRE(UPS_WRITE_PROTECTED == ups_db_erase(db, snapshot, &key, 0));
+
+    // other txns see the newest data (and conflicts)
+    REQUIRE(0 == find(0, "a", &value));
+    REQUIRE(2 == value);
+    REQUIRE(UPS_TXN_CONFLICT == find(0, "b", &value));
+    REQUIRE(0 == find(0, "c", &value));
+
+    // after the snapshot ended, all committed txns are flushed
+    REQUIRE(0 == ups_txn_commit(snapshot, 0));
+    REQUIRE(0 == ups_txn_abort(writer1, 0));
+    REQUIRE(lenv()->txn_manager->oldest_txn() == nullptr);
+    REQUIRE(0 == find(0, "a", &value));
+    REQUIRE(2 == value);
+    REQUIRE(UPS_KEY_NOT_FOUND == find(0, "b", &value));
+    REQUIRE(0 == find(0, "c", &value));
+  }
+  void snapshotMergeTest() {
+    ups_txn_t *writer1, *writer2, *snapshot;
+    int value = 0;
+
+    require_create(UPS_ENABLE_TRANSACTIONS
+                    | UPS_FLUSH_TRANSACTIONS_IMMEDIATELY);
+    insert(0, "a", 1);
+
+    // writer2 is committed before the snapshot begins, but cannot be
+    // merged while the older writer1 is active
+    REQUIRE(0 == ups_txn_begin(&writer1, env, 0, 0, 0));
+    insert(writer1, "a", 2, UPS_OVERWRITE);
+    REQUIRE(0 == ups_txn_begin(&writer2, env, 0, 0, 0));
+    insert(writer2, "b", 1);
+    REQUIRE(0 == ups_txn_commit(writer2, 0));
+    REQUIRE(0 == ups_txn_begin(&snapshot, env, 0, 0, UPS_TXN_READ_ONLY));
+
+    // writer1 is hidden from the snapshot and stays in the TxnIndex, but
+    // writer2 is visible to the snapshot and therefore merged
+    REQUIRE(0 == ups_txn_commit(writer1, 0));
+    Txn *oldest = lenv()->txn_manager->oldest_txn();
+    REQUIRE(oldest == (Txn *)writer1);
+    REQUIRE(oldest->next() == (Txn *)snapshot);
+    REQUIRE(oldest->next()->next() == nullptr);
+
+    REQUIRE(0 == find(snapshot, "a", &value));
+    REQUIRE(1 == value);
+    REQUIRE(0 == find(snapshot, "b", &value));
+    REQUIRE(1 == value);
+    REQUIRE(0 == find(0, "a", &value));
+    REQUIRE(2 == value);
+
+    // after the snapshot ended, writer1 is merged as well
+    REQUIRE(0 == ups_txn_commit(snapshot, 0));
+    REQUIRE(lenv()->txn_manager->oldest_txn() == nullptr);
+    REQUIRE(0 == find(0, "a", &value));
+    REQUIRE(2 == value);
+    REQUIRE(0 == find(0, "b", &value));
+    REQUIRE(1 == value);
+  }
+
+
+  // Returns the number of committed txns which were not yet merged
+  int committedTxns() {
+    ScopedWriteLock lock(lenv()->mutex);
+    int count = 0;
+    for (Txn *t = lenv()->txn_manager->oldest_txn(); t; t = t->next())
+      if (t->is_committed())
+        count++;
+    return count;
+  }
+
+  static void commitAfterDelay(ups_txn_t *txn, ups_status_t *st) {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    *st = ups_txn_commit(txn, 0);
+  }
+
+  void conflictingTxnIdTest() {
+    ups_txn_t *txn1, *txn2;
+    int value = 0;
+
+    require_create(UPS_ENABLE_TRANSACTIONS);
+    REQUIRE(0 == ups_txn_begin(&txn1, env, 0, 0, 0));
+    REQUIRE(0 == ups_txn_begin(&txn2, env, 0, 0, 0));
+    REQUIRE(ups_txn_get_id(txn1) != 0);
+    REQUIRE(ups_txn_get_id(txn2) > ups_txn_get_id(txn1));
+    REQUIRE(0ull == ups_txn_get_conflicting_txn_id(txn2));
+
+    insert(txn1, "a", 1);
+    ups_key_t key = ups_make_key((void *)"a", 1);
+    ups_record_t rec = ups_make_record(&value, sizeof(value));
+    REQUIRE(UPS_TXN_CONFLICT == ups_db_insert(db, txn2, &key, &rec, 0));
+    REQUIRE(ups_txn_get_id(txn1) == ups_txn_get_conflicting_txn_id(txn2));
+    REQUIRE(UPS_TXN_CONFLICT == find(txn2, "a", &value));
+    REQUIRE(ups_txn_get_id(txn1) == ups_txn_get_conflicting_txn_id(txn2));
+
+    REQUIRE(0 == ups_txn_abort(txn2, 0));
+    REQUIRE(0 == ups_txn_commit(txn1, 0));
+  }
+
+  void waitOnConflictTest() {
+    ups_parameter_t params[] = {
+        {UPS_PARAM_TXN_CONFLICT_WAIT_MSEC, 100},
+        {0, 0}
+    };
+    ups_txn_t *txn1, *txn2;
+    int value = 0;
+
+    require_create(UPS_ENABLE_TRANSACTIONS, params);
+
+    // the conflict persists: the operation fails after the timeout
+    REQUIRE(0 == ups_txn_begin(&txn1, env, 0, 0, 0));
+    REQUIRE(0 == ups_txn_begin(&txn2, env, 0, 0, 0));
+    insert(txn1, "a", 1);
+    boost::system_time start = boost::get_system_time();
+    REQUIRE(UPS_TXN_CONFLICT == find(txn2, "a", &value));
+    REQUIRE((boost::get_system_time() - start).total_milliseconds() >= 90);
+
+    // the conflicting txn is committed while the operation waits
+    close();
+    params[0].value = 10000;
+    require_create(UPS_ENABLE_TRANSACTIONS, params);
+    REQUIRE(0 == ups_txn_begin(&txn1, env, 0, 0, 0));
+    REQUIRE(0 == ups_txn_begin(&txn2, env, 0, 0, 0));
+    insert(txn1, "a", 1);
+    ups_status_t st = -1;
+    boost::thread committer(&commitAfterDelay, txn1, &st);
+    REQUIRE(0 == find(txn2, "a", &value));
+    REQUIRE(1 == value);
+    committer.join();
+    REQUIRE(0 == st);
+    REQUIRE(0 == ups_txn_commit(txn2, 0));
+  }
+
+  void backgroundMergeTest() {
+    ups_parameter_t params[] = {
+        {UPS_PARAM_TXN_MERGE_LIMIT, 30},
+        {0, 0}
+    };
+    require_create(UPS_ENABLE_TRANSACTIONS, params);
+
+    ups_parameter_t query[] = {
+        {UPS_PARAM_TXN_MERGE_LIMIT, 0},
+        {0, 0}
+    };
+    REQUIRE(0 == ups_env_get_parameters(env, query));
+    REQUIRE(30ull == query[0].value);
+
+    // the committing thread only merges if the background thread falls
+    // behind
+    ups_txn_t *txn;
+    for (int i = 0; i < 200; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = ups_make_record(&i, sizeof(i));
+      REQUIRE(0 == ups_txn_begin(&txn, env, 0, 0, 0));
+      REQUIRE(0 == ups_db_insert(db, txn, &key, &rec, 0));
+      REQUIRE(0 == ups_txn_commit(txn, 0));
+      REQUIRE(committedTxns() <= 30);
+    }
+
+    // the background thread merges the remaining txns
+    LocalTxnManager *tm = (LocalTxnManager *)lenv()->txn_manager.get();
+    uint64_t merge_count = 0;
+    for (int i = 0; i < 1000; i++) {
+      {
+        ScopedLock lock(tm->merge.mutex);
+        merge_count = tm->merge.merge_count;
+      }
+      if (merge_count > 0 && committedTxns() < 10)
+        break;
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    REQUIRE(merge_count > 0);
+    REQUIRE(committedTxns() < 10);
+
+    // the txns which were not merged are flushed when the env is closed
+    close();
+    require_open(UPS_ENABLE_TRANSACTIONS);
+    for (int i = 0; i < 200; i++) {
+      ups_key_t key = ups_make_key(&i, sizeof(i));
+      ups_record_t rec = {0};
+      REQUIRE(0 == ups_db_find(db, 0, &key, &rec, 0));
+      REQUIRE(*(int *)rec.data == i);
+    }
+  }
+
+  enum {
+    kStagingThreads = 4,
+    kStagedKeys = 5000,
+    kSharedKeys = 500
+  };
+
+  // Inserts the keys of thread |id|, erases every 10th key, and tries to
+  // insert keys which are shared by all threads
+  static void stageKeys(ups_db_t *db, ups_txn_t *txn, uint32_t id,
+                  int *shared_inserts, int *failures) {
+    for (uint32_t i = 0; i < kStagedKeys; i++) {
+      uint32_t k = i * kStagingThreads + id;
+      ups_key_t key = ups_make_key(&k, sizeof(k));
+      ups_record_t rec = ups_make_record(&k, sizeof(k));
+      if (0 != ups_db_insert(db, txn, &key, &rec, 0))
+        (*failures)++;
+      if (i % 10 == 0 && 0 != ups_db_erase(db, txn, &key, 0))
+        (*failures)++;
+
+      if (i < kSharedKeys) {
+        k = kStagedKeys * kStagingThreads + i;
+        ups_status_t st = ups_db_insert(db, txn, &key, &rec, 0);
+        if (st == 0)
+          (*shared_inserts)++;
+        else if (st != UPS_TXN_CONFLICT)
+          (*failures)++;
+      }
+    }
+  }
+
+  void concurrentStagingTest(int key_filter_bits = 0) {
+    ups_parameter_t params[] = {
+        {UPS_PARAM_KEY_TYPE, UPS_TYPE_UINT32},
+        {0, 0},
+        {0, 0}
+    };
+    if (key_filter_bits) {
+      params[1].name = UPS_PARAM_KEY_FILTER_BITS;
+      params[1].value = key_filter_bits;
+    }
+    require_create(UPS_ENABLE_TRANSACTIONS | UPS_ENABLE_CONCURRENT_READS,
+                    0, 0, params);
+    // the KeyFilter is not thread-safe; the Txns are staged one at a time
+    REQUIRE(ldb()->supports_concurrent_staging() == (key_filter_bits == 0));
+
+    // a committed key: the threads have to check the btree
+    uint32_t k = 0;
+    ups_key_t key = ups_make_key(&k, sizeof(k));
+    ups_record_t rec = ups_make_record(&k, sizeof(k));
+    REQUIRE(0 == ups_db_insert(db, 0, &key, &rec, 0));
+    REQUIRE(0 == ups_env_flush(env, 0));
+
+    ups_txn_t *txns[kStagingThreads];
+    int shared_inserts[kStagingThreads] = {0};
+    int failures[kStagingThreads] = {0};
+    std::vector<boost::thread *> threads;
+    for (uint32_t i = 0; i < kStagingThreads; i++) {
+      REQUIRE(0 == ups_txn_begin(&txns[i], env, 0, 0, 0));
+      threads.push_back(new boost::thread(&stageKeys, db, txns[i], i,
+                              &shared_inserts[i], &failures[i]));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i]->join();
+      delete threads[i];
+    }
+
+    // key 0 already existed (and was then erased); each shared key was
+    // inserted exactly once
+    int total = 0;
+    for (int i = 0; i < kStagingThreads; i++) {
+      REQUIRE(failures[i] == (i == 0 ? 1 : 0));
+      total += shared_inserts[i];
+    }
+    REQUIRE(total == kSharedKeys);
+
+    // the TxnIndex is sorted in both directions
+    TxnIndex *index = ldb()->txn_index.get();
+    uint32_t previous = 0;
+    int count = 0;
+    for (TxnNode *node = index->first(); node; node = node->next_sibling()) {
+      uint32_t current = *(uint32_t *)node->key()->data;
+      REQUIRE((count == 0 || current > previous));
+      previous = current;
+      count++;
+    }
+    REQUIRE(count == kStagedKeys * kStagingThreads + kSharedKeys);
+    for (TxnNode *node = index->last(); node;
+                    node = node->previous_sibling())
+      count--;
+    REQUIRE(count == 0);
+
+    for (int i = 0; i < kStagingThreads; i++)
+      REQUIRE(0 == ups_txn_commit(txns[i], 0));
+
+    for (uint32_t i = 0; i < kStagedKeys * kStagingThreads + kSharedKeys;
+                    i++) {
+      k = i;
+      key = ups_make_key(&k, sizeof(k));
+      rec = ups_make_record(0, 0);
+      ups_status_t st = ups_db_find(db, 0, &key, &rec, 0);
+      bool is_erased = i < kStagedKeys * kStagingThreads
+                          && (i / kStagingThreads) % 10 == 0;
+      REQUIRE(st == (is_erased ? UPS_KEY_NOT_FOUND : 0));
+    }
+  }
 };
 
 TEST_CASE("Txn/high/noPersistentDatabaseFlagTest", "")
@@ -950,6 +1422,48 @@ TEST_CASE("Txn/high/getKeyCountOverwriteTest", "")
   f.getKeyCountOverwriteTest();
 }
 
+TEST_CASE("Txn/high/snapshotTest", "")
+{
+  HighLevelTxnFixture f;
+  f.snapshotTest();
+}
+
+TEST_CASE("Txn/high/snapshotMergeTest", "")
+{
+  HighLevelTxnFixture f;
+  f.snapshotMergeTest();
+}
+
+TEST_CASE("Txn/high/conflictingTxnIdTest", "")
+{
+  HighLevelTxnFixture f;
+  f.conflictingTxnIdTest();
+}
+
+TEST_CASE("Txn/high/waitOnConflictTest", "")
+{
+  HighLevelTxnFixture f;
+  f.waitOnConflictTest();
+}
+
+TEST_CASE("Txn/high/backgroundMergeTest", "")
+{
+  HighLevelTxnFixture f;
+  f.backgroundMergeTest();
+}
+
+TEST_CASE("Txn/high/concurrentStagingTest", "")
+{
+  HighLevelTxnFixture f;
+  f.concurrentStagingTest();
+}
+
+TEST_CASE("Txn/high/concurrentStagingKeyFilterTest", "")
+{
+  HighLevelTxnFixture f;
+  f.concurrentStagingTest(10);
+}
+
 TEST_CASE("Txn/high/insertTxnsWithDelay", "")
 {
   HighLevelTxnFixture f;